@@ -2,6 +2,10 @@
 #include "esphome/core/log.h"
 #include <cstring>
 
+#ifdef USE_ESP_AEC
+#include <esp_timer.h>
+#endif
+
 namespace esphome {
 namespace esp_aec {
 
@@ -39,6 +43,8 @@ void EspAec::process(int16_t *mic_input, int16_t *speaker_ref, int16_t *output,
   }
 
   // Process in frame_size chunks
+  int64_t start = esp_timer_get_time();
+  uint32_t chunks = 0;
   size_t processed = 0;
   while (processed < samples) {
     size_t chunk = std::min((size_t)this->frame_size_, samples - processed);
@@ -53,7 +59,10 @@ void EspAec::process(int16_t *mic_input, int16_t *speaker_ref, int16_t *output,
     aec_process(this->aec_handle_, mic_input + processed, speaker_ref + processed, output + processed);
 
     processed += chunk;
+    chunks++;
   }
+  this->chunks_processed_.fetch_add(chunks, std::memory_order_relaxed);
+  this->process_us_.fetch_add((uint64_t) (esp_timer_get_time() - start), std::memory_order_relaxed);
 #else
   // No AEC available, passthrough
   memcpy(output, mic_input, samples * sizeof(int16_t));
@@ -4,6 +4,8 @@
 #include "esphome/core/log.h"
 #include "esphome/core/defines.h"
 
+#include <atomic>
+
 #ifdef USE_ESP_AEC
 // ESP-SR AEC library (C interface requires extern "C")
 extern "C" {
@@ -32,12 +34,19 @@ class EspAec : public Component {
   void process(int16_t *mic_input, int16_t *speaker_ref, int16_t *output, size_t samples);
   int get_frame_size() const { return this->frame_size_; }
   bool is_initialized() const { return this->initialized_; }
+  int get_filter_length() const { return this->filter_length_; }
+
+  // Chunks run through the canceller and the time they took, since boot
+  uint32_t get_chunks_processed() const { return this->chunks_processed_.load(std::memory_order_relaxed); }
+  uint64_t get_process_us() const { return this->process_us_.load(std::memory_order_relaxed); }
 
  protected:
   uint32_t sample_rate_{16000};
   int filter_length_{4};  // Recommended: 4 for ESP32-S3
   int frame_size_{0};
   bool initialized_{false};
+  std::atomic<uint32_t> chunks_processed_{0};
+  std::atomic<uint64_t> process_us_{0};
 
 #ifdef USE_ESP_AEC
   aec_handle_t *aec_handle_{nullptr};
@@ -1,12 +1,16 @@
 """I2S Audio Duplex Component - Full duplex I2S for simultaneous mic+speaker"""
 import esphome.codegen as cg
 import esphome.config_validation as cv
-from esphome import pins
-from esphome.const import CONF_ID
+from esphome import automation, pins
+import esphome.final_validate as fv
+from esphome.components import i2c
+from esphome.components.esp32 import get_esp32_variant
+from esphome.components.esp32.const import VARIANT_ESP32
+from esphome.const import CONF_ID, CONF_TYPE
 
 CODEOWNERS = ["@n-IA-hane"]
 DEPENDENCIES = []
-AUTO_LOAD = ["switch", "number"]
+AUTO_LOAD = ["switch", "number", "sensor"]
 
 CONF_I2S_LRCLK_PIN = "i2s_lrclk_pin"
 CONF_I2S_BCLK_PIN = "i2s_bclk_pin"
@@ -14,11 +18,150 @@ CONF_I2S_MCLK_PIN = "i2s_mclk_pin"
 CONF_I2S_DIN_PIN = "i2s_din_pin"
 CONF_I2S_DOUT_PIN = "i2s_dout_pin"
 CONF_SAMPLE_RATE = "sample_rate"
+CONF_FRAME_DURATION = "frame_duration"
 CONF_AEC_ID = "aec_id"
+CONF_CODEC = "codec"
+CONF_PROMPTS = "prompts"
+CONF_PARTITION = "partition"
+CONF_DUCK_LEVEL = "duck_level"
+CONF_FILES = "files"
+CONF_NAME = "name"
+CONF_OFFSET = "offset"
+CONF_PROMPT = "prompt"
+CONF_LOOP = "loop"
+CONF_LEVEL = "level"
+CONF_BITS_PER_SAMPLE = "bits_per_sample"
+CONF_MIC_ARRAY = "mic_array"
+CONF_SLOT_MODE = "slot_mode"
+CONF_SLOTS = "slots"
+CONF_REFERENCE_SLOT = "reference_slot"
+CONF_MIC_SPACING = "mic_spacing"
+CONF_STEERING_ANGLE = "steering_angle"
+CONF_DMA_BUFFER_COUNT = "dma_buffer_count"
+CONF_DMA_BUFFER_SIZE = "dma_buffer_size"
+CONF_SPEAKER_BUFFER_SIZE = "speaker_buffer_size"
 
 i2s_audio_duplex_ns = cg.esphome_ns.namespace("i2s_audio_duplex")
 I2SAudioDuplex = i2s_audio_duplex_ns.class_("I2SAudioDuplex", cg.Component)
 
+# Codec register control (hardware volume/gain)
+CodecType = i2s_audio_duplex_ns.enum("CodecType", is_class=True)
+CODEC_TYPES = {
+    "es8311": CodecType.ES8311,
+    "es8388": CodecType.ES8388,
+}
+CodecI2CBus = i2s_audio_duplex_ns.class_("CodecI2CBus", i2c.I2CDevice)
+
+
+def _codec_schema(default_address):
+    return cv.Schema({
+        cv.GenerateID(): cv.declare_id(CodecI2CBus),
+    }).extend(i2c.i2c_device_schema(default_address))
+
+
+CODEC_SCHEMA = cv.typed_schema(
+    {
+        "es8311": _codec_schema(0x18),
+        "es8388": _codec_schema(0x10),
+    },
+    lower=True,
+)
+
+# Prompt playback (WAV assets memory-mapped from a data partition)
+PROMPTS_SCHEMA = cv.Schema({
+    cv.Required(CONF_PARTITION): cv.string_strict,
+    cv.Optional(CONF_DUCK_LEVEL, default=0.25): cv.percentage,
+    cv.Required(CONF_FILES): cv.ensure_list(cv.Schema({
+        cv.Required(CONF_NAME): cv.string_strict,
+        cv.Required(CONF_OFFSET): cv.hex_uint32_t,
+    })),
+})
+
+# Mic array: capture every slot and beamform the mics into one frame
+SlotMode = i2s_audio_duplex_ns.enum("SlotMode", is_class=True)
+SLOT_MODES = {
+    "stereo": SlotMode.STEREO,
+    "tdm": SlotMode.TDM,
+}
+MAX_SLOTS = 8
+# Beamformer::MAX_DELAY, and the speed of sound it assumes
+MAX_STEERING_DELAY_SAMPLES = 64
+SPEED_OF_SOUND = 343.0
+
+
+def _validate_mic_array(config):
+    mode = config[CONF_SLOT_MODE]
+    if mode == "stereo":
+        if config.setdefault(CONF_SLOTS, 2) != 2:
+            raise cv.Invalid("slot_mode: stereo always has 2 slots")
+    elif CONF_SLOTS not in config:
+        raise cv.Invalid("slots is required with slot_mode: tdm")
+    if CONF_REFERENCE_SLOT in config and config[CONF_REFERENCE_SLOT] >= config[CONF_SLOTS]:
+        raise cv.Invalid(f"reference_slot must be below slots ({config[CONF_SLOTS]})")
+    return config
+
+
+MIC_ARRAY_SCHEMA = cv.All(
+    cv.Schema({
+        cv.Required(CONF_SLOT_MODE): cv.one_of(*SLOT_MODES, lower=True),
+        cv.Optional(CONF_SLOTS): cv.int_range(min=2, max=MAX_SLOTS),
+        cv.Optional(CONF_REFERENCE_SLOT): cv.int_range(min=0, max=MAX_SLOTS - 1),
+        cv.Optional(CONF_MIC_SPACING, default="40mm"): cv.All(cv.distance, cv.float_range(min=0.005, max=0.5)),
+        cv.Optional(CONF_STEERING_ANGLE, default=0): cv.All(cv.angle, cv.float_range(min=-90, max=90)),
+    }),
+    _validate_mic_array,
+)
+
+
+def _validate_mic_array_geometry(config):
+    if CONF_MIC_ARRAY not in config:
+        return config
+    array = config[CONF_MIC_ARRAY]
+    mics = array[CONF_SLOTS] - (1 if CONF_REFERENCE_SLOT in array else 0)
+    if array[CONF_SLOT_MODE] == "tdm" and get_esp32_variant() == VARIANT_ESP32:
+        raise cv.Invalid("slot_mode: tdm is not supported on the original ESP32, use stereo")
+    if config[CONF_I2S_DIN_PIN] < 0:
+        raise cv.Invalid("mic_array requires i2s_din_pin")
+    if config[CONF_BITS_PER_SAMPLE] != 16:
+        raise cv.Invalid("mic_array captures 16-bit slots, use bits_per_sample: 16bit")
+    length = array[CONF_MIC_SPACING] * (mics - 1)
+    if length / SPEED_OF_SOUND * config[CONF_SAMPLE_RATE] >= MAX_STEERING_DELAY_SAMPLES:
+        raise cv.Invalid(
+            f"mic_array is too long to steer at {config[CONF_SAMPLE_RATE]} Hz "
+            f"(at most {MAX_STEERING_DELAY_SAMPLES} samples of delay across the array)"
+        )
+    return config
+
+
+# Actions / conditions
+PlayPromptAction = i2s_audio_duplex_ns.class_("PlayPromptAction", automation.Action)
+StopPromptAction = i2s_audio_duplex_ns.class_("StopPromptAction", automation.Action)
+CalibrateAction = i2s_audio_duplex_ns.class_("CalibrateAction", automation.Action)
+IsPlayingPromptCondition = i2s_audio_duplex_ns.class_("IsPlayingPromptCondition", automation.Condition)
+
+# Stream formats the audio path is built for (frame size is fixed at compile time)
+SUPPORTED_SAMPLE_RATES = [8000, 16000, 24000, 32000, 48000]
+SUPPORTED_FRAME_DURATIONS_MS = [10, 16, 20]
+# ESP-SR AEC processes 16 ms chunks
+AEC_FRAME_DURATION_MS = 16
+# DMA ring when neither dma_buffer_* nor intercom_audio latency_target sets it
+DEFAULT_DMA_BUFFER_COUNT = 8
+DEFAULT_DMA_BUFFER_SIZE = 512
+
+
+def validate_frame_duration(value):
+    value = cv.positive_time_period_milliseconds(value)
+    if value.total_milliseconds not in SUPPORTED_FRAME_DURATIONS_MS:
+        raise cv.Invalid(
+            f"frame_duration must be one of {', '.join(f'{d}ms' for d in SUPPORTED_FRAME_DURATIONS_MS)}"
+        )
+    return value
+
+
+def frame_samples(sample_rate, frame_duration):
+    return sample_rate * int(frame_duration.total_milliseconds) // 1000
+
+
 # Forward declare esp_aec
 esp_aec_ns = cg.esphome_ns.namespace("esp_aec")
 EspAec = esp_aec_ns.class_("EspAec")
@@ -39,9 +182,46 @@ CONFIG_SCHEMA = cv.Schema({
         cv.int_range(min=-1, max=-1),
         pins.internal_gpio_output_pin_number,
     ),
-    cv.Optional(CONF_SAMPLE_RATE, default=16000): cv.int_range(min=8000, max=48000),
+    cv.Optional(CONF_SAMPLE_RATE, default=16000): cv.one_of(*SUPPORTED_SAMPLE_RATES, int=True),
+    cv.Optional(CONF_FRAME_DURATION, default="16ms"): validate_frame_duration,
+    cv.Optional(CONF_BITS_PER_SAMPLE, default="16bit"): cv.All(
+        cv.float_with_unit("Bits per sample", "bit"), cv.one_of(16, 32, int=True)
+    ),
     cv.Optional(CONF_AEC_ID): cv.use_id(EspAec),
+    cv.Optional(CONF_CODEC): cv.All(cv.requires_component("i2c"), CODEC_SCHEMA),
+    cv.Optional(CONF_PROMPTS): PROMPTS_SCHEMA,
+    cv.Optional(CONF_MIC_ARRAY): MIC_ARRAY_SCHEMA,
+    # Latency: DMA ring per direction (descriptors x samples) and speaker buffer.
+    # Defaults are 8 x 512 and 8192 bytes; intercom_audio latency_target sizes
+    # whatever is not set here.
+    cv.Optional(CONF_DMA_BUFFER_COUNT): cv.int_range(min=2, max=16),
+    cv.Optional(CONF_DMA_BUFFER_SIZE): cv.int_range(min=32, max=1023),
+    cv.Optional(CONF_SPEAKER_BUFFER_SIZE): cv.int_range(min=512, max=65536),
 }).extend(cv.COMPONENT_SCHEMA)
+CONFIG_SCHEMA = cv.All(CONFIG_SCHEMA, _validate_mic_array_geometry)
+
+
+def _final_validate(config):
+    # AEC runs on the duplex frames, so it must be built for the same format
+    if CONF_AEC_ID not in config:
+        if CONF_REFERENCE_SLOT in config.get(CONF_MIC_ARRAY, {}):
+            raise cv.Invalid("mic_array reference_slot is the AEC reference and needs aec_id")
+        return config
+    full_config = fv.full_config.get()
+    path = full_config.get_path_for_id(config[CONF_AEC_ID])[:-1]
+    aec_config = full_config.get_config_for_path(path)
+    aec_rate = aec_config.get(CONF_SAMPLE_RATE, 16000)
+    if aec_rate != config[CONF_SAMPLE_RATE]:
+        raise cv.Invalid(
+            f"esp_aec sample_rate ({aec_rate}) must match i2s_audio_duplex sample_rate "
+            f"({config[CONF_SAMPLE_RATE]})"
+        )
+    if config[CONF_FRAME_DURATION].total_milliseconds != AEC_FRAME_DURATION_MS:
+        raise cv.Invalid(f"frame_duration must be {AEC_FRAME_DURATION_MS}ms when aec_id is set")
+    return config
+
+
+FINAL_VALIDATE_SCHEMA = _final_validate
 
 
 async def to_code(config):
@@ -57,6 +237,47 @@ async def to_code(config):
     cg.add(var.set_din_pin(config[CONF_I2S_DIN_PIN]))
     cg.add(var.set_dout_pin(config[CONF_I2S_DOUT_PIN]))
     cg.add(var.set_sample_rate(config[CONF_SAMPLE_RATE]))
+    cg.add(var.set_bits_per_sample(config[CONF_BITS_PER_SAMPLE]))
+    if CONF_DMA_BUFFER_COUNT in config or CONF_DMA_BUFFER_SIZE in config:
+        cg.add(var.set_dma_buffers(
+            config.get(CONF_DMA_BUFFER_COUNT, DEFAULT_DMA_BUFFER_COUNT),
+            config.get(CONF_DMA_BUFFER_SIZE, DEFAULT_DMA_BUFFER_SIZE),
+        ))
+    if CONF_SPEAKER_BUFFER_SIZE in config:
+        cg.add(var.set_speaker_buffer_size(config[CONF_SPEAKER_BUFFER_SIZE]))
+
+    # Mic array before set_aec(): a loopback slot replaces the software reference
+    if CONF_MIC_ARRAY in config:
+        array = config[CONF_MIC_ARRAY]
+        cg.add(var.set_mic_array(
+            SLOT_MODES[array[CONF_SLOT_MODE]],
+            array[CONF_SLOTS],
+            array.get(CONF_REFERENCE_SLOT, -1),
+            array[CONF_MIC_SPACING],
+            array[CONF_STEERING_ANGLE],
+        ))
+
+    # Frame size is a compile-time constant of the audio task
+    cg.add_define("I2S_AUDIO_DUPLEX_SAMPLE_RATE", config[CONF_SAMPLE_RATE])
+    cg.add_define(
+        "I2S_AUDIO_DUPLEX_FRAME_SAMPLES",
+        frame_samples(config[CONF_SAMPLE_RATE], config[CONF_FRAME_DURATION]),
+    )
+
+    # Hardware volume/gain via codec registers (software scaling stays as fallback)
+    if CONF_CODEC in config:
+        codec_conf = config[CONF_CODEC]
+        bus = cg.new_Pvariable(codec_conf[CONF_ID])
+        await i2c.register_i2c_device(bus, codec_conf)
+        cg.add(var.set_codec(bus, CODEC_TYPES[codec_conf[CONF_TYPE]]))
+
+    # Prompts/ringtones mixed into the speaker path
+    if CONF_PROMPTS in config:
+        prompts = config[CONF_PROMPTS]
+        cg.add(var.set_prompt_partition(prompts[CONF_PARTITION]))
+        cg.add(var.set_prompt_duck_level(prompts[CONF_DUCK_LEVEL]))
+        for prompt in prompts[CONF_FILES]:
+            cg.add(var.add_prompt(prompt[CONF_NAME], prompt[CONF_OFFSET]))
 
     # Link AEC if configured
     if CONF_AEC_ID in config:
@@ -64,3 +285,52 @@ async def to_code(config):
         cg.add(var.set_aec(aec))
         # Enable AEC compilation in i2s_audio_duplex
         cg.add_define("USE_ESP_AEC")
+
+
+# Action: play a prompt from the prompt partition
+@automation.register_action("i2s_audio_duplex.play_prompt", PlayPromptAction, cv.Schema({
+    cv.GenerateID(): cv.use_id(I2SAudioDuplex),
+    cv.Required(CONF_PROMPT): cv.templatable(cv.string),
+    cv.Optional(CONF_LOOP, default=False): cv.templatable(cv.boolean),
+}))
+async def play_prompt_action_to_code(config, action_id, template_arg, args):
+    var = cg.new_Pvariable(action_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    template_ = await cg.templatable(config[CONF_PROMPT], args, cg.std_string)
+    cg.add(var.set_prompt(template_))
+    template_ = await cg.templatable(config[CONF_LOOP], args, bool)
+    cg.add(var.set_loop(template_))
+    return var
+
+
+# Action: stop the playing prompt
+@automation.register_action("i2s_audio_duplex.stop_prompt", StopPromptAction, cv.Schema({
+    cv.GenerateID(): cv.use_id(I2SAudioDuplex),
+}))
+async def stop_prompt_action_to_code(config, action_id, template_arg, args):
+    var = cg.new_Pvariable(action_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    return var
+
+
+# Action: measure speaker-to-mic delay and echo gain with a test sequence
+@automation.register_action("i2s_audio_duplex.calibrate", CalibrateAction, cv.Schema({
+    cv.GenerateID(): cv.use_id(I2SAudioDuplex),
+    cv.Optional(CONF_LEVEL, default=0.25): cv.templatable(cv.percentage),
+}))
+async def calibrate_action_to_code(config, action_id, template_arg, args):
+    var = cg.new_Pvariable(action_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    template_ = await cg.templatable(config[CONF_LEVEL], args, float)
+    cg.add(var.set_level(template_))
+    return var
+
+
+# Condition: a prompt is playing
+@automation.register_condition("i2s_audio_duplex.is_playing_prompt", IsPlayingPromptCondition, cv.Schema({
+    cv.GenerateID(): cv.use_id(I2SAudioDuplex),
+}))
+async def is_playing_prompt_condition_to_code(config, condition_id, template_arg, args):
+    var = cg.new_Pvariable(condition_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    return var
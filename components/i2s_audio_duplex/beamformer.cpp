@@ -0,0 +1,126 @@
+#include "beamformer.h"
+
+#ifdef USE_ESP32
+#include <esp_heap_caps.h>
+#else
+#include <cstdlib>
+#endif
+
+#include <cmath>
+#include <cstring>
+
+namespace esphome {
+namespace i2s_audio_duplex {
+
+static const float SPEED_OF_SOUND = 343.0f;  // m/s at 20 °C
+
+bool Beamformer::configure(uint8_t slots, int8_t reference_slot, uint32_t sample_rate, float spacing_m,
+                           float steering_deg) {
+  if (slots == 0 || slots > MAX_SLOTS || reference_slot >= (int8_t) slots) {
+    return false;
+  }
+  this->slots_ = slots;
+  this->reference_slot_ = reference_slot;
+  this->mics_ = 0;
+  for (uint8_t s = 0; s < slots; s++) {
+    this->slot_mic_[s] = (int8_t) s == reference_slot ? -1 : (int8_t) this->mics_++;
+  }
+  if (this->mics_ == 0) {
+    return false;
+  }
+
+  // A plane wave from steering_deg reaches mic m earlier by m * spacing * sin / c;
+  // delaying each mic by that much (shifted so the smallest delay is 0) lines them up
+  float per_mic = spacing_m * sinf(steering_deg * (float) M_PI / 180.0f) * sample_rate / SPEED_OF_SOUND;
+  float base = per_mic < 0 ? per_mic * (this->mics_ - 1) : 0.0f;
+  uint16_t longest = 0;
+  for (uint8_t m = 0; m < this->mics_; m++) {
+    float delay = per_mic * m - base;
+    uint32_t q15 = (uint32_t) lroundf(delay * 32768.0f);
+    this->delay_q15_[m] = q15;
+    this->delay_int_[m] = (uint16_t) (q15 >> 15);
+    // Linear interpolation between the two neighbouring samples, 1/mics each
+    uint32_t frac = q15 & 0x7FFF;
+    this->tap0_[m] = (int32_t) ((32768 - frac + this->mics_ / 2) / this->mics_);
+    this->tap1_[m] = (int32_t) ((frac + this->mics_ / 2) / this->mics_);
+    if (this->delay_int_[m] > longest) {
+      longest = this->delay_int_[m];
+    }
+  }
+  if (longest >= MAX_DELAY) {
+    return false;
+  }
+  // One extra sample for the older interpolation tap
+  this->history_ = this->mics_ > 1 ? longest + 1 : 0;
+  return true;
+}
+
+size_t Beamformer::get_memory_bytes() const {
+  return (size_t) this->mics_ * (this->history_ + this->frame_samples_) * sizeof(int16_t);
+}
+
+bool Beamformer::allocate(size_t frame_samples) {
+  if (this->history_buf_ != nullptr) {
+    return true;
+  }
+  this->frame_samples_ = frame_samples;
+  size_t bytes = this->get_memory_bytes();
+#ifdef USE_ESP32
+  this->history_buf_ = (int16_t *) heap_caps_calloc(1, bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+#else
+  this->history_buf_ = (int16_t *) calloc(1, bytes);
+#endif
+  return this->history_buf_ != nullptr;
+}
+
+void Beamformer::process(const int16_t *interleaved, int16_t *out, int16_t *reference) {
+  const size_t frame = this->frame_samples_;
+  const size_t stride = this->history_ + frame;
+  const uint8_t slots = this->slots_;
+
+  // De-interleave: each mic behind its history, a single mic straight to out
+  for (uint8_t s = 0; s < slots; s++) {
+    int8_t mic = this->slot_mic_[s];
+    int16_t *dst;
+    if (mic < 0) {
+      dst = reference;
+    } else if (this->mics_ == 1) {
+      dst = out;
+    } else {
+      dst = this->history_buf_ + mic * stride + this->history_;
+    }
+    if (dst == nullptr) {
+      continue;
+    }
+    const int16_t *src = interleaved + s;
+    for (size_t t = 0; t < frame; t++) {
+      dst[t] = src[t * slots];
+    }
+  }
+  if (this->mics_ == 1) {
+    return;
+  }
+
+  // Delay-and-sum in Q15; the taps of all mics add up to ~1.0 so the sum cannot
+  // exceed 2^30 and only the +32768 edge needs clamping
+  for (size_t t = 0; t < frame; t++) {
+    int32_t acc = 1 << 14;
+    for (uint8_t m = 0; m < this->mics_; m++) {
+      const int16_t *x = this->history_buf_ + m * stride + this->history_ + t - this->delay_int_[m];
+      acc += this->tap0_[m] * x[0] + this->tap1_[m] * x[-1];
+    }
+    acc >>= 15;
+    if (acc > 32767) acc = 32767;
+    if (acc < -32768) acc = -32768;
+    out[t] = (int16_t) acc;
+  }
+
+  // Keep the tail of this frame as the next frame's history
+  for (uint8_t m = 0; m < this->mics_; m++) {
+    int16_t *ch = this->history_buf_ + m * stride;
+    memmove(ch, ch + frame, this->history_ * sizeof(int16_t));
+  }
+}
+
+}  // namespace i2s_audio_duplex
+}  // namespace esphome
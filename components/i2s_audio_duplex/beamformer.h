@@ -0,0 +1,59 @@
+#pragma once
+
+// Mic array front end: splits an interleaved multi-slot capture (stereo or
+// TDM) into per-channel frames, optionally pulls out a hardware loopback
+// reference slot, and combines the mic slots into one mono frame with a
+// fixed-point delay-and-sum beamformer steered at a fixed angle.
+// The mics form a line in slot order, `spacing` apart.
+// No ESPHome dependencies so it can be built and checked on the host.
+
+#include <cstddef>
+#include <cstdint>
+
+namespace esphome {
+namespace i2s_audio_duplex {
+
+class Beamformer {
+ public:
+  static const uint8_t MAX_SLOTS = 8;
+  // Longest steering delay in samples (0.45 m of array at 48 kHz)
+  static const uint16_t MAX_DELAY = 64;
+
+  // reference_slot < 0: every slot is a mic. steering_deg is measured from
+  // broadside (0 = straight ahead), positive toward the highest mic slot.
+  // False if the geometry needs more than MAX_DELAY samples.
+  bool configure(uint8_t slots, int8_t reference_slot, uint32_t sample_rate, float spacing_m, float steering_deg);
+  bool allocate(size_t frame_samples);
+  bool is_allocated() const { return this->history_buf_ != nullptr; }
+
+  uint8_t get_slots() const { return this->slots_; }
+  uint8_t get_mic_channels() const { return this->mics_; }
+  int8_t get_reference_slot() const { return this->reference_slot_; }
+  // Steering delay of a mic channel in samples
+  float get_delay(uint8_t mic) const { return this->delay_q15_[mic] / 32768.0f; }
+  size_t get_memory_bytes() const;
+
+  // interleaved: frame_samples * slots samples as read from I2S.
+  // out gets the beamformed mic frame; reference (may be nullptr) the loopback slot.
+  void process(const int16_t *interleaved, int16_t *out, int16_t *reference);
+
+ protected:
+  uint8_t slots_{1};
+  uint8_t mics_{1};
+  int8_t reference_slot_{-1};
+  // Which mic channel each slot feeds (-1: the reference slot)
+  int8_t slot_mic_[MAX_SLOTS]{};
+
+  // Per mic: delay in Q15 samples, split into whole samples and Q15 taps
+  uint32_t delay_q15_[MAX_SLOTS]{};
+  uint16_t delay_int_[MAX_SLOTS]{};
+  int32_t tap0_[MAX_SLOTS]{};
+  int32_t tap1_[MAX_SLOTS]{};
+
+  size_t frame_samples_{0};
+  size_t history_{0};  // Samples of the previous frame kept in front of each channel
+  int16_t *history_buf_{nullptr};  // mics_ * (history_ + frame_samples_)
+};
+
+}  // namespace i2s_audio_duplex
+}  // namespace esphome
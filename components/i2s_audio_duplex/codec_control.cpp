@@ -0,0 +1,99 @@
+#include "codec_control.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace esphome {
+namespace i2s_audio_duplex {
+
+// Linear amplitude -> dB (same curve as the software multiply it replaces)
+static float linear_to_db(float linear) { return 20.0f * log10f(linear); }
+
+static int clamp_int(int value, int lo, int hi) { return std::max(lo, std::min(hi, value)); }
+
+std::unique_ptr<CodecControl> CodecControl::create(CodecType type, CodecRegisterBus *bus) {
+  switch (type) {
+    case CodecType::ES8311:
+      return std::unique_ptr<CodecControl>(new ES8311Control(bus));
+    case CodecType::ES8388:
+      return std::unique_ptr<CodecControl>(new ES8388Control(bus));
+  }
+  return nullptr;
+}
+
+// ════════════════════════════════════════════════════════════════════
+// ES8311
+// ════════════════════════════════════════════════════════════════════
+
+// 0x00 = -95.5 dB, 0xBF = 0 dB, 0xFF = +32 dB
+static uint8_t es8311_volume_reg(float linear) {
+  if (linear <= 0.0f) {
+    return 0x00;
+  }
+  int steps = (int) lroundf(linear_to_db(linear) * 2.0f);
+  return (uint8_t) clamp_int(0xBF + steps, 0x01, 0xFF);
+}
+
+bool ES8311Control::set_speaker_volume(float volume) {
+  return this->bus_->write_register(REG_DAC_VOLUME, es8311_volume_reg(volume));
+}
+
+bool ES8311Control::set_mic_gain(float gain) {
+  return this->bus_->write_register(REG_ADC_VOLUME, es8311_volume_reg(gain));
+}
+
+// ════════════════════════════════════════════════════════════════════
+// ES8388
+// ════════════════════════════════════════════════════════════════════
+
+static const int ES8388_MAX_ATTENUATION = 192;  // -96 dB
+static const int ES8388_MAX_PGA = 8;            // +24 dB
+
+// Attenuation register: 0 = 0 dB, each step -0.5 dB
+static uint8_t es8388_attenuation_reg(float db) {
+  return (uint8_t) clamp_int((int) lroundf(-db * 2.0f), 0, ES8388_MAX_ATTENUATION);
+}
+
+bool ES8388Control::init() {
+  uint8_t pga;
+  if (!this->bus_->read_register(REG_ADC_PGA, &pga)) {
+    return false;
+  }
+  this->base_pga_l_ = std::min<uint8_t>(pga >> 4, ES8388_MAX_PGA);
+  this->base_pga_r_ = std::min<uint8_t>(pga & 0x0F, ES8388_MAX_PGA);
+  return true;
+}
+
+bool ES8388Control::set_speaker_volume(float volume) {
+  uint8_t att = volume <= 0.0f ? ES8388_MAX_ATTENUATION : es8388_attenuation_reg(linear_to_db(volume));
+  return this->bus_->write_register(REG_DAC_VOLUME_L, att) && this->bus_->write_register(REG_DAC_VOLUME_R, att);
+}
+
+void ES8388Control::channel_gain_(uint8_t base_pga, float db, uint8_t *pga, uint8_t *att) const {
+  // Boost comes from the PGA in 3 dB steps, the ADC attenuator trims the excess
+  int steps = base_pga;
+  if (db > 0.0f) {
+    steps = clamp_int(base_pga + (int) ceilf(db / 3.0f), 0, ES8388_MAX_PGA);
+  }
+  *pga = (uint8_t) steps;
+  *att = es8388_attenuation_reg(db - (steps - base_pga) * 3.0f);
+}
+
+bool ES8388Control::set_mic_gain(float gain) {
+  uint8_t pga_l = this->base_pga_l_;
+  uint8_t pga_r = this->base_pga_r_;
+  uint8_t att_l = ES8388_MAX_ATTENUATION;
+  uint8_t att_r = ES8388_MAX_ATTENUATION;
+  if (gain > 0.0f) {
+    float db = linear_to_db(gain);
+    this->channel_gain_(this->base_pga_l_, db, &pga_l, &att_l);
+    this->channel_gain_(this->base_pga_r_, db, &pga_r, &att_r);
+  }
+
+  uint8_t pga_reg = (uint8_t) ((pga_l << 4) | pga_r);
+  return this->bus_->write_register(REG_ADC_PGA, pga_reg) && this->bus_->write_register(REG_ADC_VOLUME_L, att_l) &&
+         this->bus_->write_register(REG_ADC_VOLUME_R, att_r);
+}
+
+}  // namespace i2s_audio_duplex
+}  // namespace esphome
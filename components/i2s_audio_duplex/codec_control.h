@@ -0,0 +1,89 @@
+#pragma once
+
+// Register-level volume/gain control for ES83xx-class codecs.
+// Deliberately free of ESPHome/ESP-IDF headers so it can be compiled on the
+// host against a fake register bus.
+
+#include <cstdint>
+#include <memory>
+
+namespace esphome {
+namespace i2s_audio_duplex {
+
+enum class CodecType : uint8_t {
+  ES8311,
+  ES8388,
+};
+
+// Minimal register access used by the codec drivers below.
+// On device this is backed by I2C (see codec_i2c.h), on host by a fake.
+class CodecRegisterBus {
+ public:
+  virtual ~CodecRegisterBus() = default;
+  virtual bool write_register(uint8_t reg, uint8_t value) = 0;
+  virtual bool read_register(uint8_t reg, uint8_t *value) = 0;
+};
+
+class CodecControl {
+ public:
+  explicit CodecControl(CodecRegisterBus *bus) : bus_(bus) {}
+  virtual ~CodecControl() = default;
+
+  static std::unique_ptr<CodecControl> create(CodecType type, CodecRegisterBus *bus);
+
+  // Read any baseline state from the codec. Returns false if the codec does not respond.
+  virtual bool init() { return true; }
+
+  // Same scales as I2SAudioDuplex: volume 0.0-1.0, gain 0.0-2.0 (1.0 = 0 dB).
+  // Returns false on bus error; caller falls back to software scaling.
+  virtual bool set_speaker_volume(float volume) = 0;
+  virtual bool set_mic_gain(float gain) = 0;
+
+  virtual const char *get_name() const = 0;
+
+ protected:
+  CodecRegisterBus *bus_;
+};
+
+// ES8311: DAC/ADC digital volume registers, 0.5 dB/step, 0xBF = 0 dB
+class ES8311Control : public CodecControl {
+ public:
+  using CodecControl::CodecControl;
+
+  static constexpr uint8_t REG_ADC_VOLUME = 0x17;
+  static constexpr uint8_t REG_DAC_VOLUME = 0x32;
+
+  bool set_speaker_volume(float volume) override;
+  bool set_mic_gain(float gain) override;
+  const char *get_name() const override { return "ES8311"; }
+};
+
+// ES8388: DAC/ADC attenuation registers (0.5 dB/step, 0 = 0 dB) plus the
+// mic PGA (3 dB/step, left channel in the high nibble) for boost. Each
+// channel's PGA setting found at init() is kept as its 0 dB baseline so codec
+// init done elsewhere is preserved.
+class ES8388Control : public CodecControl {
+ public:
+  using CodecControl::CodecControl;
+
+  static constexpr uint8_t REG_ADC_PGA = 0x09;
+  static constexpr uint8_t REG_ADC_VOLUME_L = 0x10;
+  static constexpr uint8_t REG_ADC_VOLUME_R = 0x11;
+  static constexpr uint8_t REG_DAC_VOLUME_L = 0x1A;
+  static constexpr uint8_t REG_DAC_VOLUME_R = 0x1B;
+
+  bool init() override;
+  bool set_speaker_volume(float volume) override;
+  bool set_mic_gain(float gain) override;
+  const char *get_name() const override { return "ES8388"; }
+
+ protected:
+  // PGA step (0-8) and attenuation for one channel at the requested gain
+  void channel_gain_(uint8_t base_pga, float db, uint8_t *pga, uint8_t *att) const;
+
+  uint8_t base_pga_l_{0};  // PGA steps (0-8) at init
+  uint8_t base_pga_r_{0};
+};
+
+}  // namespace i2s_audio_duplex
+}  // namespace esphome
@@ -0,0 +1,21 @@
+#pragma once
+
+#ifdef USE_I2C
+
+#include "esphome/components/i2c/i2c.h"
+#include "codec_control.h"
+
+namespace esphome {
+namespace i2s_audio_duplex {
+
+// CodecRegisterBus over ESPHome's I2C bus (8-bit register addresses)
+class CodecI2CBus : public CodecRegisterBus, public i2c::I2CDevice {
+ public:
+  bool write_register(uint8_t reg, uint8_t value) override { return this->write_byte(reg, value); }
+  bool read_register(uint8_t reg, uint8_t *value) override { return this->read_byte(reg, value); }
+};
+
+}  // namespace i2s_audio_duplex
+}  // namespace esphome
+
+#endif  // USE_I2C
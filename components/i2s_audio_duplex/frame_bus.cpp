@@ -0,0 +1,176 @@
+#include "frame_bus.h"
+
+#ifdef USE_ESP32
+
+#include "esphome/core/log.h"
+
+#include <esp_heap_caps.h>
+
+namespace esphome {
+namespace i2s_audio_duplex {
+
+static const char *const TAG = "i2s_audio_duplex.bus";
+
+// Frames the publisher itself may hold (one in flight + one spare)
+static const size_t PUBLISHER_SLOTS = 2;
+
+// ════════════════════════════════════════════════════════════════════
+// FrameSubscription
+// ════════════════════════════════════════════════════════════════════
+
+FrameSlot *FrameSubscription::receive(TickType_t ticks_to_wait) {
+  FrameSlot *slot = nullptr;
+  if (xQueueReceive(this->queue_, &slot, ticks_to_wait) != pdTRUE) {
+    return nullptr;
+  }
+  return slot;
+}
+
+void FrameSubscription::release(FrameSlot *slot) { this->bus_->release(slot); }
+
+void FrameSubscription::set_active(bool active) {
+  if (active) {
+    // A publish() racing the last deactivation may have queued a frame after
+    // its drain; don't hand that stale frame to the new session
+    this->drain_();
+  }
+  this->active_.store(active, std::memory_order_release);
+  if (!active) {
+    this->drain_();
+  }
+}
+
+void FrameSubscription::drain_() {
+  FrameSlot *slot = nullptr;
+  while (xQueueReceive(this->queue_, &slot, 0) == pdTRUE) {
+    this->bus_->release(slot);
+  }
+}
+
+// ════════════════════════════════════════════════════════════════════
+// FrameBus
+// ════════════════════════════════════════════════════════════════════
+
+FrameSubscription *FrameBus::subscribe(size_t max_lag, DropPolicy policy) {
+  if (this->is_allocated()) {
+    ESP_LOGE(TAG, "Cannot subscribe after the frame pool is allocated");
+    return nullptr;
+  }
+  if (max_lag == 0) {
+    max_lag = 1;
+  }
+
+  std::unique_ptr<FrameSubscription> sub(new FrameSubscription());
+  sub->queue_ = xQueueCreate(max_lag, sizeof(FrameSlot *));
+  if (sub->queue_ == nullptr) {
+    ESP_LOGE(TAG, "Failed to create subscriber queue");
+    return nullptr;
+  }
+  sub->bus_ = this;
+  sub->max_lag_ = max_lag;
+  sub->policy_ = policy;
+
+  FrameSubscription *ptr = sub.get();
+  this->subscriptions_.push_back(std::move(sub));
+  return ptr;
+}
+
+bool FrameBus::allocate(size_t frame_samples) {
+  if (this->is_allocated()) {
+    return true;
+  }
+
+  // Worst case every subscriber holds max_lag frames plus one being processed
+  size_t slots = PUBLISHER_SLOTS;
+  for (auto &sub : this->subscriptions_) {
+    slots += sub->max_lag_ + 1;
+  }
+
+  size_t frame_bytes = frame_samples * sizeof(int16_t);
+  auto *memory = (int16_t *) heap_caps_malloc(slots * frame_bytes, MALLOC_CAP_INTERNAL);
+  if (memory == nullptr) {
+    ESP_LOGE(TAG, "Failed to allocate frame pool (%zu slots)", slots);
+    return false;
+  }
+
+  this->pool_.reset(new FrameSlot[slots]);
+  for (size_t i = 0; i < slots; i++) {
+    this->pool_[i].data = memory + i * frame_samples;
+    this->pool_[i].samples = frame_samples;
+  }
+  this->pool_size_ = slots;
+
+  ESP_LOGI(TAG, "Frame bus: %zu subscribers, %zu slots (%zu bytes)", this->subscriptions_.size(), slots,
+           slots * frame_bytes);
+  return true;
+}
+
+FrameSlot *FrameBus::acquire() {
+  if (this->pool_ == nullptr) {
+    return nullptr;
+  }
+
+  // Only the audio task moves a slot from 0 to 1 reference, so load+store is race-free
+  for (size_t n = 0; n < this->pool_size_; n++) {
+    size_t i = (this->next_slot_ + n) % this->pool_size_;
+    FrameSlot &slot = this->pool_[i];
+    if (slot.refs.load(std::memory_order_acquire) == 0) {
+      slot.refs.store(1, std::memory_order_relaxed);
+      this->next_slot_ = (i + 1) % this->pool_size_;
+      return &slot;
+    }
+  }
+
+  this->overruns_.fetch_add(1, std::memory_order_relaxed);
+  return nullptr;
+}
+
+void FrameBus::publish(FrameSlot *slot) {
+  slot->sequence = this->sequence_++;
+
+  for (auto &sub : this->subscriptions_) {
+    if (!sub->is_active()) {
+      continue;
+    }
+
+    slot->refs.fetch_add(1, std::memory_order_acq_rel);
+    if (xQueueSend(sub->queue_, &slot, 0) == pdTRUE) {
+      // Deactivated between the check and the send: its drain may already
+      // have run, so take the frame back rather than pin a pool slot
+      if (!sub->is_active()) {
+        sub->drain_();
+      }
+      continue;
+    }
+
+    // Subscriber is max_lag frames behind
+    sub->dropped_.fetch_add(1, std::memory_order_relaxed);
+    if (sub->policy_ == DropPolicy::DROP_OLDEST) {
+      FrameSlot *oldest = nullptr;
+      if (xQueueReceive(sub->queue_, &oldest, 0) == pdTRUE) {
+        this->release(oldest);
+      }
+      if (xQueueSend(sub->queue_, &slot, 0) == pdTRUE) {
+        if (!sub->is_active()) {
+          sub->drain_();
+        }
+        continue;
+      }
+    }
+    this->release(slot);
+  }
+
+  // Drop the publisher's own reference
+  this->release(slot);
+}
+
+void FrameBus::release(FrameSlot *slot) {
+  if (slot != nullptr) {
+    slot->refs.fetch_sub(1, std::memory_order_acq_rel);
+  }
+}
+
+}  // namespace i2s_audio_duplex
+}  // namespace esphome
+
+#endif  // USE_ESP32
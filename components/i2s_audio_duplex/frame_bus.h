@@ -0,0 +1,102 @@
+#pragma once
+
+#ifdef USE_ESP32
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace esphome {
+namespace i2s_audio_duplex {
+
+// What a subscriber loses when it falls behind its lag tolerance
+enum class DropPolicy : uint8_t {
+  DROP_OLDEST,  // Keep the newest audio (wake word, live streaming)
+  DROP_NEWEST,  // Keep continuity of what is already queued (recording)
+};
+
+// One processed mic frame in the shared pool. The audio task writes it once;
+// subscribers get a pointer to the same memory and hand it back with release().
+struct FrameSlot {
+  int16_t *data{nullptr};
+  size_t samples{0};
+  uint32_t sequence{0};
+  int64_t timestamp_us{0};  // Capture time (esp_timer)
+  std::atomic<uint8_t> refs{0};
+};
+
+class FrameBus;
+
+class FrameSubscription {
+ public:
+  // Next frame, or nullptr on timeout. Must be returned via release().
+  FrameSlot *receive(TickType_t ticks_to_wait);
+  void release(FrameSlot *slot);
+
+  // Inactive subscriptions are skipped by publish() and cost nothing
+  void set_active(bool active);
+  bool is_active() const { return this->active_.load(std::memory_order_acquire); }
+
+  uint32_t get_dropped() const { return this->dropped_.load(std::memory_order_relaxed); }
+  size_t get_max_lag() const { return this->max_lag_; }
+
+ protected:
+  friend class FrameBus;
+  void drain_();
+
+  FrameBus *bus_{nullptr};
+  QueueHandle_t queue_{nullptr};
+  size_t max_lag_{0};
+  DropPolicy policy_{DropPolicy::DROP_OLDEST};
+  std::atomic<bool> active_{false};
+  std::atomic<uint32_t> dropped_{0};
+};
+
+// Reference-counted, fixed-pool frame fan-out from the I2S task.
+// The publisher never blocks: if a subscriber queue is full its drop policy
+// applies, and if the pool is exhausted the frame simply isn't published.
+class FrameBus {
+ public:
+  // Setup-time only (before allocate()). max_lag is in frames.
+  FrameSubscription *subscribe(size_t max_lag, DropPolicy policy);
+  bool has_subscribers() const { return !this->subscriptions_.empty(); }
+  size_t get_subscriber_count() const { return this->subscriptions_.size(); }
+  bool has_active_subscribers() const {
+    for (const auto &sub : this->subscriptions_) {
+      if (sub->is_active())
+        return true;
+    }
+    return false;
+  }
+
+  // Allocate the pool once, sized so every subscriber can hold max_lag frames
+  bool allocate(size_t frame_samples);
+  bool is_allocated() const { return this->pool_ != nullptr; }
+
+  // Audio task side
+  FrameSlot *acquire();
+  void publish(FrameSlot *slot);
+  void release(FrameSlot *slot);
+
+  uint32_t get_overruns() const { return this->overruns_.load(std::memory_order_relaxed); }
+  uint32_t get_published() const { return this->sequence_; }
+  size_t get_pool_size() const { return this->pool_size_; }
+
+ protected:
+  std::vector<std::unique_ptr<FrameSubscription>> subscriptions_;
+  std::unique_ptr<FrameSlot[]> pool_;
+  size_t pool_size_{0};
+  size_t next_slot_{0};
+  uint32_t sequence_{0};
+  std::atomic<uint32_t> overruns_{0};  // Frames not published: every slot still referenced
+};
+
+}  // namespace i2s_audio_duplex
+}  // namespace esphome
+
+#endif  // USE_ESP32
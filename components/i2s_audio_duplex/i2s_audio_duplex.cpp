@@ -4,6 +4,15 @@
 
 #include "esphome/core/log.h"
 #include "esphome/core/application.h"
+#include "esphome/core/hal.h"
+#include "esphome/core/helpers.h"
+
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 
 #ifdef USE_ESP_AEC
 #include "../esp_aec/esp_aec.h"
@@ -14,21 +23,64 @@ namespace i2s_audio_duplex {
 
 static const char *const TAG = "i2s_audio_duplex";
 
-// Audio parameters
-static const size_t DMA_BUFFER_COUNT = 8;
-static const size_t DMA_BUFFER_SIZE = 512;
-static const size_t FRAME_SIZE = 256;  // samples per frame
+// Audio parameters (DMA geometry and speaker buffer depth are configurable, see the header)
+static const size_t DMA_BUFFER_MAX_BYTES = 4092;  // Per descriptor, limits frames when many slots are captured
+static const size_t FRAME_SIZE = I2S_AUDIO_DUPLEX_FRAME_SAMPLES;  // samples per frame
 static const size_t FRAME_BYTES = FRAME_SIZE * sizeof(int16_t);
-static const size_t SPEAKER_BUFFER_SIZE = 8192;
+static const size_t REF_BUFFER_SIZE = 8192;
 
 // I2S new driver uses milliseconds directly, NOT FreeRTOS ticks
 static const uint32_t I2S_IO_TIMEOUT_MS = 50;
 
+// Loopback calibration: lags correlated per loop() pass (~2k adds each), and how
+// long the sequence may take to come back before the run is abandoned
+static const size_t CALIBRATION_LAGS_PER_LOOP = 32;
+static const uint32_t CALIBRATION_TIMEOUT_MS = 5000;
+// The software AEC reference is held back to arrive this much ahead of its echo;
+// the echo canceller's filter spans several frames, an early reference is
+// cancelled but a late one is not
+static const size_t AEC_REF_LEAD_SAMPLES = FRAME_SIZE / 2;
+
+// Loopback calibration as stored in flash; only valid for the DMA ring it was measured with
+struct LoopbackRecord {
+  uint32_t sample_rate;
+  uint16_t dma_buffer_count;
+  uint16_t dma_buffer_size;
+  float delay_samples;
+  float gain_db;
+};
+
+// Smoothed (1/16 EWMA) CPU cycles since start
+static void record_cycles(std::atomic<uint32_t> &avg_q4, uint32_t start) {
+  uint32_t cycles = arch_get_cpu_cycle_count() - start;
+  uint32_t avg = avg_q4.load(std::memory_order_relaxed);
+  avg += cycles - ((avg + 8) >> 4);
+  avg_q4.store(avg, std::memory_order_relaxed);
+}
+
+// 32-bit capture to the int16 frame: gain (Q12) on the full-width sample, then
+// one rounding with +-1 LSB TPDF dither
+static void narrow_wide_capture(const int32_t *in, int16_t *out, size_t samples, int32_t gain_q12,
+                                uint32_t &dither_state) {
+  uint32_t state = dither_state;
+  for (size_t i = 0; i < samples; i++) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    int64_t dither = (int64_t) (state & 0xFFFF) + (int64_t) (state >> 16) - 0xFFFF;
+    int64_t value = ((int64_t) in[i] * gain_q12 + (dither << 12) + (1 << 27)) >> 28;
+    if (value > 32767) value = 32767;
+    if (value < -32768) value = -32768;
+    out[i] = (int16_t) value;
+  }
+  dither_state = state;
+}
+
 void I2SAudioDuplex::setup() {
   ESP_LOGCONFIG(TAG, "Setting up I2S Audio Duplex...");
 
   // Create speaker ring buffer
-  this->speaker_buffer_ = RingBuffer::create(SPEAKER_BUFFER_SIZE);
+  this->speaker_buffer_ = RingBuffer::create(this->speaker_buffer_size_);
   if (!this->speaker_buffer_) {
     ESP_LOGE(TAG, "Failed to create speaker ring buffer");
     this->mark_failed();
@@ -37,14 +89,58 @@ void I2SAudioDuplex::setup() {
 
   // Note: speaker_ref_buffer_ for AEC is created in set_aec() which is called after setup()
 
+  // Loopback calibration from an earlier run
+  this->loopback_pref_ = global_preferences->make_preference<LoopbackRecord>(fnv1_hash("i2s_audio_duplex_loopback"), true);
+  LoopbackRecord record{};
+  if (this->loopback_pref_.load(&record)) {
+    if (record.sample_rate == this->sample_rate_ && record.dma_buffer_count == this->dma_buffer_count_ &&
+        record.dma_buffer_size == this->dma_buffer_size_) {
+      this->has_loopback_ = true;
+      this->loopback_delay_samples_ = record.delay_samples;
+      this->echo_path_gain_db_ = record.gain_db;
+    } else {
+      ESP_LOGW(TAG, "Stored loopback calibration is for another sample rate or DMA ring, run calibrate again");
+    }
+  }
+
+  // Mic array: steering delays and per-channel history, allocated once
+  if (this->slot_mode_ != SlotMode::MONO) {
+    if (!this->beamformer_.configure(this->mic_slots_, this->reference_slot_, this->sample_rate_,
+                                     this->mic_spacing_, this->steering_angle_) ||
+        !this->beamformer_.allocate(FRAME_SIZE)) {
+      ESP_LOGE(TAG, "Failed to set up the mic array");
+      this->mark_failed();
+      return;
+    }
+  }
+
+  // Map prompt partition (no RAM cost beyond the asset table)
+  if (this->prompt_player_ != nullptr && !this->prompt_player_->setup(this->sample_rate_)) {
+    ESP_LOGW(TAG, "Prompt playback disabled");
+    this->prompt_player_.reset();
+  }
+
+  // Push initial volume/gain to the codec (I2C bus is set up before HARDWARE priority)
+  if (this->codec_ != nullptr) {
+    if (this->codec_->init()) {
+      this->set_speaker_volume(this->speaker_volume_);
+      this->set_mic_gain(this->mic_gain_);
+    } else {
+      ESP_LOGW(TAG, "%s not responding, using software volume", this->codec_->get_name());
+      this->codec_.reset();
+    }
+  }
+
   ESP_LOGI(TAG, "I2S Audio Duplex ready");
 }
 
 void I2SAudioDuplex::set_aec(esp_aec::EspAec *aec) {
   this->aec_ = aec;
-  // Create speaker reference buffer for AEC now (since set_aec is called after setup)
-  if (aec != nullptr && !this->speaker_ref_buffer_) {
-    this->speaker_ref_buffer_ = RingBuffer::create(SPEAKER_BUFFER_SIZE);
+  // Create speaker reference buffer for AEC now (since set_aec is called after setup).
+  // A hardware loopback slot makes it unnecessary.
+  if (aec != nullptr && !this->speaker_ref_buffer_ && !this->has_hw_reference()) {
+    this->speaker_ref_buffer_ = RingBuffer::create(REF_BUFFER_SIZE);
+    this->speaker_ref_size_ = REF_BUFFER_SIZE;
     if (this->speaker_ref_buffer_) {
       ESP_LOGI(TAG, "AEC speaker reference buffer created");
     } else {
@@ -53,6 +149,68 @@ void I2SAudioDuplex::set_aec(esp_aec::EspAec *aec) {
   }
 }
 
+void I2SAudioDuplex::set_prompt_partition(const std::string &label) {
+  if (this->prompt_player_ == nullptr) {
+    this->prompt_player_.reset(new PromptPlayer());
+  }
+  this->prompt_player_->set_partition(label);
+}
+
+void I2SAudioDuplex::set_prompt_duck_level(float level) {
+  if (this->prompt_player_ != nullptr) {
+    this->prompt_player_->set_duck_level(level);
+  }
+}
+
+void I2SAudioDuplex::add_prompt(const std::string &name, uint32_t offset) {
+  if (this->prompt_player_ != nullptr) {
+    this->prompt_player_->add_prompt(name, offset);
+  }
+}
+
+bool I2SAudioDuplex::play_prompt(const std::string &name, bool loop) {
+  if (this->prompt_player_ == nullptr || !this->prompt_player_->play(name, loop)) {
+    return false;
+  }
+  // Prompts (e.g. ringtone) may play before any call owns the bus
+  if (!this->duplex_running_) {
+    this->start();
+  }
+  return true;
+}
+
+void I2SAudioDuplex::stop_prompt() {
+  if (this->prompt_player_ != nullptr) {
+    this->prompt_player_->stop();
+  }
+}
+
+void I2SAudioDuplex::set_mic_gain(float gain) {
+  this->mic_gain_ = gain;
+  bool hw = this->codec_ != nullptr && this->codec_->set_mic_gain(gain);
+  if (this->codec_ != nullptr && !hw) {
+    ESP_LOGW(TAG, "Codec mic gain write failed, using software gain");
+  }
+  this->hw_mic_gain_.store(hw, std::memory_order_release);
+}
+
+void I2SAudioDuplex::set_speaker_volume(float volume) {
+  this->speaker_volume_ = volume;
+  bool hw = this->codec_ != nullptr && this->codec_->set_speaker_volume(volume);
+  if (this->codec_ != nullptr && !hw) {
+    ESP_LOGW(TAG, "Codec volume write failed, using software volume");
+  }
+  this->hw_speaker_volume_.store(hw, std::memory_order_release);
+}
+
+uint32_t I2SAudioDuplex::get_channel_cycles() const {
+  uint8_t slots = this->beamformer_.get_slots();
+  if (this->slot_mode_ == SlotMode::MONO || slots < 2) {
+    return 0;
+  }
+  return (this->array_cycles_q4_.load(std::memory_order_relaxed) >> 4) / (slots - 1);
+}
+
 void I2SAudioDuplex::dump_config() {
   ESP_LOGCONFIG(TAG, "I2S Audio Duplex:");
   ESP_LOGCONFIG(TAG, "  LRCLK Pin: %d", this->lrclk_pin_);
@@ -61,11 +219,163 @@ void I2SAudioDuplex::dump_config() {
   ESP_LOGCONFIG(TAG, "  DIN Pin: %d", this->din_pin_);
   ESP_LOGCONFIG(TAG, "  DOUT Pin: %d", this->dout_pin_);
   ESP_LOGCONFIG(TAG, "  Sample Rate: %d Hz", this->sample_rate_);
+  ESP_LOGCONFIG(TAG, "  Capture: %u-bit%s", this->bits_per_sample_,
+                this->bits_per_sample_ == 32 ? " (gain before AEC, dithered to 16-bit)" : "");
+  ESP_LOGCONFIG(TAG, "  Frame: %zu samples (%u ms)", FRAME_SIZE, (unsigned) (FRAME_SIZE * 1000 / this->sample_rate_));
+  ESP_LOGCONFIG(TAG, "  DMA: %u x %u samples (%u ms per direction)", (unsigned) this->dma_buffer_count_,
+                (unsigned) (this->dma_frames_ != 0 ? this->dma_frames_ : this->dma_buffer_size_),
+                (unsigned) (this->get_playback_dma_us() / 1000));
+  ESP_LOGCONFIG(TAG, "  Speaker Buffer: %zu bytes (%u ms)", this->speaker_buffer_size_,
+                (unsigned) (this->speaker_buffer_size_ * 1000 / (this->sample_rate_ * sizeof(int16_t))));
   ESP_LOGCONFIG(TAG, "  AEC: %s", this->aec_ != nullptr ? "enabled" : "disabled");
+  if (this->has_loopback_) {
+    ESP_LOGCONFIG(TAG, "  Loopback: %.2f ms, echo path gain %.1f dB (calibrated)", this->get_loopback_latency_ms(),
+                  this->echo_path_gain_db_);
+    if (this->speaker_ref_buffer_ != nullptr) {
+      ESP_LOGCONFIG(TAG, "    AEC reference delay: %zu samples", this->ref_delay_samples_());
+    }
+  }
+  if (this->slot_mode_ != SlotMode::MONO) {
+    ESP_LOGCONFIG(TAG, "  Mic Array: %s, %u slots, %u mic(s)", this->slot_mode_ == SlotMode::TDM ? "TDM" : "stereo",
+                  this->mic_slots_, this->beamformer_.get_mic_channels());
+    if (this->reference_slot_ >= 0) {
+      ESP_LOGCONFIG(TAG, "    AEC reference: slot %d (hardware loopback)", this->reference_slot_);
+    }
+    if (this->beamformer_.get_mic_channels() > 1) {
+      ESP_LOGCONFIG(TAG, "    Beamformer: %.0f mm spacing, steered %.0f deg, %zu bytes", this->mic_spacing_ * 1000.0f,
+                    this->steering_angle_, this->beamformer_.get_memory_bytes());
+      for (uint8_t m = 0; m < this->beamformer_.get_mic_channels(); m++) {
+        ESP_LOGCONFIG(TAG, "    Mic %u delay: %.2f samples", m, this->beamformer_.get_delay(m));
+      }
+    }
+  }
+  ESP_LOGCONFIG(TAG, "  Frame Bus Subscribers: %zu", this->frame_bus_.get_subscriber_count());
+  if (this->prompt_player_ != nullptr) {
+    ESP_LOGCONFIG(TAG, "  Prompts: partition '%s'", this->prompt_player_->get_partition_label().c_str());
+    for (const auto &prompt : this->prompt_player_->get_prompts()) {
+      ESP_LOGCONFIG(TAG, "    %s @0x%06x: %s, %zu bytes", prompt.name.c_str(), (unsigned) prompt.offset,
+                    !prompt.valid ? "INVALID" : (prompt.format == PromptFormat::PCM16 ? "PCM16" : "IMA-ADPCM"),
+                    prompt.size);
+    }
+  }
+  if (this->codec_ != nullptr) {
+    ESP_LOGCONFIG(TAG, "  Codec Control: %s (volume: %s, mic gain: %s)", this->codec_->get_name(),
+                  this->hw_speaker_volume_ ? "hardware" : "software",
+                  this->hw_mic_gain_ ? "hardware" : "software");
+  } else {
+    ESP_LOGCONFIG(TAG, "  Codec Control: none (software volume)");
+  }
 }
 
 void I2SAudioDuplex::loop() {
-  // Main loop - nothing needed, audio runs in separate task
+  // Audio runs in its own task; the main loop only finishes a loopback calibration
+  if (this->calibrator_.is_active()) {
+    this->calibration_loop_();
+  }
+}
+
+bool I2SAudioDuplex::start_calibration(float level) {
+  if (this->calibrator_.is_active()) {
+    ESP_LOGW(TAG, "Loopback calibration already running");
+    return false;
+  }
+  if (this->din_pin_ < 0 || this->dout_pin_ < 0) {
+    ESP_LOGW(TAG, "Loopback calibration needs both a speaker and a mic");
+    return false;
+  }
+  // Search both DMA rings, a few frames of task scheduling and 100 ms of acoustic path
+  size_t ring = (size_t) this->dma_buffer_count_ * this->dma_buffer_size_;
+  size_t max_lag = 2 * ring + 2 * FRAME_SIZE + this->sample_rate_ / 10;
+  level = std::max(0.0f, std::min(1.0f, level));
+  if (!this->calibrator_.begin(max_lag, (int16_t) lroundf(level * 32767.0f))) {
+    ESP_LOGE(TAG, "Not enough memory for loopback calibration");
+    return false;
+  }
+  ESP_LOGI(TAG, "Loopback calibration: %u ms sequence at %.0f%%, searching up to %u ms",
+           (unsigned) (LoopbackCalibrator::MLS_LENGTH * 1000 / this->sample_rate_), level * 100.0f,
+           (unsigned) (max_lag * 1000 / this->sample_rate_));
+
+  this->calibration_start_ms_ = millis();
+  this->calibration_stop_after_ = !this->duplex_running_;
+  this->calibration_state_.store(CalibrationState::RUNNING, std::memory_order_release);
+  if (!this->duplex_running_) {
+    this->start();
+  }
+  return true;
+}
+
+void I2SAudioDuplex::calibration_loop_() {
+  CalibrationState state = this->calibration_state_.load(std::memory_order_acquire);
+  switch (state) {
+    case CalibrationState::RUNNING: {
+      if (this->duplex_running_ && millis() - this->calibration_start_ms_ < CALIBRATION_TIMEOUT_MS) {
+        return;
+      }
+      ESP_LOGW(TAG, "Loopback calibration abandoned, the mic recording did not complete");
+      // Fails if the audio task just finished the recording; analyze it then
+      this->calibration_state_.compare_exchange_strong(state, CalibrationState::ABORT, std::memory_order_acq_rel);
+      return;
+    }
+    case CalibrationState::ABORT:
+      // The audio task may still be using the calibrator until it answers
+      if (this->duplex_running_) {
+        return;
+      }
+      this->calibration_state_.store(CalibrationState::IDLE, std::memory_order_release);
+      this->finish_calibration_();
+      return;
+    case CalibrationState::IDLE:
+      this->finish_calibration_();
+      return;
+    case CalibrationState::CAPTURED:
+      break;
+  }
+
+  if (!this->calibrator_.analyze(CALIBRATION_LAGS_PER_LOOP)) {
+    return;
+  }
+  const LoopbackResult &r = this->calibrator_.get_result();
+  if (!r.valid) {
+    ESP_LOGW(TAG, "Loopback calibration failed: peak only %.1f dB above the noise (speaker muted, or too quiet?)",
+             r.peak_to_noise_db);
+  } else {
+    ESP_LOGI(TAG, "Loopback: %.2f ms (%.1f samples), echo path gain %.1f dB, peak %.1f dB above the noise%s",
+             r.delay_samples * 1000.0f / this->sample_rate_, r.delay_samples, r.gain_db, r.peak_to_noise_db,
+             r.inverted ? ", polarity inverted" : "");
+    this->has_loopback_ = true;
+    this->loopback_delay_samples_ = r.delay_samples;
+    this->echo_path_gain_db_ = r.gain_db;
+    LoopbackRecord record{this->sample_rate_, this->dma_buffer_count_, this->dma_buffer_size_, r.delay_samples,
+                          r.gain_db};
+    if (!this->loopback_pref_.save(&record) || !global_preferences->sync()) {
+      ESP_LOGW(TAG, "Failed to store the loopback calibration");
+    }
+    if (this->speaker_ref_buffer_ != nullptr && !this->calibration_stop_after_) {
+      ESP_LOGI(TAG, "AEC reference delay takes effect on the next start");
+    }
+  }
+  this->calibration_state_.store(CalibrationState::IDLE, std::memory_order_release);
+  this->finish_calibration_();
+}
+
+void I2SAudioDuplex::finish_calibration_() {
+  this->calibrator_.end();
+  if (this->calibration_stop_after_) {
+    this->calibration_stop_after_ = false;
+    this->stop();
+  }
+}
+
+float I2SAudioDuplex::get_loopback_latency_ms() const {
+  return this->has_loopback_ ? this->loopback_delay_samples_ * 1000.0f / this->sample_rate_ : NAN;
+}
+
+size_t I2SAudioDuplex::ref_delay_samples_() const {
+  if (!this->has_loopback_) {
+    return 0;
+  }
+  long delay = lroundf(this->loopback_delay_samples_) - (long) AEC_REF_LEAD_SAMPLES;
+  return delay > 0 ? (size_t) delay : 0;
 }
 
 bool I2SAudioDuplex::init_i2s_duplex_() {
@@ -79,12 +389,18 @@ bool I2SAudioDuplex::init_i2s_duplex_() {
     return false;
   }
 
+  // Every captured slot widens a DMA frame; keep each descriptor under the size limit
+  size_t slots = this->slot_mode_ == SlotMode::MONO ? 1 : this->mic_slots_;
+  size_t slot_bytes = this->bits_per_sample_ / 8;
+  uint32_t dma_frames = (uint32_t) std::min<size_t>(this->dma_buffer_size_, DMA_BUFFER_MAX_BYTES / (slots * slot_bytes));
+  this->dma_frames_ = dma_frames;
+
   // Channel configuration
   i2s_chan_config_t chan_cfg = {
       .id = I2S_NUM_0,
       .role = I2S_ROLE_MASTER,
-      .dma_desc_num = DMA_BUFFER_COUNT,
-      .dma_frame_num = DMA_BUFFER_SIZE,
+      .dma_desc_num = this->dma_buffer_count_,
+      .dma_frame_num = dma_frames,
       .auto_clear_after_cb = true,
       .auto_clear_before_cb = false,
       .intr_priority = 0,
@@ -134,26 +450,47 @@ bool I2SAudioDuplex::init_i2s_duplex_() {
   // Set slot mask to left channel
   std_cfg.slot_cfg.slot_mask = I2S_STD_SLOT_LEFT;
 
-  // Initialize TX channel if available
-  if (this->tx_handle_) {
-    err = i2s_channel_init_std_mode(this->tx_handle_, &std_cfg);
-    if (err != ESP_OK) {
-      ESP_LOGE(TAG, "Failed to init TX channel: %s", esp_err_to_name(err));
-      this->deinit_i2s_();
-      return false;
-    }
-    ESP_LOGD(TAG, "TX channel initialized");
+  // Wide capture: 32-bit slots on the bus, 16-bit speaker data padded into them
+  if (this->bits_per_sample_ == 32) {
+    std_cfg.slot_cfg.slot_bit_width = I2S_SLOT_BIT_WIDTH_32BIT;
+    std_cfg.slot_cfg.ws_width = 32;
   }
 
-  // Initialize RX channel if available
-  if (this->rx_handle_) {
-    err = i2s_channel_init_std_mode(this->rx_handle_, &std_cfg);
-    if (err != ESP_OK) {
-      ESP_LOGE(TAG, "Failed to init RX channel: %s", esp_err_to_name(err));
+  if (this->slot_mode_ == SlotMode::TDM) {
+    if (!this->init_tdm_(std_cfg)) {
       this->deinit_i2s_();
       return false;
     }
-    ESP_LOGD(TAG, "RX channel initialized");
+  } else {
+    // Initialize TX channel if available (speaker stays mono on the left slot)
+    if (this->tx_handle_) {
+      err = i2s_channel_init_std_mode(this->tx_handle_, &std_cfg);
+      if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to init TX channel: %s", esp_err_to_name(err));
+        this->deinit_i2s_();
+        return false;
+      }
+      ESP_LOGD(TAG, "TX channel initialized");
+    }
+
+    // Initialize RX channel if available; a stereo array captures both slots
+    if (this->rx_handle_) {
+      i2s_std_config_t rx_cfg = std_cfg;
+      if (this->bits_per_sample_ == 32) {
+        rx_cfg.slot_cfg.data_bit_width = I2S_DATA_BIT_WIDTH_32BIT;
+      }
+      if (this->slot_mode_ == SlotMode::STEREO) {
+        rx_cfg.slot_cfg.slot_mode = I2S_SLOT_MODE_STEREO;
+        rx_cfg.slot_cfg.slot_mask = I2S_STD_SLOT_BOTH;
+      }
+      err = i2s_channel_init_std_mode(this->rx_handle_, &rx_cfg);
+      if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to init RX channel: %s", esp_err_to_name(err));
+        this->deinit_i2s_();
+        return false;
+      }
+      ESP_LOGD(TAG, "RX channel initialized");
+    }
   }
 
   // Enable channels with error checking
@@ -178,6 +515,56 @@ bool I2SAudioDuplex::init_i2s_duplex_() {
   return true;
 }
 
+bool I2SAudioDuplex::init_tdm_(const i2s_std_config_t &std_cfg) {
+#if SOC_I2S_SUPPORTS_TDM
+  // Same clock and pins as std mode; RX captures every slot, TX sends the mono
+  // speaker frame on slot 0 of an equally wide frame so both share BCLK/WS
+  i2s_tdm_config_t tdm_cfg = {
+      .clk_cfg = {
+          .sample_rate_hz = std_cfg.clk_cfg.sample_rate_hz,
+          .clk_src = std_cfg.clk_cfg.clk_src,
+          .mclk_multiple = std_cfg.clk_cfg.mclk_multiple,
+      },
+      .slot_cfg = I2S_TDM_PHILIPS_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_16BIT, I2S_SLOT_MODE_STEREO,
+                                                      (i2s_tdm_slot_mask_t) ((1u << this->mic_slots_) - 1)),
+      .gpio_cfg = {
+          .mclk = std_cfg.gpio_cfg.mclk,
+          .bclk = std_cfg.gpio_cfg.bclk,
+          .ws = std_cfg.gpio_cfg.ws,
+          .dout = std_cfg.gpio_cfg.dout,
+          .din = std_cfg.gpio_cfg.din,
+          .invert_flags = std_cfg.gpio_cfg.invert_flags,
+      },
+  };
+  tdm_cfg.slot_cfg.total_slot = this->mic_slots_;
+
+  esp_err_t err;
+  if (this->tx_handle_) {
+    i2s_tdm_config_t tx_cfg = tdm_cfg;
+    tx_cfg.slot_cfg.slot_mode = I2S_SLOT_MODE_MONO;
+    tx_cfg.slot_cfg.slot_mask = I2S_TDM_SLOT0;
+    err = i2s_channel_init_tdm_mode(this->tx_handle_, &tx_cfg);
+    if (err != ESP_OK) {
+      ESP_LOGE(TAG, "Failed to init TX channel (TDM): %s", esp_err_to_name(err));
+      return false;
+    }
+    ESP_LOGD(TAG, "TX channel initialized (TDM slot 0 of %u)", this->mic_slots_);
+  }
+  if (this->rx_handle_) {
+    err = i2s_channel_init_tdm_mode(this->rx_handle_, &tdm_cfg);
+    if (err != ESP_OK) {
+      ESP_LOGE(TAG, "Failed to init RX channel (TDM): %s", esp_err_to_name(err));
+      return false;
+    }
+    ESP_LOGD(TAG, "RX channel initialized (TDM, %u slots)", this->mic_slots_);
+  }
+  return true;
+#else
+  ESP_LOGE(TAG, "TDM is not supported on this chip");
+  return false;
+#endif
+}
+
 void I2SAudioDuplex::deinit_i2s_() {
   // Used for cleanup during init errors; stop() handles normal shutdown
   if (this->tx_handle_) {
@@ -204,6 +591,11 @@ void I2SAudioDuplex::start() {
 
   ESP_LOGI(TAG, "Starting duplex audio...");
 
+  // Frame pool is sized from the subscribers registered during setup; allocated once, kept across sessions
+  if (this->frame_bus_.has_subscribers() && !this->frame_bus_.allocate(FRAME_SIZE)) {
+    ESP_LOGW(TAG, "Frame bus disabled, only mic callbacks will receive audio");
+  }
+
   if (!this->init_i2s_duplex_()) {
     ESP_LOGE(TAG, "Failed to initialize I2S");
     return;
@@ -219,6 +611,31 @@ void I2SAudioDuplex::start() {
   // Clear speaker buffer
   this->speaker_buffer_->reset();
 
+  // Software AEC reference: each frame is queued as it is written to the TX DMA
+  // ring, so it would reach the AEC a whole loopback delay before its echo.
+  // Start the ring with that much silence (less a small lead) to line them up.
+  if (this->speaker_ref_buffer_ != nullptr) {
+    size_t delay_bytes = this->ref_delay_samples_() * sizeof(int16_t);
+    size_t needed = delay_bytes + 2 * FRAME_BYTES;
+    if (needed > this->speaker_ref_size_) {
+      auto grown = RingBuffer::create(needed);
+      if (grown) {
+        this->speaker_ref_buffer_ = std::move(grown);
+        this->speaker_ref_size_ = needed;
+      } else {
+        ESP_LOGW(TAG, "No memory to delay the AEC reference by %zu samples", this->ref_delay_samples_());
+        delay_bytes = this->speaker_ref_size_ - 2 * FRAME_BYTES;
+      }
+    }
+    this->speaker_ref_buffer_->reset();
+    static const int16_t SILENCE[FRAME_SIZE] = {};
+    while (delay_bytes > 0) {
+      size_t chunk = std::min(delay_bytes, FRAME_BYTES);
+      this->speaker_ref_buffer_->write_without_replacement((const void *) SILENCE, chunk, 0, true);
+      delay_bytes -= chunk;
+    }
+  }
+
   // Create audio task on core 1
   xTaskCreatePinnedToCore(
       audio_task,
@@ -312,17 +729,32 @@ size_t I2SAudioDuplex::play(const uint8_t *data, size_t len, TickType_t ticks_to
     return 0;
   }
 
-  // Store speaker data as reference for AEC (non-blocking, best effort)
-  if (this->speaker_ref_buffer_ != nullptr) {
-    this->speaker_ref_buffer_->write_without_replacement((void *) data, len, 0, true);
-  }
-
+  // AEC reference is written by the audio task from the final mixed frame (call audio + prompts)
   // Use write_without_replacement which properly supports timeout
   // This avoids the non-thread-safe free() call in regular write()
   // Note: RingBuffer timeout is in FreeRTOS ticks (NOT milliseconds)
   return this->speaker_buffer_->write_without_replacement((void *) data, len, ticks_to_wait, true);
 }
 
+size_t I2SAudioDuplex::get_speaker_buffered() const {
+  return this->speaker_buffer_ != nullptr ? this->speaker_buffer_->available() : 0;
+}
+
+uint32_t I2SAudioDuplex::get_playback_dma_us() const {
+  // The TX descriptors are kept full, so every one of them is queued ahead of a written frame
+  uint32_t frames = this->dma_frames_ != 0 ? this->dma_frames_ : this->dma_buffer_size_;
+  return (uint32_t) ((uint64_t) this->dma_buffer_count_ * frames * 1000000 / this->sample_rate_);
+}
+
+size_t I2SAudioDuplex::get_speaker_free() const {
+  // The audio task only drains this buffer, so with one writer the space can only grow before its write
+  return this->speaker_buffer_ != nullptr ? this->speaker_buffer_->free() : 0;
+}
+
+bool I2SAudioDuplex::has_buffered_speaker_data() const {
+  return this->speaker_buffer_ != nullptr && this->speaker_buffer_->available() > 0;
+}
+
 void I2SAudioDuplex::audio_task(void *param) {
   I2SAudioDuplex *self = static_cast<I2SAudioDuplex *>(param);
   self->audio_task_();
@@ -337,6 +769,19 @@ void I2SAudioDuplex::audio_task_() {
   int16_t *spk_buffer = (int16_t *) heap_caps_malloc(FRAME_BYTES, MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA);
   int16_t *spk_ref_buffer = nullptr;  // Speaker reference for AEC
   int16_t *aec_output = nullptr;      // AEC processed output
+  int16_t *slot_buffer = nullptr;     // Interleaved capture of every slot (mic array)
+  const bool array = this->slot_mode_ != SlotMode::MONO;
+  const size_t slot_bytes = FRAME_BYTES * this->beamformer_.get_slots();
+  if (array) {
+    slot_buffer = (int16_t *) heap_caps_malloc(slot_bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA);
+  }
+  int32_t *wide_buffer = nullptr;  // 32-bit capture before narrowing
+  const bool wide = this->bits_per_sample_ == 32;
+  const size_t wide_bytes = FRAME_SIZE * sizeof(int32_t);
+  if (wide) {
+    wide_buffer = (int32_t *) heap_caps_malloc(wide_bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA);
+  }
+  uint32_t dither_state = 0x12345678;
 
 #ifdef USE_ESP_AEC
   if (this->aec_ != nullptr) {
@@ -345,41 +790,102 @@ void I2SAudioDuplex::audio_task_() {
   }
 #endif
 
-  if (!mic_buffer || !spk_buffer) {
+  if (!mic_buffer || !spk_buffer || (array && !slot_buffer) || (wide && !wide_buffer)) {
     ESP_LOGE(TAG, "Failed to allocate audio buffers");
     if (mic_buffer) heap_caps_free(mic_buffer);
     if (spk_buffer) heap_caps_free(spk_buffer);
     if (spk_ref_buffer) heap_caps_free(spk_ref_buffer);
     if (aec_output) heap_caps_free(aec_output);
+    if (slot_buffer) heap_caps_free(slot_buffer);
+    if (wide_buffer) heap_caps_free(wide_buffer);
     return;
   }
 
+  // ESP-SR works on fixed chunks; a frame that isn't a whole number of them would
+  // leave its tail uncancelled, so run without AEC rather than leak echo
+  [[maybe_unused]] bool aec_usable = false;  // Only read with USE_ESP_AEC
+#ifdef USE_ESP_AEC
+  if (this->aec_ != nullptr && this->aec_->is_initialized() && spk_ref_buffer != nullptr && aec_output != nullptr) {
+    int chunk = this->aec_->get_frame_size();
+    aec_usable = chunk > 0 && FRAME_SIZE % chunk == 0;
+    if (!aec_usable) {
+      ESP_LOGW(TAG, "AEC chunk (%d samples) does not divide the %zu-sample frame, AEC disabled", chunk, FRAME_SIZE);
+    }
+  }
+#endif
+
   size_t bytes_read, bytes_written;
 
   while (this->duplex_running_) {
     bool did_work = false;  // Track if we did useful I/O this iteration
 
+    // Loopback calibration: loop() owns the calibrator except while RUNNING
+    if (this->calibration_state_.load(std::memory_order_acquire) == CalibrationState::ABORT) {
+      this->calibration_state_.store(CalibrationState::IDLE, std::memory_order_release);
+    }
+    const bool calibrating = this->calibration_state_.load(std::memory_order_acquire) == CalibrationState::RUNNING;
+
     // ══════════════════════════════════════════════════════════════════
     // MICROPHONE READ (RX)
     // ══════════════════════════════════════════════════════════════════
     if (this->rx_handle_ && this->mic_running_) {
+      bool aec_active = false;
+#ifdef USE_ESP_AEC
+      aec_active = aec_usable && this->aec_enabled_ && this->aec_->is_initialized();
+#endif
+      // Final frame goes straight into a bus slot when one is free (nullptr if bus unused),
+      // so subscribers and callbacks share it without copies.
+      FrameSlot *slot = this->frame_bus_.acquire();
+      int16_t *output_buffer = slot != nullptr ? slot->data : (aec_active ? aec_output : mic_buffer);
+      int16_t *capture_buffer = aec_active ? mic_buffer : output_buffer;
+
       // Note: i2s_channel_read timeout is in milliseconds (new driver), not ticks
-      esp_err_t err = i2s_channel_read(this->rx_handle_, mic_buffer, FRAME_BYTES,
-                                        &bytes_read, I2S_IO_TIMEOUT_MS);
-      if (err != ESP_OK && err != ESP_ERR_TIMEOUT) {
+      size_t read_bytes = array ? slot_bytes : (wide ? wide_bytes : FRAME_BYTES);
+      void *read_buffer = array ? (void *) slot_buffer : (wide ? (void *) wide_buffer : (void *) capture_buffer);
+      esp_err_t err = this->inject_io_fault_(false)
+                          ? ESP_ERR_TIMEOUT
+                          : i2s_channel_read(this->rx_handle_, read_buffer, read_bytes, &bytes_read, I2S_IO_TIMEOUT_MS);
+      if (err == ESP_ERR_TIMEOUT) {
+        this->read_timeouts_.fetch_add(1, std::memory_order_relaxed);
+      } else if (err != ESP_OK) {
         ESP_LOGW(TAG, "i2s_channel_read failed: %s", esp_err_to_name(err));
       }
-      if (err == ESP_OK && bytes_read == FRAME_BYTES) {
+      if (err == ESP_OK && bytes_read == read_bytes) {
         did_work = true;
-        int16_t *output_buffer = mic_buffer;  // Default: no AEC processing
+
+        // Mic array: beamform the mic slots into the capture frame; the loopback
+        // slot becomes the AEC reference when the AEC runs on this frame
+        if (array) {
+          uint32_t cycles = arch_get_cpu_cycle_count();
+          this->beamformer_.process(slot_buffer, capture_buffer, aec_active ? spk_ref_buffer : nullptr);
+          record_cycles(this->array_cycles_q4_, cycles);
+        }
+
+        // Wide capture: mic gain is applied here, ahead of the AEC, while the
+        // sample still has its low bits (software gain only)
+        if (wide) {
+          uint32_t cycles = arch_get_cpu_cycle_count();
+          float gain = this->hw_mic_gain_.load(std::memory_order_relaxed) ? 1.0f : this->mic_gain_;
+          narrow_wide_capture(wide_buffer, capture_buffer, FRAME_SIZE, (int32_t) lroundf(gain * 4096.0f),
+                              dither_state);
+          record_cycles(this->wide_cycles_q4_, cycles);
+        }
+
+        // Loopback calibration records what the AEC would see as the echo
+        if (calibrating && this->calibrator_.capture(capture_buffer, FRAME_SIZE)) {
+          CalibrationState expected = CalibrationState::RUNNING;
+          this->calibration_state_.compare_exchange_strong(expected, CalibrationState::CAPTURED,
+                                                          std::memory_order_acq_rel);
+        }
 
 #ifdef USE_ESP_AEC
         // Process through AEC if enabled and initialized
-        if (this->aec_ != nullptr && this->aec_enabled_ && this->aec_->is_initialized() &&
-            spk_ref_buffer != nullptr && aec_output != nullptr) {
+        if (aec_active) {
           // Get speaker reference (best effort, pad with silence if not enough data)
           // Avoid available() which is not thread-safe; read directly and pad
-          if (this->speaker_ref_buffer_ != nullptr) {
+          if (this->has_hw_reference()) {
+            // Already filled from the loopback slot, sample-aligned with the mic
+          } else if (this->speaker_ref_buffer_ != nullptr) {
             size_t got_ref = this->speaker_ref_buffer_->read((void *) spk_ref_buffer, FRAME_BYTES, 0);
             if (got_ref < FRAME_BYTES) {
               memset(((uint8_t *) spk_ref_buffer) + got_ref, 0, FRAME_BYTES - got_ref);
@@ -388,8 +894,7 @@ void I2SAudioDuplex::audio_task_() {
             memset(spk_ref_buffer, 0, FRAME_BYTES);
           }
           // Process AEC: removes echo from mic_buffer using spk_ref_buffer
-          this->aec_->process(mic_buffer, spk_ref_buffer, aec_output, FRAME_SIZE);
-          output_buffer = aec_output;
+          this->aec_->process(mic_buffer, spk_ref_buffer, output_buffer, FRAME_SIZE);
           if (++this->aec_frame_count_ % 500 == 0) {
             ESP_LOGD(TAG, "AEC processing: %lu frames", (unsigned long) this->aec_frame_count_);
           }
@@ -405,8 +910,8 @@ void I2SAudioDuplex::audio_task_() {
         }
 #endif
 
-        // Apply mic gain
-        if (this->mic_gain_ != 1.0f) {
+        // Apply mic gain (software fallback when the codec isn't handling it)
+        if (!wide && !this->hw_mic_gain_.load(std::memory_order_relaxed) && this->mic_gain_ != 1.0f) {
           for (size_t i = 0; i < FRAME_SIZE; i++) {
             int32_t sample = (int32_t)(output_buffer[i] * this->mic_gain_);
             // Clamp to int16_t range
@@ -420,6 +925,16 @@ void I2SAudioDuplex::audio_task_() {
         for (auto &callback : this->mic_callbacks_) {
           callback((const uint8_t *) output_buffer, FRAME_BYTES);
         }
+
+        // Fan out to bus subscribers (never blocks; slow subscribers drop per their policy)
+        if (slot != nullptr) {
+          slot->timestamp_us = esp_timer_get_time();
+          this->frame_bus_.publish(slot);
+          slot = nullptr;
+        }
+      }
+      if (slot != nullptr) {
+        this->frame_bus_.release(slot);
       }
     }
 
@@ -438,8 +953,24 @@ void I2SAudioDuplex::audio_task_() {
         memset(((uint8_t *) spk_buffer) + got, 0, FRAME_BYTES - got);
       }
 
-      // Apply speaker volume with clamp
-      if (this->speaker_volume_ != 1.0f) {
+      // Mix prompts/ringtones over (ducked) call audio
+      if (this->prompt_player_ != nullptr && this->prompt_player_->mix(spk_buffer, FRAME_SIZE)) {
+        did_work = true;
+      }
+
+      // Loopback calibration: the test sequence replaces call audio and prompts
+      if (calibrating) {
+        this->calibrator_.fill_stimulus(spk_buffer, FRAME_SIZE);
+        did_work = true;
+      }
+
+      // AEC reference: exactly what is about to be played (pre-volume), so prompts are cancelled too
+      if (this->speaker_ref_buffer_ != nullptr) {
+        this->speaker_ref_buffer_->write_without_replacement((void *) spk_buffer, FRAME_BYTES, 0, true);
+      }
+
+      // Apply speaker volume with clamp (software fallback when the codec isn't handling it)
+      if (!this->hw_speaker_volume_.load(std::memory_order_relaxed) && this->speaker_volume_ != 1.0f) {
         for (size_t i = 0; i < FRAME_SIZE; i++) {
           int32_t sample = (int32_t)(spk_buffer[i] * this->speaker_volume_);
           if (sample > 32767) sample = 32767;
@@ -449,8 +980,13 @@ void I2SAudioDuplex::audio_task_() {
       }
 
       // Note: i2s_channel_write timeout is in milliseconds (new driver), not ticks
-      esp_err_t err = i2s_channel_write(this->tx_handle_, spk_buffer, FRAME_BYTES, &bytes_written, I2S_IO_TIMEOUT_MS);
-      if (err != ESP_OK && err != ESP_ERR_TIMEOUT) {
+      esp_err_t err = this->inject_io_fault_(true)
+                          ? ESP_ERR_TIMEOUT
+                          : i2s_channel_write(this->tx_handle_, spk_buffer, FRAME_BYTES, &bytes_written,
+                                              I2S_IO_TIMEOUT_MS);
+      if (err == ESP_ERR_TIMEOUT) {
+        this->write_timeouts_.fetch_add(1, std::memory_order_relaxed);
+      } else if (err != ESP_OK) {
         ESP_LOGW(TAG, "i2s_channel_write failed: %s", esp_err_to_name(err));
       }
     }
@@ -467,6 +1003,8 @@ void I2SAudioDuplex::audio_task_() {
   heap_caps_free(spk_buffer);
   if (spk_ref_buffer) heap_caps_free(spk_ref_buffer);
   if (aec_output) heap_caps_free(aec_output);
+  if (slot_buffer) heap_caps_free(slot_buffer);
+  if (wide_buffer) heap_caps_free(wide_buffer);
   ESP_LOGI(TAG, "Audio task stopped");
 }
 
@@ -2,17 +2,39 @@
 
 #ifdef USE_ESP32
 
+#include "esphome/core/automation.h"
 #include "esphome/core/component.h"
+#include "esphome/core/preferences.h"
 #include "esphome/core/ring_buffer.h"
 
+#include "beamformer.h"
+#include "codec_control.h"
+#include "frame_bus.h"
+#include "loopback_calibrator.h"
+#include "prompt_player.h"
+
 #include <driver/i2s_std.h>
+#include <soc/soc_caps.h>
+#if SOC_I2S_SUPPORTS_TDM
+#include <driver/i2s_tdm.h>
+#endif
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 
 #include <atomic>
+#include <cmath>
 #include <functional>
 #include <vector>
 
+// Stream format, emitted by codegen from sample_rate / frame_duration so every
+// frame-sized buffer and loop in the audio path is sized at compile time
+#ifndef I2S_AUDIO_DUPLEX_SAMPLE_RATE
+#define I2S_AUDIO_DUPLEX_SAMPLE_RATE 16000
+#endif
+#ifndef I2S_AUDIO_DUPLEX_FRAME_SAMPLES
+#define I2S_AUDIO_DUPLEX_FRAME_SAMPLES 256
+#endif
+
 // Forward declare AEC
 namespace esphome {
 namespace esp_aec {
@@ -23,6 +45,13 @@ class EspAec;
 namespace esphome {
 namespace i2s_audio_duplex {
 
+// How the capture side uses the bus: one mic, both std slots, or a TDM frame
+enum class SlotMode : uint8_t {
+  MONO,    // Left slot only
+  STEREO,  // Both std slots (two mics, or mic + loopback)
+  TDM,     // Up to 8 slots (ES7210 and similar ADCs); not on the original ESP32
+};
+
 // Callback type for mic data: receives raw PCM samples (pointer + length, zero-copy)
 using MicDataCallback = std::function<void(const uint8_t *data, size_t len)>;
 
@@ -40,42 +69,147 @@ class I2SAudioDuplex : public Component {
   void set_din_pin(int pin) { this->din_pin_ = pin; }
   void set_dout_pin(int pin) { this->dout_pin_ = pin; }
   void set_sample_rate(uint32_t rate) { this->sample_rate_ = rate; }
+  uint32_t get_sample_rate() const { return this->sample_rate_; }
+  static constexpr size_t get_frame_samples() { return I2S_AUDIO_DUPLEX_FRAME_SAMPLES; }
+
+  // Latency: I2S DMA ring (descriptors x samples, per direction) and speaker
+  // buffer depth in bytes. Each adds its full length to mouth-to-ear latency
+  // when it runs full; intercom_audio latency_target sizes them.
+  void set_dma_buffers(uint8_t count, uint16_t samples) {
+    this->dma_buffer_count_ = count;
+    this->dma_buffer_size_ = samples;
+  }
+  void set_speaker_buffer_size(size_t bytes) { this->speaker_buffer_size_ = bytes; }
+
+  // 32: capture 24/32-bit mic data and apply mic gain at full width before the
+  // single dithered rounding to the int16 frame the AEC and consumers see.
+  // The speaker stays 16-bit data in 32-bit slots.
+  void set_bits_per_sample(uint8_t bits) { this->bits_per_sample_ = bits; }
+  uint8_t get_bits_per_sample() const { return this->bits_per_sample_; }
+  // Smoothed CPU cycles per frame of the 32 -> 16 bit conversion
+  float get_wide_capture_cycles() const { return this->wide_cycles_q4_.load(std::memory_order_relaxed) / 16.0f; }
+
+  // Mic array: every slot is captured, the mic slots are beamformed into the
+  // mono mic frame and reference_slot (>= 0) replaces the software AEC reference.
+  // Call before set_aec().
+  void set_mic_array(SlotMode mode, uint8_t slots, int8_t reference_slot, float spacing_m, float steering_deg) {
+    this->slot_mode_ = mode;
+    this->mic_slots_ = slots;
+    this->reference_slot_ = reference_slot;
+    this->mic_spacing_ = spacing_m;
+    this->steering_angle_ = steering_deg;
+  }
+  SlotMode get_slot_mode() const { return this->slot_mode_; }
+  bool has_hw_reference() const {
+    return this->slot_mode_ != SlotMode::MONO && this->reference_slot_ >= 0;
+  }
+  // Average CPU cycles per frame that each captured slot beyond the first costs
+  // (de-interleave + beamforming); 0 in mono mode
+  uint32_t get_channel_cycles() const;
 
   // AEC setter
   void set_aec(esp_aec::EspAec *aec);
+  esp_aec::EspAec *get_aec() const { return this->aec_; }
   void set_aec_enabled(bool enabled) { this->aec_enabled_ = enabled; }
   bool is_aec_enabled() const { return this->aec_enabled_; }
 
+  // Loopback calibration: plays a test sequence at `level` (0-1 of full scale)
+  // through the speaker path and correlates it with the mic. The measured delay
+  // is kept in flash and holds the software AEC reference back to match its
+  // echo from the next start(). Starts the duplex if needed, stops it after.
+  bool start_calibration(float level);
+  bool is_calibrating() const { return this->calibrator_.is_active(); }
+  // Speaker write to mic read, and the echo level relative to the speaker
+  // reference at the strongest tap; NAN until a calibration succeeded
+  float get_loopback_latency_ms() const;
+  float get_echo_path_gain_db() const { return this->has_loopback_ ? this->echo_path_gain_db_ : NAN; }
+
+  // Optional codec register access: volume/gain go to the codec instead of
+  // scaling every sample in the audio task
+  void set_codec(CodecRegisterBus *bus, CodecType type) { this->codec_ = CodecControl::create(type, bus); }
+  bool has_hw_mic_gain() const { return this->hw_mic_gain_; }
+  bool has_hw_speaker_volume() const { return this->hw_speaker_volume_; }
+
   // Volume control (0.0 - 1.0)
-  void set_mic_gain(float gain) { this->mic_gain_ = gain; }
+  void set_mic_gain(float gain);
   float get_mic_gain() const { return this->mic_gain_; }
-  void set_speaker_volume(float volume) { this->speaker_volume_ = volume; }
+  void set_speaker_volume(float volume);
   float get_speaker_volume() const { return this->speaker_volume_; }
 
   // Microphone interface
   void add_mic_data_callback(MicDataCallback callback) { this->mic_callbacks_.push_back(callback); }
+
+  // Shared capture bus: processed mic frames fanned out by reference to consumers
+  // running in their own tasks. Subscribe during setup(), before the first start().
+  FrameSubscription *subscribe_frames(size_t max_lag_frames, DropPolicy policy) {
+    return this->frame_bus_.subscribe(max_lag_frames, policy);
+  }
+  const FrameBus &get_frame_bus() const { return this->frame_bus_; }
   void start_mic();
   void stop_mic();
   bool is_mic_running() const { return this->mic_running_; }
 
   // Speaker interface
-  size_t play(const uint8_t *data, size_t len, TickType_t ticks_to_wait = portMAX_DELAY);
+  // Non-blocking by default; callers that must not stall check get_speaker_free() first
+  size_t play(const uint8_t *data, size_t len, TickType_t ticks_to_wait = 0);
+  size_t get_speaker_free() const;
+  // Bytes waiting in the speaker buffer, and the audio queued in the TX DMA ring (µs)
+  size_t get_speaker_buffered() const;
+  uint32_t get_playback_dma_us() const;
+  bool has_buffered_speaker_data() const;
   void start_speaker();
   void stop_speaker();
   bool is_speaker_running() const { return this->speaker_running_; }
 
+  // Prompts/ringtones from a flash partition, mixed into the speaker path
+  void set_prompt_partition(const std::string &label);
+  void set_prompt_duck_level(float level);
+  void add_prompt(const std::string &name, uint32_t offset);
+  bool play_prompt(const std::string &name, bool loop = false);
+  void stop_prompt();
+  bool is_playing_prompt() const { return this->prompt_player_ != nullptr && this->prompt_player_->is_playing(); }
+  uint32_t get_prompt_start_latency_us() const {
+    return this->prompt_player_ != nullptr ? this->prompt_player_->get_last_start_latency_us() : 0;
+  }
+
   // Full duplex control
   void start();  // Start both mic and speaker
   void stop();   // Stop both
 
   bool is_running() const { return this->duplex_running_; }
 
+  // I2S reads and writes that timed out (or were failed on purpose)
+  uint32_t get_read_timeouts() const { return this->read_timeouts_.load(std::memory_order_relaxed); }
+  uint32_t get_write_timeouts() const { return this->write_timeouts_.load(std::memory_order_relaxed); }
+
+#ifdef USE_INTERCOM_FAULT_INJECTION
+  // Soak builds only: asked on the audio task before every I2S read (false)
+  // and write (true); true skips the call and takes its timeout path
+  void set_io_fault(std::function<bool(bool write)> &&fault) { this->io_fault_ = std::move(fault); }
+#endif
+
  protected:
   bool init_i2s_duplex_();
+  bool init_tdm_(const i2s_std_config_t &std_cfg);
   void deinit_i2s_();
 
   static void audio_task(void *param);
   void audio_task_();
+  bool inject_io_fault_(bool write) {
+#ifdef USE_INTERCOM_FAULT_INJECTION
+    return this->io_fault_ && this->io_fault_(write);
+#else
+    return false;
+#endif
+  }
+
+  // Loopback calibration, driven from loop(). RUNNING: the audio task plays the
+  // sequence and records the mic; CAPTURED: loop() owns the calibrator and
+  // correlates; ABORT: loop() gave up, the audio task answers with IDLE.
+  enum class CalibrationState : uint8_t { IDLE, RUNNING, CAPTURED, ABORT };
+  void calibration_loop_();
+  void finish_calibration_();
+  size_t ref_delay_samples_() const;
 
   // Pin configuration
   int lrclk_pin_{-1};
@@ -84,7 +218,23 @@ class I2SAudioDuplex : public Component {
   int din_pin_{-1};   // Mic data in
   int dout_pin_{-1};  // Speaker data out
 
-  uint32_t sample_rate_{16000};
+  uint32_t sample_rate_{I2S_AUDIO_DUPLEX_SAMPLE_RATE};
+  uint8_t bits_per_sample_{16};
+  std::atomic<uint32_t> wide_cycles_q4_{0};
+
+  uint8_t dma_buffer_count_{8};
+  uint16_t dma_buffer_size_{512};
+  uint32_t dma_frames_{0};  // Samples per descriptor actually used (capped by the slot width)
+  size_t speaker_buffer_size_{8192};
+
+  // Mic array (slot_mode_ != MONO)
+  SlotMode slot_mode_{SlotMode::MONO};
+  uint8_t mic_slots_{1};
+  int8_t reference_slot_{-1};
+  Beamformer beamformer_;
+  float mic_spacing_{0.0f};
+  float steering_angle_{0.0f};
+  std::atomic<uint32_t> array_cycles_q4_{0};  // EWMA x16 of the whole array stage
 
   // I2S handles - BOTH created from single channel for duplex
   i2s_chan_handle_t tx_handle_{nullptr};
@@ -95,10 +245,18 @@ class I2SAudioDuplex : public Component {
   bool mic_running_{false};
   bool speaker_running_{false};
   TaskHandle_t audio_task_handle_{nullptr};
+  std::atomic<uint32_t> read_timeouts_{0};
+  std::atomic<uint32_t> write_timeouts_{0};
+#ifdef USE_INTERCOM_FAULT_INJECTION
+  std::function<bool(bool write)> io_fault_;
+#endif
 
   // Mic data callbacks
   std::vector<MicDataCallback> mic_callbacks_;
 
+  // Mic frame fan-out for microphone platform / other tasks
+  FrameBus frame_bus_;
+
   // Speaker ring buffer
   std::unique_ptr<RingBuffer> speaker_buffer_;
 
@@ -106,11 +264,60 @@ class I2SAudioDuplex : public Component {
   esp_aec::EspAec *aec_{nullptr};
   bool aec_enabled_{true};  // Runtime toggle
   std::unique_ptr<RingBuffer> speaker_ref_buffer_;  // Reference for AEC
+  size_t speaker_ref_size_{0};
+
+  // Loopback calibration result (restored from flash) and the run in progress
+  LoopbackCalibrator calibrator_;
+  std::atomic<CalibrationState> calibration_state_{CalibrationState::IDLE};
+  uint32_t calibration_start_ms_{0};
+  bool calibration_stop_after_{false};
+  ESPPreferenceObject loopback_pref_;
+  bool has_loopback_{false};
+  float loopback_delay_samples_{0.0f};
+  float echo_path_gain_db_{0.0f};
   uint32_t aec_frame_count_{0};  // Debug counter, reset on start()
 
   // Volume control
   float mic_gain_{1.0f};       // 0.0 - 2.0 (1.0 = unity gain)
   float speaker_volume_{1.0f}; // 0.0 - 1.0
+
+  // Prompt playback (optional, created when a prompt partition is configured)
+  std::unique_ptr<PromptPlayer> prompt_player_;
+
+  // Codec control (optional). When the codec accepted the last value the
+  // audio task skips the software multiply for that direction.
+  std::unique_ptr<CodecControl> codec_;
+  std::atomic<bool> hw_mic_gain_{false};
+  std::atomic<bool> hw_speaker_volume_{false};
+};
+
+template<typename... Ts>
+class PlayPromptAction : public Action<Ts...>, public Parented<I2SAudioDuplex> {
+ public:
+  TEMPLATABLE_VALUE(std::string, prompt)
+  TEMPLATABLE_VALUE(bool, loop)
+
+  void play(Ts... x) override { this->parent_->play_prompt(this->prompt_.value(x...), this->loop_.value(x...)); }
+};
+
+template<typename... Ts>
+class StopPromptAction : public Action<Ts...>, public Parented<I2SAudioDuplex> {
+ public:
+  void play(Ts... x) override { this->parent_->stop_prompt(); }
+};
+
+template<typename... Ts>
+class CalibrateAction : public Action<Ts...>, public Parented<I2SAudioDuplex> {
+ public:
+  TEMPLATABLE_VALUE(float, level)
+
+  void play(Ts... x) override { this->parent_->start_calibration(this->level_.value(x...)); }
+};
+
+template<typename... Ts>
+class IsPlayingPromptCondition : public Condition<Ts...>, public Parented<I2SAudioDuplex> {
+ public:
+  bool check(Ts... x) override { return this->parent_->is_playing_prompt(); }
 };
 
 }  // namespace i2s_audio_duplex
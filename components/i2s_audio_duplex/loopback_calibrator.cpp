@@ -0,0 +1,203 @@
+#include "loopback_calibrator.h"
+
+#ifdef USE_ESP32
+#include <esp_heap_caps.h>
+#endif
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+namespace esphome {
+namespace i2s_audio_duplex {
+
+// x^12 + x^6 + x^4 + x + 1: maximal length, every non-zero state in 4095 steps
+static const uint16_t MLS_TAPS = 0x0829;
+
+static bool lfsr_step(uint16_t &state) {
+  bool bit = state & 1;
+  state >>= 1;
+  if (bit) {
+    state ^= MLS_TAPS;
+  }
+  return bit;
+}
+
+static void *alloc_buffer(size_t bytes) {
+#ifdef USE_ESP32
+  // Only touched by the main loop and once per frame by the audio task, so PSRAM is fine
+  void *buf = heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+  if (buf == nullptr) {
+    buf = heap_caps_malloc(bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+  }
+  return buf;
+#else
+  return malloc(bytes);
+#endif
+}
+
+static void free_buffer(void *buf) {
+#ifdef USE_ESP32
+  heap_caps_free(buf);
+#else
+  free(buf);
+#endif
+}
+
+bool LoopbackCalibrator::begin(size_t max_lag, int16_t amplitude) {
+  this->end();
+  this->max_lag_ = max_lag;
+  this->amplitude_ = amplitude;
+  this->capture_len_ = MLS_LENGTH + max_lag;
+  this->capture_buf_ = (int16_t *) alloc_buffer(this->capture_len_ * sizeof(int16_t));
+  this->ones_ = (uint16_t *) alloc_buffer(MLS_LENGTH * sizeof(uint16_t));
+  if (this->capture_buf_ == nullptr || this->ones_ == nullptr) {
+    this->end();
+    return false;
+  }
+
+  uint16_t state = 1;
+  this->ones_count_ = 0;
+  for (size_t n = 0; n < MLS_LENGTH; n++) {
+    if (lfsr_step(state)) {
+      this->ones_[this->ones_count_++] = (uint16_t) n;
+    }
+  }
+
+  this->lfsr_ = 1;
+  this->sent_ = 0;
+  this->captured_ = 0;
+  this->lag_ = 0;
+  this->window_sum_ = 0;
+  this->prev_corr_ = 0;
+  this->peak_ = 0;
+  this->peak_before_ = 0;
+  this->peak_after_ = 0;
+  this->peak_lag_ = 0;
+  this->sum_squares_ = 0.0;
+  this->result_ = LoopbackResult();
+  return true;
+}
+
+void LoopbackCalibrator::end() {
+  if (this->capture_buf_ != nullptr) {
+    free_buffer(this->capture_buf_);
+    this->capture_buf_ = nullptr;
+  }
+  if (this->ones_ != nullptr) {
+    free_buffer(this->ones_);
+    this->ones_ = nullptr;
+  }
+  this->capture_len_ = 0;
+}
+
+void LoopbackCalibrator::fill_stimulus(int16_t *out, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    if (this->sent_ < MLS_LENGTH) {
+      out[i] = lfsr_step(this->lfsr_) ? this->amplitude_ : (int16_t) -this->amplitude_;
+      this->sent_++;
+    } else {
+      out[i] = 0;
+    }
+  }
+}
+
+bool LoopbackCalibrator::capture(const int16_t *mic, size_t n) {
+  if (this->sent_ == 0) {
+    return false;  // Nothing played yet
+  }
+  size_t take = this->capture_len_ - this->captured_;
+  if (n < take) {
+    take = n;
+  }
+  memcpy(this->capture_buf_ + this->captured_, mic, take * sizeof(int16_t));
+  this->captured_ += take;
+  return this->is_captured();
+}
+
+bool LoopbackCalibrator::analyze(size_t max_lags) {
+  const int16_t *x = this->capture_buf_;
+  if (this->lag_ == 0) {
+    int32_t sum = 0;
+    for (size_t n = 0; n < MLS_LENGTH; n++) {
+      sum += x[n];
+    }
+    this->window_sum_ = sum;
+  }
+
+  // |corr| <= 4095 * 32768, so int32 holds every term
+  for (size_t done = 0; done < max_lags && this->lag_ <= this->max_lag_; done++) {
+    const size_t lag = this->lag_;
+    const int16_t *shifted = x + lag;
+    int32_t ones_sum = 0;
+    for (size_t i = 0; i < this->ones_count_; i++) {
+      ones_sum += shifted[this->ones_[i]];
+    }
+    int32_t corr = 2 * ones_sum - this->window_sum_;
+
+    if (lag == this->peak_lag_ + 1) {
+      this->peak_after_ = corr;
+    }
+    if (std::abs(corr) > std::abs(this->peak_)) {
+      this->peak_ = corr;
+      this->peak_lag_ = lag;
+      this->peak_before_ = lag > 0 ? this->prev_corr_ : 0;
+      this->peak_after_ = 0;
+    }
+    this->prev_corr_ = corr;
+    this->sum_squares_ += (double) corr * corr;
+
+    // Slide the window one sample for the next lag
+    if (lag < this->max_lag_) {
+      this->window_sum_ += x[lag + MLS_LENGTH] - x[lag];
+    }
+    this->lag_++;
+  }
+
+  if (this->lag_ <= this->max_lag_) {
+    return false;
+  }
+  this->finish_();
+  return true;
+}
+
+void LoopbackCalibrator::finish_() {
+  LoopbackResult &r = this->result_;
+  r = LoopbackResult();
+  if (this->peak_ == 0 || this->amplitude_ == 0) {
+    return;
+  }
+  const float sign = this->peak_ < 0 ? -1.0f : 1.0f;
+  const float y0 = sign * this->peak_;
+  const float ym = sign * this->peak_before_;
+  const float yp = sign * this->peak_after_;
+
+  // Parabola through the peak and its neighbours (not at the edges of the search)
+  float delta = 0.0f;
+  float denom = ym - 2.0f * y0 + yp;
+  if (this->peak_lag_ > 0 && this->peak_lag_ < this->max_lag_ && denom < 0.0f) {
+    delta = 0.5f * (ym - yp) / denom;
+    if (delta > 0.5f) delta = 0.5f;
+    if (delta < -0.5f) delta = -0.5f;
+  }
+  r.delay_samples = (float) this->peak_lag_ + delta;
+  r.inverted = sign < 0.0f;
+
+  // The sequence is white, so the correlation is the impulse response scaled by
+  // amplitude * length. A delay between two samples spreads the direct path over
+  // the peak and its neighbours; their energy together is the path gain.
+  double peak_energy = (double) this->peak_ * this->peak_ + (double) this->peak_before_ * this->peak_before_ +
+                       (double) this->peak_after_ * this->peak_after_;
+  double full_scale = (double) this->amplitude_ * MLS_LENGTH;
+  r.gain_db = (float) (10.0 * log10(peak_energy / (full_scale * full_scale)));
+
+  // Noise floor: every lag but the peak and its neighbours
+  double rest = this->sum_squares_ - peak_energy;
+  size_t rest_lags = this->max_lag_ + 1 > 3 ? this->max_lag_ + 1 - 3 : 1;
+  double noise = rest > 0.0 ? rest / rest_lags : 1.0;
+  r.peak_to_noise_db = (float) (10.0 * log10((double) y0 * y0 / noise));
+  r.valid = r.peak_to_noise_db >= MIN_PEAK_TO_NOISE_DB;
+}
+
+}  // namespace i2s_audio_duplex
+}  // namespace esphome
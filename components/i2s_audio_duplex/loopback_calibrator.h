@@ -0,0 +1,79 @@
+#pragma once
+
+// Speaker-to-mic loopback measurement: plays a maximum length sequence (MLS)
+// through the speaker path, records what the mic hears and cross-correlates
+// the two. The correlation peak gives the round-trip delay (fractional, by
+// parabolic interpolation) and the echo path gain at that tap.
+// No ESPHome dependencies so it can be built and checked on the host.
+
+#include <cstddef>
+#include <cstdint>
+
+namespace esphome {
+namespace i2s_audio_duplex {
+
+struct LoopbackResult {
+  float delay_samples{0.0f};  // Speaker write to mic read, in samples
+  float gain_db{0.0f};        // Mic level over stimulus level at the peak tap
+  float peak_to_noise_db{0.0f};  // Peak over the mean of every other lag
+  bool inverted{false};       // Speaker or mic wired with opposite polarity
+  bool valid{false};          // Peak stood out by at least MIN_PEAK_TO_NOISE_DB
+};
+
+class LoopbackCalibrator {
+ public:
+  static const uint8_t MLS_ORDER = 12;
+  static const size_t MLS_LENGTH = (1u << MLS_ORDER) - 1;  // 4095 samples, 256 ms at 16 kHz
+  static constexpr float MIN_PEAK_TO_NOISE_DB = 15.0f;
+
+  ~LoopbackCalibrator() { this->end(); }
+
+  // max_lag: longest delay searched, in samples. The mic is recorded for the
+  // sequence plus max_lag. False if the buffers cannot be allocated.
+  bool begin(size_t max_lag, int16_t amplitude);
+  void end();
+  bool is_active() const { return this->capture_buf_ != nullptr; }
+  size_t get_max_lag() const { return this->max_lag_; }
+
+  // Next n speaker samples: the sequence, then silence. Capture starts with the
+  // first mic read after the first call, so that read is lag 0.
+  void fill_stimulus(int16_t *out, size_t n);
+  // Records mic samples; true once the recording is complete
+  bool capture(const int16_t *mic, size_t n);
+  bool is_captured() const { return this->capture_len_ != 0 && this->captured_ >= this->capture_len_; }
+
+  // Correlates up to max_lags more lags; true once every lag is done and the
+  // result is ready. Split so a caller can spread the work over several passes.
+  bool analyze(size_t max_lags);
+  const LoopbackResult &get_result() const { return this->result_; }
+
+ protected:
+  void finish_();
+
+  size_t max_lag_{0};
+  int16_t amplitude_{0};
+  uint16_t lfsr_{1};  // Sequence generator, stepped once per stimulus sample
+  size_t sent_{0};
+
+  int16_t *capture_buf_{nullptr};  // MLS_LENGTH + max_lag_ samples
+  size_t capture_len_{0};
+  size_t captured_{0};
+
+  // Positions of the +1 chips: corr(L) = 2 * sum(x[ones + L]) - sum(x[L .. L + N))
+  uint16_t *ones_{nullptr};
+  size_t ones_count_{0};
+
+  // Analysis state
+  size_t lag_{0};
+  int32_t window_sum_{0};
+  int32_t prev_corr_{0};
+  int32_t peak_{0};  // Largest |corr| and its neighbours
+  int32_t peak_before_{0};
+  int32_t peak_after_{0};
+  size_t peak_lag_{0};
+  double sum_squares_{0.0};
+  LoopbackResult result_;
+};
+
+}  // namespace i2s_audio_duplex
+}  // namespace esphome
@@ -0,0 +1,105 @@
+#include "microphone.h"
+
+#ifdef USE_ESP32
+#ifdef USE_MICROPHONE
+
+#include "esphome/core/log.h"
+
+#include <cstring>
+
+namespace esphome {
+namespace i2s_audio_duplex {
+
+static const char *const TAG = "i2s_audio_duplex.microphone";
+
+void DuplexMicrophone::setup() {
+  const uint32_t sample_rate = this->parent_->get_sample_rate();
+  const size_t frame_samples = this->parent_->get_frame_samples();
+
+  // Lag tolerance in whole frames (rounded up)
+  size_t samples = (size_t) this->max_lag_ms_ * sample_rate / 1000;
+  size_t max_lag = (samples + frame_samples - 1) / frame_samples;
+
+  this->subscription_ = this->parent_->subscribe_frames(max_lag, this->drop_policy_);
+  if (this->subscription_ == nullptr) {
+    ESP_LOGE(TAG, "Failed to subscribe to duplex frame bus");
+    this->mark_failed();
+    return;
+  }
+
+  this->audio_stream_info_ = audio::AudioStreamInfo(16, 1, sample_rate);
+  this->data_.reserve(frame_samples * sizeof(int16_t));
+
+  BaseType_t ok = xTaskCreatePinnedToCore(read_task, "duplex_mic", 4096, this, 5, &this->task_handle_, 0);
+  if (ok != pdPASS) {
+    ESP_LOGE(TAG, "Failed to create microphone task");
+    this->mark_failed();
+    return;
+  }
+}
+
+void DuplexMicrophone::dump_config() {
+  ESP_LOGCONFIG(TAG, "I2S Audio Duplex Microphone:");
+  ESP_LOGCONFIG(TAG, "  Max Lag: %u ms (%zu frames)", (unsigned) this->max_lag_ms_,
+                this->subscription_ != nullptr ? this->subscription_->get_max_lag() : 0);
+  ESP_LOGCONFIG(TAG, "  Drop Policy: %s", this->drop_policy_ == DropPolicy::DROP_OLDEST ? "drop_oldest" : "drop_newest");
+}
+
+void DuplexMicrophone::start() {
+  if (this->is_failed() || this->subscription_ == nullptr) {
+    return;
+  }
+  // Shared bus: starting the duplex is idempotent, other users may already run it
+  if (!this->parent_->is_running()) {
+    this->parent_->start();
+  }
+  this->subscription_->set_active(true);
+  this->state_ = microphone::STATE_RUNNING;
+  xTaskNotifyGive(this->task_handle_);
+}
+
+void DuplexMicrophone::stop() {
+  // Only detach from the bus - the duplex keeps running for its other users
+  if (this->subscription_ != nullptr) {
+    this->subscription_->set_active(false);
+  }
+  this->state_ = microphone::STATE_STOPPED;
+}
+
+void DuplexMicrophone::read_task(void *param) {
+  DuplexMicrophone *self = static_cast<DuplexMicrophone *>(param);
+  self->read_task_();
+  vTaskDelete(nullptr);
+}
+
+void DuplexMicrophone::read_task_() {
+  while (true) {
+    if (!this->subscription_->is_active()) {
+      ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+      continue;
+    }
+
+    FrameSlot *slot = this->subscription_->receive(pdMS_TO_TICKS(100));
+    if (slot == nullptr) {
+      continue;
+    }
+
+    // Copy out and hand the slot back before running (possibly slow) consumers
+    const size_t bytes = slot->samples * sizeof(int16_t);
+    this->data_.resize(bytes);
+    if (this->mute_state_) {
+      memset(this->data_.data(), 0, bytes);
+    } else {
+      memcpy(this->data_.data(), slot->data, bytes);
+    }
+    this->subscription_->release(slot);
+
+    this->data_callbacks_.call(this->data_);
+  }
+}
+
+}  // namespace i2s_audio_duplex
+}  // namespace esphome
+
+#endif  // USE_MICROPHONE
+#endif  // USE_ESP32
@@ -0,0 +1,54 @@
+#pragma once
+
+#ifdef USE_ESP32
+#ifdef USE_MICROPHONE
+
+#include "esphome/components/microphone/microphone.h"
+#include "esphome/core/component.h"
+#include "esphome/core/helpers.h"
+#include "i2s_audio_duplex.h"
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <vector>
+
+namespace esphome {
+namespace i2s_audio_duplex {
+
+// Standard ESPHome microphone backed by a frame bus subscription, so
+// micro_wake_word / voice_assistant can share the duplex I2S bus with intercom_audio.
+// Data callbacks run in this component's own task: a slow consumer only
+// drops its own frames and never stalls the I2S task.
+class DuplexMicrophone : public microphone::Microphone, public Component, public Parented<I2SAudioDuplex> {
+ public:
+  void setup() override;
+  void dump_config() override;
+
+  void set_max_lag_ms(uint32_t ms) { this->max_lag_ms_ = ms; }
+  void set_drop_policy(DropPolicy policy) { this->drop_policy_ = policy; }
+
+  void start() override;
+  void stop() override;
+
+  uint32_t get_dropped_frames() const {
+    return this->subscription_ != nullptr ? this->subscription_->get_dropped() : 0;
+  }
+
+ protected:
+  static void read_task(void *param);
+  void read_task_();
+
+  uint32_t max_lag_ms_{64};
+  DropPolicy drop_policy_{DropPolicy::DROP_OLDEST};
+
+  FrameSubscription *subscription_{nullptr};
+  TaskHandle_t task_handle_{nullptr};
+  std::vector<uint8_t> data_;  // Reused for every callback (ESPHome API takes a vector)
+};
+
+}  // namespace i2s_audio_duplex
+}  // namespace esphome
+
+#endif  // USE_MICROPHONE
+#endif  // USE_ESP32
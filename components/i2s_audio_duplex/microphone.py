@@ -0,0 +1,44 @@
+"""Microphone platform for I2S Audio Duplex - shares the duplex mic via the frame bus"""
+import esphome.codegen as cg
+import esphome.config_validation as cv
+from esphome.components import microphone
+from esphome.const import CONF_ID
+
+from . import i2s_audio_duplex_ns, I2SAudioDuplex
+
+DEPENDENCIES = ["i2s_audio_duplex"]
+
+CONF_I2S_AUDIO_DUPLEX_ID = "i2s_audio_duplex_id"
+CONF_MAX_LAG = "max_lag"
+CONF_DROP_POLICY = "drop_policy"
+
+DuplexMicrophone = i2s_audio_duplex_ns.class_(
+    "DuplexMicrophone", microphone.Microphone, cg.Component, cg.Parented.template(I2SAudioDuplex)
+)
+
+DropPolicy = i2s_audio_duplex_ns.enum("DropPolicy", is_class=True)
+DROP_POLICIES = {
+    "drop_oldest": DropPolicy.DROP_OLDEST,
+    "drop_newest": DropPolicy.DROP_NEWEST,
+}
+
+CONFIG_SCHEMA = microphone.MICROPHONE_SCHEMA.extend({
+    cv.GenerateID(): cv.declare_id(DuplexMicrophone),
+    cv.GenerateID(CONF_I2S_AUDIO_DUPLEX_ID): cv.use_id(I2SAudioDuplex),
+    # How far this consumer may fall behind before frames are dropped
+    cv.Optional(CONF_MAX_LAG, default="64ms"): cv.All(
+        cv.positive_time_period_milliseconds,
+        cv.Range(min=cv.TimePeriod(milliseconds=16), max=cv.TimePeriod(milliseconds=2000)),
+    ),
+    cv.Optional(CONF_DROP_POLICY, default="drop_oldest"): cv.enum(DROP_POLICIES, lower=True),
+}).extend(cv.COMPONENT_SCHEMA)
+
+
+async def to_code(config):
+    var = cg.new_Pvariable(config[CONF_ID])
+    await cg.register_component(var, config)
+    await cg.register_parented(var, config[CONF_I2S_AUDIO_DUPLEX_ID])
+    await microphone.register_microphone(var, config)
+
+    cg.add(var.set_max_lag_ms(config[CONF_MAX_LAG]))
+    cg.add(var.set_drop_policy(config[CONF_DROP_POLICY]))
@@ -0,0 +1,249 @@
+#include "prompt_player.h"
+
+#ifdef USE_ESP32
+
+#include "esphome/core/log.h"
+
+#include <esp_timer.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace esphome {
+namespace i2s_audio_duplex {
+
+static const char *const TAG = "i2s_audio_duplex.prompt";
+
+static const uint16_t WAV_FORMAT_PCM = 0x0001;
+static const uint16_t WAV_FORMAT_IMA_ADPCM = 0x0011;
+
+// IMA ADPCM tables
+static const int16_t IMA_STEP_TABLE[89] = {
+    7,     8,     9,     10,    11,    12,    13,    14,    16,    17,    19,    21,    23,    25,    28,
+    31,    34,    37,    41,    45,    50,    55,    60,    66,    73,    80,    88,    97,    107,   118,
+    130,   143,   157,   173,   190,   209,   230,   253,   279,   307,   337,   371,   408,   449,   494,
+    544,   598,   658,   724,   796,   876,   963,   1060,  1166,  1282,  1411,  1552,  1707,  1878,  2066,
+    2272,  2499,  2749,  3024,  3327,  3660,  4026,  4428,  4871,  5358,  5894,  6484,  7132,  7845,  8630,
+    9493,  10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767,
+};
+static const int8_t IMA_INDEX_TABLE[16] = {-1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8};
+
+static uint16_t read_le16(const uint8_t *p) { return (uint16_t) (p[0] | (p[1] << 8)); }
+static uint32_t read_le32(const uint8_t *p) {
+  return (uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static int16_t clamp16(int32_t v) {
+  if (v > 32767)
+    return 32767;
+  if (v < -32768)
+    return -32768;
+  return (int16_t) v;
+}
+
+void PromptPlayer::add_prompt(const std::string &name, uint32_t offset) {
+  PromptAsset asset;
+  asset.name = name;
+  asset.offset = offset;
+  this->prompts_.push_back(asset);
+}
+
+bool PromptPlayer::setup(uint32_t sample_rate) {
+  const esp_partition_t *part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+                                                         this->partition_label_.c_str());
+  if (part == nullptr) {
+    ESP_LOGE(TAG, "Partition '%s' not found", this->partition_label_.c_str());
+    return false;
+  }
+
+  // Map the whole partition once: costs MMU pages, not RAM, regardless of asset length
+  esp_err_t err = esp_partition_mmap(part, 0, part->size, ESP_PARTITION_MMAP_DATA, &this->mapped_,
+                                     &this->mmap_handle_);
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "Failed to map partition '%s': %s", this->partition_label_.c_str(), esp_err_to_name(err));
+    return false;
+  }
+
+  const uint8_t *base = static_cast<const uint8_t *>(this->mapped_);
+  for (auto &asset : this->prompts_) {
+    if (asset.offset >= part->size) {
+      ESP_LOGE(TAG, "Prompt '%s': offset 0x%x beyond partition", asset.name.c_str(), (unsigned) asset.offset);
+      continue;
+    }
+    asset.valid = this->parse_wav_(asset, base + asset.offset, part->size - asset.offset, sample_rate);
+  }
+  return true;
+}
+
+bool PromptPlayer::parse_wav_(PromptAsset &asset, const uint8_t *p, size_t avail, uint32_t sample_rate) {
+  if (avail < 12 || memcmp(p, "RIFF", 4) != 0 || memcmp(p + 8, "WAVE", 4) != 0) {
+    ESP_LOGE(TAG, "Prompt '%s': not a WAV file", asset.name.c_str());
+    return false;
+  }
+
+  bool have_fmt = false;
+  size_t pos = 12;
+  while (pos + 8 <= avail) {
+    const uint8_t *chunk = p + pos;
+    uint32_t chunk_size = read_le32(chunk + 4);
+    const uint8_t *body = chunk + 8;
+
+    if (memcmp(chunk, "fmt ", 4) == 0 && chunk_size >= 16) {
+      uint16_t format = read_le16(body);
+      uint16_t channels = read_le16(body + 2);
+      uint32_t rate = read_le32(body + 4);
+      asset.block_align = read_le16(body + 12);
+      uint16_t bits = read_le16(body + 14);
+
+      if (channels != 1 || rate != sample_rate) {
+        ESP_LOGE(TAG, "Prompt '%s': need mono %u Hz, got %u ch %u Hz", asset.name.c_str(), (unsigned) sample_rate,
+                 channels, (unsigned) rate);
+        return false;
+      }
+      if (format == WAV_FORMAT_PCM && bits == 16) {
+        asset.format = PromptFormat::PCM16;
+      } else if (format == WAV_FORMAT_IMA_ADPCM && bits == 4 && asset.block_align > 4) {
+        asset.format = PromptFormat::IMA_ADPCM;
+      } else {
+        ESP_LOGE(TAG, "Prompt '%s': unsupported format 0x%04x/%u bit", asset.name.c_str(), format, bits);
+        return false;
+      }
+      have_fmt = true;
+    } else if (memcmp(chunk, "data", 4) == 0) {
+      if (!have_fmt) {
+        break;
+      }
+      asset.data = body;
+      asset.size = std::min<size_t>(chunk_size, avail - pos - 8);
+      return asset.size > 0;
+    }
+    pos += 8 + chunk_size + (chunk_size & 1);  // Chunks are word aligned
+  }
+
+  ESP_LOGE(TAG, "Prompt '%s': missing fmt/data chunk", asset.name.c_str());
+  return false;
+}
+
+bool PromptPlayer::play(const std::string &name, bool loop) {
+  for (size_t i = 0; i < this->prompts_.size(); i++) {
+    if (this->prompts_[i].name != name) {
+      continue;
+    }
+    if (!this->prompts_[i].valid) {
+      ESP_LOGW(TAG, "Prompt '%s' is not playable", name.c_str());
+      return false;
+    }
+    this->request_time_us_.store(esp_timer_get_time(), std::memory_order_relaxed);
+    this->request_loop_.store(loop, std::memory_order_relaxed);
+    this->stop_requested_.store(false, std::memory_order_relaxed);
+    this->requested_.store((int) i, std::memory_order_release);
+    this->playing_.store(true, std::memory_order_release);
+    return true;
+  }
+  ESP_LOGW(TAG, "Unknown prompt '%s'", name.c_str());
+  return false;
+}
+
+void PromptPlayer::begin_(int index) {
+  this->current_ = &this->prompts_[index];
+  this->pos_ = 0;
+  this->block_left_ = 0;
+  this->high_nibble_ = false;
+}
+
+bool PromptPlayer::next_sample_(int16_t *sample) {
+  if (this->current_->format == PromptFormat::IMA_ADPCM) {
+    return this->next_adpcm_sample_(sample);
+  }
+  if (this->pos_ + 2 > this->current_->size) {
+    return false;
+  }
+  *sample = (int16_t) read_le16(this->current_->data + this->pos_);
+  this->pos_ += 2;
+  return true;
+}
+
+bool PromptPlayer::next_adpcm_sample_(int16_t *sample) {
+  const uint8_t *data = this->current_->data;
+
+  // Block header: initial predictor (int16), step index, reserved - also the first sample
+  if (this->block_left_ == 0) {
+    if (this->pos_ + 4 > this->current_->size) {
+      return false;
+    }
+    this->predictor_ = (int16_t) read_le16(data + this->pos_);
+    this->step_index_ = std::min<int>(data[this->pos_ + 2], 88);
+    this->pos_ += 4;
+    this->block_left_ = std::min<size_t>(this->current_->block_align - 4, this->current_->size - this->pos_);
+    this->high_nibble_ = false;
+    *sample = (int16_t) this->predictor_;
+    return true;
+  }
+
+  uint8_t byte = data[this->pos_];
+  uint8_t nibble = this->high_nibble_ ? (byte >> 4) : (byte & 0x0F);
+  if (this->high_nibble_) {
+    this->pos_++;
+    this->block_left_--;
+  }
+  this->high_nibble_ = !this->high_nibble_;
+
+  int32_t step = IMA_STEP_TABLE[this->step_index_];
+  int32_t diff = step >> 3;
+  if (nibble & 1)
+    diff += step >> 2;
+  if (nibble & 2)
+    diff += step >> 1;
+  if (nibble & 4)
+    diff += step;
+  this->predictor_ = clamp16((nibble & 8) ? this->predictor_ - diff : this->predictor_ + diff);
+  this->step_index_ = std::max(0, std::min(88, this->step_index_ + IMA_INDEX_TABLE[nibble]));
+
+  *sample = (int16_t) this->predictor_;
+  return true;
+}
+
+bool PromptPlayer::mix(int16_t *frame, size_t samples) {
+  if (this->stop_requested_.exchange(false, std::memory_order_acq_rel)) {
+    this->current_ = nullptr;
+    this->requested_.store(-1, std::memory_order_relaxed);
+    this->playing_.store(false, std::memory_order_release);
+  }
+  int requested = this->requested_.exchange(-1, std::memory_order_acq_rel);
+  if (requested >= 0) {
+    this->begin_(requested);
+    this->loop_ = this->request_loop_.load(std::memory_order_relaxed);
+    this->first_frame_ = true;
+  }
+  if (this->current_ == nullptr) {
+    return false;
+  }
+
+  if (this->first_frame_) {
+    int64_t latency = esp_timer_get_time() - this->request_time_us_.load(std::memory_order_relaxed);
+    this->last_start_latency_us_.store((uint32_t) latency, std::memory_order_relaxed);
+    this->first_frame_ = false;
+  }
+
+  for (size_t i = 0; i < samples; i++) {
+    int16_t prompt = 0;
+    if (!this->next_sample_(&prompt)) {
+      if (!this->loop_) {
+        // Finished mid-frame: leave the rest of the call audio unducked
+        this->current_ = nullptr;
+        this->playing_.store(false, std::memory_order_release);
+        return true;
+      }
+      this->begin_(this->current_ - this->prompts_.data());
+      this->next_sample_(&prompt);
+    }
+    int32_t call = ((int32_t) frame[i] * this->duck_q15_) >> 15;
+    frame[i] = clamp16(call + prompt);
+  }
+  return true;
+}
+
+}  // namespace i2s_audio_duplex
+}  // namespace esphome
+
+#endif  // USE_ESP32
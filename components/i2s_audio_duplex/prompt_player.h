@@ -0,0 +1,94 @@
+#pragma once
+
+#ifdef USE_ESP32
+
+#include <esp_partition.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace esphome {
+namespace i2s_audio_duplex {
+
+enum class PromptFormat : uint8_t {
+  PCM16,
+  IMA_ADPCM,
+};
+
+// A WAV file stored at an offset in the prompt partition. Audio is read straight
+// from the memory-mapped flash, so RAM cost does not depend on the asset length.
+struct PromptAsset {
+  std::string name;
+  uint32_t offset{0};
+  const uint8_t *data{nullptr};  // Start of the WAV data chunk (mapped flash)
+  size_t size{0};                // Data chunk size in bytes
+  PromptFormat format{PromptFormat::PCM16};
+  uint16_t block_align{0};       // IMA ADPCM block size in bytes
+  bool valid{false};
+};
+
+// Plays prompts/ringtones from flash into the duplex speaker path.
+// play()/stop() are called from the main loop; mix() runs in the audio task and
+// owns all decoder state, so the two only communicate through atomics.
+class PromptPlayer {
+ public:
+  void set_partition(const std::string &label) { this->partition_label_ = label; }
+  void set_duck_level(float level) { this->duck_q15_ = (int32_t) (level * 32767.0f); }
+  void add_prompt(const std::string &name, uint32_t offset);
+
+  // Map the partition and parse all WAV headers. sample_rate must match the duplex.
+  bool setup(uint32_t sample_rate);
+
+  bool play(const std::string &name, bool loop);
+  void stop() { this->stop_requested_.store(true, std::memory_order_release); }
+  bool is_playing() const { return this->playing_.load(std::memory_order_acquire); }
+
+  // Audio task: duck call audio in-place and add prompt samples. Returns true while a prompt is playing.
+  bool mix(int16_t *frame, size_t samples);
+
+  // Time from play() to the first mixed sample of the last prompt
+  uint32_t get_last_start_latency_us() const { return this->last_start_latency_us_.load(std::memory_order_relaxed); }
+  size_t get_prompt_count() const { return this->prompts_.size(); }
+  const std::vector<PromptAsset> &get_prompts() const { return this->prompts_; }
+  const std::string &get_partition_label() const { return this->partition_label_; }
+
+ protected:
+  bool parse_wav_(PromptAsset &asset, const uint8_t *base, size_t avail, uint32_t sample_rate);
+  void begin_(int index);
+  bool next_sample_(int16_t *sample);
+  bool next_adpcm_sample_(int16_t *sample);
+
+  std::string partition_label_;
+  std::vector<PromptAsset> prompts_;
+  const void *mapped_{nullptr};
+  esp_partition_mmap_handle_t mmap_handle_{};
+  int32_t duck_q15_{8192};  // Call audio level while a prompt plays (0.25)
+
+  // Main loop -> audio task
+  std::atomic<int> requested_{-1};
+  std::atomic<bool> request_loop_{false};
+  std::atomic<bool> stop_requested_{false};
+  std::atomic<int64_t> request_time_us_{0};
+
+  // Audio task -> main loop
+  std::atomic<bool> playing_{false};
+  std::atomic<uint32_t> last_start_latency_us_{0};
+
+  // Decoder state (audio task only)
+  const PromptAsset *current_{nullptr};
+  bool loop_{false};
+  bool first_frame_{false};
+  size_t pos_{0};
+  size_t block_left_{0};
+  int32_t predictor_{0};
+  int step_index_{0};
+  bool high_nibble_{false};
+};
+
+}  // namespace i2s_audio_duplex
+}  // namespace esphome
+
+#endif  // USE_ESP32
@@ -0,0 +1,47 @@
+#pragma once
+
+#ifdef USE_ESP32
+
+#include "esphome/components/sensor/sensor.h"
+#include "esphome/core/component.h"
+#include "i2s_audio_duplex.h"
+
+namespace esphome {
+namespace i2s_audio_duplex {
+
+class I2SAudioDuplexSensor : public sensor::Sensor, public PollingComponent {
+ public:
+  void update() override {
+    if (this->parent_ == nullptr) return;
+
+    switch (this->sensor_type_) {
+      case 0:  // Prompt start latency (trigger -> first sample mixed)
+        this->publish_state(this->parent_->get_prompt_start_latency_us() / 1000.0f);
+        break;
+      case 1:  // Mic array cost per captured slot beyond the first
+        this->publish_state(this->parent_->get_channel_cycles());
+        break;
+      case 2:  // 32-bit capture narrowed to 16 bits, per frame
+        this->publish_state(this->parent_->get_wide_capture_cycles());
+        break;
+      case 3:  // Calibrated speaker write to mic read
+        this->publish_state(this->parent_->get_loopback_latency_ms());
+        break;
+      case 4:  // Calibrated echo level relative to the speaker reference
+        this->publish_state(this->parent_->get_echo_path_gain_db());
+        break;
+    }
+  }
+
+  void set_parent(I2SAudioDuplex *parent) { this->parent_ = parent; }
+  void set_sensor_type(uint8_t type) { this->sensor_type_ = type; }
+
+ protected:
+  I2SAudioDuplex *parent_{nullptr};
+  uint8_t sensor_type_{0};
+};
+
+}  // namespace i2s_audio_duplex
+}  // namespace esphome
+
+#endif  // USE_ESP32
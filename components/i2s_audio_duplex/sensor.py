@@ -0,0 +1,101 @@
+"""Sensors for I2S Audio Duplex component."""
+import esphome.codegen as cg
+import esphome.config_validation as cv
+from esphome.components import sensor
+from esphome.const import (
+    ENTITY_CATEGORY_DIAGNOSTIC,
+    STATE_CLASS_MEASUREMENT,
+    UNIT_DECIBEL,
+    UNIT_MILLISECOND,
+)
+
+from . import i2s_audio_duplex_ns, I2SAudioDuplex
+
+CONF_I2S_AUDIO_DUPLEX_ID = "i2s_audio_duplex_id"
+CONF_PROMPT_LATENCY = "prompt_latency"
+CONF_CHANNEL_CYCLES = "channel_cycles"
+CONF_WIDE_CAPTURE_CYCLES = "wide_capture_cycles"
+CONF_LOOPBACK_LATENCY = "loopback_latency"
+CONF_ECHO_PATH_GAIN = "echo_path_gain"
+
+I2SAudioDuplexSensor = i2s_audio_duplex_ns.class_(
+    "I2SAudioDuplexSensor", sensor.Sensor, cg.PollingComponent
+)
+
+CONFIG_SCHEMA = cv.Schema({
+    cv.GenerateID(CONF_I2S_AUDIO_DUPLEX_ID): cv.use_id(I2SAudioDuplex),
+    cv.Optional(CONF_PROMPT_LATENCY): sensor.sensor_schema(
+        I2SAudioDuplexSensor,
+        unit_of_measurement=UNIT_MILLISECOND,
+        accuracy_decimals=1,
+        entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        state_class=STATE_CLASS_MEASUREMENT,
+    ).extend(cv.polling_component_schema("10s")),
+    cv.Optional(CONF_CHANNEL_CYCLES): sensor.sensor_schema(
+        I2SAudioDuplexSensor,
+        unit_of_measurement="cycles",
+        accuracy_decimals=0,
+        entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        state_class=STATE_CLASS_MEASUREMENT,
+    ).extend(cv.polling_component_schema("10s")),
+    cv.Optional(CONF_WIDE_CAPTURE_CYCLES): sensor.sensor_schema(
+        I2SAudioDuplexSensor,
+        unit_of_measurement="cycles",
+        accuracy_decimals=0,
+        entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        state_class=STATE_CLASS_MEASUREMENT,
+    ).extend(cv.polling_component_schema("10s")),
+    cv.Optional(CONF_LOOPBACK_LATENCY): sensor.sensor_schema(
+        I2SAudioDuplexSensor,
+        unit_of_measurement=UNIT_MILLISECOND,
+        accuracy_decimals=2,
+        entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        state_class=STATE_CLASS_MEASUREMENT,
+    ).extend(cv.polling_component_schema("60s")),
+    cv.Optional(CONF_ECHO_PATH_GAIN): sensor.sensor_schema(
+        I2SAudioDuplexSensor,
+        unit_of_measurement=UNIT_DECIBEL,
+        accuracy_decimals=1,
+        entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        state_class=STATE_CLASS_MEASUREMENT,
+    ).extend(cv.polling_component_schema("60s")),
+})
+
+
+async def to_code(config):
+    parent = await cg.get_variable(config[CONF_I2S_AUDIO_DUPLEX_ID])
+
+    if CONF_PROMPT_LATENCY in config:
+        conf = config[CONF_PROMPT_LATENCY]
+        sens = await sensor.new_sensor(conf)
+        await cg.register_component(sens, conf)
+        cg.add(sens.set_parent(parent))
+        cg.add(sens.set_sensor_type(0))  # Prompt latency
+
+    if CONF_CHANNEL_CYCLES in config:
+        conf = config[CONF_CHANNEL_CYCLES]
+        sens = await sensor.new_sensor(conf)
+        await cg.register_component(sens, conf)
+        cg.add(sens.set_parent(parent))
+        cg.add(sens.set_sensor_type(1))  # Mic array cycles per extra slot
+
+    if CONF_WIDE_CAPTURE_CYCLES in config:
+        conf = config[CONF_WIDE_CAPTURE_CYCLES]
+        sens = await sensor.new_sensor(conf)
+        await cg.register_component(sens, conf)
+        cg.add(sens.set_parent(parent))
+        cg.add(sens.set_sensor_type(2))  # 32 -> 16 bit capture conversion
+
+    if CONF_LOOPBACK_LATENCY in config:
+        conf = config[CONF_LOOPBACK_LATENCY]
+        sens = await sensor.new_sensor(conf)
+        await cg.register_component(sens, conf)
+        cg.add(sens.set_parent(parent))
+        cg.add(sens.set_sensor_type(3))  # Calibrated loopback delay
+
+    if CONF_ECHO_PATH_GAIN in config:
+        conf = config[CONF_ECHO_PATH_GAIN]
+        sens = await sensor.new_sensor(conf)
+        await cg.register_component(sens, conf)
+        cg.add(sens.set_parent(parent))
+        cg.add(sens.set_sensor_type(4))  # Calibrated echo path gain
@@ -0,0 +1,73 @@
+#pragma once
+
+#ifdef USE_ESP32
+#ifdef USE_SPEAKER
+
+#include "esphome/components/speaker/speaker.h"
+#include "esphome/core/component.h"
+#include "esphome/core/helpers.h"
+#include "esphome/core/log.h"
+#include "i2s_audio_duplex.h"
+
+namespace esphome {
+namespace i2s_audio_duplex {
+
+// Standard ESPHome speaker writing into the duplex speaker buffer
+// (and therefore into the AEC reference), 16-bit mono at the duplex sample rate.
+class DuplexSpeaker : public speaker::Speaker, public Component, public Parented<I2SAudioDuplex> {
+ public:
+  void setup() override {
+    this->audio_stream_info_ = audio::AudioStreamInfo(16, 1, this->parent_->get_sample_rate());
+  }
+
+  void dump_config() override {
+    ESP_LOGCONFIG("i2s_audio_duplex.speaker", "I2S Audio Duplex Speaker");
+  }
+
+  void start() override {
+    if (this->audio_stream_info_.get_sample_rate() != this->parent_->get_sample_rate() ||
+        this->audio_stream_info_.get_bits_per_sample() != 16 || this->audio_stream_info_.get_channels() != 1) {
+      ESP_LOGE("i2s_audio_duplex.speaker", "Unsupported stream format, duplex bus is 16-bit mono %u Hz",
+               (unsigned) this->parent_->get_sample_rate());
+      return;
+    }
+    if (!this->parent_->is_running()) {
+      this->parent_->start();
+    }
+    this->state_ = speaker::STATE_RUNNING;
+  }
+
+  // Only stops accepting data - the duplex keeps running for its other users
+  void stop() override { this->state_ = speaker::STATE_STOPPED; }
+
+  size_t play(const uint8_t *data, size_t length) override { return this->play(data, length, 0); }
+  size_t play(const uint8_t *data, size_t length, TickType_t ticks_to_wait) override {
+    if (this->state_ != speaker::STATE_RUNNING) {
+      this->start();
+    }
+    if (this->state_ != speaker::STATE_RUNNING) {
+      return 0;
+    }
+    return this->parent_->play(data, length, ticks_to_wait);
+  }
+
+  bool has_buffered_data() const override { return this->parent_->has_buffered_speaker_data(); }
+
+  void set_volume(float volume) override {
+    this->volume_ = volume;
+    if (!this->mute_state_) {
+      this->parent_->set_speaker_volume(volume);
+    }
+  }
+
+  void set_mute_state(bool mute_state) override {
+    this->mute_state_ = mute_state;
+    this->parent_->set_speaker_volume(mute_state ? 0.0f : this->volume_);
+  }
+};
+
+}  // namespace i2s_audio_duplex
+}  // namespace esphome
+
+#endif  // USE_SPEAKER
+#endif  // USE_ESP32
@@ -0,0 +1,27 @@
+"""Speaker platform for I2S Audio Duplex - plays into the duplex speaker path"""
+import esphome.codegen as cg
+import esphome.config_validation as cv
+from esphome.components import speaker
+from esphome.const import CONF_ID
+
+from . import i2s_audio_duplex_ns, I2SAudioDuplex
+
+DEPENDENCIES = ["i2s_audio_duplex"]
+
+CONF_I2S_AUDIO_DUPLEX_ID = "i2s_audio_duplex_id"
+
+DuplexSpeaker = i2s_audio_duplex_ns.class_(
+    "DuplexSpeaker", speaker.Speaker, cg.Component, cg.Parented.template(I2SAudioDuplex)
+)
+
+CONFIG_SCHEMA = speaker.SPEAKER_SCHEMA.extend({
+    cv.GenerateID(): cv.declare_id(DuplexSpeaker),
+    cv.GenerateID(CONF_I2S_AUDIO_DUPLEX_ID): cv.use_id(I2SAudioDuplex),
+}).extend(cv.COMPONENT_SCHEMA)
+
+
+async def to_code(config):
+    var = cg.new_Pvariable(config[CONF_ID])
+    await cg.register_component(var, config)
+    await cg.register_parented(var, config[CONF_I2S_AUDIO_DUPLEX_ID])
+    await speaker.register_speaker(var, config)
@@ -11,11 +11,20 @@ Supports:
 - Echo cancellation integration (esp_aec)
 """
 
+import logging
+
 import esphome.codegen as cg
 import esphome.config_validation as cv
 from esphome import automation
-from esphome.components import microphone, speaker
-from esphome.const import CONF_ID, CONF_PORT
+import esphome.final_validate as fv
+from esphome.components import microphone, speaker, web_server_base
+from esphome.components.esp32 import add_idf_sdkconfig_option
+from esphome.components.web_server_base import CONF_WEB_SERVER_BASE_ID
+from esphome.const import CONF_DURATION, CONF_FORMAT, CONF_ID, CONF_KEY, CONF_MODE, CONF_PATH, CONF_PORT, CONF_TIMEOUT
+
+from .latency import Geometry, plan_latency
+
+_LOGGER = logging.getLogger(__name__)
 
 CODEOWNERS = ["@n-IA-hane"]
 DEPENDENCIES = []
@@ -32,15 +41,190 @@ CONF_BUFFER_SIZE = "buffer_size"
 CONF_PREBUFFER_SIZE = "prebuffer_size"
 CONF_ON_START = "on_start"
 CONF_ON_STOP = "on_stop"
+CONF_ON_PEER_LOST = "on_peer_lost"
 CONF_DC_OFFSET_REMOVAL = "dc_offset_removal"
+CONF_SAMPLE_RATE = "sample_rate"
+CONF_FRAME_DURATION = "frame_duration"
+CONF_PACKET_DURATION = "packet_duration"
+CONF_TX_CODEC = "tx_codec"
+CONF_RX_CODEC = "rx_codec"
+CONF_TRANSPORT = "transport"
+CONF_FEC = "fec"
+CONF_GROUP_SIZE = "group_size"
+CONF_LOSS_THRESHOLD = "loss_threshold"
+CONF_ADAPTATION = "adaptation"
+CONF_CALL_PROFILE = "call_profile"
+CONF_DSCP = "dscp"
+CONF_DISABLE_POWER_SAVE = "disable_power_save"
+CONF_TX_POWER = "tx_power"
+CONF_IDLE_LIGHT_SLEEP = "idle_light_sleep"
+CONF_IDLE_LOOP_INTERVAL = "idle_loop_interval"
+CONF_MAX_FRAMES_PER_PACKET = "max_frames_per_packet"
+CONF_CODEC_FALLBACK = "codec_fallback"
+CONF_ENCRYPTION = "encryption"
+CONF_KEEPALIVE = "keepalive"
+CONF_STOP_ON_PEER_LOST = "stop_on_peer_lost"
+CONF_CIPHER = "cipher"
+CONF_RECORDING = "recording"
+CONF_HISTORY = "history"
+CONF_PRE_ROLL = "pre_roll"
+CONF_RECORD_CALLS = "record_calls"
+CONF_WEB_EXPORT = "web_export"
+CONF_TRACE = "trace"
+CONF_METRICS = "metrics"
+CONF_DISCOVERY_ID = "discovery_id"
+CONF_FAULT_INJECTION = "fault_injection"
+CONF_SEND_ERROR = "send_error"
+CONF_RECEIVE_LOSS = "receive_loss"
+CONF_SPEAKER_STALL = "speaker_stall"
+CONF_MIC_OVERFLOW = "mic_overflow"
+CONF_I2S_READ_TIMEOUT = "i2s_read_timeout"
+CONF_I2S_WRITE_TIMEOUT = "i2s_write_timeout"
+CONF_LATENCY_TARGET = "latency_target"
+# Keys of the components latency_target looks at
+CONF_DMA_BUFFER_COUNT = "dma_buffer_count"
+CONF_DMA_BUFFER_SIZE = "dma_buffer_size"
+CONF_SPEAKER_BUFFER_SIZE = "speaker_buffer_size"
+CONF_BITS_PER_SAMPLE = "bits_per_sample"
+CONF_MIC_ARRAY = "mic_array"
+CONF_SLOTS = "slots"
+CONF_BUFFER_DURATION = "buffer_duration"
 
 intercom_audio_ns = cg.esphome_ns.namespace("intercom_audio")
 IntercomAudio = intercom_audio_ns.class_("IntercomAudio", cg.Component)
 
+PayloadCodec = intercom_audio_ns.enum("PayloadCodec", is_class=True)
+PAYLOAD_CODECS = {
+    "pcm": PayloadCodec.PCM16,
+    "alaw": PayloadCodec.G711_ALAW,
+    "ulaw": PayloadCodec.G711_ULAW,
+}
+
+# Adaptation fallback: "none" keeps PCM
+CODEC_FALLBACKS = {
+    "none": PayloadCodec.PCM16,
+    "alaw": PayloadCodec.G711_ALAW,
+    "ulaw": PayloadCodec.G711_ULAW,
+}
+
+FecMode = intercom_audio_ns.enum("FecMode", is_class=True)
+FEC_MODES = {
+    "xor": FecMode.XOR,
+    "red": FecMode.RED,
+}
+
+# Components that run Bluetooth next to Wi-Fi (coexistence needs modem sleep)
+BLE_COMPONENTS = [
+    "esp32_ble",
+    "esp32_ble_beacon",
+    "esp32_ble_server",
+    "esp32_ble_tracker",
+    "bluetooth_proxy",
+]
+
+# DSCP code points for the call profile (EF maps to WMM AC_VO)
+DSCP_CLASSES = {
+    "ef": 46,
+    "cs5": 40,
+    "af41": 34,
+    "none": 0,
+}
+
+CipherSuite = intercom_audio_ns.enum("CipherSuite", is_class=True)
+CIPHER_SUITES = {
+    "aes_gcm": CipherSuite.AES_256_GCM,
+    "chacha20_poly1305": CipherSuite.CHACHA20_POLY1305,
+}
+
+RecordFormat = intercom_audio_ns.enum("RecordFormat", is_class=True)
+RECORD_FORMATS = {
+    "pcm": RecordFormat.PCM16,
+    "ulaw": RecordFormat.ULAW,
+}
+RECORD_FORMAT_BYTES = {"pcm": 2, "ulaw": 1}
+
+Fault = intercom_audio_ns.enum("Fault", is_class=True)
+FAULTS = {
+    CONF_SEND_ERROR: Fault.SEND_ERROR,
+    CONF_RECEIVE_LOSS: Fault.RECEIVE_LOSS,
+    CONF_SPEAKER_STALL: Fault.SPEAKER_STALL,
+    CONF_MIC_OVERFLOW: Fault.MIC_OVERFLOW,
+    CONF_I2S_READ_TIMEOUT: Fault.I2S_READ_TIMEOUT,
+    CONF_I2S_WRITE_TIMEOUT: Fault.I2S_WRITE_TIMEOUT,
+}
+
+TransportType = intercom_audio_ns.enum("TransportType", is_class=True)
+TRANSPORTS = {
+    "socket": TransportType.SOCKET,
+    "netconn": TransportType.NETCONN,
+}
+
+# Stream formats (frame size is fixed at compile time)
+SUPPORTED_SAMPLE_RATES = [8000, 16000, 24000, 32000, 48000]
+SUPPORTED_FRAME_DURATIONS_MS = [10, 16, 20]
+# ESP-SR AEC processes 16 ms chunks
+AEC_FRAME_DURATION_MS = 16
+# G.711 is carried at 8 kHz and resampled 2:1
+G711_DEVICE_RATE = 16000
+
+# Frames packed into one UDP packet, and the UDP payload that still fits a
+# 1500-byte MTU (lwIP on ESP32 does not reassemble fragments by default)
+MAX_PACKET_FRAMES = 4
+MAX_DATAGRAM_BYTES = 1472
+# Encrypted packets always carry the framed header and an authentication tag
+PACKET_HEADER_BYTES = 10
+AEAD_TAG_BYTES = 16
+ENCRYPTION_KEY_BYTES = 32
+# Recording ring: a power of two samples, in PSRAM
+RECORDING_MAX_BYTES = 4 * 1024 * 1024
+# Trace ring: a power of two records of one frame each, about five per frame
+TRACE_RECORD_HEADER_BYTES = 24
+TRACE_RECORDS_PER_FRAME = 5
+TRACE_MAX_BYTES = 4 * 1024 * 1024
+
+
+def validate_frame_duration(value):
+    value = cv.positive_time_period_milliseconds(value)
+    if value.total_milliseconds not in SUPPORTED_FRAME_DURATIONS_MS:
+        raise cv.Invalid(
+            f"frame_duration must be one of {', '.join(f'{d}ms' for d in SUPPORTED_FRAME_DURATIONS_MS)}"
+        )
+    return value
+
+
+def validate_encryption_key(value):
+    value = cv.string_strict(value).replace(":", "").replace(" ", "")
+    try:
+        key = bytes.fromhex(value)
+    except ValueError as err:
+        raise cv.Invalid("encryption key must be hexadecimal") from err
+    if len(key) != ENCRYPTION_KEY_BYTES:
+        raise cv.Invalid(
+            f"encryption key must be {ENCRYPTION_KEY_BYTES} bytes ({ENCRYPTION_KEY_BYTES * 2} hex characters)"
+        )
+    return value
+
+
+def validate_export_path(value):
+    value = cv.string_strict(value)
+    if not value.startswith("/"):
+        raise cv.Invalid("web_export path must start with '/'")
+    return value
+
+
+def web_export_schema(default_path):
+    return cv.Schema({
+        cv.GenerateID(CONF_WEB_SERVER_BASE_ID): cv.use_id(web_server_base.WebServerBase),
+        cv.Optional(CONF_PATH, default=default_path): validate_export_path,
+    })
+
+
 # Actions
 StartAction = intercom_audio_ns.class_("StartAction", automation.Action)
 StopAction = intercom_audio_ns.class_("StopAction", automation.Action)
 ResetCountersAction = intercom_audio_ns.class_("ResetCountersAction", automation.Action)
+RecordingStartAction = intercom_audio_ns.class_("RecordingStartAction", automation.Action)
+RecordingStopAction = intercom_audio_ns.class_("RecordingStopAction", automation.Action)
 
 # Forward declare esp_aec if available
 esp_aec_ns = cg.esphome_ns.namespace("esp_aec")
@@ -50,6 +234,25 @@ EspAec = esp_aec_ns.class_("EspAec")
 i2s_audio_duplex_ns = cg.esphome_ns.namespace("i2s_audio_duplex")
 I2SAudioDuplex = i2s_audio_duplex_ns.class_("I2SAudioDuplex")
 
+# Forward declare mdns_discovery (metrics only)
+mdns_discovery_ns = cg.esphome_ns.namespace("mdns_discovery")
+MdnsDiscovery = mdns_discovery_ns.class_("MdnsDiscovery")
+
+
+def validate_buffer_sizes(config):
+    buffer_size = config[CONF_BUFFER_SIZE]
+    prebuffer_size = config[CONF_PREBUFFER_SIZE]
+    if prebuffer_size >= buffer_size:
+        raise cv.Invalid(
+            f"prebuffer_size ({prebuffer_size}) must be smaller than "
+            f"buffer_size ({buffer_size})"
+        )
+    # Minimum buffer size for reasonable audio (64ms at 16kHz = 2048 bytes)
+    if buffer_size < 2048:
+        raise cv.Invalid(
+            f"buffer_size ({buffer_size}) is too small, minimum is 2048 bytes"
+        )
+
 
 def validate_audio_config(config):
     """Validate audio configuration.
@@ -73,19 +276,106 @@ def validate_audio_config(config):
                 "At least one audio source required: duplex_id, microphone_id, or speaker_id"
             )
 
-    # Validate buffer sizes
-    buffer_size = config.get(CONF_BUFFER_SIZE, 8192)
-    prebuffer_size = config.get(CONF_PREBUFFER_SIZE, 2048)
-    if prebuffer_size >= buffer_size:
+    # With latency_target the buffer sizes left out are planned in final validation
+    if CONF_LATENCY_TARGET not in config:
+        config.setdefault(CONF_BUFFER_SIZE, 8192)
+        config.setdefault(CONF_PREBUFFER_SIZE, 2048)
+        validate_buffer_sizes(config)
+
+    # G.711 resampling is a fixed 2:1 against the device rate
+    uses_g711 = any(config.get(key, "pcm") != "pcm" for key in (CONF_TX_CODEC, CONF_RX_CODEC))
+    if uses_g711 and config[CONF_SAMPLE_RATE] != G711_DEVICE_RATE:
+        raise cv.Invalid(f"tx_codec/rx_codec alaw and ulaw require sample_rate {G711_DEVICE_RATE}")
+
+    # Packetization interval: whole frames, one unfragmented datagram
+    frame_ms = int(config[CONF_FRAME_DURATION].total_milliseconds)
+    packet_ms = int(config.setdefault(CONF_PACKET_DURATION, config[CONF_FRAME_DURATION]).total_milliseconds)
+    if packet_ms % frame_ms != 0 or not 1 <= packet_ms // frame_ms <= MAX_PACKET_FRAMES:
         raise cv.Invalid(
-            f"prebuffer_size ({prebuffer_size}) must be smaller than "
-            f"buffer_size ({buffer_size})"
+            f"packet_duration must be 1 to {MAX_PACKET_FRAMES} times frame_duration ({frame_ms}ms)"
         )
-    # Minimum buffer size for reasonable audio (64ms at 16kHz = 2048 bytes)
-    if buffer_size < 2048:
+    packet_frames = packet_ms // frame_ms
+    frame_samples = config[CONF_SAMPLE_RATE] * frame_ms // 1000
+    frame_bytes = frame_samples * 2 if config.get(CONF_TX_CODEC, "pcm") == "pcm" else frame_samples // 2
+    if packet_frames > 1 and packet_frames * frame_bytes > MAX_DATAGRAM_BYTES:
         raise cv.Invalid(
-            f"buffer_size ({buffer_size}) is too small, minimum is 2048 bytes"
+            f"packet_duration {packet_ms}ms is {packet_frames * frame_bytes} bytes per packet, more than "
+            f"one unfragmented UDP datagram ({MAX_DATAGRAM_BYTES}); use a shorter packet or a G.711 tx_codec"
         )
+    # Sealed packets are never fragmented, so even a single frame has to fit
+    sealed_bytes = packet_frames * frame_bytes + PACKET_HEADER_BYTES + AEAD_TAG_BYTES
+    if CONF_ENCRYPTION in config and sealed_bytes > MAX_DATAGRAM_BYTES:
+        raise cv.Invalid(
+            f"encrypted packets of {packet_ms}ms are {sealed_bytes} bytes, more than one unfragmented "
+            f"UDP datagram ({MAX_DATAGRAM_BYTES}); use a shorter frame/packet or a G.711 tx_codec"
+        )
+
+    # netconn plays straight out of the received pbufs, which only works for PCM
+    if config.get(CONF_TRANSPORT, "socket") == "netconn" and config.get(CONF_RX_CODEC, "pcm") != "pcm":
+        raise cv.Invalid("transport: netconn requires rx_codec: pcm")
+    if config.get(CONF_TRANSPORT, "socket") == "netconn" and CONF_FEC in config:
+        raise cv.Invalid("fec requires transport: socket")
+    if config.get(CONF_TRANSPORT, "socket") == "netconn" and CONF_ADAPTATION in config:
+        raise cv.Invalid("adaptation requires transport: socket")
+    if config.get(CONF_TRANSPORT, "socket") == "netconn" and CONF_ENCRYPTION in config:
+        raise cv.Invalid("encryption requires transport: socket")
+    if config.get(CONF_TRANSPORT, "socket") == "netconn" and CONF_KEEPALIVE in config:
+        raise cv.Invalid("keepalive requires transport: socket")
+    if CONF_ON_PEER_LOST in config and CONF_KEEPALIVE not in config:
+        raise cv.Invalid("on_peer_lost requires keepalive")
+    if CONF_ADAPTATION in config:
+        adaptation = config[CONF_ADAPTATION]
+        adaptation.setdefault(CONF_MAX_FRAMES_PER_PACKET, max(2, packet_frames))
+        if adaptation[CONF_MAX_FRAMES_PER_PACKET] < packet_frames:
+            raise cv.Invalid("adaptation max_frames_per_packet must be at least the frames in packet_duration")
+        if CONF_CODEC_FALLBACK not in adaptation:
+            default = "ulaw" if config[CONF_SAMPLE_RATE] == G711_DEVICE_RATE else "none"
+            adaptation[CONF_CODEC_FALLBACK] = cv.enum(CODEC_FALLBACKS, lower=True)(default)
+        fallback = adaptation[CONF_CODEC_FALLBACK]
+        if fallback != "none" and config[CONF_SAMPLE_RATE] != G711_DEVICE_RATE:
+            raise cv.Invalid(f"adaptation codec_fallback {fallback} requires sample_rate {G711_DEVICE_RATE}")
+
+    if CONF_RECORDING in config:
+        recording = config[CONF_RECORDING]
+        if not has_duplex and not has_mic:
+            raise cv.Invalid("recording requires duplex_id or microphone_id")
+        history_ms = int(recording[CONF_HISTORY].total_milliseconds)
+        pre_roll_ms = int(recording[CONF_PRE_ROLL].total_milliseconds)
+        if pre_roll_ms >= history_ms:
+            raise cv.Invalid("recording pre_roll must be shorter than history")
+        # The ring is rounded up to a power of two samples
+        samples = 1
+        while samples < config[CONF_SAMPLE_RATE] * history_ms // 1000:
+            samples *= 2
+        ring_bytes = samples * RECORD_FORMAT_BYTES[recording[CONF_FORMAT]]
+        if ring_bytes > RECORDING_MAX_BYTES:
+            raise cv.Invalid(
+                f"recording history {history_ms // 1000}s needs {ring_bytes} bytes, more than "
+                f"{RECORDING_MAX_BYTES}; use a shorter history or format: ulaw"
+            )
+        # The I2S driver holds a PM lock while the microphone runs
+        if pre_roll_ms > 0 and config[CONF_CALL_PROFILE][CONF_IDLE_LIGHT_SLEEP]:
+            raise cv.Invalid(
+                "recording pre_roll keeps the microphone running between calls; "
+                "it cannot be combined with call_profile idle_light_sleep"
+            )
+
+    if CONF_TRACE in config:
+        trace_ms = int(config[CONF_TRACE][CONF_DURATION].total_milliseconds)
+        records = 1
+        while records < trace_ms // frame_ms * TRACE_RECORDS_PER_FRAME:
+            records *= 2
+        trace_bytes = records * (TRACE_RECORD_HEADER_BYTES + frame_samples * 2)
+        if trace_bytes > TRACE_MAX_BYTES:
+            raise cv.Invalid(
+                f"trace duration {trace_ms // 1000}s needs {trace_bytes} bytes, more than {TRACE_MAX_BYTES}"
+            )
+
+    # The I2S faults are injected in the duplex audio task
+    if CONF_FAULT_INJECTION in config and not has_duplex:
+        for key in (CONF_I2S_READ_TIMEOUT, CONF_I2S_WRITE_TIMEOUT):
+            if config[CONF_FAULT_INJECTION][key] > 0:
+                raise cv.Invalid(f"fault_injection {key} requires duplex_id")
 
     return config
 
@@ -104,20 +394,211 @@ CONFIG_SCHEMA = cv.All(
         cv.Optional(CONF_REMOTE_PORT, default=12346): cv.templatable(cv.All(
             cv.port, cv.Range(min=1024, max=65535)
         )),
-        cv.Optional(CONF_BUFFER_SIZE, default=8192): cv.All(
+        # Default 8192 / 2048, or sized by latency_target
+        cv.Optional(CONF_BUFFER_SIZE): cv.All(
             cv.positive_int, cv.Range(min=2048, max=65536)
         ),
-        cv.Optional(CONF_PREBUFFER_SIZE, default=2048): cv.All(
+        cv.Optional(CONF_PREBUFFER_SIZE): cv.All(
             cv.positive_int, cv.Range(min=512, max=32768)
         ),
+        # Expected mouth-to-ear latency to plan the buffering for (see latency.py)
+        cv.Optional(CONF_LATENCY_TARGET): cv.All(
+            cv.positive_time_period_milliseconds,
+            cv.Range(min=cv.TimePeriod(milliseconds=20), max=cv.TimePeriod(milliseconds=2000)),
+        ),
         cv.Optional(CONF_DC_OFFSET_REMOVAL, default=False): cv.boolean,
+        # Must match the duplex / microphone / AEC configuration (checked below)
+        cv.Optional(CONF_SAMPLE_RATE, default=16000): cv.one_of(*SUPPORTED_SAMPLE_RATES, int=True),
+        cv.Optional(CONF_FRAME_DURATION, default="16ms"): validate_frame_duration,
+        # Audio per UDP packet, a multiple of frame_duration (default: one frame)
+        cv.Optional(CONF_PACKET_DURATION): cv.positive_time_period_milliseconds,
+        # Wire format per direction; G.711 is 8 kHz, resampled on-device
+        cv.Optional(CONF_TX_CODEC, default="pcm"): cv.enum(PAYLOAD_CODECS, lower=True),
+        cv.Optional(CONF_RX_CODEC, default="pcm"): cv.enum(PAYLOAD_CODECS, lower=True),
+        cv.Optional(CONF_TRANSPORT, default="socket"): cv.enum(TRANSPORTS, lower=True),
+        cv.Optional(CONF_FEC): cv.Schema({
+            cv.Required(CONF_MODE): cv.enum(FEC_MODES, lower=True),
+            cv.Optional(CONF_GROUP_SIZE, default=4): cv.int_range(min=2, max=8),
+            cv.Optional(CONF_LOSS_THRESHOLD, default="1%"): cv.percentage,
+        }),
+        cv.Optional(CONF_ADAPTATION): cv.Schema({
+            # Default: 2, or the frames in packet_duration if that is more
+            cv.Optional(CONF_MAX_FRAMES_PER_PACKET): cv.int_range(min=1, max=MAX_PACKET_FRAMES),
+            # Default: ulaw where G.711 is possible (16 kHz), none otherwise
+            cv.Optional(CONF_CODEC_FALLBACK): cv.enum(CODEC_FALLBACKS, lower=True),
+        }),
+        # Applied on start, restored on stop; nothing changes unless asked for
+        cv.Optional(CONF_CALL_PROFILE, default={}): cv.Schema({
+            cv.Optional(CONF_DSCP, default="none"): cv.one_of(*DSCP_CLASSES, lower=True),
+            cv.Optional(CONF_DISABLE_POWER_SAVE, default=False): cv.boolean,
+            cv.Optional(CONF_TX_POWER): cv.All(cv.decibel, cv.float_range(min=8.5, max=20.5)),
+            # Between calls (the reverse: applied on stop and at boot)
+            cv.Optional(CONF_IDLE_LIGHT_SLEEP, default=False): cv.boolean,
+            cv.Optional(CONF_IDLE_LOOP_INTERVAL): cv.All(
+                cv.positive_time_period_milliseconds, cv.Range(min=cv.TimePeriod(milliseconds=16))
+            ),
+        }),
+        cv.Optional(CONF_ENCRYPTION): cv.Schema({
+            cv.Required(CONF_KEY): validate_encryption_key,
+            cv.Optional(CONF_CIPHER, default="aes_gcm"): cv.enum(CIPHER_SUITES, lower=True),
+        }),
+        # Peer loss detection: the peer is gone after this long without a packet.
+        # Keepalives go out every 200 ms of silence, so a few can be lost.
+        cv.Optional(CONF_KEEPALIVE): cv.Schema({
+            cv.Optional(CONF_TIMEOUT, default="1s"): cv.All(
+                cv.positive_time_period_milliseconds, cv.Range(min=cv.TimePeriod(milliseconds=500))
+            ),
+            cv.Optional(CONF_STOP_ON_PEER_LOST, default=False): cv.boolean,
+        }),
+        # Ring of the outgoing audio; pre_roll keeps it fed between calls
+        cv.Optional(CONF_RECORDING): cv.Schema({
+            cv.Optional(CONF_HISTORY, default="30s"): cv.All(
+                cv.positive_time_period_milliseconds, cv.Range(min=cv.TimePeriod(seconds=1))
+            ),
+            cv.Optional(CONF_PRE_ROLL, default="5s"): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_FORMAT, default="ulaw"): cv.enum(RECORD_FORMATS, lower=True),
+            cv.Optional(CONF_RECORD_CALLS, default=True): cv.boolean,
+            cv.Optional(CONF_WEB_EXPORT): web_export_schema("/intercom/recording.wav"),
+        }),
+        # Debug trace ring, switched on at runtime (switch platform)
+        cv.Optional(CONF_TRACE): cv.Schema({
+            cv.Optional(CONF_DURATION, default="5s"): cv.All(
+                cv.positive_time_period_milliseconds, cv.Range(min=cv.TimePeriod(seconds=1))
+            ),
+            cv.Optional(CONF_WEB_EXPORT): web_export_schema("/intercom/trace.bin"),
+        }),
+        # Prometheus scrape target on the local web server
+        cv.Optional(CONF_METRICS): web_export_schema("/metrics").extend({
+            cv.Optional(CONF_DISCOVERY_ID): cv.use_id(MdnsDiscovery),
+        }),
+        # Soak builds only (tools/soak.py): fail this share of events on purpose
+        cv.Optional(CONF_FAULT_INJECTION): cv.Schema({
+            cv.Optional(key, default="0%"): cv.percentage for key in FAULTS
+        }),
         cv.Optional(CONF_ON_START): automation.validate_automation(single=True),
         cv.Optional(CONF_ON_STOP): automation.validate_automation(single=True),
+        cv.Optional(CONF_ON_PEER_LOST): automation.validate_automation(single=True),
     }).extend(cv.COMPONENT_SCHEMA),
     validate_audio_config,
 )
 
 
+def _get_config_for_id(full_config, id_):
+    path = full_config.get_path_for_id(id_)[:-1]
+    return full_config.get_config_for_path(path)
+
+
+def _final_validate(config):
+    """Every component touching the stream must agree on its format."""
+    full_config = fv.full_config.get()
+    rate = config[CONF_SAMPLE_RATE]
+    duration = config[CONF_FRAME_DURATION]
+
+    if CONF_DUPLEX_ID in config:
+        duplex_config = _get_config_for_id(full_config, config[CONF_DUPLEX_ID])
+        duplex_rate = duplex_config.get(CONF_SAMPLE_RATE, 16000)
+        if duplex_rate != rate:
+            raise cv.Invalid(
+                f"sample_rate ({rate}) must match i2s_audio_duplex sample_rate ({duplex_rate})"
+            )
+        duplex_duration = duplex_config.get(CONF_FRAME_DURATION)
+        if duplex_duration is not None and duplex_duration != duration:
+            raise cv.Invalid(
+                f"frame_duration ({duration}) must match i2s_audio_duplex frame_duration ({duplex_duration})"
+            )
+
+    if CONF_MICROPHONE_ID in config:
+        mic_config = _get_config_for_id(full_config, config[CONF_MICROPHONE_ID])
+        mic_rate = mic_config.get(CONF_SAMPLE_RATE)
+        if mic_rate is not None and mic_rate != rate:
+            raise cv.Invalid(f"sample_rate ({rate}) must match the microphone sample_rate ({mic_rate})")
+
+    if CONF_AEC_ID in config:
+        aec_config = _get_config_for_id(full_config, config[CONF_AEC_ID])
+        aec_rate = aec_config.get(CONF_SAMPLE_RATE, 16000)
+        if aec_rate != rate:
+            raise cv.Invalid(f"esp_aec sample_rate ({aec_rate}) must match sample_rate ({rate})")
+        if duration.total_milliseconds != AEC_FRAME_DURATION_MS:
+            raise cv.Invalid(f"frame_duration must be {AEC_FRAME_DURATION_MS}ms when aec_id is set")
+
+    # ESP-IDF refuses WIFI_PS_NONE while Wi-Fi and Bluetooth share the radio,
+    # the same combination the wifi component rejects for power_save_mode: none
+    if config[CONF_CALL_PROFILE][CONF_DISABLE_POWER_SAVE]:
+        for conflicting in BLE_COMPONENTS:
+            if conflicting in full_config:
+                raise cv.Invalid(
+                    f"call_profile disable_power_save is incompatible with {conflicting}: "
+                    "Wi-Fi modem sleep must stay on while Bluetooth shares the radio"
+                )
+
+    _plan_latency(config, full_config)
+    return config
+
+
+def _fec_hold_packets(config):
+    """Packets a gap can wait in the reorder window for its repair."""
+    if CONF_FEC not in config:
+        return 0
+    fec = config[CONF_FEC]
+    # red: the next packet carries the copy; xor: the rest of the parity group
+    return fec[CONF_GROUP_SIZE] if fec[CONF_MODE] == "xor" else 1
+
+
+def _plan_latency(config, full_config):
+    """Budget the mouth-to-ear latency and, with latency_target, size the buffering.
+
+    Sizes picked here are written back into this config and the duplex config:
+    final validation runs before any code is generated.
+    """
+    frame_ms = int(config[CONF_FRAME_DURATION].total_milliseconds)
+    geometry = Geometry(
+        sample_rate=config[CONF_SAMPLE_RATE],
+        frame_ms=frame_ms,
+        packet_frames=int(config[CONF_PACKET_DURATION].total_milliseconds) // frame_ms,
+        fec_hold_packets=_fec_hold_packets(config),
+        prebuffer_size=config.get(CONF_PREBUFFER_SIZE),
+        buffer_size=config.get(CONF_BUFFER_SIZE),
+    )
+    duplex_config = None
+    if CONF_DUPLEX_ID in config:
+        duplex_config = _get_config_for_id(full_config, config[CONF_DUPLEX_ID])
+        slots = duplex_config.get(CONF_MIC_ARRAY, {}).get(CONF_SLOTS, 1)
+        geometry.duplex = True
+        geometry.dma_buffer_count = duplex_config.get(CONF_DMA_BUFFER_COUNT)
+        geometry.dma_buffer_size = duplex_config.get(CONF_DMA_BUFFER_SIZE)
+        geometry.dma_frame_bytes = slots * duplex_config.get(CONF_BITS_PER_SAMPLE, 16) // 8
+        geometry.speaker_buffer_size = duplex_config.get(CONF_SPEAKER_BUFFER_SIZE)
+    elif CONF_SPEAKER_ID in config:
+        speaker_config = _get_config_for_id(full_config, config[CONF_SPEAKER_ID])
+        if CONF_BUFFER_DURATION in speaker_config:
+            geometry.speaker_buffer_ms = speaker_config[CONF_BUFFER_DURATION].total_milliseconds
+
+    target = config.get(CONF_LATENCY_TARGET)
+    try:
+        plan = plan_latency(geometry, None if target is None else int(target.total_milliseconds))
+    except ValueError as err:
+        raise cv.Invalid(str(err)) from err
+
+    if plan.prebuffer_size is not None:
+        config[CONF_PREBUFFER_SIZE] = plan.prebuffer_size
+    if plan.buffer_size is not None:
+        config[CONF_BUFFER_SIZE] = plan.buffer_size
+    if duplex_config is not None:
+        if plan.dma_buffer_count is not None:
+            duplex_config[CONF_DMA_BUFFER_COUNT] = plan.dma_buffer_count
+        if plan.dma_buffer_size is not None:
+            duplex_config[CONF_DMA_BUFFER_SIZE] = plan.dma_buffer_size
+        if plan.speaker_buffer_size is not None:
+            duplex_config[CONF_SPEAKER_BUFFER_SIZE] = plan.speaker_buffer_size
+    if target is not None:
+        validate_buffer_sizes(config)
+    _LOGGER.info("intercom_audio latency budget (expected %.0f ms, worst %.0f ms):\n%s",
+                 plan.expected_ms, plan.worst_ms, plan.format())
+
+
+FINAL_VALIDATE_SCHEMA = _final_validate
+
+
 async def to_code(config):
     var = cg.new_Pvariable(config[CONF_ID])
     await cg.register_component(var, config)
@@ -158,10 +639,115 @@ async def to_code(config):
     # Buffer settings
     cg.add(var.set_buffer_size(config[CONF_BUFFER_SIZE]))
     cg.add(var.set_prebuffer_size(config[CONF_PREBUFFER_SIZE]))
+    if CONF_LATENCY_TARGET in config:
+        cg.add(var.set_latency_target(config[CONF_LATENCY_TARGET]))
 
     # DC offset removal (for mics with significant DC bias like SPH0645)
     cg.add(var.set_dc_offset_removal(config[CONF_DC_OFFSET_REMOVAL]))
 
+    # Stream format: frame-sized buffers and loops are compile-time constants
+    cg.add_define("INTERCOM_AUDIO_SAMPLE_RATE", config[CONF_SAMPLE_RATE])
+    cg.add_define(
+        "INTERCOM_AUDIO_FRAME_SAMPLES",
+        config[CONF_SAMPLE_RATE] * int(config[CONF_FRAME_DURATION].total_milliseconds) // 1000,
+    )
+
+    # Frames per UDP packet
+    cg.add(var.set_packet_frames(
+        int(config[CONF_PACKET_DURATION].total_milliseconds) // int(config[CONF_FRAME_DURATION].total_milliseconds)
+    ))
+
+    # Payload codecs
+    cg.add(var.set_tx_codec(config[CONF_TX_CODEC]))
+    cg.add(var.set_rx_codec(config[CONF_RX_CODEC]))
+
+    # UDP transport: BSD sockets or lwIP netconn (fewer payload copies)
+    cg.add(var.set_transport(config[CONF_TRANSPORT]))
+
+    # Call profile: voice DSCP on the sockets, Wi-Fi settings while streaming
+    profile = config[CONF_CALL_PROFILE]
+    cg.add(var.set_dscp(DSCP_CLASSES[profile[CONF_DSCP]]))
+    cg.add(var.set_disable_power_save(profile[CONF_DISABLE_POWER_SAVE]))
+    if CONF_TX_POWER in profile:
+        cg.add(var.set_tx_power(profile[CONF_TX_POWER]))
+    if profile[CONF_IDLE_LIGHT_SLEEP]:
+        cg.add(var.set_idle_light_sleep(True))
+        # Automatic light sleep: power management plus a tickless FreeRTOS idle task
+        add_idf_sdkconfig_option("CONFIG_PM_ENABLE", True)
+        add_idf_sdkconfig_option("CONFIG_FREERTOS_USE_TICKLESS_IDLE", True)
+    if CONF_IDLE_LOOP_INTERVAL in profile:
+        cg.add(var.set_idle_loop_interval(profile[CONF_IDLE_LOOP_INTERVAL]))
+
+    # Forward error correction (negotiated with the peer each session)
+    if CONF_FEC in config:
+        fec = config[CONF_FEC]
+        cg.add(var.set_fec_mode(fec[CONF_MODE]))
+        cg.add(var.set_fec_group_size(fec[CONF_GROUP_SIZE]))
+        cg.add(var.set_fec_loss_threshold(fec[CONF_LOSS_THRESHOLD]))
+
+    # Receiver reports drive packing and codec fallback on congestion
+    if CONF_ADAPTATION in config:
+        adaptation = config[CONF_ADAPTATION]
+        cg.add(var.set_adaptive(True))
+        cg.add(var.set_max_packet_frames(adaptation[CONF_MAX_FRAMES_PER_PACKET]))
+        cg.add(var.set_codec_fallback(adaptation[CONF_CODEC_FALLBACK]))
+
+    # Authenticated encryption: pre-shared key, per-session keys from the HELLO exchange
+    if CONF_ENCRYPTION in config:
+        encryption = config[CONF_ENCRYPTION]
+        cg.add(var.set_encryption_key(list(bytes.fromhex(encryption[CONF_KEY]))))
+        cg.add(var.set_cipher_suite(encryption[CONF_CIPHER]))
+        if encryption[CONF_CIPHER] == "chacha20_poly1305":
+            # Not in the default mbedTLS configuration (AES-GCM uses the AES hardware)
+            add_idf_sdkconfig_option("CONFIG_MBEDTLS_CHACHA20_C", True)
+            add_idf_sdkconfig_option("CONFIG_MBEDTLS_POLY1305_C", True)
+            add_idf_sdkconfig_option("CONFIG_MBEDTLS_CHACHAPOLY_C", True)
+
+    # Keepalives in quiet stretches; a peer that stops sending them is lost
+    if CONF_KEEPALIVE in config:
+        keepalive = config[CONF_KEEPALIVE]
+        cg.add(var.set_peer_timeout(keepalive[CONF_TIMEOUT]))
+        cg.add(var.set_stop_on_peer_lost(keepalive[CONF_STOP_ON_PEER_LOST]))
+
+    # Recording history in PSRAM, exported as WAV by the web server
+    if CONF_RECORDING in config:
+        recording = config[CONF_RECORDING]
+        cg.add(var.set_recording_history(recording[CONF_HISTORY]))
+        cg.add(var.set_recording_pre_roll(recording[CONF_PRE_ROLL]))
+        cg.add(var.set_recording_format(recording[CONF_FORMAT]))
+        cg.add(var.set_record_calls(recording[CONF_RECORD_CALLS]))
+        if CONF_WEB_EXPORT in recording:
+            web_export = recording[CONF_WEB_EXPORT]
+            base = await cg.get_variable(web_export[CONF_WEB_SERVER_BASE_ID])
+            cg.add(var.set_recording_export(base, web_export[CONF_PATH]))
+            cg.add_define("USE_INTERCOM_WEB_EXPORT")
+
+    # Debug trace ring in PSRAM, dumped over the web server
+    if CONF_TRACE in config:
+        trace = config[CONF_TRACE]
+        cg.add(var.set_trace_duration(trace[CONF_DURATION]))
+        if CONF_WEB_EXPORT in trace:
+            web_export = trace[CONF_WEB_EXPORT]
+            base = await cg.get_variable(web_export[CONF_WEB_SERVER_BASE_ID])
+            cg.add(var.set_trace_export(base, web_export[CONF_PATH]))
+            cg.add_define("USE_INTERCOM_WEB_EXPORT")
+
+    # Counters and latency histograms in the Prometheus text format
+    if CONF_METRICS in config:
+        metrics = config[CONF_METRICS]
+        base = await cg.get_variable(metrics[CONF_WEB_SERVER_BASE_ID])
+        cg.add(var.set_metrics_export(base, metrics[CONF_PATH]))
+        cg.add_define("USE_INTERCOM_WEB_EXPORT")
+        if CONF_DISCOVERY_ID in metrics:
+            discovery = await cg.get_variable(metrics[CONF_DISCOVERY_ID])
+            cg.add(var.set_discovery(discovery))
+
+    # Error paths on purpose, for soak runs
+    if CONF_FAULT_INJECTION in config:
+        for key, rate in config[CONF_FAULT_INJECTION].items():
+            cg.add(var.set_fault_rate(FAULTS[key], rate))
+        cg.add_define("USE_INTERCOM_FAULT_INJECTION")
+
     # Automations
     if CONF_ON_START in config:
         await automation.build_automation(
@@ -171,6 +757,10 @@ async def to_code(config):
         await automation.build_automation(
             var.get_stop_trigger(), [], config[CONF_ON_STOP]
         )
+    if CONF_ON_PEER_LOST in config:
+        await automation.build_automation(
+            var.get_peer_lost_trigger(), [], config[CONF_ON_PEER_LOST]
+        )
 
 
 # Action: start streaming
@@ -209,3 +799,23 @@ async def reset_counters_action_to_code(config, action_id, template_arg, args):
     var = cg.new_Pvariable(action_id, template_arg)
     await cg.register_parented(var, config[CONF_ID])
     return var
+
+
+# Action: start a recording (with the pre-roll before it)
+@automation.register_action("intercom_audio.recording_start", RecordingStartAction, cv.Schema({
+    cv.GenerateID(): cv.use_id(IntercomAudio),
+}))
+async def recording_start_action_to_code(config, action_id, template_arg, args):
+    var = cg.new_Pvariable(action_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    return var
+
+
+# Action: end the recording
+@automation.register_action("intercom_audio.recording_stop", RecordingStopAction, cv.Schema({
+    cv.GenerateID(): cv.use_id(IntercomAudio),
+}))
+async def recording_stop_action_to_code(config, action_id, template_arg, args):
+    var = cg.new_Pvariable(action_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    return var
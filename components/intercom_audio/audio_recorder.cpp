@@ -0,0 +1,231 @@
+#include "audio_recorder.h"
+#include "g711.h"
+
+#ifdef USE_ESP32
+#include <esp_heap_caps.h>
+#else
+#include <cstdlib>
+#endif
+
+#include <cstring>
+
+namespace esphome {
+namespace intercom_audio {
+
+static void put_le16(uint8_t *p, uint16_t v) {
+  p[0] = (uint8_t) v;
+  p[1] = (uint8_t) (v >> 8);
+}
+
+static void put_le32(uint8_t *p, uint32_t v) {
+  put_le16(p, (uint16_t) v);
+  put_le16(p + 2, (uint16_t) (v >> 16));
+}
+
+bool AudioRecorder::allocate() {
+  if (this->buf_ != nullptr) {
+    return true;
+  }
+  // A power of two, so ring slots stay continuous when the positions wrap
+  uint32_t wanted = (uint32_t) ((uint64_t) this->history_ms_ * this->sample_rate_ / 1000);
+  this->capacity_ = 1;
+  while (this->capacity_ < wanted) {
+    this->capacity_ <<= 1;
+  }
+  size_t bytes = this->get_memory_bytes();
+  if (wanted == 0) {
+    return false;
+  }
+#ifdef USE_ESP32
+  this->buf_ = (uint8_t *) heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+  if (this->buf_ == nullptr) {
+    this->buf_ = (uint8_t *) heap_caps_malloc(bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+  }
+#else
+  this->buf_ = (uint8_t *) malloc(bytes);
+#endif
+  if (this->buf_ == nullptr) {
+    return false;
+  }
+  memset(this->buf_, this->silence_(), bytes);
+  return true;
+}
+
+bool AudioRecorder::write(const int16_t *pcm, size_t samples) {
+  if (this->buf_ == nullptr || samples == 0) {
+    return true;
+  }
+  if (this->writing_.exchange(true, std::memory_order_acquire)) {
+    return false;  // The other producer is mid-frame (start/stop handover)
+  }
+  if (samples > this->capacity_) {
+    pcm += samples - this->capacity_;
+    samples = this->capacity_;
+  }
+
+  uint32_t pos = this->head_.load(std::memory_order_relaxed);
+  uint32_t next = pos + (uint32_t) samples;
+  // Announce the overwrite before touching the ring
+  this->head_.store(next, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+
+  size_t index = pos & (this->capacity_ - 1);
+  size_t bps = this->bytes_per_sample_();
+  while (samples > 0) {
+    size_t run = this->capacity_ - index;
+    if (run > samples) {
+      run = samples;
+    }
+    if (this->format_ == RecordFormat::ULAW) {
+      uint8_t *dst = this->buf_ + index;
+      for (size_t i = 0; i < run; i++) {
+        dst[i] = g711::ulaw_encode(pcm[i]);
+      }
+    } else {
+      memcpy(this->buf_ + index * bps, pcm, run * bps);
+    }
+    pcm += run;
+    samples -= run;
+    index = 0;
+  }
+
+  this->committed_.store(next, std::memory_order_release);
+  if (next >= this->capacity_ || next < pos) {
+    this->full_.store(true, std::memory_order_relaxed);
+  }
+  this->writing_.store(false, std::memory_order_release);
+  return true;
+}
+
+uint32_t AudioRecorder::oldest_(uint32_t head) const {
+  if (!this->full_.load(std::memory_order_relaxed) && head <= this->capacity_) {
+    return 0;
+  }
+  return head - this->capacity_;
+}
+
+float AudioRecorder::get_buffered_seconds() const {
+  if (this->buf_ == nullptr) {
+    return 0.0f;
+  }
+  uint32_t head = this->committed_.load(std::memory_order_acquire);
+  return (float) (head - this->oldest_(head)) / this->sample_rate_;
+}
+
+void AudioRecorder::start_recording() {
+  if (this->buf_ == nullptr || this->recording_.load(std::memory_order_acquire)) {
+    return;
+  }
+  uint32_t now = this->committed_.load(std::memory_order_acquire);
+  uint32_t pre_roll = (uint32_t) ((uint64_t) this->pre_roll_ms_ * this->sample_rate_ / 1000);
+  uint32_t held = now - this->oldest_(now);
+  this->rec_start_.store(now - (pre_roll < held ? pre_roll : held), std::memory_order_relaxed);
+  this->rec_end_.store(now, std::memory_order_relaxed);
+  this->has_recording_.store(true, std::memory_order_release);
+  this->recording_.store(true, std::memory_order_release);
+}
+
+void AudioRecorder::stop_recording() {
+  if (!this->recording_.load(std::memory_order_acquire)) {
+    return;
+  }
+  this->rec_end_.store(this->committed_.load(std::memory_order_acquire), std::memory_order_relaxed);
+  this->recording_.store(false, std::memory_order_release);
+}
+
+bool AudioRecorder::open(Reader *reader) const {
+  if (this->buf_ == nullptr || !this->has_recording_.load(std::memory_order_acquire)) {
+    return false;
+  }
+  // A recording still running is exported up to now
+  bool live = this->recording_.load(std::memory_order_acquire);
+  uint32_t committed = this->committed_.load(std::memory_order_acquire);
+  reader->pos = this->rec_start_.load(std::memory_order_relaxed);
+  reader->end = live ? committed : this->rec_end_.load(std::memory_order_relaxed);
+  reader->gaps = 0;
+  // Longer than the history: the start is gone, export what is left
+  uint32_t oldest = this->oldest_(this->head_.load(std::memory_order_acquire));
+  if ((int32_t) (reader->pos - oldest) < 0) {
+    reader->pos = oldest;
+  }
+  if ((int32_t) (reader->end - reader->pos) < 0) {
+    reader->end = reader->pos;
+  }
+  return true;
+}
+
+size_t AudioRecorder::write_wav_header(const Reader &reader, uint8_t *out) const {
+  uint32_t samples = reader.end - reader.pos;
+  uint16_t bps = (uint16_t) this->bytes_per_sample_();
+  uint32_t data_bytes = samples * bps;
+  bool ulaw = this->format_ == RecordFormat::ULAW;
+  // Non-PCM formats carry cbSize in fmt and a fact chunk
+  uint32_t fmt_size = ulaw ? 18 : 16;
+  size_t header = 12 + 8 + fmt_size + (ulaw ? 12 : 0) + 8;
+
+  memcpy(out, "RIFF", 4);
+  put_le32(out + 4, (uint32_t) (header - 8) + data_bytes);
+  memcpy(out + 8, "WAVE", 4);
+  uint8_t *p = out + 12;
+  memcpy(p, "fmt ", 4);
+  put_le32(p + 4, fmt_size);
+  put_le16(p + 8, ulaw ? 7 : 1);  // WAVE_FORMAT_MULAW / WAVE_FORMAT_PCM
+  put_le16(p + 10, 1);            // Mono
+  put_le32(p + 12, this->sample_rate_);
+  put_le32(p + 16, this->sample_rate_ * bps);
+  put_le16(p + 20, bps);
+  put_le16(p + 22, (uint16_t) (bps * 8));
+  p += 8 + 16;
+  if (ulaw) {
+    put_le16(p, 0);  // cbSize
+    p += 2;
+    memcpy(p, "fact", 4);
+    put_le32(p + 4, 4);
+    put_le32(p + 8, samples);
+    p += 12;
+  }
+  memcpy(p, "data", 4);
+  put_le32(p + 4, data_bytes);
+  return header;
+}
+
+size_t AudioRecorder::read(Reader *reader, uint8_t *out, size_t max_bytes) const {
+  size_t bps = this->bytes_per_sample_();
+  uint32_t remaining = reader->end - reader->pos;
+  uint32_t samples = (uint32_t) (max_bytes / bps);
+  if (samples > remaining) {
+    samples = remaining;
+  }
+  if (samples == 0) {
+    return 0;
+  }
+
+  uint32_t start = reader->pos;
+  size_t index = start & (this->capacity_ - 1);
+  uint8_t *dst = out;
+  uint32_t left = samples;
+  while (left > 0) {
+    uint32_t run = this->capacity_ - (uint32_t) index;
+    if (run > left) {
+      run = left;
+    }
+    memcpy(dst, this->buf_ + index * bps, run * bps);
+    dst += run * bps;
+    left -= run;
+    index = 0;
+  }
+
+  // The writer announces an overwrite before it starts, so if the chunk start
+  // is still newer than the oldest position, nothing in it was touched
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  uint32_t oldest = this->oldest_(this->head_.load(std::memory_order_acquire));
+  if ((int32_t) (start - oldest) < 0) {
+    memset(out, this->silence_(), samples * bps);
+    reader->gaps++;
+  }
+  reader->pos += samples;
+  return samples * bps;
+}
+
+}  // namespace intercom_audio
+}  // namespace esphome
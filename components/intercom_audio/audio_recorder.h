@@ -0,0 +1,97 @@
+#pragma once
+
+// History of the outgoing (post-AEC) audio in a PSRAM ring, and recordings
+// cut from it. One task writes at a time; readers (the WAV export) never
+// block the writer: they copy and then check whether the writer lapped them.
+// No ESPHome dependencies so it can be built and checked on the host.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace esphome {
+namespace intercom_audio {
+
+enum class RecordFormat : uint8_t {
+  PCM16,  // s16le, 2 bytes per sample
+  ULAW,   // G.711 µ-law at the device rate, 1 byte per sample
+};
+
+class AudioRecorder {
+ public:
+  // Largest header write_wav_header() produces (µ-law: extended fmt + fact chunk)
+  static const size_t WAV_HEADER_MAX = 58;
+
+  void set_sample_rate(uint32_t rate) { this->sample_rate_ = rate; }
+  void set_format(RecordFormat format) { this->format_ = format; }
+  void set_history_ms(uint32_t ms) { this->history_ms_ = ms; }
+  // History a recording starts with; non-zero keeps the tap running between calls
+  void set_pre_roll_ms(uint32_t ms) { this->pre_roll_ms_ = ms; }
+
+  bool is_configured() const { return this->history_ms_ != 0; }
+  bool is_always_on() const { return this->pre_roll_ms_ != 0 && this->buf_ != nullptr; }
+  RecordFormat get_format() const { return this->format_; }
+  uint32_t get_history_ms() const { return this->history_ms_; }
+  uint32_t get_pre_roll_ms() const { return this->pre_roll_ms_; }
+  size_t get_bytes_per_second() const { return this->sample_rate_ * this->bytes_per_sample_(); }
+  size_t get_memory_bytes() const { return (size_t) this->capacity_ * this->bytes_per_sample_(); }
+  // History actually held: history rounded up to a power-of-two number of samples
+  uint32_t get_capacity_ms() const { return (uint32_t) ((uint64_t) this->capacity_ * 1000 / this->sample_rate_); }
+
+  // Ring in PSRAM (internal RAM if there is none); false if it does not fit
+  bool allocate();
+  bool is_allocated() const { return this->buf_ != nullptr; }
+
+  // Producer. False if another task was writing (the frame is dropped).
+  bool write(const int16_t *pcm, size_t samples);
+  // Seconds of audio currently held
+  float get_buffered_seconds() const;
+
+  // A recording starts pre_roll before now (or at the oldest sample held) and
+  // runs until stop; start while recording keeps the original start
+  void start_recording();
+  void stop_recording();
+  bool is_recording() const { return this->recording_.load(std::memory_order_acquire); }
+  bool has_recording() const { return this->has_recording_.load(std::memory_order_acquire); }
+
+  // Export cursor over the recording as it was when opened
+  struct Reader {
+    uint32_t pos;
+    uint32_t end;
+    uint32_t gaps;  // Chunks lost to the writer, replaced with silence
+  };
+  bool open(Reader *reader) const;
+  size_t write_wav_header(const Reader &reader, uint8_t *out) const;
+  // Up to max_bytes of sample data; 0 once the recording has been read
+  size_t read(Reader *reader, uint8_t *out, size_t max_bytes) const;
+
+ protected:
+  size_t bytes_per_sample_() const { return this->format_ == RecordFormat::ULAW ? 1 : 2; }
+  uint8_t silence_() const { return this->format_ == RecordFormat::ULAW ? 0xFF : 0x00; }
+  // Oldest position the writer has not started to overwrite
+  uint32_t oldest_(uint32_t head) const;
+
+  uint32_t sample_rate_{16000};
+  RecordFormat format_{RecordFormat::PCM16};
+  uint32_t history_ms_{0};
+  uint32_t pre_roll_ms_{0};
+
+  uint8_t *buf_{nullptr};
+  uint32_t capacity_{0};  // Samples, a power of two
+
+  // Sample positions since allocation (wrapping). head_ moves before the
+  // samples are written, committed_ after, so a reader can tell what it may
+  // have raced with.
+  std::atomic<uint32_t> head_{0};
+  std::atomic<uint32_t> committed_{0};
+  std::atomic<bool> full_{false};
+  std::atomic<bool> writing_{false};
+
+  std::atomic<bool> recording_{false};
+  std::atomic<bool> has_recording_{false};
+  std::atomic<uint32_t> rec_start_{0};
+  std::atomic<uint32_t> rec_end_{0};
+};
+
+}  // namespace intercom_audio
+}  // namespace esphome
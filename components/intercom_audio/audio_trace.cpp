@@ -0,0 +1,128 @@
+#include "audio_trace.h"
+
+#ifdef USE_ESP32
+#include <esp_heap_caps.h>
+#else
+#include <cstdlib>
+#endif
+
+#include <cstring>
+
+namespace esphome {
+namespace intercom_audio {
+
+static_assert(sizeof(TraceRecordHeader) == 24, "trace record header is part of the dump format");
+
+void AudioTrace::configure(uint32_t sample_rate, uint16_t frame_samples, uint32_t records) {
+  this->sample_rate_ = sample_rate;
+  this->frame_samples_ = frame_samples;
+  this->records_ = 1;
+  while (this->records_ < records) {
+    this->records_ <<= 1;
+  }
+  this->record_size_ = sizeof(TraceRecordHeader) + frame_samples * sizeof(int16_t);
+}
+
+bool AudioTrace::allocate() {
+  if (this->buf_ != nullptr) {
+    return true;
+  }
+  size_t bytes = this->get_memory_bytes();
+  if (bytes == 0) {
+    return false;
+  }
+#ifdef USE_ESP32
+  this->buf_ = (uint8_t *) heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+#else
+  this->buf_ = (uint8_t *) malloc(bytes);
+#endif
+  return this->buf_ != nullptr;
+}
+
+void AudioTrace::write(const TraceRecordHeader &header, const int16_t *samples) {
+  if (!this->enabled_.load(std::memory_order_relaxed)) {
+    return;
+  }
+  uint32_t pos = this->head_.load(std::memory_order_relaxed);
+  this->head_.store(pos + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+
+  uint8_t *slot = this->buf_ + (size_t) (pos & (this->records_ - 1)) * this->record_size_;
+  TraceRecordHeader *dst = reinterpret_cast<TraceRecordHeader *>(slot);
+  *dst = header;
+  size_t count = samples == nullptr ? 0 : header.samples;
+  if (count > this->frame_samples_) {
+    count = this->frame_samples_;
+  }
+  dst->samples = (uint16_t) count;
+  if (count > 0) {
+    memcpy(slot + sizeof(TraceRecordHeader), samples, count * sizeof(int16_t));
+  }
+
+  this->committed_.store(pos + 1, std::memory_order_release);
+  if (pos + 1 >= this->records_ || pos + 1 < pos) {
+    this->full_.store(true, std::memory_order_relaxed);
+  }
+}
+
+uint32_t AudioTrace::oldest_(uint32_t head) const {
+  if (!this->full_.load(std::memory_order_relaxed) && head <= this->records_) {
+    return 0;
+  }
+  return head - this->records_;
+}
+
+void AudioTrace::open(Reader *reader) const {
+  reader->end = this->committed_.load(std::memory_order_acquire);
+  reader->pos = this->oldest_(this->head_.load(std::memory_order_acquire));
+  reader->lost = 0;
+  if ((int32_t) (reader->end - reader->pos) < 0) {
+    reader->pos = reader->end;
+  }
+}
+
+size_t AudioTrace::write_file_header(uint8_t *out) const {
+  // "IATR", version, record header size, sample rate, frame samples, record size
+  memcpy(out, "IATR", 4);
+  uint16_t version = VERSION;
+  uint16_t header_size = sizeof(TraceRecordHeader);
+  uint32_t rate = this->sample_rate_;
+  uint16_t frame = this->frame_samples_;
+  uint16_t record = (uint16_t) this->record_size_;
+  memcpy(out + 4, &version, 2);
+  memcpy(out + 6, &header_size, 2);
+  memcpy(out + 8, &rate, 4);
+  memcpy(out + 12, &frame, 2);
+  memcpy(out + 14, &record, 2);
+  return FILE_HEADER_SIZE;
+}
+
+size_t AudioTrace::read(Reader *reader, uint8_t *out, size_t max_bytes) const {
+  uint32_t count = (uint32_t) (max_bytes / this->record_size_);
+  uint32_t remaining = reader->end - reader->pos;
+  if (count > remaining) {
+    count = remaining;
+  }
+  if (count == 0) {
+    return 0;
+  }
+  uint32_t start = reader->pos;
+  for (uint32_t i = 0; i < count; i++) {
+    const uint8_t *slot = this->buf_ + (size_t) ((start + i) & (this->records_ - 1)) * this->record_size_;
+    memcpy(out + i * this->record_size_, slot, this->record_size_);
+  }
+  // Anything the writer announced since the copy started may be torn
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  uint32_t oldest = this->oldest_(this->head_.load(std::memory_order_acquire));
+  for (uint32_t i = 0; i < count; i++) {
+    if ((int32_t) (start + i - oldest) < 0) {
+      out[i * this->record_size_] = (uint8_t) TraceKind::LOST;
+      reader->lost++;
+    }
+  }
+  reader->pos += count;
+  return count * this->record_size_;
+}
+
+}  // namespace intercom_audio
+}  // namespace esphome
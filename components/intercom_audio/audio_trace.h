@@ -0,0 +1,107 @@
+#pragma once
+
+// Black-box trace of the audio path: mic, AEC reference, AEC output, received
+// and played frames plus drop / underrun events, each stamped with the time
+// and the buffer fill levels, in a fixed ring of equal-size records. Written
+// by the audio task only; the dump reader never blocks it (same lapping check
+// as AudioRecorder). tools/trace_report.py turns a dump into a report, and
+// replays its received frames through a host build of the receive path.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace esphome {
+namespace intercom_audio {
+
+enum class TraceKind : uint8_t {
+  MIC = 0,      // Captured frame, before AEC
+  REF = 1,      // Speaker reference the AEC got for that frame
+  AEC_OUT = 2,  // AEC output (what is sent)
+  PLAY = 3,     // Bytes handed to the speaker; samples < frame if it was full
+  EVENT = 4,
+  RX = 5,       // Received audio as it went into the jitter buffer, a frame per record
+  LOST = 0xFF,  // Dump only: overwritten while it was being read
+};
+
+enum class TraceEvent : uint16_t {
+  SESSION_START = 1,
+  SESSION_STOP = 2,
+  TX_DROP = 3,   // value: frames the mic buffer could not take since the last event
+  RX_DROP = 4,   // value: datagrams dropped (jitter buffer full / stale)
+  RX_EMPTY = 5,  // Jitter buffer ran dry after the prebuffer had filled
+};
+
+// Flags on RX records
+static const uint8_t TRACE_RX_DROPPED = 0x01;  // The jitter buffer could not take all of it
+
+// Flags on REF records
+static const uint8_t TRACE_REF_FRESH = 0x01;  // Read from the reference buffer
+static const uint8_t TRACE_REF_HELD = 0x02;   // Last reference repeated
+
+struct TraceRecordHeader {
+  uint8_t kind;
+  uint8_t flags;
+  uint16_t samples;  // s16le samples following the header
+  uint32_t seq;      // TX frame counter (MIC/REF/AEC_OUT share it), per-kind otherwise
+  uint32_t time_us;  // esp_timer, low 32 bits
+  uint16_t mic_fill;  // Bytes in the mic buffer
+  uint16_t rx_fill;   // Bytes in the jitter buffer
+  uint16_t ref_fill;  // Bytes in the AEC reference buffer
+  uint16_t event;     // TraceEvent for EVENT records
+  uint32_t value;
+};
+
+class AudioTrace {
+ public:
+  static const uint16_t VERSION = 1;
+  static const size_t FILE_HEADER_SIZE = 16;
+  // Most records one frame of audio can produce: MIC, REF, AEC_OUT, PLAY and RX
+  static const uint32_t RECORDS_PER_FRAME = 5;
+
+  // Records: frame_samples of audio each; the count is rounded up to a power of two
+  void configure(uint32_t sample_rate, uint16_t frame_samples, uint32_t records);
+  bool allocate();
+  bool is_allocated() const { return this->buf_ != nullptr; }
+  size_t get_record_size() const { return this->record_size_; }
+  uint32_t get_records() const { return this->records_; }
+  size_t get_memory_bytes() const { return (size_t) this->records_ * this->record_size_; }
+
+  void set_enabled(bool enabled) { this->enabled_.store(enabled && this->buf_ != nullptr, std::memory_order_release); }
+  bool is_enabled() const { return this->enabled_.load(std::memory_order_acquire); }
+
+  // Writer (audio task). header.samples is clamped to the frame size.
+  void write(const TraceRecordHeader &header, const int16_t *samples);
+
+  // Dump cursor over the records held when opened, oldest first
+  struct Reader {
+    uint32_t pos;
+    uint32_t end;
+    uint32_t lost;
+  };
+  void open(Reader *reader) const;
+  size_t write_file_header(uint8_t *out) const;
+  size_t get_dump_size(const Reader &reader) const {
+    return FILE_HEADER_SIZE + (size_t) (reader.end - reader.pos) * this->record_size_;
+  }
+  // Whole records, up to max_bytes; 0 at the end
+  size_t read(Reader *reader, uint8_t *out, size_t max_bytes) const;
+
+ protected:
+  uint32_t oldest_(uint32_t head) const;
+
+  uint32_t sample_rate_{16000};
+  uint16_t frame_samples_{256};
+  uint32_t records_{0};  // Power of two
+  size_t record_size_{0};
+  uint8_t *buf_{nullptr};
+
+  std::atomic<bool> enabled_{false};
+  // Record positions: head_ moves before a slot is written, committed_ after
+  std::atomic<uint32_t> head_{0};
+  std::atomic<uint32_t> committed_{0};
+  std::atomic<bool> full_{false};
+};
+
+}  // namespace intercom_audio
+}  // namespace esphome
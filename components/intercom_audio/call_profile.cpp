@@ -0,0 +1,147 @@
+#include "call_profile.h"
+
+#ifdef USE_ESP32
+
+#include "esphome/core/application.h"
+#include "esphome/core/log.h"
+
+#include <soc/rtc.h>
+
+#ifdef USE_WIFI
+#include <esp_wifi.h>
+#endif
+
+namespace esphome {
+namespace intercom_audio {
+
+static const char *const TAG = "intercom_audio.profile";
+
+void WifiCallProfile::apply() {
+  if (this->applied_ || !this->is_configured()) {
+    return;
+  }
+  this->applied_ = true;
+#ifdef USE_WIFI
+  if (this->disable_power_save_) {
+    wifi_ps_type_t ps;
+    this->ps_saved_ = esp_wifi_get_ps(&ps) == ESP_OK;
+    if (this->ps_saved_) {
+      this->saved_ps_ = ps;
+      if (ps != WIFI_PS_NONE && esp_wifi_set_ps(WIFI_PS_NONE) != ESP_OK) {
+        ESP_LOGW(TAG, "Could not disable Wi-Fi power save");
+      }
+    }
+  }
+  if (this->tx_power_quarter_dbm_ != 0) {
+    int8_t power;
+    this->power_saved_ = esp_wifi_get_max_tx_power(&power) == ESP_OK;
+    if (this->power_saved_) {
+      this->saved_power_ = power;
+      if (esp_wifi_set_max_tx_power(this->tx_power_quarter_dbm_) != ESP_OK) {
+        ESP_LOGW(TAG, "Could not set Wi-Fi TX power");
+      }
+    }
+  }
+  ESP_LOGD(TAG, "Call profile applied");
+#endif
+}
+
+void WifiCallProfile::restore() {
+  if (!this->applied_) {
+    return;
+  }
+  this->applied_ = false;
+#ifdef USE_WIFI
+  if (this->ps_saved_) {
+    esp_wifi_set_ps((wifi_ps_type_t) this->saved_ps_);
+    this->ps_saved_ = false;
+  }
+  if (this->power_saved_) {
+    esp_wifi_set_max_tx_power(this->saved_power_);
+    this->power_saved_ = false;
+  }
+  ESP_LOGD(TAG, "Call profile restored");
+#endif
+}
+
+void WifiCallProfile::dump_config(const char *tag) const {
+#ifdef USE_WIFI
+  ESP_LOGCONFIG(tag, "  Wi-Fi During Calls: power save %s", this->disable_power_save_ ? "off" : "unchanged");
+  if (this->tx_power_quarter_dbm_ != 0) {
+    ESP_LOGCONFIG(tag, "    TX Power: %.2f dBm", this->tx_power_quarter_dbm_ / 4.0f);
+  }
+#else
+  ESP_LOGCONFIG(tag, "  Wi-Fi During Calls: no Wi-Fi in this build");
+#endif
+}
+
+void IdlePowerMode::setup() {
+  if (this->light_sleep_) {
+    // Full speed while busy, XTAL and light sleep once every task is blocked
+    esp_pm_config_t config = {};
+    config.max_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ;
+    config.min_freq_mhz = (int) rtc_clk_xtal_freq_get();
+    config.light_sleep_enable = true;
+    esp_err_t err = esp_pm_configure(&config);
+    if (err == ESP_OK) {
+      err = esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "intercom_call", &this->no_sleep_lock_);
+    }
+    if (err == ESP_OK) {
+      err = esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "intercom_cpu", &this->cpu_max_lock_);
+    }
+    this->pm_ready_ = err == ESP_OK;
+    if (!this->pm_ready_) {
+      ESP_LOGW(TAG, "Automatic light sleep unavailable: %s", esp_err_to_name(err));
+    }
+  }
+  this->enter();
+}
+
+void IdlePowerMode::enter() {
+  if (this->idle_ || !this->is_configured()) {
+    return;
+  }
+  this->idle_ = true;
+  if (this->locks_held_) {
+    esp_pm_lock_release(this->cpu_max_lock_);
+    esp_pm_lock_release(this->no_sleep_lock_);
+    this->locks_held_ = false;
+  }
+  if (this->loop_interval_ms_ != 0) {
+    this->saved_loop_interval_ = App.get_loop_interval();
+    App.set_loop_interval(this->loop_interval_ms_);
+  }
+  ESP_LOGD(TAG, "Idle power mode");
+}
+
+void IdlePowerMode::leave() {
+  if (!this->idle_) {
+    return;
+  }
+  this->idle_ = false;
+  if (this->pm_ready_) {
+    esp_pm_lock_acquire(this->no_sleep_lock_);
+    esp_pm_lock_acquire(this->cpu_max_lock_);
+    this->locks_held_ = true;
+  }
+  if (this->loop_interval_ms_ != 0) {
+    App.set_loop_interval(this->saved_loop_interval_);
+  }
+  ESP_LOGD(TAG, "Call power mode");
+}
+
+void IdlePowerMode::dump_config(const char *tag) const {
+  if (!this->is_configured()) {
+    return;
+  }
+  const char *sleep = !this->light_sleep_ ? "off" : this->pm_ready_ ? "on" : "unavailable";
+  ESP_LOGCONFIG(tag, "  Between Calls: light sleep %s", sleep);
+  if (this->loop_interval_ms_ != 0) {
+    ESP_LOGCONFIG(tag, "    Loop Interval: %u ms", (unsigned) this->loop_interval_ms_);
+  }
+}
+
+}  // namespace intercom_audio
+}  // namespace esphome
+
+#endif  // USE_ESP32
@@ -0,0 +1,77 @@
+#pragma once
+
+#ifdef USE_ESP32
+
+#include <esp_pm.h>
+
+#include <cstdint>
+
+namespace esphome {
+namespace intercom_audio {
+
+// Wi-Fi settings held for the duration of a call: modem sleep off (no waiting
+// for the next DTIM beacon to receive) and optionally a fixed TX power. The
+// previous settings are read on apply() and put back on restore(). No-op on
+// builds without Wi-Fi.
+class WifiCallProfile {
+ public:
+  void set_disable_power_save(bool disable) { this->disable_power_save_ = disable; }
+  // dBm; 0 leaves the TX power alone
+  void set_tx_power(float dbm) { this->tx_power_quarter_dbm_ = (int8_t) (dbm * 4.0f); }
+
+  bool is_configured() const { return this->disable_power_save_ || this->tx_power_quarter_dbm_ != 0; }
+  bool is_applied() const { return this->applied_; }
+
+  void apply();
+  void restore();
+
+  void dump_config(const char *tag) const;
+
+ protected:
+  bool disable_power_save_{false};
+  int8_t tx_power_quarter_dbm_{0};
+
+  bool applied_{false};
+  bool ps_saved_{false};
+  int saved_ps_{0};  // wifi_ps_type_t
+  bool power_saved_{false};
+  int8_t saved_power_{0};
+};
+
+// Between calls: automatic light sleep (the CPU sleeps until the next timer,
+// Wi-Fi modem sleep keeps the association and wakes for DTIM beacons, so
+// signaling still gets through) and optionally a slower main loop. During a
+// call PM locks keep the CPU awake at full speed. Light sleep needs
+// CONFIG_PM_ENABLE and tickless idle (set by the code generator).
+class IdlePowerMode {
+ public:
+  void set_light_sleep(bool enable) { this->light_sleep_ = enable; }
+  // Main loop interval between calls; 0 leaves it alone
+  void set_loop_interval(uint32_t ms) { this->loop_interval_ms_ = ms; }
+
+  bool is_configured() const { return this->light_sleep_ || this->loop_interval_ms_ != 0; }
+  bool is_idle() const { return this->idle_; }
+
+  // Once from setup(); the device starts out idle
+  void setup();
+  void enter();  // Call ended
+  void leave();  // Call starting
+
+  void dump_config(const char *tag) const;
+
+ protected:
+  bool light_sleep_{false};
+  uint32_t loop_interval_ms_{0};
+
+  bool idle_{false};
+  bool pm_ready_{false};
+  bool locks_held_{false};
+  uint32_t saved_loop_interval_{0};
+  esp_pm_lock_handle_t no_sleep_lock_{nullptr};
+  esp_pm_lock_handle_t cpu_max_lock_{nullptr};
+};
+
+}  // namespace intercom_audio
+}  // namespace esphome
+
+#endif  // USE_ESP32
@@ -0,0 +1,107 @@
+#include "call_quality.h"
+
+#include <cmath>
+
+namespace esphome {
+namespace intercom_audio {
+
+float emodel_delay_impairment(float one_way_ms) {
+  if (one_way_ms <= 100.0f) {
+    return 0.0f;
+  }
+  // G.107 Idd, with the mouth-to-ear delay standing in for Ta
+  float x = log10f(one_way_ms / 100.0f) / log10f(2.0f);
+  return 25.0f * (powf(1.0f + powf(x, 6.0f), 1.0f / 6.0f) - 3.0f * powf(1.0f + powf(x / 3.0f, 6.0f), 1.0f / 6.0f) +
+                  2.0f);
+}
+
+float emodel_burst_ratio(uint32_t packets, uint32_t lost, uint32_t loss_runs) {
+  if (lost == 0 || lost >= packets || loss_runs == 0) {
+    return 1.0f;
+  }
+  // Two-state Markov model: p = P(lost | previous received), q = P(received | previous lost);
+  // every run is entered once and left once
+  float p = (float) loss_runs / (packets - lost);
+  float q = (float) loss_runs / lost;
+  return 1.0f / (p + q);
+}
+
+float emodel_rating(float one_way_ms, float loss_percent, float burst_ratio) {
+  float ie_eff = EMODEL_CODEC_IE;
+  if (loss_percent > 0.0f) {
+    ie_eff += (95.0f - EMODEL_CODEC_IE) * loss_percent / (loss_percent / burst_ratio + EMODEL_CODEC_BPL);
+  }
+  return EMODEL_R_DEFAULT - emodel_delay_impairment(one_way_ms) - ie_eff;
+}
+
+float emodel_mos(float r) {
+  if (r <= 0.0f) {
+    return 1.0f;
+  }
+  if (r >= 100.0f) {
+    return 4.5f;
+  }
+  return 1.0f + 0.035f * r + r * (r - 60.0f) * (100.0f - r) * 7e-6f;
+}
+
+void CallQuality::reset() {
+  this->intervals_ = 0;
+  this->packets_ = 0;
+  this->lost_ = 0;
+  this->loss_runs_ = 0;
+  this->delay_sum_ms_ = 0.0f;
+  this->windows_ = 0;
+  this->mos_sum_ = 0.0f;
+  this->worst_mos_ = 0.0f;
+  this->last_r_ = NAN;
+  this->last_mos_ = NAN;
+}
+
+bool CallQuality::add(uint32_t packets, uint32_t lost, uint32_t loss_runs, float delay_ms) {
+  if (packets == 0) {
+    return false;
+  }
+  this->packets_ += packets;
+  this->lost_ += lost;
+  this->loss_runs_ += loss_runs;
+  this->delay_sum_ms_ += delay_ms;
+  if (++this->intervals_ < WINDOW_INTERVALS) {
+    return false;
+  }
+  this->close_window_();
+  return true;
+}
+
+void CallQuality::finish() {
+  if (this->intervals_ > 0) {
+    this->close_window_();
+  }
+}
+
+void CallQuality::close_window_() {
+  float loss_percent = this->lost_ * 100.0f / this->packets_;
+  float burst = emodel_burst_ratio(this->packets_, this->lost_, this->loss_runs_);
+  float r = emodel_rating(this->delay_sum_ms_ / this->intervals_, loss_percent, burst);
+  float mos = emodel_mos(r);
+
+  this->last_r_ = r;
+  this->last_mos_ = mos;
+  if (this->windows_ == 0 || mos < this->worst_mos_) {
+    this->worst_mos_ = mos;
+  }
+  this->mos_sum_ += mos;
+  this->windows_++;
+
+  this->intervals_ = 0;
+  this->packets_ = 0;
+  this->lost_ = 0;
+  this->loss_runs_ = 0;
+  this->delay_sum_ms_ = 0.0f;
+}
+
+float CallQuality::get_average_mos() const { return this->windows_ > 0 ? this->mos_sum_ / this->windows_ : NAN; }
+
+float CallQuality::get_worst_mos() const { return this->windows_ > 0 ? this->worst_mos_ : NAN; }
+
+}  // namespace intercom_audio
+}  // namespace esphome
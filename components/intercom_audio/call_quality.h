@@ -0,0 +1,74 @@
+#pragma once
+
+// Listening quality of the received stream, estimated with the ITU-T G.107
+// E-model: a transmission rating R from the mouth-to-ear delay and the packet
+// loss the listener hears (after FEC), with its burstiness, then mapped to MOS.
+// Echo terms are left out (the AEC is expected to handle echo), and every codec
+// this component sends is rated like G.711 without loss concealment.
+// No ESPHome dependencies so it can be built and checked on the host.
+
+#include <cmath>
+#include <cstdint>
+
+namespace esphome {
+namespace intercom_audio {
+
+// G.107 default Ro - Is (R of a perfect narrowband connection)
+static const float EMODEL_R_DEFAULT = 93.2f;
+// G.113 Appendix I, G.711 without packet loss concealment
+static const float EMODEL_CODEC_IE = 0.0f;
+static const float EMODEL_CODEC_BPL = 4.3f;
+
+// Delay impairment Idd for a one-way (mouth-to-ear) delay
+float emodel_delay_impairment(float one_way_ms);
+// Burst ratio from a loss pattern: 1 for random loss, above 1 for bursts.
+// loss_runs counts the separate stretches the lost packets formed.
+float emodel_burst_ratio(uint32_t packets, uint32_t lost, uint32_t loss_runs);
+// Transmission rating R
+float emodel_rating(float one_way_ms, float loss_percent, float burst_ratio);
+// MOS (1.0 - 4.5) for a rating
+float emodel_mos(float r);
+
+// Runs the E-model over fixed windows of a call: the latest window is the
+// rolling value, and the windows together give the call average and worst.
+class CallQuality {
+ public:
+  // Observations (report intervals) per window
+  static const uint8_t WINDOW_INTERVALS = 5;
+
+  void reset();
+
+  // One observation: packets released towards playout, how many of them were
+  // gaps and in how many runs, and the mouth-to-ear delay meanwhile. Intervals
+  // without packets (peer silent) are skipped. True when a window completed.
+  bool add(uint32_t packets, uint32_t lost, uint32_t loss_runs, float delay_ms);
+  // Closes a partly filled window; call when the call ends
+  void finish();
+
+  uint32_t get_windows() const { return this->windows_; }
+  // Latest window; NAN until the first one completed
+  float get_window_r() const { return this->last_r_; }
+  float get_window_mos() const { return this->last_mos_; }
+  // Mean and minimum of the window MOS values; NAN without windows
+  float get_average_mos() const;
+  float get_worst_mos() const;
+
+ protected:
+  void close_window_();
+
+  // Window being filled
+  uint8_t intervals_{0};
+  uint32_t packets_{0};
+  uint32_t lost_{0};
+  uint32_t loss_runs_{0};
+  float delay_sum_ms_{0.0f};
+
+  uint32_t windows_{0};
+  float mos_sum_{0.0f};
+  float worst_mos_{0.0f};
+  float last_r_{NAN};
+  float last_mos_{NAN};
+};
+
+}  // namespace intercom_audio
+}  // namespace esphome
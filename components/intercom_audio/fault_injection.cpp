@@ -0,0 +1,66 @@
+#include "fault_injection.h"
+
+namespace esphome {
+namespace intercom_audio {
+
+const char *fault_to_str(Fault fault) {
+  switch (fault) {
+    case Fault::SEND_ERROR:
+      return "send_error";
+    case Fault::RECEIVE_LOSS:
+      return "receive_loss";
+    case Fault::SPEAKER_STALL:
+      return "speaker_stall";
+    case Fault::MIC_OVERFLOW:
+      return "mic_overflow";
+    case Fault::I2S_READ_TIMEOUT:
+      return "i2s_read_timeout";
+    case Fault::I2S_WRITE_TIMEOUT:
+      return "i2s_write_timeout";
+    default:
+      return "unknown";
+  }
+}
+
+void FaultInjector::set_rate(Fault fault, float rate) {
+  uint32_t &threshold = this->threshold_[(size_t) fault];
+  if (rate <= 0.0f) {
+    threshold = 0;
+  } else if (rate >= 1.0f) {
+    threshold = UINT32_MAX;
+  } else {
+    threshold = (uint32_t) (rate * 4294967296.0);
+  }
+}
+
+float FaultInjector::get_rate(Fault fault) const { return this->threshold_[(size_t) fault] / 4294967296.0f; }
+
+bool FaultInjector::is_enabled() const {
+  for (size_t i = 0; i < FAULTS; i++) {
+    if (this->threshold_[i] != 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool FaultInjector::inject(Fault fault) {
+  const size_t i = (size_t) fault;
+  if (this->threshold_[i] == 0) {
+    return false;
+  }
+  uint32_t x = this->random_[i];
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  this->random_[i] = x;
+  // x is never 0, so UINT32_MAX fails every event
+  if (x > this->threshold_[i]) {
+    return false;
+  }
+  this->injected_[i].fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
+
+}  // namespace intercom_audio
+}  // namespace esphome
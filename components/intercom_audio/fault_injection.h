@@ -0,0 +1,51 @@
+#pragma once
+
+// Fault injection for soak builds: at configured rates the audio path acts as
+// if a send failed, a datagram was lost, the speaker had no room, the mic
+// buffer overflowed or an I2S read or write of the duplex timed out, so
+// start/stop storms (tools/soak.py) also run the error paths. The component
+// only calls it with USE_INTERCOM_FAULT_INJECTION.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace esphome {
+namespace intercom_audio {
+
+enum class Fault : uint8_t {
+  SEND_ERROR,         // Audio task: a send call fails
+  RECEIVE_LOSS,       // Audio task: a received datagram is dropped
+  SPEAKER_STALL,      // Audio task: the speaker reports no room for a frame
+  MIC_OVERFLOW,       // Mic task: the mic buffer reports no room for a frame
+  I2S_READ_TIMEOUT,   // Duplex audio task: an I2S read times out
+  I2S_WRITE_TIMEOUT,  // Duplex audio task: an I2S write times out
+  COUNT,
+};
+
+const char *fault_to_str(Fault fault);
+
+class FaultInjector {
+ public:
+  static const size_t FAULTS = (size_t) Fault::COUNT;
+
+  // Fraction of events to fail, 0 (never) to 1 (always)
+  void set_rate(Fault fault, float rate);
+  float get_rate(Fault fault) const;
+  bool is_enabled() const;
+
+  // True when this event should fail. Each fault is only ever checked from one
+  // task, so its random state needs no lock.
+  bool inject(Fault fault);
+  // Faults injected since boot (any task)
+  uint32_t get_injected(Fault fault) const { return this->injected_[(size_t) fault].load(std::memory_order_relaxed); }
+
+ protected:
+  uint32_t threshold_[FAULTS]{};  // Out of 2^32
+  uint32_t random_[FAULTS]{0x9E3779B9u, 0x7F4A7C15u, 0x85EBCA6Bu,
+                           0xC2B2AE35u, 0x27D4EB2Fu, 0x165667B1u};  // xorshift32 states
+  std::atomic<uint32_t> injected_[FAULTS]{};
+};
+
+}  // namespace intercom_audio
+}  // namespace esphome
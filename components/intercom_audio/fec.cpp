@@ -0,0 +1,370 @@
+#include "fec.h"
+#include "g711.h"
+
+#include <cstring>
+#include <new>
+
+namespace esphome {
+namespace intercom_audio {
+
+// A sequence jump larger than this is a peer restart, not loss
+static const int32_t MAX_SEQ_JUMP = 1000;
+
+// === Encoder ===
+
+bool FecEncoder::allocate(size_t max_payload) {
+  this->max_payload_ = max_payload;
+  this->red_.reset(new (std::nothrow) uint8_t[max_payload]);
+  this->parity_.reset(new (std::nothrow) uint8_t[2 + max_payload]);
+  return this->red_ != nullptr && this->parity_ != nullptr;
+}
+
+void FecEncoder::reset() {
+  this->seq_ = 0;
+  this->active_ = false;
+  this->have_red_ = false;
+  this->group_index_ = 0;
+  this->parity_ready_ = false;
+}
+
+void FecEncoder::set_active(bool active) {
+  if (active == this->active_) {
+    return;
+  }
+  this->active_ = active;
+  this->restart_();
+}
+
+void FecEncoder::set_redundant_ulaw(bool ulaw) {
+  if (ulaw == this->redundant_ulaw_) {
+    return;
+  }
+  this->redundant_ulaw_ = ulaw;
+  this->restart_();
+}
+
+void FecEncoder::restart_() {
+  // Start clean: no stale redundant copy, parity groups begin at index 0
+  this->have_red_ = false;
+  this->group_index_ = 0;
+  this->parity_ready_ = false;
+}
+
+void FecEncoder::prepare(size_t len, wire::PacketHeader *header, const uint8_t **red, size_t *red_len) const {
+  header->type = wire::PacketType::AUDIO;
+  header->flags = 0;
+  header->seq = this->seq_;
+  header->length = (uint16_t) len;
+  header->aux = 0;
+  *red = nullptr;
+  *red_len = 0;
+  if (!this->active_) {
+    return;
+  }
+  if (this->mode_ == FecMode::XOR) {
+    header->aux = (uint8_t) ((this->group_size_ << 4) | this->group_index_);
+  } else if (this->mode_ == FecMode::RED && this->have_red_) {
+    header->flags |= wire::FLAG_RED;
+    *red = this->red_.get();
+    *red_len = this->red_len_;
+  }
+}
+
+void FecEncoder::commit(const uint8_t *payload, size_t len) {
+  this->seq_++;
+  if (!this->active_ || len > this->max_payload_) {
+    this->have_red_ = false;
+    this->group_index_ = 0;
+    return;
+  }
+
+  if (this->mode_ == FecMode::RED) {
+    if (this->redundant_ulaw_) {
+      size_t samples = len / sizeof(int16_t);
+      for (size_t i = 0; i < samples; i++) {
+        int16_t sample;
+        memcpy(&sample, payload + i * sizeof(int16_t), sizeof(sample));
+        this->red_[i] = g711::ulaw_encode(sample);
+      }
+      this->red_len_ = samples;
+    } else {
+      memcpy(this->red_.get(), payload, len);
+      this->red_len_ = len;
+    }
+    this->have_red_ = true;
+    return;
+  }
+
+  if (this->mode_ == FecMode::XOR) {
+    uint8_t *parity = this->parity_.get();
+    if (this->group_index_ == 0) {
+      this->parity_base_ = (uint16_t) (this->seq_ - 1);
+      this->parity_len_ = 0;
+      parity[0] = 0;
+      parity[1] = 0;
+    }
+    wire::put_be16(parity, wire::get_be16(parity) ^ (uint16_t) len);
+    uint8_t *data = parity + 2;
+    if (len > this->parity_len_) {
+      memset(data + this->parity_len_, 0, len - this->parity_len_);
+      this->parity_len_ = len;
+    }
+    for (size_t i = 0; i < len; i++) {
+      data[i] ^= payload[i];
+    }
+    if (++this->group_index_ >= this->group_size_) {
+      this->group_index_ = 0;
+      this->parity_ready_ = true;
+    }
+  }
+}
+
+bool FecEncoder::take_parity(wire::PacketHeader *header, const uint8_t **body, size_t *body_len) {
+  if (!this->parity_ready_) {
+    return false;
+  }
+  this->parity_ready_ = false;
+  header->type = wire::PacketType::PARITY;
+  header->flags = 0;
+  header->seq = this->parity_base_;
+  header->length = (uint16_t) (2 + this->parity_len_);
+  header->aux = (uint8_t) (this->group_size_ << 4);
+  *body = this->parity_.get();
+  *body_len = 2 + this->parity_len_;
+  return true;
+}
+
+// === Decoder ===
+
+bool FecDecoder::allocate(size_t max_payload) {
+  this->max_payload_ = max_payload;
+  this->storage_.reset(new (std::nothrow) uint8_t[WINDOW * max_payload]);
+  this->parity_.reset(new (std::nothrow) uint8_t[2 + max_payload]);
+  return this->storage_ != nullptr && this->parity_ != nullptr;
+}
+
+void FecDecoder::reset() {
+  this->started_ = false;
+  this->interval_released_ = 0;
+  this->interval_lost_ = 0;
+  this->interval_loss_runs_ = 0;
+}
+
+void FecDecoder::resync_(uint32_t seq) {
+  this->started_ = true;
+  this->next_ = seq;
+  this->highest_ = seq - 1;
+  this->force_until_ = seq;
+  this->group_size_ = 0;
+  this->parity_valid_ = false;
+  this->interval_highest_ = seq - 1;
+  this->interval_received_ = 0;
+  this->last_lost_ = false;
+  for (auto &slot : this->slots_) {
+    slot.state = EMPTY;
+  }
+}
+
+uint32_t FecDecoder::unwrap_(uint16_t seq) const {
+  return this->highest_ + (int16_t) (seq - (uint16_t) this->highest_);
+}
+
+void FecDecoder::put_(uint32_t seq, const uint8_t *data, size_t len, uint8_t flags, SlotState state) {
+  memcpy(this->slot_data_(seq), data, len);
+  Slot &slot = this->slot_(seq);
+  slot.seq = seq;
+  slot.len = (uint16_t) len;
+  slot.flags = flags;
+  slot.state = state;
+}
+
+bool FecDecoder::accept_(const wire::PacketHeader &header, uint32_t *seq) {
+  if (!this->started_) {
+    this->resync_(header.seq + 0x10000u);  // Offset keeps early reordering above zero
+  }
+  uint32_t ext = this->unwrap_(header.seq);
+  int32_t jump = (int32_t) (ext - this->highest_);
+  if (jump > MAX_SEQ_JUMP || jump < -MAX_SEQ_JUMP) {
+    this->resync_(ext);
+  }
+  if (ext < this->next_ || this->has_(ext)) {
+    return false;
+  }
+  this->interval_received_++;
+  if (ext - this->next_ >= WINDOW) {
+    this->force_until_ = ext - WINDOW + 1;
+  }
+
+  uint8_t group = header.aux >> 4;
+  uint8_t index = header.aux & 0x0F;
+  if (group >= FEC_MIN_GROUP && group <= FEC_MAX_GROUP && index < group) {
+    this->group_size_ = group;
+    this->last_base_ = ext - index;
+  } else {
+    this->group_size_ = 0;
+  }
+  *seq = ext;
+  return true;
+}
+
+bool FecDecoder::store_audio_(uint32_t seq, const wire::PacketHeader &header, const uint8_t *body,
+                              size_t body_len) {
+  // Whatever the window could not hold is gone
+  if (this->next_ < this->force_until_) {
+    this->count_release_(this->force_until_ - this->next_, true);
+    this->next_ = this->force_until_;
+  }
+  size_t len = header.length;
+  if (len > this->max_payload_) {
+    return false;
+  }
+
+  // RED: the previous frame rides along; use it if that frame is still missing
+  if ((header.flags & wire::FLAG_RED) && seq - 1 >= this->next_ && !this->has_(seq - 1)) {
+    size_t red_len = body_len - len;
+    if (red_len > 0 && red_len <= this->max_payload_) {
+      this->put_(seq - 1, body + len, red_len, header.flags, REDUNDANT);
+      this->recovered_.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  bool direct = seq == this->next_ && this->highest_ < seq && this->group_size_ == 0;
+  if (seq > this->highest_) {
+    this->highest_ = seq;
+  }
+  if (direct) {
+    this->count_release_(1, false);
+    this->next_++;
+    return true;
+  }
+  this->put_(seq, body, len, header.flags, PRIMARY);
+  if (this->parity_valid_) {
+    this->try_recover_xor_();
+  }
+  return false;
+}
+
+void FecDecoder::store_parity_(const wire::PacketHeader &header, const uint8_t *body, size_t body_len) {
+  uint8_t group = header.aux >> 4;
+  if (!this->started_ || group < FEC_MIN_GROUP || group > FEC_MAX_GROUP || header.length < 2 ||
+      header.length - 2u > this->max_payload_) {
+    return;
+  }
+  uint32_t base = this->unwrap_(header.seq);
+  if (base + group <= this->next_) {
+    return;  // The whole group has already been released
+  }
+  memcpy(this->parity_.get(), body, header.length);
+  this->parity_len_ = header.length - 2;
+  this->parity_base_ = base;
+  this->parity_group_ = group;
+  this->parity_flags_ = header.flags;
+  this->parity_valid_ = true;
+  this->try_recover_xor_();
+}
+
+void FecDecoder::try_recover_xor_() {
+  uint32_t missing = 0;
+  uint32_t missing_seq = 0;
+  for (uint32_t i = 0; i < this->parity_group_; i++) {
+    uint32_t seq = this->parity_base_ + i;
+    if (!this->has_(seq) || this->slot_(seq).state != PRIMARY) {
+      missing++;
+      missing_seq = seq;
+    }
+  }
+  if (missing != 1 || missing_seq < this->next_) {
+    return;  // Nothing to do, or more than one parity can fix
+  }
+
+  const uint8_t *parity = this->parity_.get();
+  uint16_t len = wire::get_be16(parity);
+  uint8_t *out = this->slot_data_(missing_seq);
+  memcpy(out, parity + 2, this->parity_len_);
+  for (uint32_t i = 0; i < this->parity_group_; i++) {
+    uint32_t seq = this->parity_base_ + i;
+    if (seq == missing_seq) {
+      continue;
+    }
+    const Slot &slot = this->slot_(seq);
+    const uint8_t *data = this->slot_data_(seq);
+    len ^= slot.len;
+    for (size_t j = 0; j < slot.len; j++) {
+      out[j] ^= data[j];
+    }
+  }
+  if (len == 0 || len > this->parity_len_) {
+    return;  // Inconsistent group (sender changed grouping mid-way)
+  }
+  Slot &slot = this->slot_(missing_seq);
+  slot.seq = missing_seq;
+  slot.len = len;
+  slot.flags = this->parity_flags_;
+  slot.state = PRIMARY;
+  this->recovered_.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint32_t FecDecoder::group_base_(uint32_t seq) const {
+  if (seq >= this->last_base_) {
+    return this->last_base_;
+  }
+  uint32_t groups = (this->last_base_ - seq + this->group_size_ - 1) / this->group_size_;
+  return this->last_base_ - groups * this->group_size_;
+}
+
+bool FecDecoder::recoverable_later_(uint32_t seq) const {
+  if (seq < this->force_until_ || this->group_size_ == 0) {
+    return false;
+  }
+  uint32_t base = this->group_base_(seq);
+  if (this->parity_valid_ && this->parity_base_ == base) {
+    return false;  // Parity is here and could not fill the gap
+  }
+  // Parity follows the last frame of the group: wait until the next group starts
+  return this->highest_ < base + this->group_size_;
+}
+
+bool FecDecoder::pop_(const uint8_t **data, size_t *len, uint8_t *flags, bool *redundant) {
+  while (this->started_ && this->next_ <= this->highest_) {
+    uint32_t seq = this->next_;
+    if (this->has_(seq)) {
+      const Slot &slot = this->slot_(seq);
+      *data = this->slot_data_(seq);
+      *len = slot.len;
+      *flags = slot.flags;
+      *redundant = slot.state == REDUNDANT;
+      this->count_release_(1, false);
+      this->next_++;
+      return true;
+    }
+    if (this->recoverable_later_(seq)) {
+      return false;
+    }
+    this->count_release_(1, true);
+    this->next_++;
+  }
+  return false;
+}
+
+uint16_t FecDecoder::take_loss_permille() {
+  uint32_t expected = this->highest_ - this->interval_highest_;
+  uint32_t received = this->interval_received_;
+  this->interval_highest_ = this->highest_;
+  this->interval_received_ = 0;
+  if (!this->started_ || expected == 0 || received >= expected) {
+    return 0;
+  }
+  return (uint16_t) ((expected - received) * 1000 / expected);
+}
+
+void FecDecoder::take_release_counts(uint32_t *released, uint32_t *lost, uint32_t *loss_runs) {
+  *released = this->interval_released_;
+  *lost = this->interval_lost_;
+  *loss_runs = this->interval_loss_runs_;
+  this->interval_released_ = 0;
+  this->interval_lost_ = 0;
+  this->interval_loss_runs_ = 0;
+}
+
+}  // namespace intercom_audio
+}  // namespace esphome
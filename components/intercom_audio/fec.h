@@ -0,0 +1,204 @@
+#pragma once
+
+// Forward error correction for the framed intercom stream.
+//   XOR: one parity packet after every group of N frames recovers any single
+//        lost frame of that group (N = 2..8)
+//   RED: every packet also carries the previous one (µ-law when the stream
+//        is PCM), so any isolated loss is recovered from the next packet
+// A "frame" here is one packet payload, which may pack several audio frames.
+// No ESPHome/ESP-IDF dependencies so it can be built and checked on the host.
+
+#include "packet.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace esphome {
+namespace intercom_audio {
+
+enum class FecMode : uint8_t {
+  NONE,
+  XOR,
+  RED,
+};
+
+static const uint8_t FEC_MIN_GROUP = 2;
+static const uint8_t FEC_MAX_GROUP = 8;
+
+// Sender side. Call prepare() -> send -> commit() -> take_parity() per frame.
+class FecEncoder {
+ public:
+  void set_mode(FecMode mode) { this->mode_ = mode; }
+  void set_group_size(uint8_t size) { this->group_size_ = size; }
+  // PCM streams send their redundant copy as device-rate µ-law (half the bytes).
+  // Changing it (payload codec switch) restarts redundancy like set_active().
+  void set_redundant_ulaw(bool ulaw);
+  FecMode get_mode() const { return this->mode_; }
+
+  bool allocate(size_t max_payload);
+  void reset();
+
+  // Redundancy is only sent while active (driven by the peer's loss reports)
+  void set_active(bool active);
+  bool is_active() const { return this->active_; }
+
+  // Header and redundant block for the next audio packet with `len` payload bytes
+  void prepare(size_t len, wire::PacketHeader *header, const uint8_t **red, size_t *red_len) const;
+  // The payload just sent: feeds the next redundant copy / running parity
+  void commit(const uint8_t *payload, size_t len);
+  // A parity packet completed by the last commit(); body is valid until the next commit()
+  bool take_parity(wire::PacketHeader *header, const uint8_t **body, size_t *body_len);
+
+ protected:
+  void restart_();
+
+  FecMode mode_{FecMode::NONE};
+  uint8_t group_size_{4};
+  bool redundant_ulaw_{true};
+  bool active_{false};
+  size_t max_payload_{0};
+
+  uint16_t seq_{0};
+
+  // RED: redundant copy of the previous frame
+  std::unique_ptr<uint8_t[]> red_;
+  size_t red_len_{0};
+  bool have_red_{false};
+
+  // XOR: length XOR (2 bytes) followed by the payload XOR
+  std::unique_ptr<uint8_t[]> parity_;
+  size_t parity_len_{0};
+  uint16_t parity_base_{0};
+  uint8_t group_index_{0};
+  bool parity_ready_{false};
+};
+
+// Receiver side: a small reorder window in front of the jitter buffer.
+// Frames are released in sequence order as soon as there is no gap; a gap is
+// only held while its recovery data can still arrive (rest of the XOR group),
+// so a clean stream adds no latency.
+class FecDecoder {
+ public:
+  static const uint32_t WINDOW = 16;  // Frames; must exceed FEC_MAX_GROUP
+
+  bool allocate(size_t max_payload);
+  void reset();
+
+  // Sink: void(const uint8_t *payload, size_t len, uint8_t flags, bool redundant).
+  // flags are those of the packet that carried (or rebuilt) the payload;
+  // redundant payloads are the RED copy (device-rate µ-law for PCM streams).
+  template<typename Sink>
+  void on_audio(const wire::PacketHeader &header, const uint8_t *body, size_t body_len, Sink &&sink) {
+    uint32_t seq;
+    if (!this->accept_(header, &seq)) {
+      return;  // Late or duplicate
+    }
+    this->release_(sink);  // Makes room if seq jumped past the window
+    if (this->store_audio_(seq, header, body, body_len)) {
+      // In order with nothing held: deliver straight from the packet
+      sink(body, header.length, header.flags, false);
+    }
+    this->release_(sink);
+  }
+
+  template<typename Sink>
+  void on_parity(const wire::PacketHeader &header, const uint8_t *body, size_t body_len, Sink &&sink) {
+    this->store_parity_(header, body, body_len);
+    this->release_(sink);
+  }
+
+  // Share of frames missing on arrival (before recovery) since the last call, per mille
+  uint16_t take_loss_permille();
+  // Frames released since the last call, how many of them were gaps (after
+  // recovery) and in how many separate runs
+  void take_release_counts(uint32_t *released, uint32_t *lost, uint32_t *loss_runs);
+
+  uint32_t get_recovered() const { return this->recovered_.load(std::memory_order_relaxed); }
+  uint32_t get_lost() const { return this->lost_.load(std::memory_order_relaxed); }
+  void reset_counters() {
+    this->recovered_.store(0, std::memory_order_relaxed);
+    this->lost_.store(0, std::memory_order_relaxed);
+  }
+
+ protected:
+  enum SlotState : uint8_t { EMPTY, PRIMARY, REDUNDANT };
+  struct Slot {
+    uint32_t seq{0};
+    uint16_t len{0};
+    uint8_t flags{0};
+    SlotState state{EMPTY};
+  };
+
+  template<typename Sink> void release_(Sink &sink) {
+    const uint8_t *data;
+    size_t len;
+    uint8_t flags;
+    bool redundant;
+    while (this->pop_(&data, &len, &flags, &redundant)) {
+      sink(data, len, flags, redundant);
+    }
+  }
+
+  uint32_t unwrap_(uint16_t seq) const;
+  Slot &slot_(uint32_t seq) { return this->slots_[seq % WINDOW]; }
+  uint8_t *slot_data_(uint32_t seq) { return this->storage_.get() + (seq % WINDOW) * this->max_payload_; }
+  bool has_(uint32_t seq) const {
+    const Slot &slot = this->slots_[seq % WINDOW];
+    return slot.seq == seq && slot.state != EMPTY;
+  }
+  void put_(uint32_t seq, const uint8_t *data, size_t len, uint8_t flags, SlotState state);
+  void resync_(uint32_t seq);
+
+  bool accept_(const wire::PacketHeader &header, uint32_t *seq);
+  // True when the caller may deliver the packet directly
+  bool store_audio_(uint32_t seq, const wire::PacketHeader &header, const uint8_t *body, size_t body_len);
+  void store_parity_(const wire::PacketHeader &header, const uint8_t *body, size_t body_len);
+  void try_recover_xor_();
+  uint32_t group_base_(uint32_t seq) const;
+  bool recoverable_later_(uint32_t seq) const;
+  bool pop_(const uint8_t **data, size_t *len, uint8_t *flags, bool *redundant);
+  void count_release_(uint32_t frames, bool lost) {
+    this->interval_released_ += frames;
+    if (lost) {
+      this->interval_lost_ += frames;
+      this->interval_loss_runs_ += this->last_lost_ ? 0 : 1;
+      this->lost_.fetch_add(frames, std::memory_order_relaxed);
+    }
+    this->last_lost_ = lost;
+  }
+
+  size_t max_payload_{0};
+  std::unique_ptr<uint8_t[]> storage_;
+  Slot slots_[WINDOW];
+
+  bool started_{false};
+  uint32_t next_{0};     // Next sequence number to release (unwrapped)
+  uint32_t highest_{0};  // Highest sequence number stored or delivered (unwrapped)
+  uint32_t force_until_{0};  // Frames below this are released without waiting
+
+  // Sender's current XOR grouping, from the latest audio packet
+  uint8_t group_size_{0};
+  uint32_t last_base_{0};
+
+  std::unique_ptr<uint8_t[]> parity_;
+  size_t parity_len_{0};
+  uint32_t parity_base_{0};
+  uint8_t parity_group_{0};
+  uint8_t parity_flags_{0};
+  bool parity_valid_{false};
+
+  uint32_t interval_highest_{0};
+  uint32_t interval_received_{0};
+  uint32_t interval_released_{0};
+  uint32_t interval_lost_{0};
+  uint32_t interval_loss_runs_{0};
+  bool last_lost_{false};
+
+  std::atomic<uint32_t> recovered_{0};
+  std::atomic<uint32_t> lost_{0};  // Released as gaps: not recoverable in time
+};
+
+}  // namespace intercom_audio
+}  // namespace esphome
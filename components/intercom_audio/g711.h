@@ -0,0 +1,62 @@
+#pragma once
+
+// Table-driven ITU-T G.711 A-law / µ-law codec.
+// No ESPHome/ESP-IDF dependencies so it can be built and checked on the host.
+
+#include <cstddef>
+#include <cstdint>
+
+namespace esphome {
+namespace intercom_audio {
+namespace g711 {
+
+extern const int16_t ALAW_DECODE_TABLE[256];
+extern const int16_t ULAW_DECODE_TABLE[256];
+extern const uint8_t SEGMENT_TABLE[256];  // floor(log2(v)) for v >= 1, 0 for v = 0
+
+inline uint8_t alaw_encode(int16_t pcm) {
+  int32_t value = pcm >> 3;  // 13-bit
+  uint8_t mask;
+  if (value >= 0) {
+    mask = 0xD5;
+  } else {
+    mask = 0x55;
+    value = -value - 1;
+  }
+  if (value > 0xFFF) {
+    return 0x7F ^ mask;
+  }
+  uint8_t seg = value < 0x20 ? 0 : SEGMENT_TABLE[value >> 4];
+  uint8_t mantissa = seg < 2 ? (value >> 1) & 0x0F : (value >> seg) & 0x0F;
+  return (uint8_t) ((seg << 4) | mantissa) ^ mask;
+}
+
+inline uint8_t ulaw_encode(int16_t pcm) {
+  static const int32_t CLIP = 8159;
+  static const int32_t BIAS = 0x84 >> 2;
+  int32_t value = pcm >> 2;  // 14-bit
+  uint8_t mask;
+  if (value < 0) {
+    mask = 0x7F;
+    value = -value;
+  } else {
+    mask = 0xFF;
+  }
+  if (value > CLIP) {
+    value = CLIP;
+  }
+  value += BIAS;
+  if (value > 0x1FFF) {
+    return 0x7F ^ mask;
+  }
+  uint8_t seg = SEGMENT_TABLE[value >> 5];
+  uint8_t mantissa = (value >> (seg + 1)) & 0x0F;
+  return (uint8_t) ((seg << 4) | mantissa) ^ mask;
+}
+
+inline int16_t alaw_decode(uint8_t code) { return ALAW_DECODE_TABLE[code]; }
+inline int16_t ulaw_decode(uint8_t code) { return ULAW_DECODE_TABLE[code]; }
+
+}  // namespace g711
+}  // namespace intercom_audio
+}  // namespace esphome
@@ -8,17 +8,28 @@
 #include "esphome/components/esp_aec/esp_aec.h"
 #endif
 
+#ifdef USE_MDNS_DISCOVERY
+#include "esphome/components/mdns_discovery/mdns_discovery.h"
+#endif
+
 #ifdef USE_ESP32
 
 #include "esphome/core/log.h"
 #include "esphome/core/application.h"
+#include "esphome/core/hal.h"
+#include "esphome/core/helpers.h"
+#include "g711.h"
 #ifdef USE_SPEAKER
 #include "esphome/components/audio/audio.h"
 #endif
 
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+#include <esp_vfs_eventfd.h>
 #include <lwip/netdb.h>
 #include <arpa/inet.h>
 #include <fcntl.h>
+#include <algorithm>
 #include <cstring>
 
 namespace esphome {
@@ -26,27 +37,111 @@ namespace intercom_audio {
 
 static const char *const TAG = "intercom_audio";
 
-// Audio parameters
-static const uint32_t SAMPLE_RATE = 16000;
-static const size_t FRAME_SAMPLES = 256;  // 16ms @ 16kHz
+// Audio parameters (fixed at compile time, see intercom_audio.h)
+static const uint32_t SAMPLE_RATE = INTERCOM_AUDIO_SAMPLE_RATE;
+static const size_t FRAME_SAMPLES = INTERCOM_AUDIO_FRAME_SAMPLES;
 static const size_t FRAME_BYTES = FRAME_SAMPLES * sizeof(int16_t);
-static const size_t RX_MAX_SAMPLES = 512;  // Max samples per UDP packet
+static const uint8_t MAX_PACKET_FRAMES = 4;  // Frames per UDP packet, both directions
+static const size_t RX_MAX_SAMPLES = FRAME_SAMPLES * MAX_PACKET_FRAMES;  // Max samples per UDP packet
 static const size_t RX_MAX_BYTES = RX_MAX_SAMPLES * sizeof(int16_t);
 
+// UDP payload of a 1500-byte MTU. lwIP on ESP32 does not reassemble IP
+// fragments by default, so packed and framed packets stay below it.
+static const size_t MAX_DATAGRAM_BYTES = 1472;
+// Framed payloads leave room for the header, an XOR parity length and an authentication tag
+static const size_t FRAMED_MAX_PAYLOAD =
+    std::min(RX_MAX_BYTES, MAX_DATAGRAM_BYTES - wire::HEADER_SIZE - 2 - StreamCrypto::TAG_SIZE);
+
+// Upper bound on a select() wait while streaming; every real wakeup is an event
+static const uint32_t EVENT_GUARD_MS = 100;
+// Wait while the speaker is full: it frees a frame every FRAME_SAMPLES / rate
+static const uint32_t BACKPRESSURE_WAIT_MS = std::max<uint32_t>(1, FRAME_SAMPLES * 1000 / SAMPLE_RATE / 2);
+
+// Largest datagram read from the socket: header, payload, a redundant µ-law copy and a tag
+static const size_t RX_PACKET_BYTES = wire::HEADER_SIZE + RX_MAX_BYTES + RX_MAX_SAMPLES + StreamCrypto::TAG_SIZE;
+
+// Link adaptation: step down on loss or RTT growth (queueing), step back up
+// after several clean reports
+static const uint16_t CONGESTED_LOSS_PERMILLE = 50;
+static const uint16_t CLEAR_LOSS_PERMILLE = 10;
+static const uint32_t QUEUE_DELAY_MS = 80;
+static const uint8_t CLEAR_REPORTS_TO_STEP_UP = 5;
+
+// Framing negotiation: unanswered HELLOs stop after a while so a raw peer
+// (go2rtc, older firmware) only ever sees a few short blips
+static const uint32_t HELLO_INTERVAL_MS = 250;
+static const uint8_t MAX_UNANSWERED_HELLOS = 8;
+static const uint32_t REPORT_INTERVAL_MS = 1000;
+
+// Encryption: a HELLO with a new nonce that does not echo ours may be a
+// replay, so it only rekeys once the current session keys have gone quiet
+static const uint32_t REKEY_QUIET_MS = 1000;
+
+// G.711 payloads are 8 kHz: half the samples, one byte each
+static const size_t NARROW_FRAME_SAMPLES = FRAME_SAMPLES / 2;
+static const size_t RX_MAX_NARROW_SAMPLES = RX_MAX_SAMPLES / 2;
+
+static const char *fec_mode_to_str(FecMode mode) {
+  switch (mode) {
+    case FecMode::XOR:
+      return "xor";
+    case FecMode::RED:
+      return "red";
+    default:
+      return "off";
+  }
+}
+
+static const char *codec_to_str(PayloadCodec codec) {
+  switch (codec) {
+    case PayloadCodec::G711_ALAW:
+      return "G.711 A-law 8kHz";
+    case PayloadCodec::G711_ULAW:
+      return "G.711 mu-law 8kHz";
+    default:
+      return "PCM 16-bit";
+  }
+}
+
+// Payload bytes of one device-rate frame on the wire
+static size_t frame_payload_bytes(PayloadCodec codec) {
+  return codec == PayloadCodec::PCM16 ? FRAME_BYTES : FRAME_SAMPLES / 2;
+}
+
 void IntercomAudio::setup() {
   ESP_LOGCONFIG(TAG, "Setting up Intercom Audio...");
 
-  // Create mutexes for shared buffers
+  // Create mutexes for shared buffers, and the audio task's answer to stop()
   this->mic_mutex_ = xSemaphoreCreateMutex();
   this->ref_mutex_ = xSemaphoreCreateMutex();
-  if (!this->mic_mutex_ || !this->ref_mutex_) {
+  this->task_idle_ = xSemaphoreCreateBinary();
+  if (!this->mic_mutex_ || !this->ref_mutex_ || !this->task_idle_) {
     ESP_LOGE(TAG, "Failed to create mutexes");
     this->mark_failed();
     return;
   }
 
-  // Pre-allocate mic conversion buffer
-  this->mic_convert_buf_.resize(FRAME_SAMPLES);
+#ifdef USE_I2S_AUDIO_DUPLEX
+  // Codegen validates this too; a mismatch here would mean a mixed build
+  if (this->duplex_ != nullptr && (this->duplex_->get_sample_rate() != SAMPLE_RATE ||
+                                   this->duplex_->get_frame_samples() != FRAME_SAMPLES)) {
+    ESP_LOGE(TAG, "Duplex format (%u Hz, %zu samples) does not match intercom (%u Hz, %zu samples)",
+             (unsigned) this->duplex_->get_sample_rate(), this->duplex_->get_frame_samples(),
+             (unsigned) SAMPLE_RATE, FRAME_SAMPLES);
+    this->mark_failed();
+    return;
+  }
+#endif
+
+  // Mic ingestion: frame accumulator and conversion buffers, nothing allocated per callback
+  this->mic_frame_ = (int16_t *) heap_caps_malloc(FRAME_BYTES, MALLOC_CAP_INTERNAL);
+  this->mic_wide_ = (int32_t *) heap_caps_malloc(FRAME_SAMPLES * sizeof(int32_t), MALLOC_CAP_INTERNAL);
+  if (!this->mic_ingest_.allocate(FRAME_SAMPLES, SAMPLE_RATE) || !this->mic_frame_ || !this->mic_wide_) {
+    ESP_LOGE(TAG, "Failed to allocate mic buffers");
+    this->mark_failed();
+    return;
+  }
+  this->mic_converter_.set_gain(this->mic_gain_);
 
   // Allocate frame buffers
   this->rx_frame_ = (int16_t *)heap_caps_malloc(RX_MAX_BYTES, MALLOC_CAP_INTERNAL);
@@ -57,14 +152,133 @@ void IntercomAudio::setup() {
     return;
   }
 
-  // Create ring buffers
-  this->rx_buffer_ = RingBuffer::create(this->buffer_size_);
+  // G.711 scratch buffers, only for the directions that use it (configured, or
+  // reachable through link adaptation / a framed peer on a 16 kHz device)
+  const bool socket = this->transport_ == TransportType::SOCKET;
+  const bool g711_capable = SAMPLE_RATE == 16000 && socket && this->framing_enabled_();
+  const bool tx_g711 = this->tx_codec_ != PayloadCodec::PCM16 ||
+                       (g711_capable && this->adaptive_ && this->codec_fallback_ != PayloadCodec::PCM16);
+  if (tx_g711) {
+    this->tx_narrow_buf_ = (int16_t *)heap_caps_malloc(NARROW_FRAME_SAMPLES * sizeof(int16_t), MALLOC_CAP_INTERNAL);
+    if (!this->tx_narrow_buf_) {
+      ESP_LOGE(TAG, "Failed to allocate TX codec buffers");
+      this->mark_failed();
+      return;
+    }
+  }
+  if (this->framing_enabled_()) {
+    this->max_packet_frames_ = std::max(this->max_packet_frames_, this->packet_frames_);
+  } else {
+    this->max_packet_frames_ = this->packet_frames_;
+  }
+  if (socket && (tx_g711 || this->max_packet_frames_ > 1)) {
+    this->tx_pack_buf_ = (uint8_t *)heap_caps_malloc(this->max_packet_frames_ * FRAME_BYTES, MALLOC_CAP_INTERNAL);
+    if (!this->tx_pack_buf_) {
+      ESP_LOGE(TAG, "Failed to allocate TX packet buffer");
+      this->mark_failed();
+      return;
+    }
+  }
+  if (this->rx_codec_ != PayloadCodec::PCM16 || g711_capable) {
+    this->rx_narrow_buf_ = (int16_t *)heap_caps_malloc(RX_MAX_NARROW_SAMPLES * sizeof(int16_t), MALLOC_CAP_INTERNAL);
+    if (!this->rx_narrow_buf_) {
+      ESP_LOGE(TAG, "Failed to allocate RX codec buffers");
+      this->mark_failed();
+      return;
+    }
+  }
+  if (socket) {
+    this->rx_packet_ = (uint8_t *)heap_caps_malloc(RX_PACKET_BYTES, MALLOC_CAP_INTERNAL);
+    if (!this->rx_packet_) {
+      ESP_LOGE(TAG, "Failed to allocate RX packet buffer");
+      this->mark_failed();
+      return;
+    }
+  }
+  if (this->crypto_.is_enabled()) {
+    if (!StreamCrypto::is_supported(this->crypto_.get_suite())) {
+      ESP_LOGE(TAG, "ChaCha20-Poly1305 is not enabled in mbedTLS");
+      this->mark_failed();
+      return;
+    }
+    this->tx_crypt_buf_ = (uint8_t *)heap_caps_malloc(MAX_DATAGRAM_BYTES, MALLOC_CAP_INTERNAL);
+    if (!this->tx_crypt_buf_) {
+      ESP_LOGE(TAG, "Failed to allocate TX encryption buffer");
+      this->mark_failed();
+      return;
+    }
+  }
+
+  // Recording history; without it the intercom itself still works
+  if (this->recorder_.is_configured()) {
+    this->recorder_.set_sample_rate(SAMPLE_RATE);
+    if (!this->recorder_.allocate()) {
+      ESP_LOGE(TAG, "Failed to allocate %zu bytes of recording history", this->recorder_.get_memory_bytes());
+    }
+#ifdef USE_INTERCOM_WEB_EXPORT
+    if (this->recording_export_ != nullptr && this->recorder_.is_allocated()) {
+      this->recording_export_->setup();
+    }
+#endif
+  }
+
+  // Trace ring: at most five records (mic, reference, AEC output, received, played) per frame
+  if (this->trace_duration_ms_ != 0) {
+    uint32_t frames = (uint32_t) ((uint64_t) this->trace_duration_ms_ * SAMPLE_RATE / 1000 / FRAME_SAMPLES);
+    this->trace_.configure(SAMPLE_RATE, FRAME_SAMPLES, frames * AudioTrace::RECORDS_PER_FRAME);
+    if (!this->trace_.allocate()) {
+      ESP_LOGE(TAG, "Failed to allocate %zu bytes of PSRAM for the trace", this->trace_.get_memory_bytes());
+    }
+#ifdef USE_INTERCOM_WEB_EXPORT
+    if (this->trace_export_ != nullptr && this->trace_.is_allocated()) {
+      this->trace_export_->setup();
+    }
+#endif
+  }
+#ifdef USE_INTERCOM_WEB_EXPORT
+  if (this->metrics_export_ != nullptr) {
+    this->metrics_export_->setup();
+  }
+#endif
+
+  // Sequencing, reorder window and FEC redundancy buffers for framed sessions
+  if (this->framing_enabled_()) {
+    this->fec_tx_.set_mode(this->fec_mode_);
+    this->fec_tx_.set_group_size(this->fec_group_size_);
+    this->fec_tx_.set_redundant_ulaw(this->tx_codec_ == PayloadCodec::PCM16);
+    if (!this->fec_tx_.allocate(FRAMED_MAX_PAYLOAD) || !this->fec_rx_.allocate(FRAMED_MAX_PAYLOAD)) {
+      ESP_LOGE(TAG, "Failed to allocate FEC buffers");
+      this->mark_failed();
+      return;
+    }
+  }
+  this->tx_codec_active_ = this->tx_codec_;
+  this->tx_frames_ = this->packet_frames_;
+  this->link_codec_.store((uint8_t) this->tx_codec_, std::memory_order_relaxed);
+  this->link_frames_.store(this->packet_frames_, std::memory_order_relaxed);
+
+  // Create ring buffers (netconn keeps received pbufs queued instead of an RX ring)
+  if (this->transport_ == TransportType::SOCKET) {
+    this->rx_buffer_ = RingBuffer::create(this->buffer_size_);
+  }
   this->mic_input_buffer_ = RingBuffer::create(this->buffer_size_);
-  if (!this->rx_buffer_ || !this->mic_input_buffer_) {
+  if ((this->transport_ == TransportType::SOCKET && !this->rx_buffer_) || !this->mic_input_buffer_) {
     ESP_LOGE(TAG, "Failed to create ring buffers");
     this->mark_failed();
     return;
   }
+  // One capture time per frame the mic buffer can hold
+  uint32_t capture_slots = 1;
+  while (capture_slots < this->buffer_size_ / FRAME_BYTES + 1) {
+    capture_slots <<= 1;
+  }
+  this->capture_times_ = (uint32_t *) heap_caps_calloc(capture_slots, sizeof(uint32_t), MALLOC_CAP_INTERNAL);
+  if (this->capture_times_ == nullptr) {
+    ESP_LOGE(TAG, "Failed to allocate capture times");
+    this->mark_failed();
+    return;
+  }
+  this->capture_times_mask_ = capture_slots - 1;
 
   // Create speaker reference buffer for AEC (if AEC configured)
 #ifdef USE_ESP_AEC
@@ -92,6 +306,12 @@ void IntercomAudio::setup() {
     this->duplex_->add_mic_data_callback([this](const uint8_t *data, size_t len) {
       this->on_microphone_data_(data, len);
     });
+#ifdef USE_INTERCOM_FAULT_INJECTION
+    // Both checked on the duplex audio task only
+    this->duplex_->set_io_fault([this](bool write) {
+      return this->inject_fault_(write ? Fault::I2S_WRITE_TIMEOUT : Fault::I2S_READ_TIMEOUT);
+    });
+#endif
   } else
 #endif
 #ifdef USE_MICROPHONE
@@ -113,6 +333,17 @@ void IntercomAudio::setup() {
   }
 #endif
 
+  // Wake fd lets the audio task block in select() on the RX socket and still be
+  // woken by mic frames and start/stop
+  esp_vfs_eventfd_config_t eventfd_config = ESP_VFS_EVENTD_CONFIG_DEFAULT();
+  esp_err_t err = esp_vfs_eventfd_register(&eventfd_config);
+  if (err == ESP_OK || err == ESP_ERR_INVALID_STATE) {  // INVALID_STATE: already registered
+    this->wake_fd_ = eventfd(0, 0);
+  }
+  if (this->wake_fd_ < 0) {
+    ESP_LOGW(TAG, "eventfd unavailable, falling back to 5 ms polling");
+  }
+
   // Create audio task ONCE - runs forever, controlled by streaming_ flag
   // Stack: 8KB needed for AEC processing + local buffers
   BaseType_t ok = xTaskCreatePinnedToCore(
@@ -130,6 +361,9 @@ void IntercomAudio::setup() {
     return;
   }
 
+  // Not in a call yet: allow light sleep / slow the main loop if configured
+  this->idle_power_.setup();
+
   ESP_LOGI(TAG, "Intercom Audio ready, listen port: %d", this->listen_port_);
 }
 
@@ -138,6 +372,74 @@ void IntercomAudio::dump_config() {
   ESP_LOGCONFIG(TAG, "  Listen Port: %d", this->listen_port_);
   ESP_LOGCONFIG(TAG, "  Buffer Size: %zu bytes", this->buffer_size_);
   ESP_LOGCONFIG(TAG, "  Mode: %s", this->get_mode_str());
+  ESP_LOGCONFIG(TAG, "  Format: %u Hz, %zu-sample frames (%u ms)", (unsigned) SAMPLE_RATE, FRAME_SAMPLES,
+                (unsigned) (FRAME_SAMPLES * 1000 / SAMPLE_RATE));
+  ESP_LOGCONFIG(TAG, "  TX Codec: %s", codec_to_str(this->tx_codec_));
+  ESP_LOGCONFIG(TAG, "  RX Codec: %s", codec_to_str(this->rx_codec_));
+  ESP_LOGCONFIG(TAG, "  Transport: %s", this->transport_ == TransportType::NETCONN ? "netconn" : "socket");
+  if (this->ip_tos_ != 0) {
+    ESP_LOGCONFIG(TAG, "  DSCP: %u", this->ip_tos_ >> 2);
+  }
+  this->wifi_profile_.dump_config(TAG);
+  this->idle_power_.dump_config(TAG);
+  if (this->latency_target_ms_ != 0) {
+    ESP_LOGCONFIG(TAG, "  Latency Target: %u ms (prebuffer %zu bytes)", (unsigned) this->latency_target_ms_,
+                  this->prebuffer_size_);
+  }
+  ESP_LOGCONFIG(TAG, "  Packet: %u frame(s), %u ms", this->packet_frames_,
+                (unsigned) (this->packet_frames_ * FRAME_SAMPLES * 1000 / SAMPLE_RATE));
+  ESP_LOGCONFIG(TAG, "  FEC: %s", fec_mode_to_str(this->fec_mode_));
+  if (this->fec_mode_ != FecMode::NONE) {
+    ESP_LOGCONFIG(TAG, "    Loss Threshold: %.1f%%", this->fec_loss_threshold_permille_ / 10.0f);
+  }
+  if (this->fec_mode_ == FecMode::XOR) {
+    ESP_LOGCONFIG(TAG, "    Group Size: %u frames", this->fec_group_size_);
+  }
+  if (this->adaptive_) {
+    ESP_LOGCONFIG(TAG, "  Adaptation: up to %u frames per packet, fallback %s", this->max_packet_frames_,
+                  this->codec_fallback_ == PayloadCodec::PCM16 ? "none" : codec_to_str(this->codec_fallback_));
+  }
+  if (this->crypto_.is_enabled()) {
+    ESP_LOGCONFIG(TAG, "  Encryption: %s", this->crypto_.get_suite() == CipherSuite::CHACHA20_POLY1305
+                                               ? "ChaCha20-Poly1305"
+                                               : "AES-256-GCM");
+  }
+  if (this->peer_timeout_ms_ > 0) {
+    ESP_LOGCONFIG(TAG, "  Peer Timeout: %u ms%s", (unsigned) this->peer_timeout_ms_,
+                  this->stop_on_peer_lost_ ? ", stops streaming" : "");
+  }
+#ifdef USE_INTERCOM_FAULT_INJECTION
+  if (this->faults_.is_enabled()) {
+    ESP_LOGW(TAG, "  Fault Injection: enabled, for soak testing only");
+    for (size_t i = 0; i < FaultInjector::FAULTS; i++) {
+      ESP_LOGCONFIG(TAG, "    %s: %.2f%%", fault_to_str((Fault) i), this->faults_.get_rate((Fault) i) * 100.0f);
+    }
+  }
+#endif
+  if (this->recorder_.is_configured()) {
+    ESP_LOGCONFIG(TAG, "  Recording: %s, %u ms history, %zu bytes (%zu bytes/s)%s",
+                  this->recorder_.get_format() == RecordFormat::ULAW ? "ulaw" : "pcm",
+                  (unsigned) this->recorder_.get_capacity_ms(), this->recorder_.get_memory_bytes(),
+                  this->recorder_.get_bytes_per_second(), this->recorder_.is_allocated() ? "" : " [NOT ALLOCATED]");
+    ESP_LOGCONFIG(TAG, "    Pre-roll: %u ms%s", (unsigned) this->recorder_.get_pre_roll_ms(),
+                  this->recorder_.get_pre_roll_ms() != 0 ? " (microphone runs between calls)" : "");
+    ESP_LOGCONFIG(TAG, "    Record Calls: %s", this->record_calls_ ? "yes" : "no");
+#ifdef USE_INTERCOM_WEB_EXPORT
+    if (this->recording_export_ != nullptr) {
+      ESP_LOGCONFIG(TAG, "    Export: %s", this->recording_export_->get_path().c_str());
+    }
+#endif
+  }
+  if (this->trace_duration_ms_ != 0) {
+    ESP_LOGCONFIG(TAG, "  Trace: %u records of %zu bytes (%zu bytes)%s", (unsigned) this->trace_.get_records(),
+                  this->trace_.get_record_size(), this->trace_.get_memory_bytes(),
+                  this->trace_.is_allocated() ? "" : " [NOT ALLOCATED]");
+#ifdef USE_INTERCOM_WEB_EXPORT
+    if (this->trace_export_ != nullptr) {
+      ESP_LOGCONFIG(TAG, "    Export: %s", this->trace_export_->get_path().c_str());
+    }
+#endif
+  }
   if (this->aec_ == nullptr) {
     ESP_LOGCONFIG(TAG, "  AEC: not configured");
   } else {
@@ -146,7 +448,15 @@ void IntercomAudio::dump_config() {
 }
 
 void IntercomAudio::loop() {
-  // Nothing needed - task does all the work
+  // The task does all the streaming work; it only hands peer loss over here so
+  // the automation (and stop()) run on the main loop
+  if (this->peer_lost_pending_.exchange(false, std::memory_order_acq_rel)) {
+    this->peer_lost_trigger_.trigger();
+    if (this->stop_on_peer_lost_ && this->is_streaming()) {
+      ESP_LOGI(TAG, "Peer lost: stopping stream");
+      this->stop();
+    }
+  }
 }
 
 void IntercomAudio::start() {
@@ -175,21 +485,28 @@ void IntercomAudio::start(const std::string &remote_ip, uint16_t remote_port) {
     return;
   }
 
+  // Call profile: CPU awake at full speed, Wi-Fi power save off / TX power for the duration of the call
+  this->idle_power_.leave();
+  this->wifi_profile_.apply();
+
   // Reset metrics
-  this->tx_packets_.store(0, std::memory_order_relaxed);
-  this->rx_packets_.store(0, std::memory_order_relaxed);
-  this->tx_drops_.store(0, std::memory_order_relaxed);
-  this->rx_drops_.store(0, std::memory_order_relaxed);
+  this->reset_counters();
 
   // Increment session to invalidate any stale data, then reset buffers
   this->session_.fetch_add(1, std::memory_order_acq_rel);
+  this->peer_lost_.store(false, std::memory_order_relaxed);
+  this->peer_lost_pending_.store(false, std::memory_order_relaxed);
 
-  // Reset DC offset tracking for clean start
-  this->dc_sum_ = 0;
+  // Reset DC offset tracking for clean start (with a pre-roll the mic callback
+  // is running and the estimate is already settled)
+  if (!this->recorder_.is_always_on()) {
+    this->mic_converter_.reset();
+  }
 
   if (this->rx_buffer_) this->rx_buffer_->reset();
   if (xSemaphoreTake(this->mic_mutex_, pdMS_TO_TICKS(50)) == pdTRUE) {
     if (this->mic_input_buffer_) this->mic_input_buffer_->reset();
+    this->capture_times_tail_ = this->capture_times_head_;
     xSemaphoreGive(this->mic_mutex_);
   }
   if (xSemaphoreTake(this->ref_mutex_, pdMS_TO_TICKS(50)) == pdTRUE) {
@@ -197,12 +514,16 @@ void IntercomAudio::start(const std::string &remote_ip, uint16_t remote_port) {
     xSemaphoreGive(this->ref_mutex_);
   }
 
-  // Enable streaming and wake up task
+  // Enable streaming and wake up task (idle, it waits on its notification)
   this->streaming_.store(true, std::memory_order_release);
   if (this->audio_task_handle_) {
     xTaskNotifyGive(this->audio_task_handle_);
   }
+  if (this->record_calls_) {
+    this->recorder_.start_recording();
+  }
 
+  this->starts_.fetch_add(1, std::memory_order_relaxed);
   this->start_trigger_.trigger();
   ESP_LOGI(TAG, "Streaming started");
 }
@@ -211,6 +532,7 @@ void IntercomAudio::stop() {
   if (!this->streaming_.load(std::memory_order_acquire)) {
     return;
   }
+  const int64_t stop_start = esp_timer_get_time();
 
   // Diagnostic logging before stop
   ESP_LOGW(TAG, "STOP: heap_free=%u, rx_avail=%zu",
@@ -224,6 +546,9 @@ void IntercomAudio::stop() {
 
   ESP_LOGI(TAG, "Stopping stream");
 
+  // An answer left from an earlier stop (or boot) must not count for this one
+  xSemaphoreTake(this->task_idle_, 0);
+
   // Disable streaming first
   this->streaming_.store(false, std::memory_order_release);
 
@@ -231,22 +556,31 @@ void IntercomAudio::stop() {
   this->session_.fetch_add(1, std::memory_order_acq_rel);
 
   // Wake up task FIRST so it sees streaming_=false
-  if (this->audio_task_handle_) {
-    xTaskNotifyGive(this->audio_task_handle_);
+  this->wake_task_();
+
+  // CRITICAL: the task may be mid-receive or mid-write to the speaker. Sockets,
+  // netconn and buffers go only once it has left its pass and gone idle.
+  if (this->audio_task_handle_ != nullptr &&
+      xSemaphoreTake(this->task_idle_, pdMS_TO_TICKS(STOP_ACK_TIMEOUT_MS)) != pdTRUE) {
+    this->stop_ack_timeouts_.fetch_add(1, std::memory_order_relaxed);
+    ESP_LOGE(TAG, "Audio task did not go idle within %u ms; stopping anyway", (unsigned) STOP_ACK_TIMEOUT_MS);
   }
 
-  // CRITICAL: Wait for audio_task to stop processing before resetting buffers
-  // This prevents race condition where task is mid-write to speaker
-  vTaskDelay(pdMS_TO_TICKS(100));
+  if (this->record_calls_) {
+    this->recorder_.stop_recording();
+  }
 
-  // Close sockets
+  // Close sockets, put the Wi-Fi settings back and go idle
   this->close_sockets_();
+  this->wifi_profile_.restore();
+  this->idle_power_.enter();
 
   // Reset buffers (now safe - audio_task has seen streaming_=false)
   if (this->rx_buffer_) this->rx_buffer_->reset();
   this->rx_fill_.store(0, std::memory_order_release);
   if (xSemaphoreTake(this->mic_mutex_, pdMS_TO_TICKS(50)) == pdTRUE) {
     if (this->mic_input_buffer_) this->mic_input_buffer_->reset();
+    this->capture_times_tail_ = this->capture_times_head_;
     xSemaphoreGive(this->mic_mutex_);
   }
   if (xSemaphoreTake(this->ref_mutex_, pdMS_TO_TICKS(50)) == pdTRUE) {
@@ -255,15 +589,21 @@ void IntercomAudio::stop() {
   }
 
 #ifdef USE_I2S_AUDIO_DUPLEX
-  // Duplex can be safely stopped (no ESPHome cleanup bug)
-  if (this->duplex_ != nullptr) {
+  // Duplex can be safely stopped (no ESPHome cleanup bug), unless a microphone
+  // platform (wake word, voice assistant) is still listening on its frame bus
+  // or the recording pre-roll needs the microphone
+  if (this->duplex_ != nullptr && !this->duplex_->get_frame_bus().has_active_subscribers() &&
+      !this->recorder_.is_always_on()) {
     this->duplex_->stop();
   }
 #endif
   // DO NOT stop ESPHome speaker/microphone - keep them running to avoid cleanup bugs
 
-  // Diagnostic logging after stop
-  ESP_LOGW(TAG, "STOP DONE: heap_free=%u", heap_caps_get_free_size(MALLOC_CAP_INTERNAL));
+  // Diagnostic logging after stop; a soak run watches the heap and stop time across cycles
+  uint32_t heap_free = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+  this->heap_after_stop_.store(heap_free, std::memory_order_relaxed);
+  this->stop_histogram_.record((uint32_t) (esp_timer_get_time() - stop_start));
+  ESP_LOGW(TAG, "STOP DONE: heap_free=%u", heap_free);
 
   this->stop_trigger_.trigger();
   ESP_LOGI(TAG, "Streaming stopped");
@@ -273,6 +613,16 @@ bool IntercomAudio::setup_sockets_() {
   // Ensure clean state
   this->close_sockets_();
 
+  if (this->transport_ == TransportType::NETCONN) {
+    if (this->remote_ip_.empty()) {
+      ESP_LOGE(TAG, "Remote IP is empty");
+      return false;
+    }
+    return this->netconn_.open(this->listen_port_, this->remote_ip_.c_str(), this->remote_port_,
+                               this->buffer_size_, [](void *arg) { static_cast<IntercomAudio *>(arg)->wake_task_(); },
+                               this, this->ip_tos_);
+  }
+
   // Create RX socket
   this->rx_socket_ = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
   if (this->rx_socket_ < 0) {
@@ -313,6 +663,15 @@ bool IntercomAudio::setup_sockets_() {
   int sndbuf = 16384;
   setsockopt(this->tx_socket_, SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
 
+  // DSCP on both sockets; the Wi-Fi driver maps EF to the WMM voice queue
+  if (this->ip_tos_ != 0) {
+    int tos = this->ip_tos_;
+    if (setsockopt(this->tx_socket_, IPPROTO_IP, IP_TOS, &tos, sizeof(tos)) != 0 ||
+        setsockopt(this->rx_socket_, IPPROTO_IP, IP_TOS, &tos, sizeof(tos)) != 0) {
+      ESP_LOGW(TAG, "Failed to set IP_TOS: %d", errno);
+    }
+  }
+
   // Setup remote address
   if (this->remote_ip_.empty()) {
     ESP_LOGE(TAG, "Remote IP is empty");
@@ -336,6 +695,7 @@ bool IntercomAudio::setup_sockets_() {
 }
 
 void IntercomAudio::close_sockets_() {
+  this->netconn_.close();
   if (this->rx_socket_ >= 0) {
     close(this->rx_socket_);
     this->rx_socket_ = -1;
@@ -346,65 +706,94 @@ void IntercomAudio::close_sockets_() {
   }
 }
 
+// Smoothed (1/16 EWMA) CPU cycles since start
+static void record_cycles(std::atomic<uint32_t> &avg_q4, uint32_t start) {
+  uint32_t cycles = arch_get_cpu_cycle_count() - start;
+  uint32_t avg = avg_q4.load(std::memory_order_relaxed);
+  avg += cycles - ((avg + 8) >> 4);
+  avg_q4.store(avg, std::memory_order_relaxed);
+}
+
 void IntercomAudio::on_microphone_data_(const uint8_t *data, size_t len) {
-  // Quick exit if not streaming
-  if (!this->streaming_.load(std::memory_order_acquire)) {
+  // Quick exit if not streaming (and no pre-roll to keep)
+  const bool streaming = this->streaming_.load(std::memory_order_acquire);
+  if (!streaming && !this->recorder_.is_always_on()) {
     return;
   }
   if (data == nullptr || len == 0) {
     return;
   }
 
-  // Capture session to detect stop/start during processing
+  // Capture session to detect stop/start during processing; a new session
+  // starts on a frame boundary (only this task touches the accumulator)
   const uint32_t captured_session = this->session_.load(std::memory_order_acquire);
+  if (captured_session != this->ingest_session_) {
+    this->mic_ingest_.reset();
+    this->ingest_session_ = captured_session;
+  }
 
-  const int16_t *mic_samples = nullptr;
-  size_t num_samples = 0;
-  size_t expected_16bit_size = FRAME_BYTES;
-
-  if (len == expected_16bit_size * 2) {
-    // 32-bit data, convert to 16-bit
-    num_samples = len / sizeof(int32_t);
-    if (num_samples > FRAME_SAMPLES) num_samples = FRAME_SAMPLES;
-
-    const int32_t *src = reinterpret_cast<const int32_t *>(data);
+  // Sample width comes from the stream, not from the chunk size (duplex frames are always 16-bit)
+#ifdef USE_MICROPHONE
+  if (this->microphone_ != nullptr) {
+    this->mic_ingest_.set_sample_bytes(this->microphone_->get_audio_stream_info().get_bits_per_sample() / 8);
+  }
+#endif
 
-    for (size_t i = 0; i < num_samples; i++) {
-      int32_t sample = src[i] >> 16;
+  this->mic_ingest_.push(data, len, esp_timer_get_time());
+  MicIngest::Frame frame;
+  while (this->mic_ingest_.pop(&frame)) {
+    this->on_mic_frame_(frame, streaming, captured_session);
+  }
+  this->mic_misaligned_.store(this->mic_ingest_.get_misaligned_bytes(), std::memory_order_relaxed);
+}
 
-      // IIR-based DC offset removal (matches ESPHome's approach)
-      // Uses shift operations for efficiency: ~1/8192 smoothing factor
-      if (this->dc_offset_removal_) {
-        this->dc_sum_ = ((this->dc_sum_ >> 13) - (this->dc_sum_ >> 17)) + sample;
-        sample -= static_cast<int32_t>(this->dc_sum_ >> 13);
+void IntercomAudio::on_mic_frame_(const MicIngest::Frame &frame, bool streaming, uint32_t session) {
+  const int16_t *mic_samples;
+  uint8_t width = this->mic_ingest_.get_sample_bytes();
+  if (width == 2) {
+    // Already 16-bit (from duplex or a 16-bit mic)
+    // NOTE: Don't apply mic_gain here - duplex already handles its own gain
+    mic_samples = reinterpret_cast<const int16_t *>(frame.data);
+  } else {
+    // 24/32-bit: DC removal and gain on the full-width sample, rounded to 16 bits once
+    uint32_t cycles = arch_get_cpu_cycle_count();
+    const int32_t *wide = reinterpret_cast<const int32_t *>(frame.data);
+    if (width == 3) {
+      for (size_t i = 0; i < FRAME_SAMPLES; i++) {
+        const uint8_t *p = frame.data + i * 3;
+        this->mic_wide_[i] = (int32_t) ((uint32_t) p[0] << 8 | (uint32_t) p[1] << 16 | (uint32_t) p[2] << 24);
       }
-
-      // Apply gain
-      sample *= this->mic_gain_;
-      if (sample > 32767) sample = 32767;
-      if (sample < -32768) sample = -32768;
-      this->mic_convert_buf_[i] = static_cast<int16_t>(sample);
+      wide = this->mic_wide_;
+    } else if (((uintptr_t) frame.data & 3) != 0) {
+      memcpy(this->mic_wide_, frame.data, FRAME_SAMPLES * sizeof(int32_t));
+      wide = this->mic_wide_;
     }
-    mic_samples = this->mic_convert_buf_.data();
-  } else {
-    // Already 16-bit (from duplex or other source)
-    // NOTE: Don't apply mic_gain here - duplex already handles its own gain
-    num_samples = len / sizeof(int16_t);
-    if (num_samples > FRAME_SAMPLES) num_samples = FRAME_SAMPLES;
-    mic_samples = reinterpret_cast<const int16_t *>(data);
+    this->mic_converter_.process(wide, this->mic_frame_, FRAME_SAMPLES);
+    record_cycles(this->convert_cycles_q4_, cycles);
+    mic_samples = this->mic_frame_;
+  }
+
+  // Between calls nothing plays, so there is no echo to cancel: this is the pre-roll
+  if (!streaming) {
+    this->tap_recorder_(mic_samples, FRAME_SAMPLES);
+    return;
   }
 
-  // Write to buffer under mutex - verify session hasn't changed
+  // Whole frames only, so the audio task always reads aligned frames
   if (this->mic_input_buffer_ != nullptr && this->mic_mutex_ != nullptr) {
     if (xSemaphoreTake(this->mic_mutex_, 1) == pdTRUE) {
       // Re-check atomics under lock
-      if (this->streaming_.load(std::memory_order_acquire) &&
-          this->session_.load(std::memory_order_acquire) == captured_session) {
-        size_t bytes = num_samples * sizeof(int16_t);
-        size_t written = this->mic_input_buffer_->write_without_replacement((void *)mic_samples, bytes, 0, true);
-        if (written < bytes) {
-          this->tx_drops_.fetch_add(1, std::memory_order_relaxed);
-        }
+      if (!this->streaming_.load(std::memory_order_acquire) ||
+          this->session_.load(std::memory_order_acquire) != session) {
+        // Captured for a session stop() already ended; it never reaches the next one
+        this->stale_mic_frames_.fetch_add(1, std::memory_order_relaxed);
+      } else if (this->mic_input_buffer_->free() < FRAME_BYTES || this->inject_fault_(Fault::MIC_OVERFLOW)) {
+        this->tx_drops_.fetch_add(1, std::memory_order_relaxed);
+      } else {
+        this->mic_input_buffer_->write_without_replacement((void *) mic_samples, FRAME_BYTES, 0, true);
+        this->capture_times_[this->capture_times_head_++ & this->capture_times_mask_] = (uint32_t) frame.capture_us;
+        this->count_copy_(FRAME_BYTES);
+        this->wake_task_();
       }
       xSemaphoreGive(this->mic_mutex_);
     } else {
@@ -413,32 +802,1049 @@ void IntercomAudio::on_microphone_data_(const uint8_t *data, size_t len) {
   }
 }
 
+// While streaming the task waits in select() on the eventfd; a notification
+// as well would stay pending and end its next idle wait at once
+void IntercomAudio::wake_task_() {
+  if (this->wake_fd_ >= 0) {
+    uint64_t one = 1;
+    write(this->wake_fd_, &one, sizeof(one));
+  } else if (this->audio_task_handle_) {
+    xTaskNotifyGive(this->audio_task_handle_);
+  }
+}
+
+void IntercomAudio::wait_for_events_(uint32_t timeout_ms) {
+  this->task_wakeups_.fetch_add(1, std::memory_order_relaxed);  // Every wait ends in one wakeup
+  if (this->wake_fd_ < 0) {
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(std::min<uint32_t>(timeout_ms, 5)));
+    return;
+  }
+
+  fd_set read_fds;
+  FD_ZERO(&read_fds);
+  FD_SET(this->wake_fd_, &read_fds);
+  int max_fd = this->wake_fd_;
+  int rx_socket = this->rx_socket_;
+  if (rx_socket >= 0) {
+    FD_SET(rx_socket, &read_fds);
+    max_fd = std::max(max_fd, rx_socket);
+  }
+
+  struct timeval timeout = {.tv_sec = (long) (timeout_ms / 1000), .tv_usec = (long) (timeout_ms % 1000) * 1000};
+  int ready = select(max_fd + 1, &read_fds, nullptr, nullptr, &timeout);
+  if (ready == 0) {
+    this->guard_wakeups_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  if (ready > 0 && rx_socket >= 0 && FD_ISSET(rx_socket, &read_fds)) {
+    this->socket_wakeups_.fetch_add(1, std::memory_order_relaxed);
+  }
+  if (ready > 0 && FD_ISSET(this->wake_fd_, &read_fds)) {
+    uint64_t count;
+    read(this->wake_fd_, &count, sizeof(count));  // Reset the counter
+  }
+}
+
 bool IntercomAudio::send_audio_(const uint8_t *data, size_t bytes) {
-  if (this->tx_socket_ < 0) {
+  if (this->tx_socket_ < 0 || this->inject_fault_(Fault::SEND_ERROR)) {
     return false;
   }
+  int64_t start = esp_timer_get_time();
   ssize_t sent = sendto(this->tx_socket_, data, bytes, 0,
                         (struct sockaddr *)&this->remote_addr_, sizeof(this->remote_addr_));
+  this->record_send_(start);
   if (sent > 0) {
+    this->count_copy_(sent);
     this->tx_packets_.fetch_add(1, std::memory_order_relaxed);
     return true;
   }
   return false;
 }
 
-size_t IntercomAudio::receive_audio_(int16_t *buffer, size_t max_samples) {
+void IntercomAudio::tap_recorder_(const int16_t *frame, size_t samples) {
+  if (!this->recorder_.is_allocated()) {
+    return;
+  }
+  uint32_t cycles = arch_get_cpu_cycle_count();
+  this->recorder_.write(frame, samples);
+  record_cycles(this->tap_cycles_q4_, cycles);
+}
+
+void IntercomAudio::trace_record_(TraceRecordHeader &header, const int16_t *samples) {
+  uint32_t cycles = arch_get_cpu_cycle_count();
+  header.time_us = (uint32_t) esp_timer_get_time();
+  header.mic_fill = (uint16_t) std::min<size_t>(this->mic_input_buffer_ ? this->mic_input_buffer_->available() : 0,
+                                                UINT16_MAX);
+  header.rx_fill = (uint16_t) std::min<size_t>(this->rx_available_(), UINT16_MAX);
+  header.ref_fill = (uint16_t) std::min<size_t>(
+      this->speaker_ref_buffer_ ? this->speaker_ref_buffer_->available() : 0, UINT16_MAX);
+  this->trace_.write(header, samples);
+  record_cycles(this->trace_cycles_q4_, cycles);
+}
+
+void IntercomAudio::trace_frame_(TraceKind kind, uint8_t flags, const int16_t *samples, size_t count) {
+  if (!this->trace_.is_enabled()) {
+    return;
+  }
+  TraceRecordHeader header{};
+  header.kind = (uint8_t) kind;
+  header.flags = flags;
+  header.samples = (uint16_t) count;
+  header.seq = kind == TraceKind::PLAY ? this->play_seq_
+               : kind == TraceKind::RX ? this->rx_seq_
+                                       : this->trace_seq_;
+  this->trace_record_(header, samples);
+}
+
+void IntercomAudio::trace_event_(TraceEvent event, uint32_t value) {
+  if (!this->trace_.is_enabled()) {
+    return;
+  }
+  TraceRecordHeader header{};
+  header.kind = (uint8_t) TraceKind::EVENT;
+  header.event = (uint16_t) event;
+  header.value = value;
+  header.seq = this->trace_seq_;
+  this->trace_record_(header, nullptr);
+}
+
+void IntercomAudio::record_send_(int64_t start_us) {
+  uint32_t us = (uint32_t) (esp_timer_get_time() - start_us);
+  this->send_cpu_us_.fetch_add(us, std::memory_order_relaxed);
+  this->send_histogram_.record(us);
+  uint32_t avg = this->send_latency_q4_us_.load(std::memory_order_relaxed);
+  avg += us - ((avg + 8) >> 4);
+  this->send_latency_q4_us_.store(avg, std::memory_order_relaxed);
+}
+
+int16_t *IntercomAudio::begin_tx_frame_(int16_t *scratch) {
+  if (this->transport_ == TransportType::NETCONN && this->tx_codec_ == PayloadCodec::PCM16) {
+    // First frame of a packet allocates the netbuf for all of them
+    uint8_t *packet = this->tx_pack_count_ > 0 ? this->netconn_.tx_payload()
+                                               : this->netconn_.begin_tx(this->tx_frames_ * FRAME_BYTES);
+    if (packet != nullptr) {
+      return reinterpret_cast<int16_t *>(packet + this->tx_pack_count_ * FRAME_BYTES);
+    }
+  }
+  return scratch;
+}
+
+void IntercomAudio::abort_tx_frame_() {
+  // A frame that never arrived: keep a partly packed netbuf for the next one
+  if (this->tx_pack_count_ == 0) {
+    this->netconn_.abort_tx();
+  }
+}
+
+void IntercomAudio::encode_g711_(const int16_t *frame, size_t samples, PayloadCodec codec, uint8_t *out) {
+  size_t narrow = samples / 2;
+  this->tx_resampler_.process(frame, samples, this->tx_narrow_buf_);
+  if (codec == PayloadCodec::G711_ALAW) {
+    for (size_t i = 0; i < narrow; i++) {
+      out[i] = g711::alaw_encode(this->tx_narrow_buf_[i]);
+    }
+  } else {
+    for (size_t i = 0; i < narrow; i++) {
+      out[i] = g711::ulaw_encode(this->tx_narrow_buf_[i]);
+    }
+  }
+}
+
+bool IntercomAudio::send_frame_(const int16_t *frame, size_t samples) {
+  if (this->transport_ == TransportType::SOCKET) {
+    return this->send_socket_frame_(frame, samples);
+  }
+
+  const size_t frame_bytes = frame_payload_bytes(this->tx_codec_);
+  uint8_t *packet = this->netconn_.tx_payload();
+  if (packet == nullptr) {
+    // begin_tx_frame_() fell back to scratch (netbuf pool exhausted) or G.711
+    packet = this->netconn_.begin_tx(this->tx_frames_ * frame_bytes);
+    if (packet == nullptr) {
+      this->tx_pack_count_ = 0;
+      this->tx_drops_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+  }
+  uint8_t *out = packet + this->tx_pack_count_ * frame_bytes;
+  if (this->tx_codec_ != PayloadCodec::PCM16) {
+    this->encode_g711_(frame, samples, this->tx_codec_, out);
+  } else if (reinterpret_cast<const uint8_t *>(frame) != out) {
+    memcpy(out, frame, frame_bytes);  // Copy once
+    this->count_copy_(frame_bytes);
+  }
+  if (++this->tx_pack_count_ < this->tx_frames_) {
+    return true;  // Packet not full yet
+  }
+  this->tx_pack_count_ = 0;
+
+  int64_t start = esp_timer_get_time();
+  bool ok = this->netconn_.send_tx();
+  this->record_send_(start);
+  if (!ok) {
+    return false;
+  }
+  this->tx_packets_.fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
+
+bool IntercomAudio::send_socket_frame_(const int16_t *frame, size_t samples) {
+  // Link level changes only take effect between packets
+  if (this->tx_pack_count_ == 0 && this->link_level_ != this->link_level_target_) {
+    this->apply_link_level_();
+  }
+
+  const PayloadCodec codec = this->tx_codec_active_;
+  const size_t pcm_bytes = samples * sizeof(int16_t);
+  if (codec == PayloadCodec::PCM16 && this->tx_frames_ == 1) {
+    // Straight from the frame buffer
+    return this->send_payload_(reinterpret_cast<const uint8_t *>(frame), pcm_bytes, codec);
+  }
+
+  uint8_t *out = this->tx_pack_buf_ + this->tx_pack_len_;
+  if (codec == PayloadCodec::PCM16) {
+    memcpy(out, frame, pcm_bytes);
+    this->count_copy_(pcm_bytes);
+    this->tx_pack_len_ += pcm_bytes;
+  } else {
+    this->encode_g711_(frame, samples, codec, out);
+    this->tx_pack_len_ += samples / 2;
+  }
+  if (++this->tx_pack_count_ < this->tx_frames_) {
+    return true;  // Packet not full yet
+  }
+
+  bool ok = this->send_payload_(this->tx_pack_buf_, this->tx_pack_len_, codec);
+  this->tx_pack_len_ = 0;
+  this->tx_pack_count_ = 0;
+  return ok;
+}
+
+bool IntercomAudio::describe_link_level_(uint8_t level, PayloadCodec *codec, uint8_t *frames) const {
+  // Pack more frames per packet first (fewer packets on air), then fall back to G.711.
+  // Level 0 is the configured packet size; nothing packs past one unfragmented datagram.
+  uint8_t max_frames = this->packet_frames_;
+  while (max_frames < this->max_packet_frames_ &&
+         (max_frames + 1) * frame_payload_bytes(this->tx_codec_) <= FRAMED_MAX_PAYLOAD) {
+    max_frames++;
+  }
+  uint8_t packing_levels = max_frames - this->packet_frames_ + 1;
+  if (level < packing_levels) {
+    *codec = this->tx_codec_;
+    *frames = this->packet_frames_ + level;
+    return true;
+  }
+  if (level == packing_levels && this->tx_codec_ == PayloadCodec::PCM16 &&
+      this->codec_fallback_ != PayloadCodec::PCM16 && this->tx_narrow_buf_ != nullptr &&
+      (this->peer_caps_ & wire::CAP_G711)) {
+    *codec = this->codec_fallback_;
+    *frames = this->max_packet_frames_;
+    return true;
+  }
+  return false;
+}
+
+void IntercomAudio::apply_link_level_() {
+  PayloadCodec codec;
+  uint8_t frames;
+  if (!this->describe_link_level_(this->link_level_target_, &codec, &frames)) {
+    this->link_level_target_ = 0;
+    this->describe_link_level_(0, &codec, &frames);
+  }
+  if (codec != this->tx_codec_active_) {
+    this->tx_resampler_.reset();
+    this->fec_tx_.set_redundant_ulaw(codec == PayloadCodec::PCM16);
+  }
+  if (this->link_level_target_ != this->link_level_) {
+    ESP_LOGD(TAG, "Link level %u: %s, %u frame(s) per packet", this->link_level_target_, codec_to_str(codec), frames);
+  }
+  this->link_level_ = this->link_level_target_;
+  this->tx_codec_active_ = codec;
+  this->tx_frames_ = frames;
+  this->link_codec_.store((uint8_t) codec, std::memory_order_relaxed);
+  this->link_frames_.store(frames, std::memory_order_relaxed);
+}
+
+std::string IntercomAudio::get_link_state() const {
+  if (!this->streaming_.load(std::memory_order_relaxed)) {
+    return "idle";
+  }
+  if (this->peer_lost_.load(std::memory_order_relaxed)) {
+    return "peer lost";
+  }
+  if (!this->link_framed_.load(std::memory_order_relaxed)) {
+    return "raw";
+  }
+  const char *codec;
+  switch ((PayloadCodec) this->link_codec_.load(std::memory_order_relaxed)) {
+    case PayloadCodec::G711_ALAW:
+      codec = "alaw";
+      break;
+    case PayloadCodec::G711_ULAW:
+      codec = "ulaw";
+      break;
+    default:
+      codec = "pcm";
+      break;
+  }
+  const char *fec = "";
+  if (this->link_fec_.load(std::memory_order_relaxed)) {
+    fec = this->fec_mode_ == FecMode::XOR ? " +xor" : " +red";
+  }
+  char buf[24];
+  snprintf(buf, sizeof(buf), "%s x%u%s", codec, this->link_frames_.load(std::memory_order_relaxed), fec);
+  return buf;
+}
+
+LatencyBreakdown IntercomAudio::get_latency_breakdown() const {
+  LatencyBreakdown latency{};
+  const float frame_ms = FRAME_SAMPLES * 1000.0f / SAMPLE_RATE;
+  const float bytes_to_ms = 1000.0f / (SAMPLE_RATE * sizeof(int16_t));
+  latency.capture_ms = this->get_capture_latency_us() / 1000.0f;
+  uint8_t frames = this->link_framed_.load(std::memory_order_relaxed) ? this->link_frames_.load(std::memory_order_relaxed)
+                                                                       : this->packet_frames_;
+  latency.packetization_ms = (frames - 1) * frame_ms;
+  latency.network_ms = this->get_rtt_ms() / 2.0f;
+  latency.jitter_buffer_ms = this->rx_fill_.load(std::memory_order_relaxed) * bytes_to_ms;
+#ifdef USE_I2S_AUDIO_DUPLEX
+  if (this->duplex_ != nullptr) {
+    latency.speaker_buffer_ms = this->duplex_->get_speaker_buffered() * bytes_to_ms;
+    latency.playback_dma_ms = this->duplex_->get_playback_dma_us() / 1000.0f;
+  }
+#endif
+  return latency;
+}
+
+void IntercomAudio::collect_task_metrics_(MetricsSnapshot &m) const {
+  m.counter("intercom_tx_packets_total", "Audio packets sent", this->get_tx_packets());
+  m.counter("intercom_rx_packets_total", "Audio packets received", this->get_rx_packets());
+  m.counter("intercom_rx_drops_total", "Received audio dropped (jitter buffer full, undecodable)",
+            this->rx_drops_.load(std::memory_order_relaxed));
+  m.gauge("intercom_jitter_buffer_bytes", "Audio waiting in the jitter buffer", this->get_buffer_fill());
+  m.counter("intercom_fec_recovered_total", "Frames recovered by FEC", this->get_fec_recovered());
+  m.counter("intercom_fec_lost_total", "Frames lost after FEC", this->get_fec_lost());
+  m.counter("intercom_fec_overhead_bytes_total", "Headers, redundancy and parity sent",
+            this->get_fec_overhead_bytes());
+  m.counter("intercom_fec_cpu_seconds_total", "Time spent in FEC", this->get_fec_cpu_us() / 1e6);
+  m.counter("intercom_send_cpu_seconds_total", "Time spent in UDP send calls", this->get_send_cpu_us() / 1e6);
+  m.counter("intercom_crypto_rejected_total", "Packets dropped by authentication or replay checks",
+            this->get_crypto_rejected());
+  m.counter("intercom_playout_deferred_total", "Passes that left audio queued for a full speaker",
+            this->get_playout_deferred());
+  m.gauge("intercom_packet_loss_ratio", "Received loss before FEC, last report interval",
+          this->get_packet_loss() / 100.0);
+  m.gauge("intercom_peer_packet_loss_ratio", "Loss the peer reports for our stream", this->get_peer_loss() / 100.0);
+  m.gauge("intercom_jitter_seconds", "Interarrival jitter of received audio", this->get_jitter_ms() / 1e3);
+  m.gauge("intercom_peer_jitter_seconds", "Jitter the peer reports for our stream", this->get_peer_jitter_ms() / 1e3);
+  m.gauge("intercom_peer_buffer_seconds", "Peer jitter buffer depth", this->get_peer_buffer_ms() / 1e3);
+  m.gauge("intercom_call_mos", "E-model MOS of the latest window of the call", this->get_call_mos());
+  m.gauge("intercom_call_r_factor", "E-model R of the latest window of the call", this->get_call_r_factor());
+  m.gauge("intercom_last_call_mos_average", "Average window MOS of the last rated call",
+          this->get_last_call_mos_average());
+  m.gauge("intercom_last_call_mos_worst", "Worst window MOS of the last rated call", this->get_last_call_mos_worst());
+  m.counter("intercom_calls_rated_total", "Calls given an E-model rating", this->get_calls_rated());
+  m.histogram("intercom_send_call_seconds", "Time per UDP send call", this->send_histogram_);
+  m.histogram("intercom_capture_to_send_seconds", "First sample of a frame captured until sent",
+              this->capture_histogram_);
+  m.histogram("intercom_task_blocked_seconds", "Audio task pass spent in speaker writes and buffer locks",
+              this->blocked_histogram_);
+  m.histogram("intercom_interarrival_deviation_seconds", "Arrival spacing of received audio against its duration",
+              this->transit_histogram_);
+  m.histogram("intercom_rtt_seconds", "Round-trip time from receiver reports", this->rtt_histogram_);
+}
+
+void IntercomAudio::collect_metrics(MetricsSnapshot &m) const {
+  // Counters are reset by start() and reset_counters(), which a scraper reads as a counter reset
+  m.gauge("intercom_streaming", "1 while a call is streaming", this->is_streaming() ? 1 : 0);
+  m.gauge("intercom_peer_lost", "1 while the peer has gone silent past the keepalive timeout",
+          this->is_peer_lost() ? 1 : 0);
+  // Packets against send time, drops against receives: taken again while a
+  // pass overlaps the copy. A task that never pauses keeps the last copy.
+  MetricsSnapshot::Mark mark = m.mark();
+  bool consistent = false;
+  for (int attempt = 0; attempt < METRICS_COPY_TRIES && !consistent; attempt++) {
+    if (attempt > 0) {
+      m.rewind(mark);
+      vTaskDelay(1);
+    }
+    uint32_t seq = this->pass_seq_.read_begin();
+    this->collect_task_metrics_(m);
+    consistent = this->pass_seq_.read_end(seq);
+  }
+  m.gauge("intercom_metrics_consistent", "1 if the audio task values were copied between two of its passes",
+          consistent ? 1 : 0);
+  // Also written by the mic callback, so read on their own
+  m.counter("intercom_tx_drops_total", "Mic frames dropped before sending",
+            this->tx_drops_.load(std::memory_order_relaxed));
+  m.counter("intercom_payload_copies_total", "Audio payload copies in both directions", this->get_copies());
+  m.counter("intercom_payload_copy_bytes_total", "Bytes moved by those copies", this->get_bytes_moved());
+  m.counter("intercom_mic_misaligned_bytes_total", "Mic bytes dropped to stay on sample boundaries",
+            this->get_mic_misaligned_bytes());
+  m.counter("intercom_task_wakeups_total", "Audio task wakeups", this->get_task_wakeups());
+  m.counter("intercom_task_guard_wakeups_total", "Audio task wakeups with nothing to do (guard timeout)",
+            this->get_guard_wakeups());
+  m.counter("intercom_task_socket_wakeups_total", "Audio task wakeups for a waiting datagram",
+            this->get_socket_wakeups());
+  m.gauge("intercom_mouth_to_ear_seconds", "Estimated mouth-to-ear latency of what we play",
+          this->get_latency_breakdown().total_ms() / 1e3);
+  m.counter("intercom_starts_total", "Calls started since boot", this->starts_.load(std::memory_order_relaxed));
+  m.counter("intercom_stale_mic_frames_total", "Mic frames captured for a session that had already ended",
+            this->stale_mic_frames_.load(std::memory_order_relaxed));
+  m.gauge("intercom_heap_free_bytes", "Internal heap free now", heap_caps_get_free_size(MALLOC_CAP_INTERNAL));
+  m.gauge("intercom_heap_after_stop_bytes", "Internal heap free when the last stop finished",
+          this->heap_after_stop_.load(std::memory_order_relaxed));
+  m.histogram("intercom_stop_seconds", "Time stop() takes to end a call", this->stop_histogram_);
+  m.counter("intercom_stop_ack_timeouts_total", "Stops that gave up waiting for the audio task to go idle",
+            this->stop_ack_timeouts_.load(std::memory_order_relaxed));
+#ifdef USE_INTERCOM_FAULT_INJECTION
+  m.counter("intercom_injected_send_errors_total", "Sends failed on purpose",
+            this->faults_.get_injected(Fault::SEND_ERROR));
+  m.counter("intercom_injected_receive_losses_total", "Received datagrams dropped on purpose",
+            this->faults_.get_injected(Fault::RECEIVE_LOSS));
+  m.counter("intercom_injected_speaker_stalls_total", "Speaker writes refused on purpose",
+            this->faults_.get_injected(Fault::SPEAKER_STALL));
+  m.counter("intercom_injected_mic_overflows_total", "Mic frames dropped on purpose",
+            this->faults_.get_injected(Fault::MIC_OVERFLOW));
+  m.counter("intercom_injected_i2s_read_timeouts_total", "Duplex I2S reads timed out on purpose",
+            this->faults_.get_injected(Fault::I2S_READ_TIMEOUT));
+  m.counter("intercom_injected_i2s_write_timeouts_total", "Duplex I2S writes timed out on purpose",
+            this->faults_.get_injected(Fault::I2S_WRITE_TIMEOUT));
+#endif
+
+#ifdef USE_ESP_AEC
+  esp_aec::EspAec *aec = this->aec_;
+#endif
+#ifdef USE_I2S_AUDIO_DUPLEX
+  if (this->duplex_ != nullptr) {
+    i2s_audio_duplex::I2SAudioDuplex *duplex = this->duplex_;
+    m.gauge("i2s_audio_duplex_running", "1 while the I2S duplex is running", duplex->is_running() ? 1 : 0);
+    m.gauge("i2s_audio_duplex_speaker_buffered_bytes", "Audio waiting in the speaker buffer",
+            duplex->get_speaker_buffered());
+    m.gauge("i2s_audio_duplex_playback_dma_seconds", "Audio queued in the playback DMA ring",
+            duplex->get_playback_dma_us() / 1e6);
+    m.counter("i2s_audio_duplex_frames_published_total", "Mic frames published on the frame bus",
+              duplex->get_frame_bus().get_published());
+    m.counter("i2s_audio_duplex_frame_overruns_total", "Mic frames not published: every slot still referenced",
+              duplex->get_frame_bus().get_overruns());
+    m.counter("i2s_audio_duplex_read_timeouts_total", "I2S reads that timed out", duplex->get_read_timeouts());
+    m.counter("i2s_audio_duplex_write_timeouts_total", "I2S writes that timed out", duplex->get_write_timeouts());
+    m.gauge("i2s_audio_duplex_loopback_latency_seconds", "Calibrated speaker write to mic read",
+            duplex->get_loopback_latency_ms() / 1e3);
+    m.gauge("i2s_audio_duplex_echo_path_gain_db", "Calibrated echo level against the speaker reference",
+            duplex->get_echo_path_gain_db());
+    m.gauge("i2s_audio_duplex_prompt_start_latency_seconds", "Last prompt trigger until its first sample",
+            duplex->get_prompt_start_latency_us() / 1e6);
+    m.gauge("i2s_audio_duplex_channel_cycles", "CPU cycles per frame for each captured slot beyond the first",
+            duplex->get_channel_cycles());
+    m.gauge("i2s_audio_duplex_wide_capture_cycles", "CPU cycles per frame narrowing 32-bit capture",
+            duplex->get_wide_capture_cycles());
+#ifdef USE_ESP_AEC
+    if (aec == nullptr) {
+      aec = duplex->get_aec();  // AEC configured on the duplex
+    }
+#endif
+  }
+#endif
+#ifdef USE_ESP_AEC
+  if (aec != nullptr) {
+    m.gauge("esp_aec_initialized", "1 once the canceller is created", aec->is_initialized() ? 1 : 0);
+    m.counter("esp_aec_chunks_total", "Chunks run through the canceller", aec->get_chunks_processed());
+    m.counter("esp_aec_process_seconds_total", "Time spent in the canceller", aec->get_process_us() / 1e6);
+  }
+#endif
+#ifdef USE_MDNS_DISCOVERY
+  if (this->discovery_ != nullptr) {
+    mdns_discovery::MdnsDiscovery *discovery = this->discovery_;
+    m.gauge("mdns_discovery_peers", "Peers currently known", discovery->get_known_peers());
+    m.counter("mdns_discovery_scans_total", "mDNS scans run", discovery->get_scans());
+    m.counter("mdns_discovery_scan_failures_total", "mDNS queries that failed", discovery->get_scan_failures());
+    m.counter("mdns_discovery_peers_found_total", "New peers found", discovery->get_peers_found());
+    m.counter("mdns_discovery_peers_lost_total", "Peers dropped after the peer timeout", discovery->get_peers_lost());
+    m.gauge("mdns_discovery_last_scan_seconds", "Duration of the last scan", discovery->get_last_scan_ms() / 1e3);
+  }
+#endif
+}
+
+std::string IntercomAudio::get_latency_summary() const {
+  LatencyBreakdown latency = this->get_latency_breakdown();
+  char net[8] = "?";
+  if (!std::isnan(latency.network_ms)) {
+    snprintf(net, sizeof(net), "%.0f", latency.network_ms);
+  }
+  char buf[96];
+  snprintf(buf, sizeof(buf), "cap %.0f + pkt %.0f + net %s + jb %.0f + spk %.0f + dma %.0f = %.0f ms",
+           latency.capture_ms, latency.packetization_ms, net, latency.jitter_buffer_ms, latency.speaker_buffer_ms,
+           latency.playback_dma_ms, latency.total_ms());
+  return buf;
+}
+
+size_t IntercomAudio::rx_available_() const {
+  if (this->transport_ == TransportType::NETCONN) {
+    return this->netconn_.queued_bytes();
+  }
+  return this->rx_buffer_->available();
+}
+
+size_t IntercomAudio::sink_space_() const {
+#ifdef USE_I2S_AUDIO_DUPLEX
+  if (this->duplex_ != nullptr) {
+    return this->duplex_->get_speaker_free();
+  }
+#endif
+  // The speaker interface has no space query; play_() takes what it can and
+  // the caller keeps the rest
+  return SIZE_MAX;
+}
+
+size_t IntercomAudio::play_(const uint8_t *data, size_t len) {
+  size_t played = len;
+
+  // Send to speaker (skip if volume is 0 to reduce crosstalk). Never waits:
+  // whatever the sink cannot take stays with the caller.
+  int64_t start = esp_timer_get_time();
+#ifdef USE_I2S_AUDIO_DUPLEX
+  if (this->duplex_ != nullptr) {
+    played = this->duplex_->play(data, len, 0);
+    this->count_copy_(played);
+  }
+#endif
+#ifdef USE_SPEAKER
+#ifdef USE_I2S_AUDIO_DUPLEX
+  else
+#endif
+  if (this->speaker_ != nullptr && this->speaker_->get_volume() > 0.001f) {
+    played = this->speaker_->play(data, len, 0);
+    this->count_copy_(played);
+  }
+#endif
+
+  if (this->trace_.is_enabled()) {
+    this->trace_frame_(TraceKind::PLAY, played < len ? 1 : 0, reinterpret_cast<const int16_t *>(data),
+                       played / sizeof(int16_t));
+    this->play_seq_++;
+  }
+
+  // Store speaker ref for AEC
+  if (played > 0 && this->speaker_ref_buffer_ != nullptr && this->ref_mutex_ != nullptr) {
+    if (xSemaphoreTake(this->ref_mutex_, pdMS_TO_TICKS(1)) == pdTRUE) {
+      this->speaker_ref_buffer_->write_without_replacement((void *) data, played, 0, true);
+      xSemaphoreGive(this->ref_mutex_);
+      this->count_copy_(played);
+    }
+  }
+  this->blocked_us_ += (uint32_t) (esp_timer_get_time() - start);
+  return played;
+}
+
+bool IntercomAudio::receive_packet_() {
   if (this->rx_socket_ < 0) {
-    return 0;
+    return false;
   }
   struct sockaddr_in sender_addr;
   socklen_t sender_len = sizeof(sender_addr);
-  ssize_t received = recvfrom(this->rx_socket_, buffer, max_samples * sizeof(int16_t), 0,
+  ssize_t received = recvfrom(this->rx_socket_, this->rx_packet_, RX_PACKET_BYTES, 0,
                               (struct sockaddr *)&sender_addr, &sender_len);
-  if (received > 0) {
+  if (received <= 0) {
+    return false;
+  }
+  this->count_copy_(received);
+  if (this->inject_fault_(Fault::RECEIVE_LOSS)) {
+    return true;  // Gone as if lost on the way
+  }
+
+  wire::PacketHeader header;
+  if (!this->framing_enabled_() || !wire::parse_header(this->rx_packet_, received, &header)) {
+    if (this->crypto_.is_enabled()) {
+      this->crypto_rejected_.fetch_add(1, std::memory_order_relaxed);  // Plaintext is never played
+      return true;
+    }
+    this->rx_packets_.fetch_add(1, std::memory_order_relaxed);
+    this->deliver_payload_(this->rx_packet_, received, this->rx_codec_, false);
+    return true;
+  }
+
+  uint8_t *body = this->rx_packet_ + wire::HEADER_SIZE;
+  size_t body_len = received - wire::HEADER_SIZE;
+  if (this->crypto_.is_enabled() && header.type != wire::PacketType::HELLO) {
+    // Authenticate and decrypt in place; the tag trails the body
+    uint32_t cycles = arch_get_cpu_cycle_count();
+    bool opened = body_len >= StreamCrypto::TAG_SIZE && header.length <= body_len - StreamCrypto::TAG_SIZE &&
+                  this->crypto_.open(this->rx_packet_, header, body, body_len);
+    record_cycles(this->open_cycles_q4_, cycles);
+    if (!opened) {
+      this->crypto_rejected_.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+    body_len -= StreamCrypto::TAG_SIZE;
+    this->last_auth_ms_ = millis();
+    this->peer_heard_us_ = true;  // Sealed with keys that include our nonce
+  }
+  if (header.type != wire::PacketType::HELLO) {
+    this->last_peer_rx_ms_ = millis();  // A HELLO counts once handle_control_ accepts it
+  }
+  if (header.type != wire::PacketType::AUDIO && header.type != wire::PacketType::PARITY) {
+    this->handle_control_(header, body, body_len);
+    return true;
+  }
+
+  // Time spent in the reorder window and recovery, not in decoding/jitter buffer writes
+  int64_t start = esp_timer_get_time();
+  int64_t delivery_us = 0;
+  auto sink = [this, &delivery_us](const uint8_t *data, size_t len, uint8_t flags, bool redundant) {
+    int64_t t = esp_timer_get_time();
+    this->deliver_payload_(data, len, (PayloadCodec) wire::flags_codec(flags), redundant);
+    delivery_us += esp_timer_get_time() - t;
+  };
+  if (header.type == wire::PacketType::AUDIO) {
     this->rx_packets_.fetch_add(1, std::memory_order_relaxed);
-    return received / sizeof(int16_t);
+    this->peer_framed_ = true;
+    this->peer_heard_us_ = true;  // Framed audio only follows our HELLO
+    this->link_framed_.store(true, std::memory_order_relaxed);
+    this->update_jitter_(header.seq, header.length, (PayloadCodec) wire::flags_codec(header.flags));
+    this->fec_rx_.on_audio(header, body, body_len, sink);
+  } else {
+    this->fec_rx_.on_parity(header, body, body_len, sink);
+  }
+  this->fec_cpu_us_.fetch_add((uint32_t) (esp_timer_get_time() - start - delivery_us), std::memory_order_relaxed);
+  return true;
+}
+
+void IntercomAudio::deliver_payload_(const uint8_t *payload, size_t len, PayloadCodec codec, bool redundant) {
+  if (codec != PayloadCodec::PCM16 && (this->rx_narrow_buf_ == nullptr || codec > PayloadCodec::G711_ULAW)) {
+    this->rx_drops_.fetch_add(1, std::memory_order_relaxed);  // Not a codec this build can decode
+    return;
+  }
+  const uint8_t *pcm = reinterpret_cast<const uint8_t *>(this->rx_frame_);
+  size_t bytes;
+  if (redundant && codec == PayloadCodec::PCM16) {
+    // RED copy of a PCM stream: device-rate mu-law
+    size_t samples = std::min(len, RX_MAX_SAMPLES);
+    for (size_t i = 0; i < samples; i++) {
+      this->rx_frame_[i] = g711::ULAW_DECODE_TABLE[payload[i]];
+    }
+    bytes = samples * sizeof(int16_t);
+  } else if (codec != PayloadCodec::PCM16) {
+    // One byte per 8 kHz sample, each expands to two device-rate samples
+    size_t narrow = std::min(len, RX_MAX_NARROW_SAMPLES);
+    const int16_t *table = codec == PayloadCodec::G711_ALAW ? g711::ALAW_DECODE_TABLE : g711::ULAW_DECODE_TABLE;
+    for (size_t i = 0; i < narrow; i++) {
+      this->rx_narrow_buf_[i] = table[payload[i]];
+    }
+    this->rx_resampler_.process(this->rx_narrow_buf_, narrow, this->rx_frame_);
+    bytes = narrow * 2 * sizeof(int16_t);
+  } else {
+    pcm = payload;
+    bytes = std::min(len, RX_MAX_BYTES) & ~(size_t) 1;
+  }
+
+  size_t written = this->rx_buffer_->write((void *) pcm, bytes);
+  this->count_copy_(written);
+  if (written < bytes) {
+    this->rx_drops_.fetch_add(1, std::memory_order_relaxed);
+  }
+  // Arrivals for the replay, a frame per record
+  if (this->trace_.is_enabled()) {
+    const int16_t *samples = reinterpret_cast<const int16_t *>(pcm);
+    for (size_t at = 0; at < bytes / sizeof(int16_t); at += FRAME_SAMPLES) {
+      this->trace_frame_(TraceKind::RX, written < bytes ? TRACE_RX_DROPPED : 0, samples + at,
+                         std::min(bytes / sizeof(int16_t) - at, FRAME_SAMPLES));
+      this->rx_seq_++;
+    }
+  }
+}
+
+bool IntercomAudio::send_framed_(const wire::PacketHeader &header, const uint8_t *body, size_t len,
+                                 const uint8_t *extra, size_t extra_len) {
+  if (this->tx_socket_ < 0 || this->inject_fault_(Fault::SEND_ERROR)) {
+    return false;
+  }
+  uint8_t head[wire::HEADER_SIZE];
+  wire::write_header(header, head);
+  struct iovec iov[3] = {
+      {.iov_base = head, .iov_len = sizeof(head)},
+      {.iov_base = (void *) body, .iov_len = len},
+      {.iov_base = (void *) extra, .iov_len = extra_len},
+  };
+  struct msghdr msg = {};
+  msg.msg_name = &this->remote_addr_;
+  msg.msg_namelen = sizeof(this->remote_addr_);
+  msg.msg_iov = iov;
+  msg.msg_iovlen = extra_len > 0 ? 3 : 2;
+
+  if (this->crypto_.is_enabled() && header.type != wire::PacketType::HELLO) {
+    // Seal a copy of the whole datagram: header (authenticated only), body, extra, tag
+    size_t body_len = len + extra_len;
+    if (wire::HEADER_SIZE + body_len + StreamCrypto::TAG_SIZE > MAX_DATAGRAM_BYTES) {
+      return false;
+    }
+    uint8_t *packet = this->tx_crypt_buf_;
+    memcpy(packet, head, wire::HEADER_SIZE);
+    if (len > 0) {
+      memcpy(packet + wire::HEADER_SIZE, body, len);
+    }
+    if (extra_len > 0) {
+      memcpy(packet + wire::HEADER_SIZE + len, extra, extra_len);
+    }
+    this->count_copy_(body_len);
+    uint32_t cycles = arch_get_cpu_cycle_count();
+    bool sealed = this->crypto_.seal(packet, header, packet + wire::HEADER_SIZE, body_len);
+    record_cycles(this->seal_cycles_q4_, cycles);
+    if (!sealed) {
+      return false;
+    }
+    iov[0].iov_base = packet;
+    iov[0].iov_len = wire::HEADER_SIZE + body_len + StreamCrypto::TAG_SIZE;
+    msg.msg_iovlen = 1;
   }
-  return 0;
+  int64_t start = esp_timer_get_time();
+  ssize_t sent = sendmsg(this->tx_socket_, &msg, 0);
+  this->record_send_(start);
+  if (sent <= 0) {
+    return false;
+  }
+  this->count_copy_(sent);
+  this->last_tx_ms_ = millis();
+  return true;
+}
+
+bool IntercomAudio::send_payload_(const uint8_t *payload, size_t len, PayloadCodec codec) {
+  // Encrypted sessions send nothing until the peer holds our nonce (never in the clear)
+  if (this->crypto_.is_enabled() && !this->peer_heard_us_) {
+    return false;
+  }
+  // Raw payload until the peer has shown it parses framed packets
+  if (!this->framing_enabled_() || !this->peer_framed_) {
+    return this->send_audio_(payload, len);
+  }
+
+  int64_t start = esp_timer_get_time();
+  wire::PacketHeader header;
+  const uint8_t *red;
+  size_t red_len;
+  this->fec_tx_.prepare(len, &header, &red, &red_len);
+  size_t tag_len = this->crypto_.is_enabled() ? StreamCrypto::TAG_SIZE : 0;
+  if (wire::HEADER_SIZE + len + red_len + tag_len > MAX_DATAGRAM_BYTES) {
+    header.flags &= ~wire::FLAG_RED;  // Would fragment: this packet goes without its copy
+    red = nullptr;
+    red_len = 0;
+  }
+  header.flags |= wire::codec_flags((uint8_t) codec);
+  int64_t cpu_us = esp_timer_get_time() - start;
+
+  bool ok = this->send_framed_(header, payload, len, red, red_len);
+  if (ok) {
+    this->tx_packets_.fetch_add(1, std::memory_order_relaxed);
+    this->fec_overhead_bytes_.fetch_add(wire::HEADER_SIZE + red_len + tag_len, std::memory_order_relaxed);
+  }
+
+  start = esp_timer_get_time();
+  this->fec_tx_.commit(payload, len);
+  const uint8_t *parity;
+  size_t parity_len;
+  bool have_parity = this->fec_tx_.take_parity(&header, &parity, &parity_len);
+  header.flags |= wire::codec_flags((uint8_t) codec);
+  cpu_us += esp_timer_get_time() - start;
+  this->fec_cpu_us_.fetch_add((uint32_t) cpu_us, std::memory_order_relaxed);
+
+  if (have_parity && this->send_framed_(header, parity, parity_len, nullptr, 0)) {
+    this->fec_overhead_bytes_.fetch_add(wire::HEADER_SIZE + parity_len + tag_len, std::memory_order_relaxed);
+  }
+  return ok;
+}
+
+void IntercomAudio::send_hello_(bool ack) {
+  wire::PacketHeader header;
+  header.type = wire::PacketType::HELLO;
+  header.flags = ack ? wire::FLAG_ACK : 0;
+  header.aux = wire::CAP_XOR | wire::CAP_RED | wire::CAP_KEEPALIVE;  // Always built in
+  if (this->rx_narrow_buf_ != nullptr) {
+    header.aux |= wire::CAP_G711;
+  }
+  if (!this->crypto_.is_enabled()) {
+    this->send_framed_(header, nullptr, 0, nullptr, 0);
+    return;
+  }
+  // Readable but authenticated: our nonce, the peer's as we know it, tag over both and the header
+  header.aux |= wire::CAP_AEAD;
+  header.length = StreamCrypto::HELLO_BODY_SIZE;
+  uint8_t head[wire::HEADER_SIZE];
+  wire::write_header(header, head);
+  uint8_t body[StreamCrypto::HELLO_BODY_SIZE];
+  this->crypto_.write_hello(head, body);
+  this->send_framed_(header, body, sizeof(body), nullptr, 0);
+}
+
+bool IntercomAudio::accept_hello_(const uint8_t *packet, const uint8_t *body, size_t len, bool *heard) {
+  const uint8_t *nonce;
+  bool echo_ok;
+  if (!this->crypto_.verify_hello(packet, body, len, &nonce, &echo_ok)) {
+    this->crypto_rejected_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  if (!this->crypto_.is_peer_nonce(nonce)) {
+    if (this->crypto_.is_keyed() && !echo_ok && millis() - this->last_auth_ms_ < REKEY_QUIET_MS) {
+      return false;  // Live session: an old HELLO replayed, or the peer will echo us soon
+    }
+    if (!this->crypto_.key_session(nonce)) {
+      ESP_LOGE(TAG, "Failed to derive session keys");
+      return false;
+    }
+    ESP_LOGD(TAG, "Session keys derived");
+    this->peer_heard_us_ = false;  // Tell the peer our nonce again
+    this->last_auth_ms_ = millis();
+  }
+  *heard = echo_ok;
+  return true;
+}
+
+void IntercomAudio::handle_control_(const wire::PacketHeader &header, const uint8_t *body, size_t len) {
+  if (header.type == wire::PacketType::HELLO) {
+    bool heard = (header.flags & wire::FLAG_ACK) != 0;
+    // With encryption the peer has heard us once it echoes our nonce; the
+    // header is authenticated too and sits right before the body
+    if (this->crypto_.is_enabled() && !this->accept_hello_(body - wire::HEADER_SIZE, body, len, &heard)) {
+      return;
+    }
+    if (!this->peer_framed_) {
+      ESP_LOGI(TAG, "Peer supports framed packets, FEC %s", fec_mode_to_str(this->fec_mode_));
+    }
+    this->peer_framed_ = true;
+    this->peer_caps_ = header.aux;
+    this->last_peer_rx_ms_ = millis();
+    this->link_framed_.store(true, std::memory_order_relaxed);
+    if (heard) {
+      this->peer_heard_us_ = true;
+    } else {
+      this->send_hello_(true);  // Answer so the peer can switch to framed packets too
+    }
+    return;
+  }
+
+  wire::Report report;
+  if (header.type == wire::PacketType::REPORT && wire::parse_report(body, len, &report)) {
+    this->handle_report_(report);
+  }
+}
+
+void IntercomAudio::handle_report_(const wire::Report &report) {
+  uint32_t now = millis();
+  this->peer_report_ts_ = report.timestamp;
+  this->peer_report_rx_ms_ = now;
+  this->peer_loss_permille_.store(report.loss_permille, std::memory_order_relaxed);
+  this->peer_jitter_100us_.store(report.jitter_100us, std::memory_order_relaxed);
+  this->peer_depth_ms_.store(report.depth_ms, std::memory_order_relaxed);
+
+  // RTT like RTCP: our timestamp came back, minus the time the peer held it
+  uint32_t rtt = RTT_UNKNOWN;
+  if (report.echo_timestamp != 0) {
+    uint32_t elapsed = now - report.echo_timestamp;
+    if (elapsed >= report.echo_delay_ms && elapsed - report.echo_delay_ms < 60000) {
+      rtt = elapsed - report.echo_delay_ms;
+      this->rtt_histogram_.record(rtt * 1000);
+      this->rtt_min_ms_ = std::min(this->rtt_min_ms_, rtt);
+      this->rtt_ms_.store(rtt, std::memory_order_relaxed);
+    }
+  }
+
+  // Redundancy follows the loss the peer measures, with hysteresis
+  if (this->fec_mode_ != FecMode::NONE) {
+    uint16_t loss = report.loss_permille;
+    uint8_t cap = this->fec_mode_ == FecMode::XOR ? wire::CAP_XOR : wire::CAP_RED;
+    bool active = this->fec_tx_.is_active();
+    if ((this->peer_caps_ & cap) == 0) {
+      active = false;
+    } else if (loss >= this->fec_loss_threshold_permille_) {
+      active = true;
+    } else if (loss < this->fec_loss_threshold_permille_ / 2) {
+      active = false;
+    }
+    if (active != this->fec_tx_.is_active()) {
+      ESP_LOGD(TAG, "Peer loss %.1f%%: FEC %s", loss / 10.0f, active ? "on" : "off");
+      this->fec_tx_.set_active(active);
+      this->link_fec_.store(active, std::memory_order_relaxed);
+    }
+  }
+
+  if (!this->adaptive_) {
+    return;
+  }
+  // Loss or a standing queue (RTT well above the best seen) means the link is
+  // congested: step to fewer/smaller packets. Step back after a clean stretch.
+  bool queueing = rtt != RTT_UNKNOWN && rtt > this->rtt_min_ms_ + QUEUE_DELAY_MS;
+  PayloadCodec codec;
+  uint8_t frames;
+  if (report.loss_permille >= CONGESTED_LOSS_PERMILLE || queueing) {
+    this->clear_reports_ = 0;
+    if (this->describe_link_level_(this->link_level_target_ + 1, &codec, &frames)) {
+      this->link_level_target_++;
+    }
+  } else if (report.loss_permille < CLEAR_LOSS_PERMILLE) {
+    if (++this->clear_reports_ >= CLEAR_REPORTS_TO_STEP_UP && this->link_level_target_ > 0) {
+      this->link_level_target_--;
+      this->clear_reports_ = 0;
+    }
+  } else {
+    this->clear_reports_ = 0;
+  }
+}
+
+void IntercomAudio::update_jitter_(uint16_t seq, size_t len, PayloadCodec codec) {
+  // RFC 3550 interarrival jitter over consecutive packets: arrival spacing
+  // against the audio duration the previous packet carried
+  int64_t now = esp_timer_get_time();
+  if (this->have_last_rx_ && seq == (uint16_t) (this->last_rx_seq_ + 1)) {
+    int32_t d = (int32_t) (now - this->last_rx_arrival_us_) - (int32_t) this->last_rx_duration_us_;
+    uint32_t abs_d = (uint32_t) (d < 0 ? -d : d);
+    this->transit_histogram_.record(abs_d);
+    this->jitter_q4_us_ += abs_d - ((this->jitter_q4_us_ + 8) >> 4);
+    this->jitter_100us_.store((uint16_t) std::min<uint32_t>((this->jitter_q4_us_ >> 4) / 100, UINT16_MAX),
+                              std::memory_order_relaxed);
+  }
+  size_t samples = codec == PayloadCodec::PCM16 ? len / sizeof(int16_t) : len * 2;
+  this->last_rx_seq_ = seq;
+  this->last_rx_arrival_us_ = now;
+  this->last_rx_duration_us_ = (uint32_t) (samples * 1000000ULL / SAMPLE_RATE);
+  this->have_last_rx_ = true;
+}
+
+void IntercomAudio::service_session_() {
+  uint32_t now = millis();
+  // An encrypted session has no raw fallback, so it keeps asking
+  bool keep_asking = this->peer_framed_ || this->crypto_.is_enabled() || this->hellos_sent_ < MAX_UNANSWERED_HELLOS;
+  if (!this->peer_heard_us_ && keep_asking && now - this->last_hello_ms_ >= HELLO_INTERVAL_MS) {
+    this->send_hello_(this->peer_framed_);
+    this->hellos_sent_++;
+    this->last_hello_ms_ = now;
+  }
+
+  if (now - this->last_report_ms_ >= REPORT_INTERVAL_MS) {
+    this->last_report_ms_ = now;
+    wire::Report report;
+    report.loss_permille = this->fec_rx_.take_loss_permille();
+    this->loss_permille_.store(report.loss_permille, std::memory_order_relaxed);
+
+    // Call quality from what was released towards playout, gaps that FEC could not fill included
+    uint32_t released, lost, loss_runs;
+    this->fec_rx_.take_release_counts(&released, &lost, &loss_runs);
+    if (this->call_quality_.add(released, lost, loss_runs, this->get_latency_breakdown().total_ms())) {
+      this->call_mos_x100_.store((uint16_t) lroundf(this->call_quality_.get_window_mos() * 100.0f),
+                                 std::memory_order_relaxed);
+      this->call_r_x10_.store((int16_t) lroundf(std::max(this->call_quality_.get_window_r(), -100.0f) * 10.0f),
+                              std::memory_order_relaxed);
+    }
+    if (this->peer_framed_) {
+      report.timestamp = now != 0 ? now : 1;  // 0 means "no timestamp" in the echo field
+      if (this->peer_report_ts_ != 0) {
+        report.echo_timestamp = this->peer_report_ts_;
+        report.echo_delay_ms = (uint16_t) std::min<uint32_t>(now - this->peer_report_rx_ms_, UINT16_MAX);
+      }
+      report.jitter_100us = this->jitter_100us_.load(std::memory_order_relaxed);
+      report.depth_ms = (uint16_t) std::min<uint64_t>(this->rx_available_() * 500ULL / SAMPLE_RATE, UINT16_MAX);
+
+      wire::PacketHeader header;
+      header.type = wire::PacketType::REPORT;
+      header.seq = this->report_seq_++;
+      uint8_t body[wire::REPORT_BODY_SIZE];
+      wire::write_report(report, body);
+      header.length = sizeof(body);
+      this->send_framed_(header, body, sizeof(body), nullptr, 0);
+    }
+  }
+
+  // Nothing else went out for a while (DTX, no mic): tell the peer we are still here.
+  // Encrypted sessions send nothing before the peer holds our nonce.
+  if (this->peer_framed_ && (this->peer_caps_ & wire::CAP_KEEPALIVE) &&
+      (!this->crypto_.is_enabled() || this->peer_heard_us_) && now - this->last_tx_ms_ >= wire::KEEPALIVE_INTERVAL_MS) {
+    wire::PacketHeader header;
+    header.type = wire::PacketType::KEEPALIVE;
+    header.seq = this->keepalive_seq_++;
+    if (!this->send_framed_(header, nullptr, 0, nullptr, 0)) {
+      this->last_tx_ms_ = now;  // Socket full or down: retry on the next interval, not every pass
+    }
+  }
+  this->check_peer_alive_(now);
+}
+
+void IntercomAudio::check_peer_alive_(uint32_t now) {
+  // Only a peer that promised keepalives can be judged by its silence
+  if (this->peer_timeout_ms_ == 0 || (this->peer_caps_ & wire::CAP_KEEPALIVE) == 0) {
+    return;
+  }
+  uint32_t silent_ms = now - this->last_peer_rx_ms_;
+  bool lost = silent_ms > this->peer_timeout_ms_;
+  if (lost == this->peer_lost_.load(std::memory_order_relaxed)) {
+    return;
+  }
+  this->peer_lost_.store(lost, std::memory_order_relaxed);
+  if (lost) {
+    ESP_LOGW(TAG, "Peer lost: nothing received for %u ms", (unsigned) silent_ms);
+    this->peer_lost_pending_.store(true, std::memory_order_release);
+  } else {
+    ESP_LOGI(TAG, "Peer is back");
+  }
+}
+
+void IntercomAudio::finish_call_quality_() {
+  this->call_quality_.finish();
+  if (this->call_quality_.get_windows() > 0) {
+    float average = this->call_quality_.get_average_mos();
+    float worst = this->call_quality_.get_worst_mos();
+    ESP_LOGI(TAG, "Call quality: MOS %.2f average, %.2f worst (%u windows)", average, worst,
+             (unsigned) this->call_quality_.get_windows());
+    this->last_call_mos_avg_x100_.store((uint16_t) lroundf(average * 100.0f), std::memory_order_relaxed);
+    this->last_call_mos_worst_x100_.store((uint16_t) lroundf(worst * 100.0f), std::memory_order_relaxed);
+    this->calls_rated_.fetch_add(1, std::memory_order_relaxed);
+  }
+  this->call_quality_.reset();
+  this->call_mos_x100_.store(0, std::memory_order_relaxed);
+  this->call_r_x10_.store(QUALITY_UNKNOWN, std::memory_order_relaxed);
+}
+
+void IntercomAudio::reset_session_() {
+  // The session that just ended (if any) gets its final rating
+  this->finish_call_quality_();
+  this->fec_tx_.reset();
+  this->fec_rx_.reset();
+  this->peer_framed_ = false;
+  this->link_framed_.store(false, std::memory_order_relaxed);
+  this->peer_heard_us_ = false;
+  this->peer_caps_ = 0;
+  this->hellos_sent_ = 0;
+  this->report_seq_ = 0;
+  this->keepalive_seq_ = 0;
+  this->peer_lost_.store(false, std::memory_order_relaxed);
+  if (this->crypto_.is_enabled()) {
+    // Fresh nonce every session, so sequence numbers restart under new keys
+    uint8_t nonce[StreamCrypto::NONCE_SIZE];
+    random_bytes(nonce, sizeof(nonce));
+    this->crypto_.begin_session(nonce);
+  }
+  uint32_t now = millis();
+  this->last_hello_ms_ = now - HELLO_INTERVAL_MS;  // First HELLO goes out right away
+  this->last_report_ms_ = now;
+  this->last_tx_ms_ = now;
+  this->last_peer_rx_ms_ = now;
+  this->loss_permille_.store(0, std::memory_order_relaxed);
+
+  // Link measurements and adaptation start over with every session
+  this->peer_report_ts_ = 0;
+  this->rtt_min_ms_ = RTT_UNKNOWN;
+  this->rtt_ms_.store(RTT_UNKNOWN, std::memory_order_relaxed);
+  this->jitter_q4_us_ = 0;
+  this->have_last_rx_ = false;
+  this->jitter_100us_.store(0, std::memory_order_relaxed);
+  this->peer_loss_permille_.store(0, std::memory_order_relaxed);
+  this->peer_jitter_100us_.store(0, std::memory_order_relaxed);
+  this->peer_depth_ms_.store(0, std::memory_order_relaxed);
+  this->link_fec_.store(false, std::memory_order_relaxed);
+  this->tx_pack_count_ = 0;
+  this->tx_pack_len_ = 0;
+  if (this->transport_ == TransportType::NETCONN) {
+    this->netconn_.abort_tx();
+  }
+  this->clear_reports_ = 0;
+  this->link_level_target_ = 0;
+  this->apply_link_level_();
 }
 
 void IntercomAudio::audio_task(void *param) {
@@ -448,15 +1854,27 @@ void IntercomAudio::audio_task(void *param) {
 }
 
 void IntercomAudio::audio_task_() {
-  ESP_LOGI(TAG, "Audio task started (runs forever)");
+  ESP_LOGI(TAG, "Audio task started (blocks until start() while idle)");
+  // A start() that ran before this task did notified an idle wait that never
+  // happened; left pending, it would end the first idle wait after stop()
+  if (this->streaming_.load(std::memory_order_acquire)) {
+    ulTaskNotifyTake(pdTRUE, 0);
+  }
 
   uint32_t seen_session = this->session_.load(std::memory_order_acquire);
   bool prebuffered = false;
   bool hw_started = false;  // Track if we started hardware
+  bool mic_started = false;
+  bool in_session = false;  // For the trace
+
+  // Trace: drop counters as of the last event, and whether the jitter buffer was dry
+  uint32_t traced_tx_drops = 0;
+  uint32_t traced_rx_drops = 0;
+  bool rx_dry = false;
 
-  // AEC hold-last buffer
+  // AEC hold-last buffer (only read with USE_ESP_AEC)
   int16_t last_ref[FRAME_SAMPLES];
-  bool have_last_ref = false;
+  [[maybe_unused]] bool have_last_ref = false;
   memset(last_ref, 0, sizeof(last_ref));
 
   // Compute AEC state
@@ -472,17 +1890,55 @@ void IntercomAudio::audio_task_() {
   };
   recompute_aec();
 
+  // Frames left over from the previous pass (per-pass limit hit): don't block
+  bool more_work = false;
+  // The speaker had no room last pass: come back when it has drained a bit
+  bool sink_full = false;
+
   while (true) {
-    // Wait for notification or timeout
-    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(5));
+    // Scrapes copy this task's values while it is paused or between passes
+    PassSequence::Pass pass(this->pass_seq_);
 
     // Check if streaming
     if (!this->streaming_.load(std::memory_order_acquire)) {
-      // Not streaming - reset state and wait
+      // Not streaming - reset state and sleep until start() notifies
       prebuffered = false;
+      more_work = false;
+      sink_full = false;
+      this->rx_held_bytes_ = 0;
       seen_session = this->session_.load(std::memory_order_acquire);
       have_last_ref = false;
+      this->tx_resampler_.reset();
+      this->rx_resampler_.reset();
+      this->reset_session_();
+      // Recording pre-roll: the microphone feeds the ring between calls
+      if (this->recorder_.is_always_on()) {
+#ifdef USE_I2S_AUDIO_DUPLEX
+        if (this->duplex_ != nullptr) {
+          if (!this->duplex_->is_running()) {
+            this->duplex_->start();
+          }
+        } else
+#endif
+        if (!mic_started) {
+#ifdef USE_MICROPHONE
+          if (this->microphone_ != nullptr) {
+            this->microphone_->start();
+          }
+#endif
+          mic_started = true;
+        }
+      }
+      if (in_session) {
+        this->trace_event_(TraceEvent::SESSION_STOP, 0);
+        in_session = false;
+      }
       // NOTE: Don't stop hardware - keep it running to avoid cleanup crash
+      pass.pause();
+      // Nothing of the call is touched past here: stop() may tear it down
+      xSemaphoreGive(this->task_idle_);
+      ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+      this->task_wakeups_.fetch_add(1, std::memory_order_relaxed);
       continue;
     }
 
@@ -505,11 +1961,12 @@ void IntercomAudio::audio_task_() {
       }
 #endif
 #ifdef USE_MICROPHONE
-      if (this->microphone_ != nullptr) {
+      if (this->microphone_ != nullptr && !mic_started) {
         this->microphone_->start();
       }
 #endif
       hw_started = true;
+      mic_started = true;
     }
 
     // Check for session change (stop/start happened)
@@ -517,119 +1974,231 @@ void IntercomAudio::audio_task_() {
     if (current_session != seen_session) {
       seen_session = current_session;
       prebuffered = false;
+      sink_full = false;
+      this->rx_held_bytes_ = 0;
       have_last_ref = false;
+      this->tx_resampler_.reset();
+      this->rx_resampler_.reset();
+      this->reset_session_();
       recompute_aec();
+      this->trace_seq_ = 0;
+      this->play_seq_ = 0;
+      this->rx_seq_ = 0;
+      traced_tx_drops = this->tx_drops_.load(std::memory_order_relaxed);
+      traced_rx_drops = this->rx_drops_.load(std::memory_order_relaxed);
+      rx_dry = false;
+      this->trace_event_(TraceEvent::SESSION_START, current_session);
+      in_session = true;
       continue;
     }
 
+    // Block until a datagram arrives, the mic delivers a frame or start/stop wakes us
+    if (!more_work) {
+      pass.pause();
+      this->wait_for_events_(sink_full ? BACKPRESSURE_WAIT_MS : EVENT_GUARD_MS);
+      pass.resume();
+      if (!this->streaming_.load(std::memory_order_acquire)) {
+        continue;
+      }
+    }
+    this->blocked_us_ = 0;
+
     // Multi-frame processing limits
     const int max_frames_per_iter = 4;
     int frames_processed = 0;
 
-    // === RX: UDP -> ring buffer -> speaker ===
-    size_t samples = this->receive_audio_(this->rx_frame_, RX_MAX_SAMPLES);
-    if (samples > 0) {
-      size_t bytes = samples * sizeof(int16_t);
-      size_t written = this->rx_buffer_->write(this->rx_frame_, bytes);
-      if (written < bytes) {
-        this->rx_drops_.fetch_add(1, std::memory_order_relaxed);
+    // === RX: UDP -> jitter buffer -> speaker ===
+    // Drain every pending datagram so bursts after a Wi-Fi stall land in the
+    // jitter buffer (and show up in rx_drops_) instead of overflowing SO_RCVBUF
+    if (this->transport_ == TransportType::NETCONN) {
+      uint32_t dropped = 0;
+      size_t received = this->netconn_.receive(&dropped);
+      this->rx_packets_.fetch_add(received, std::memory_order_relaxed);
+      this->rx_drops_.fetch_add(dropped, std::memory_order_relaxed);
+    } else {
+      while (this->receive_packet_()) {
+      }
+      if (this->framing_enabled_()) {
+        this->service_session_();
       }
-      this->rx_fill_.store(this->rx_buffer_->available(), std::memory_order_release);
+    }
+    this->rx_fill_.store(this->rx_available_(), std::memory_order_release);
+
+    if (this->trace_.is_enabled()) {
+      uint32_t tx_drops = this->tx_drops_.load(std::memory_order_relaxed);
+      uint32_t rx_drops = this->rx_drops_.load(std::memory_order_relaxed);
+      if (tx_drops != traced_tx_drops) {
+        this->trace_event_(TraceEvent::TX_DROP, tx_drops - traced_tx_drops);
+        traced_tx_drops = tx_drops;
+      }
+      if (rx_drops != traced_rx_drops) {
+        this->trace_event_(TraceEvent::RX_DROP, rx_drops - traced_rx_drops);
+        traced_rx_drops = rx_drops;
+      }
+      bool dry = prebuffered && this->rx_available_() < FRAME_BYTES;
+      if (dry && !rx_dry) {
+        this->trace_event_(TraceEvent::RX_EMPTY, 0);
+      }
+      rx_dry = dry;
     }
 
     // Wait for prebuffer before playing
     if (!prebuffered) {
-      if (this->rx_buffer_->available() >= this->prebuffer_size_) {
+      if (this->rx_available_() >= this->prebuffer_size_) {
         prebuffered = true;
         ESP_LOGD(TAG, "Prebuffer filled");
       }
     }
 
-    // Play from RX buffer to speaker (multiple frames per iteration)
-    if (prebuffered) {
+    // Play from RX buffer to speaker (multiple frames per iteration). Nothing
+    // leaves the jitter buffer until the speaker has room for it, so a full
+    // speaker leaves the frames queued instead of stalling TX below.
+    sink_full = false;
+    if (prebuffered && this->rx_held_bytes_ > 0) {
+      // Rest of a frame the speaker only partly took last pass
+      const uint8_t *held = reinterpret_cast<const uint8_t *>(this->rx_frame_) + (FRAME_BYTES - this->rx_held_bytes_);
+      this->rx_held_bytes_ -= this->play_(held, this->rx_held_bytes_);
+      sink_full = this->rx_held_bytes_ > 0;
+    }
+    if (prebuffered && !sink_full) {
       frames_processed = 0;
-      while (this->rx_buffer_->available() >= FRAME_BYTES && frames_processed < max_frames_per_iter) {
-        size_t read = this->rx_buffer_->read(this->rx_frame_, FRAME_BYTES, 0);
-        this->rx_fill_.store(this->rx_buffer_->available(), std::memory_order_release);
-
-        if (read != FRAME_BYTES || !this->streaming_.load(std::memory_order_acquire)) {
+      while (this->rx_available_() >= FRAME_BYTES && frames_processed < max_frames_per_iter &&
+             this->streaming_.load(std::memory_order_acquire)) {
+        if (this->sink_space_() < FRAME_BYTES || this->inject_fault_(Fault::SPEAKER_STALL)) {
+          sink_full = true;
           break;
         }
-
-        // Store speaker ref for AEC
-        if (this->speaker_ref_buffer_ != nullptr && this->ref_mutex_ != nullptr) {
-          if (xSemaphoreTake(this->ref_mutex_, pdMS_TO_TICKS(1)) == pdTRUE) {
-            this->speaker_ref_buffer_->write_without_replacement((void *)this->rx_frame_, FRAME_BYTES, 0, true);
-            xSemaphoreGive(this->ref_mutex_);
+        size_t played;
+        if (this->transport_ == TransportType::NETCONN) {
+          // Straight from the received pbufs; whatever the speaker can't take stays queued
+          played = this->netconn_.consume(FRAME_BYTES, [this](const uint8_t *data, size_t len) {
+            return this->play_(data, len);
+          });
+        } else {
+          size_t read = this->rx_buffer_->read(this->rx_frame_, FRAME_BYTES, 0);
+          if (read != FRAME_BYTES) {
+            break;
           }
+          this->count_copy_(read);
+          played = this->play_(reinterpret_cast<const uint8_t *>(this->rx_frame_), FRAME_BYTES);
+          this->rx_held_bytes_ = FRAME_BYTES - played;
         }
-
-        // Send to speaker (skip if volume is 0 to reduce crosstalk)
-#ifdef USE_I2S_AUDIO_DUPLEX
-        if (this->duplex_ != nullptr) {
-          this->duplex_->play((uint8_t *)this->rx_frame_, FRAME_BYTES, pdMS_TO_TICKS(10));
-        }
-#endif
-#ifdef USE_SPEAKER
-#ifdef USE_I2S_AUDIO_DUPLEX
-        else
-#endif
-        if (this->speaker_ != nullptr && this->speaker_->get_volume() > 0.001f) {
-          this->speaker_->play((uint8_t *)this->rx_frame_, FRAME_BYTES, pdMS_TO_TICKS(10));
-        }
-#endif
+        this->rx_fill_.store(this->rx_available_(), std::memory_order_release);
         frames_processed++;
+        if (played < FRAME_BYTES) {
+          sink_full = true;
+          break;
+        }
       }
     }
+    if (sink_full) {
+      this->playout_deferred_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    bool rx_pending = prebuffered && !sink_full && this->rx_available_() >= FRAME_BYTES;
 
     // === TX: mic buffer -> [AEC] -> UDP ===
     frames_processed = 0;
 
     while (frames_processed < max_frames_per_iter) {
+      bool run_aec = false;
+      int16_t *capture = this->tx_frame_;
+      int16_t *output = this->tx_frame_;
+#ifdef USE_ESP_AEC
+      run_aec = use_aec && this->aec_->is_initialized();
+      if (run_aec) {
+        capture = this->aec_mic_frame_;
+        output = this->aec_out_frame_;
+      }
+#endif
+
+      // The final frame is built straight in the outgoing netbuf when possible
       size_t got_mic = 0;
-      if (xSemaphoreTake(this->mic_mutex_, pdMS_TO_TICKS(2)) == pdTRUE) {
+      uint32_t captured_at = 0;
+      bool have_capture_time = false;
+      int64_t wait_start = esp_timer_get_time();
+      bool locked = xSemaphoreTake(this->mic_mutex_, pdMS_TO_TICKS(2)) == pdTRUE;
+      this->blocked_us_ += (uint32_t) (esp_timer_get_time() - wait_start);
+      if (locked) {
         if (this->mic_input_buffer_->available() >= FRAME_BYTES) {
-          got_mic = this->mic_input_buffer_->read(this->tx_frame_, FRAME_BYTES, 0);
+          output = this->begin_tx_frame_(output);
+          if (!run_aec) {
+            capture = output;
+          }
+          got_mic = this->mic_input_buffer_->read(capture, FRAME_BYTES, 0);
+          if (got_mic == FRAME_BYTES && this->capture_times_tail_ != this->capture_times_head_) {
+            captured_at = this->capture_times_[this->capture_times_tail_++ & this->capture_times_mask_];
+            have_capture_time = true;
+          }
         }
         xSemaphoreGive(this->mic_mutex_);
       }
 
       if (got_mic != FRAME_BYTES) {
+        this->abort_tx_frame_();
         break;  // No more data
       }
+      this->count_copy_(got_mic);
+      this->trace_frame_(TraceKind::MIC, 0, capture, FRAME_SAMPLES);
 
 #ifdef USE_ESP_AEC
-      if (use_aec && this->aec_->is_initialized()) {
+      if (run_aec) {
         // Get speaker reference (use ref_mutex_)
         size_t got_ref = 0;
-        if (this->ref_mutex_ != nullptr && xSemaphoreTake(this->ref_mutex_, pdMS_TO_TICKS(1)) == pdTRUE) {
+        int64_t ref_wait_start = esp_timer_get_time();
+        bool ref_locked = this->ref_mutex_ != nullptr && xSemaphoreTake(this->ref_mutex_, pdMS_TO_TICKS(1)) == pdTRUE;
+        this->blocked_us_ += (uint32_t) (esp_timer_get_time() - ref_wait_start);
+        if (ref_locked) {
           if (this->speaker_ref_buffer_->available() >= FRAME_BYTES) {
             got_ref = this->speaker_ref_buffer_->read(this->aec_ref_frame_, FRAME_BYTES, 0);
           }
           xSemaphoreGive(this->ref_mutex_);
         }
 
+        uint8_t ref_flags = 0;
         if (got_ref == FRAME_BYTES) {
           memcpy(last_ref, this->aec_ref_frame_, sizeof(last_ref));
           have_last_ref = true;
+          ref_flags = TRACE_REF_FRESH;
         } else if (have_last_ref) {
           memcpy(this->aec_ref_frame_, last_ref, sizeof(last_ref));
+          ref_flags = TRACE_REF_HELD;
         } else {
           memset(this->aec_ref_frame_, 0, FRAME_BYTES);
         }
 
-        // Process AEC
-        memcpy(this->aec_mic_frame_, this->tx_frame_, FRAME_BYTES);
-        this->aec_->process(this->aec_mic_frame_, this->aec_ref_frame_, this->aec_out_frame_, FRAME_SAMPLES);
-        this->send_audio_(reinterpret_cast<uint8_t *>(this->aec_out_frame_), FRAME_BYTES);
-      } else
+        // Process AEC (output may be the netbuf payload)
+        this->aec_->process(capture, this->aec_ref_frame_, output, FRAME_SAMPLES);
+        this->trace_frame_(TraceKind::REF, ref_flags, this->aec_ref_frame_, FRAME_SAMPLES);
+        this->trace_frame_(TraceKind::AEC_OUT, 0, output, FRAME_SAMPLES);
+      }
 #endif
-      {
-        // No AEC - send directly
-        this->send_audio_(reinterpret_cast<uint8_t *>(this->tx_frame_), FRAME_BYTES);
+      this->trace_seq_++;
+      this->tap_recorder_(output, FRAME_SAMPLES);
+      this->send_frame_(output, FRAME_SAMPLES);
+      if (have_capture_time) {
+        uint32_t latency = (uint32_t) esp_timer_get_time() - captured_at;
+        this->capture_histogram_.record(latency);
+        uint32_t avg = this->capture_latency_q4_us_.load(std::memory_order_relaxed);
+        avg += latency - ((avg + 8) >> 4);
+        this->capture_latency_q4_us_.store(avg, std::memory_order_relaxed);
       }
       frames_processed++;
     }
+
+    this->record_blocked_();
+    more_work = rx_pending || frames_processed >= max_frames_per_iter;
+  }
+}
+
+void IntercomAudio::record_blocked_() {
+  uint32_t blocked = this->blocked_us_;
+  this->blocked_histogram_.record(blocked);
+  uint32_t avg = this->loop_blocked_q4_us_.load(std::memory_order_relaxed);
+  avg += blocked - ((avg + 8) >> 4);
+  this->loop_blocked_q4_us_.store(avg, std::memory_order_relaxed);
+  if (blocked > this->loop_blocked_max_us_.load(std::memory_order_relaxed)) {
+    this->loop_blocked_max_us_.store(blocked, std::memory_order_relaxed);
   }
 }
 
@@ -652,6 +2221,7 @@ float IntercomAudio::get_volume() const {
 
 void IntercomAudio::set_mic_gain(int gain) {
   this->mic_gain_ = gain;
+  this->mic_converter_.set_gain(gain);
 #ifdef USE_I2S_AUDIO_DUPLEX
   // Forward to duplex if available (duplex uses float 0.0-2.0, we use int 1-10)
   if (this->duplex_ != nullptr) {
@@ -7,6 +7,21 @@
 #include "esphome/core/ring_buffer.h"
 #include "esphome/core/optional.h"
 
+#include "audio_recorder.h"
+#include "audio_trace.h"
+#include "call_profile.h"
+#include "call_quality.h"
+#include "fault_injection.h"
+#include "fec.h"
+#include "mic_convert.h"
+#include "metrics.h"
+#include "mic_ingest.h"
+#include "netconn_transport.h"
+#include "packet.h"
+#include "resampler.h"
+#include "stream_crypto.h"
+#include "web_export.h"
+
 #ifdef USE_MICROPHONE
 #include "esphome/components/microphone/microphone.h"
 #endif
@@ -20,12 +35,22 @@
 #include <freertos/semphr.h>
 
 #include <atomic>
+#include <cmath>
 #include <cstdint>
 #include <functional>
 #include <memory>
 #include <string>
 #include <vector>
 
+// Stream format, emitted by codegen from sample_rate / frame_duration so frame
+// buffers, loops and packet sizes are compile-time constants
+#ifndef INTERCOM_AUDIO_SAMPLE_RATE
+#define INTERCOM_AUDIO_SAMPLE_RATE 16000
+#endif
+#ifndef INTERCOM_AUDIO_FRAME_SAMPLES
+#define INTERCOM_AUDIO_FRAME_SAMPLES 256
+#endif
+
 // Forward declare esp_aec if available
 namespace esphome {
 namespace esp_aec {
@@ -42,6 +67,14 @@ class I2SAudioDuplex;
 }  // namespace esphome
 #endif
 
+#ifdef USE_MDNS_DISCOVERY
+namespace esphome {
+namespace mdns_discovery {
+class MdnsDiscovery;
+}  // namespace mdns_discovery
+}  // namespace esphome
+#endif
+
 namespace esphome {
 namespace intercom_audio {
 
@@ -51,6 +84,40 @@ enum class StreamState : uint8_t {
   STREAMING,
 };
 
+// Wire format of one direction of the stream. G.711 is carried at 8 kHz and
+// resampled 2:1 against the 16 kHz device rate, so go2rtc can pass it through
+// to WebRTC without ffmpeg transcoding.
+enum class PayloadCodec : uint8_t {
+  PCM16,      // s16le at the device rate
+  G711_ALAW,  // 8 kHz A-law (PCMA)
+  G711_ULAW,  // 8 kHz mu-law (PCMU)
+};
+
+// How datagrams reach lwIP
+enum class TransportType : uint8_t {
+  SOCKET,   // BSD sockets: recvfrom/sendto copy through the jitter ring buffer
+  NETCONN,  // lwIP netconn: received pbufs queued until playout, TX built in a pbuf
+};
+
+// Live mouth-to-ear latency of the audio this device plays, per stage (ms).
+// The peer's capture is taken to be like ours, so capture_ms is our own
+// capture-to-send time; network_ms is half the RTT, NAN until it is known.
+// Stages this device cannot see (a separate speaker's buffers) read 0.
+struct LatencyBreakdown {
+  float capture_ms;
+  float packetization_ms;
+  float network_ms;
+  float jitter_buffer_ms;
+  float speaker_buffer_ms;
+  float playback_dma_ms;
+
+  float playout_ms() const { return this->jitter_buffer_ms + this->speaker_buffer_ms + this->playback_dma_ms; }
+  float total_ms() const {
+    return this->capture_ms + this->packetization_ms + (std::isnan(this->network_ms) ? 0.0f : this->network_ms) +
+           this->playout_ms();
+  }
+};
+
 class IntercomAudio : public Component {
  public:
   void setup() override;
@@ -69,6 +136,10 @@ class IntercomAudio : public Component {
   void set_duplex(i2s_audio_duplex::I2SAudioDuplex *duplex) { this->duplex_ = duplex; }
 #endif
   void set_aec(esp_aec::EspAec *aec) { this->aec_ = aec; }
+#ifdef USE_MDNS_DISCOVERY
+  // Only read for the metrics export
+  void set_discovery(mdns_discovery::MdnsDiscovery *discovery) { this->discovery_ = discovery; }
+#endif
 
   void set_listen_port(uint16_t port) { this->listen_port_ = port; }
 
@@ -90,8 +161,108 @@ class IntercomAudio : public Component {
     return this->remote_port_;
   }
 
+  static constexpr uint32_t get_sample_rate() { return INTERCOM_AUDIO_SAMPLE_RATE; }
+  static constexpr size_t get_frame_samples() { return INTERCOM_AUDIO_FRAME_SAMPLES; }
+
+  void set_transport(TransportType transport) { this->transport_ = transport; }
+  TransportType get_transport() const { return this->transport_; }
+
+  // Call profile: DSCP on both directions (EF lands in WMM AC_VO) and Wi-Fi
+  // settings applied on start() and restored on stop()
+  void set_dscp(uint8_t dscp) { this->ip_tos_ = (uint8_t) (dscp << 2); }
+  void set_disable_power_save(bool disable) { this->wifi_profile_.set_disable_power_save(disable); }
+  void set_tx_power(float dbm) { this->wifi_profile_.set_tx_power(dbm); }
+  // Between calls: automatic light sleep and a slower main loop
+  void set_idle_light_sleep(bool enable) { this->idle_power_.set_light_sleep(enable); }
+  void set_idle_loop_interval(uint32_t ms) { this->idle_power_.set_loop_interval(ms); }
+
+  void set_tx_codec(PayloadCodec codec) { this->tx_codec_ = codec; }
+  void set_rx_codec(PayloadCodec codec) { this->rx_codec_ = codec; }
+  PayloadCodec get_tx_codec() const { return this->tx_codec_; }
+  PayloadCodec get_rx_codec() const { return this->rx_codec_; }
+
+  // Forward error correction (socket transport). Negotiated with the peer per
+  // session; redundancy is sent while the peer reports loss above the threshold.
+  void set_fec_mode(FecMode mode) { this->fec_mode_ = mode; }
+  void set_fec_group_size(uint8_t size) { this->fec_group_size_ = size; }
+  void set_fec_loss_threshold(float fraction) { this->fec_loss_threshold_permille_ = (uint16_t) (fraction * 1000.0f); }
+  FecMode get_fec_mode() const { return this->fec_mode_; }
+
+  // Frames sent per UDP packet (packetization interval = frames x frame duration)
+  void set_packet_frames(uint8_t frames) { this->packet_frames_ = frames; }
+
+  // Link adaptation (socket transport): follow the peer's reports by packing
+  // several frames per datagram and, under congestion, falling back to G.711
+  void set_adaptive(bool adaptive) { this->adaptive_ = adaptive; }
+  void set_max_packet_frames(uint8_t frames) { this->max_packet_frames_ = frames; }
+  void set_codec_fallback(PayloadCodec codec) { this->codec_fallback_ = codec; }
+
+  // Peer loss detection (socket transport): both ends fill quiet stretches with
+  // keepalives, so a framed peer that stays silent for the timeout is gone
+  void set_peer_timeout(uint32_t ms) { this->peer_timeout_ms_ = ms; }
+  void set_stop_on_peer_lost(bool stop) { this->stop_on_peer_lost_ = stop; }
+  bool is_peer_lost() const { return this->peer_lost_.load(std::memory_order_relaxed); }
+
+#ifdef USE_INTERCOM_FAULT_INJECTION
+  // Soak builds only: fail this fraction of sends, received datagrams, speaker
+  // writes, mic frames and duplex I2S reads/writes (socket transport for the
+  // network faults, duplex_id for the I2S ones)
+  void set_fault_rate(Fault fault, float rate) { this->faults_.set_rate(fault, rate); }
+#endif
+
+  // Authenticated encryption (socket transport): 32-byte pre-shared key,
+  // per-session keys agreed in the HELLO exchange
+  void set_encryption_key(const std::vector<uint8_t> &key) {
+    if (key.size() == StreamCrypto::KEY_SIZE) {
+      this->crypto_.set_psk(key.data());
+    }
+  }
+  void set_cipher_suite(CipherSuite suite) { this->crypto_.set_suite(suite); }
+
+  // Recording: a ring of the outgoing (post-AEC) audio in PSRAM. With a
+  // pre-roll the microphone keeps feeding it between calls, so a recording
+  // started by a doorbell press includes the seconds before it.
+  void set_recording_history(uint32_t ms) { this->recorder_.set_history_ms(ms); }
+  void set_recording_pre_roll(uint32_t ms) { this->recorder_.set_pre_roll_ms(ms); }
+  void set_recording_format(RecordFormat format) { this->recorder_.set_format(format); }
+  void set_record_calls(bool record) { this->record_calls_ = record; }
+#ifdef USE_INTERCOM_WEB_EXPORT
+  void set_recording_export(web_server_base::WebServerBase *base, const std::string &path) {
+    this->recording_export_ = new RecordingExport(base, &this->recorder_, path);  // NOLINT
+  }
+#endif
+  // Trace: ring of mic / reference / AEC output / received / played frames and
+  // events for offline debugging (tools/trace_report.py); switched on and off
+  // at runtime
+  void set_trace_duration(uint32_t ms) { this->trace_duration_ms_ = ms; }
+#ifdef USE_INTERCOM_WEB_EXPORT
+  void set_trace_export(web_server_base::WebServerBase *base, const std::string &path) {
+    this->trace_export_ = new TraceExport(base, &this->trace_, path);  // NOLINT
+  }
+#endif
+  // Metrics: every counter and latency histogram here, and those of the duplex,
+  // AEC and discovery components used with it, for a Prometheus scraper
+#ifdef USE_INTERCOM_WEB_EXPORT
+  void set_metrics_export(web_server_base::WebServerBase *base, const std::string &path) {
+    this->metrics_export_ =
+        new MetricsExport(base, [this](MetricsSnapshot &snapshot) { this->collect_metrics(snapshot); }, path);  // NOLINT
+  }
+#endif
+  void set_trace_enabled(bool enabled) { this->trace_.set_enabled(enabled); }
+  bool is_trace_enabled() const { return this->trace_.is_enabled(); }
+  bool has_trace() const { return this->trace_.is_allocated(); }
+  // For a dump outside the web export (the host replay)
+  const AudioTrace &get_trace() const { return this->trace_; }
+
+  void start_recording() { this->recorder_.start_recording(); }
+  void stop_recording() { this->recorder_.stop_recording(); }
+  bool is_recording() const { return this->recorder_.is_recording(); }
+
   void set_buffer_size(size_t size) { this->buffer_size_ = size; }
   void set_prebuffer_size(size_t size) { this->prebuffer_size_ = size; }
+  // Planned at config time (latency.py); only reported against at runtime
+  void set_latency_target(uint32_t ms) { this->latency_target_ms_ = ms; }
+  uint32_t get_latency_target() const { return this->latency_target_ms_; }
 
   // Runtime control - simple: set flags, open/close sockets
   void start();
@@ -107,6 +278,88 @@ class IntercomAudio : public Component {
   uint32_t get_rx_packets() const { return this->rx_packets_.load(std::memory_order_relaxed); }
   size_t get_buffer_fill() const { return this->rx_fill_.load(std::memory_order_acquire); }
 
+  // Audio payload copies made by this component (both directions), to compare transports
+  uint32_t get_copies() const { return this->copies_.load(std::memory_order_relaxed); }
+  uint32_t get_bytes_moved() const { return this->bytes_moved_.load(std::memory_order_relaxed); }
+
+  // FEC statistics
+  uint32_t get_fec_recovered() const { return this->fec_rx_.get_recovered(); }
+  uint32_t get_fec_lost() const { return this->fec_rx_.get_lost(); }
+  uint32_t get_fec_overhead_bytes() const { return this->fec_overhead_bytes_.load(std::memory_order_relaxed); }
+  uint32_t get_fec_cpu_us() const { return this->fec_cpu_us_.load(std::memory_order_relaxed); }
+  // Time spent in the UDP send calls (sendto/sendmsg/netconn_sendto), to size packets
+  uint32_t get_send_cpu_us() const { return this->send_cpu_us_.load(std::memory_order_relaxed); }
+  // Smoothed time per send call (1/16 EWMA), to compare with and without the call profile
+  float get_send_latency_us() const { return this->send_latency_q4_us_.load(std::memory_order_relaxed) / 16.0f; }
+  // Received packet loss before FEC over the last report interval, in percent
+  float get_packet_loss() const { return this->loss_permille_.load(std::memory_order_relaxed) / 10.0f; }
+  // Encryption: smoothed CPU cycles per packet sealed/opened (1/16 EWMA), and
+  // packets dropped for a bad tag, a replay or missing protection
+  float get_encrypt_cycles() const { return this->seal_cycles_q4_.load(std::memory_order_relaxed) / 16.0f; }
+  float get_decrypt_cycles() const { return this->open_cycles_q4_.load(std::memory_order_relaxed) / 16.0f; }
+  uint32_t get_crypto_rejected() const { return this->crypto_rejected_.load(std::memory_order_relaxed); }
+  // Times the audio task woke up (never reset); as a rate it is ~0 between calls
+  uint32_t get_task_wakeups() const { return this->task_wakeups_.load(std::memory_order_relaxed); }
+  // Streaming wakeups by cause: the guard timeout ran out, or a datagram was waiting
+  uint32_t get_guard_wakeups() const { return this->guard_wakeups_.load(std::memory_order_relaxed); }
+  uint32_t get_socket_wakeups() const { return this->socket_wakeups_.load(std::memory_order_relaxed); }
+  // Recording tap: smoothed CPU cycles per frame written (1/16 EWMA) and
+  // seconds of audio held in the ring
+  float get_recording_tap_cycles() const { return this->tap_cycles_q4_.load(std::memory_order_relaxed) / 16.0f; }
+  float get_recording_buffered() const { return this->recorder_.get_buffered_seconds(); }
+  // Smoothed CPU cycles per trace record written (1/16 EWMA)
+  float get_trace_cycles() const { return this->trace_cycles_q4_.load(std::memory_order_relaxed) / 16.0f; }
+  // Smoothed CPU cycles per 32-bit mic frame converted to int16 (microphone_id mode)
+  float get_mic_convert_cycles() const { return this->convert_cycles_q4_.load(std::memory_order_relaxed) / 16.0f; }
+  // Mic bytes dropped to stay on sample boundaries (never reset)
+  uint32_t get_mic_misaligned_bytes() const { return this->mic_misaligned_.load(std::memory_order_relaxed); }
+  // Smoothed time from capture of a frame's first sample until it is sent (µs)
+  uint32_t get_capture_latency_us() const { return this->capture_latency_q4_us_.load(std::memory_order_relaxed) >> 4; }
+  // Time per audio task pass spent in speaker writes and buffer locks (µs): smoothed
+  // (1/16 EWMA), and the worst pass since the last call (resets it)
+  float get_loop_blocked_us() const { return this->loop_blocked_q4_us_.load(std::memory_order_relaxed) / 16.0f; }
+  uint32_t take_loop_blocked_max_us() { return this->loop_blocked_max_us_.exchange(0, std::memory_order_relaxed); }
+  // Passes that left frames in the jitter buffer because the speaker was full (never reset)
+  uint32_t get_playout_deferred() const { return this->playout_deferred_.load(std::memory_order_relaxed); }
+
+  // Receiver reports (framed sessions). RTT is NAN until the peer has echoed a report.
+  float get_rtt_ms() const {
+    uint32_t rtt = this->rtt_ms_.load(std::memory_order_relaxed);
+    return rtt == RTT_UNKNOWN ? NAN : (float) rtt;
+  }
+  float get_jitter_ms() const { return this->jitter_100us_.load(std::memory_order_relaxed) / 10.0f; }
+  float get_peer_loss() const { return this->peer_loss_permille_.load(std::memory_order_relaxed) / 10.0f; }
+  float get_peer_jitter_ms() const { return this->peer_jitter_100us_.load(std::memory_order_relaxed) / 10.0f; }
+  uint32_t get_peer_buffer_ms() const { return this->peer_depth_ms_.load(std::memory_order_relaxed); }
+  // Listening quality (E-model, framed sessions): MOS and R of the latest
+  // window during a call, and the average and worst window MOS of the last
+  // finished call. NAN when unknown; get_calls_rated() moves on as a call ends.
+  float get_call_mos() const {
+    uint16_t mos = this->call_mos_x100_.load(std::memory_order_relaxed);
+    return mos == 0 ? NAN : mos / 100.0f;
+  }
+  float get_call_r_factor() const {
+    int16_t r = this->call_r_x10_.load(std::memory_order_relaxed);
+    return r == QUALITY_UNKNOWN ? NAN : r / 10.0f;
+  }
+  float get_last_call_mos_average() const {
+    uint16_t mos = this->last_call_mos_avg_x100_.load(std::memory_order_relaxed);
+    return mos == 0 ? NAN : mos / 100.0f;
+  }
+  float get_last_call_mos_worst() const {
+    uint16_t mos = this->last_call_mos_worst_x100_.load(std::memory_order_relaxed);
+    return mos == 0 ? NAN : mos / 100.0f;
+  }
+  uint32_t get_calls_rated() const { return this->calls_rated_.load(std::memory_order_relaxed); }
+  // What we currently send: "raw", or codec, frames per packet and active FEC, e.g. "pcm x2 +red"
+  std::string get_link_state() const;
+  LatencyBreakdown get_latency_breakdown() const;
+  // e.g. "cap 21 + pkt 0 + net 3 + jb 16 + spk 16 + dma 16 = 72 ms"
+  std::string get_latency_summary() const;
+  // Copies every metric into the snapshot (any task). What the audio task
+  // updates is copied from between two of its passes; see pass_seq_.
+  void collect_metrics(MetricsSnapshot &snapshot) const;
+
   // Get audio mode as string
   const char *get_mode_str() const {
 #ifdef USE_I2S_AUDIO_DUPLEX
@@ -132,6 +385,14 @@ class IntercomAudio : public Component {
     this->rx_packets_.store(0, std::memory_order_relaxed);
     this->tx_drops_.store(0, std::memory_order_relaxed);
     this->rx_drops_.store(0, std::memory_order_relaxed);
+    this->copies_.store(0, std::memory_order_relaxed);
+    this->bytes_moved_.store(0, std::memory_order_relaxed);
+    this->fec_rx_.reset_counters();
+    this->fec_overhead_bytes_.store(0, std::memory_order_relaxed);
+    this->fec_cpu_us_.store(0, std::memory_order_relaxed);
+    this->send_cpu_us_.store(0, std::memory_order_relaxed);
+    this->send_latency_q4_us_.store(0, std::memory_order_relaxed);
+    this->crypto_rejected_.store(0, std::memory_order_relaxed);
   }
 
   // Drop counters (buffer overruns)
@@ -147,7 +408,10 @@ class IntercomAudio : public Component {
   int get_mic_gain() const { return this->mic_gain_; }
 
   // DC offset removal (for microphones with significant DC bias like SPH0645)
-  void set_dc_offset_removal(bool enabled) { this->dc_offset_removal_ = enabled; }
+  void set_dc_offset_removal(bool enabled) {
+    this->dc_offset_removal_ = enabled;
+    this->mic_converter_.set_dc_removal(enabled);
+  }
   bool get_dc_offset_removal() const { return this->dc_offset_removal_; }
 
   // AEC control
@@ -157,6 +421,7 @@ class IntercomAudio : public Component {
   // Triggers for automations
   Trigger<> *get_start_trigger() { return &this->start_trigger_; }
   Trigger<> *get_stop_trigger() { return &this->stop_trigger_; }
+  Trigger<> *get_peer_lost_trigger() { return &this->peer_lost_trigger_; }
 
  protected:
   // Audio task - created ONCE in setup(), runs forever
@@ -165,6 +430,7 @@ class IntercomAudio : public Component {
 
   // Microphone callback
   void on_microphone_data_(const uint8_t *data, size_t len);
+  void on_mic_frame_(const MicIngest::Frame &frame, bool streaming, uint32_t session);
   void on_microphone_data_(const std::vector<uint8_t> &data) {
     on_microphone_data_(data.data(), data.size());
   }
@@ -173,7 +439,80 @@ class IntercomAudio : public Component {
   bool setup_sockets_();
   void close_sockets_();
   bool send_audio_(const uint8_t *data, size_t bytes);
-  size_t receive_audio_(int16_t *buffer, size_t max_samples);
+  void record_send_(int64_t start_us);
+  // Read one datagram into the jitter buffer; false once the socket is drained
+  bool receive_packet_();
+  // Decode one payload (or the RED µ-law copy of a PCM one) into the jitter buffer
+  void deliver_payload_(const uint8_t *payload, size_t len, PayloadCodec codec, bool redundant);
+
+  // Socket TX: pack frames with the current link level and send full packets
+  bool send_socket_frame_(const int16_t *frame, size_t samples);
+  // G.711 encode one device-rate frame (samples / 2 bytes)
+  void encode_g711_(const int16_t *frame, size_t samples, PayloadCodec codec, uint8_t *out);
+
+  // Framed packets (negotiated per session when fec, adaptation or encryption is configured)
+  bool framing_enabled_() const {
+    return this->fec_mode_ != FecMode::NONE || this->adaptive_ || this->crypto_.is_enabled() ||
+           this->peer_timeout_ms_ > 0;
+  }
+  bool send_payload_(const uint8_t *payload, size_t len, PayloadCodec codec);
+  bool send_framed_(const wire::PacketHeader &header, const uint8_t *body, size_t len, const uint8_t *extra,
+                    size_t extra_len);
+  void send_hello_(bool ack);
+  // Authenticate a HELLO and (re)key the session; *heard is set when it echoes our nonce
+  bool accept_hello_(const uint8_t *packet, const uint8_t *body, size_t len, bool *heard);
+  void handle_control_(const wire::PacketHeader &header, const uint8_t *body, size_t len);
+  void handle_report_(const wire::Report &report);
+  void update_jitter_(uint16_t seq, size_t len, PayloadCodec codec);
+  // Link ladder: level 0 is the configured codec one frame per packet
+  bool describe_link_level_(uint8_t level, PayloadCodec *codec, uint8_t *frames) const;
+  void apply_link_level_();
+  void service_session_();
+  void check_peer_alive_(uint32_t now);
+  void reset_session_();
+  void finish_call_quality_();
+  // True when a soak build should fail this event; always false otherwise
+  bool inject_fault_(Fault fault) {
+#ifdef USE_INTERCOM_FAULT_INJECTION
+    return this->faults_.inject(fault);
+#else
+    return false;
+#endif
+  }
+
+  // Event-driven task wakeups: eventfd + RX socket readiness
+  void wake_task_();
+  void wait_for_events_(uint32_t timeout_ms);
+
+  // Encode one device-rate frame with tx_codec_ and send it
+  bool send_frame_(const int16_t *frame, size_t samples);
+  // Where the next outgoing PCM frame should be built (a netbuf payload when possible)
+  int16_t *begin_tx_frame_(int16_t *scratch);
+  // The frame from begin_tx_frame_() will not be sent
+  void abort_tx_frame_();
+
+  // RX jitter buffer access common to both transports
+  size_t rx_available_() const;
+  // Bytes the speaker can take right now without waiting
+  size_t sink_space_() const;
+  // Hand played bytes to the speaker (and AEC reference) without waiting; returns bytes accepted
+  size_t play_(const uint8_t *data, size_t len);
+  // Fold this pass's blocked_us_ into the loop_blocked statistics
+  void record_blocked_();
+  // The values the audio task updates in a pass, for collect_metrics()
+  void collect_task_metrics_(MetricsSnapshot &m) const;
+
+  // Write one frame to the recording ring and time it
+  void tap_recorder_(const int16_t *frame, size_t samples);
+  // Trace records (audio task); a single atomic load when tracing is off
+  void trace_frame_(TraceKind kind, uint8_t flags, const int16_t *samples, size_t count);
+  void trace_event_(TraceEvent event, uint32_t value);
+  void trace_record_(TraceRecordHeader &header, const int16_t *samples);
+
+  void count_copy_(size_t bytes) {
+    this->copies_.fetch_add(1, std::memory_order_relaxed);
+    this->bytes_moved_.fetch_add(bytes, std::memory_order_relaxed);
+  }
 
   // Components
 #ifdef USE_I2S_AUDIO_DUPLEX
@@ -186,6 +525,9 @@ class IntercomAudio : public Component {
   speaker::Speaker *speaker_{nullptr};
 #endif
   esp_aec::EspAec *aec_{nullptr};
+#ifdef USE_MDNS_DISCOVERY
+  mdns_discovery::MdnsDiscovery *discovery_{nullptr};
+#endif
 
   // Network config
   uint16_t listen_port_{12346};
@@ -194,16 +536,82 @@ class IntercomAudio : public Component {
   optional<std::function<std::string()>> remote_ip_lambda_;
   optional<std::function<uint16_t()>> remote_port_lambda_;
 
+  // Payload codecs
+  PayloadCodec tx_codec_{PayloadCodec::PCM16};
+  PayloadCodec rx_codec_{PayloadCodec::PCM16};
+
+  // G.711 scratch and resampler state (audio task only, reset every session)
+  uint8_t *tx_pack_buf_{nullptr};  // Socket TX payload: G.711 and/or several packed frames
+  int16_t *tx_narrow_buf_{nullptr};
+  uint8_t *rx_packet_{nullptr};  // Socket RX datagram (header + payload + redundancy)
+  uint8_t *tx_crypt_buf_{nullptr};  // Socket TX datagram being sealed (encryption only)
+  int16_t *rx_narrow_buf_{nullptr};
+  Downsampler2x tx_resampler_;
+  Upsampler2x rx_resampler_;
+
+  // FEC config and per-session state (audio task only)
+  FecMode fec_mode_{FecMode::NONE};
+  uint8_t fec_group_size_{4};
+  uint16_t fec_loss_threshold_permille_{10};
+  FecEncoder fec_tx_;
+  FecDecoder fec_rx_;
+  CallQuality call_quality_;  // Audio task only
+  bool peer_framed_{false};    // Peer sent HELLO: it parses framed packets
+  bool peer_heard_us_{false};  // Peer has our HELLO: it sends framed packets
+  uint8_t peer_caps_{0};
+  uint8_t hellos_sent_{0};
+  uint32_t last_hello_ms_{0};
+  uint32_t last_report_ms_{0};
+  uint32_t peer_report_ts_{0};        // Timestamp of the peer's last report, echoed back
+  uint32_t peer_report_rx_ms_{0};     // When we received it
+  uint32_t rtt_min_ms_{RTT_UNKNOWN};  // Session minimum, the uncongested baseline
+  uint16_t report_seq_{0};            // Reports carry a sequence number for the replay window
+  uint16_t keepalive_seq_{0};
+  uint32_t last_tx_ms_{0};       // Last framed packet sent
+  uint32_t last_peer_rx_ms_{0};  // Last framed packet from the peer that checked out
+
+  // Peer loss detection: config, and flags the task raises for loop()
+  uint32_t peer_timeout_ms_{0};  // 0 = off
+  bool stop_on_peer_lost_{false};
+  std::atomic<bool> peer_lost_{false};
+  std::atomic<bool> peer_lost_pending_{false};
+
+  // Encryption state (audio task only)
+  StreamCrypto crypto_;
+  uint32_t last_auth_ms_{0};  // Last packet that authenticated with the session keys
+
+  // Interarrival jitter (RFC 3550, x16) over consecutive audio packets
+  uint32_t jitter_q4_us_{0};
+  int64_t last_rx_arrival_us_{0};
+  uint32_t last_rx_duration_us_{0};
+  uint16_t last_rx_seq_{0};
+  bool have_last_rx_{false};
+
+  // Link adaptation config and state (audio task only)
+  uint8_t packet_frames_{1};
+  bool adaptive_{false};
+  uint8_t max_packet_frames_{2};
+  PayloadCodec codec_fallback_{PayloadCodec::PCM16};  // PCM16 = no fallback
+  uint8_t link_level_target_{0};
+  uint8_t link_level_{0};
+  uint8_t clear_reports_{0};
+  PayloadCodec tx_codec_active_{PayloadCodec::PCM16};
+  uint8_t tx_frames_{1};
+  uint8_t tx_pack_count_{0};
+  size_t tx_pack_len_{0};
+
   // Buffer config
   size_t buffer_size_{8192};
   size_t prebuffer_size_{2048};
+  uint32_t latency_target_ms_{0};  // 0: none configured
 
   // Mic gain for 32->16 bit conversion
   int mic_gain_{4};
 
   // DC offset removal for mics with significant DC bias
   bool dc_offset_removal_{false};
-  int64_t dc_sum_{0};  // Running sum for IIR-based DC offset removal
+  // 32-bit mic samples -> int16: DC removal and gain at full width, one dithered rounding
+  MicConverter mic_converter_;
 
   // Core state: just two atomics
   std::atomic<bool> streaming_{false};       // True = actively streaming
@@ -215,11 +623,38 @@ class IntercomAudio : public Component {
   // Separate mutexes to reduce contention
   SemaphoreHandle_t mic_mutex_{nullptr};  // Protects mic_input_buffer_
   SemaphoreHandle_t ref_mutex_{nullptr};  // Protects speaker_ref_buffer_
+  SemaphoreHandle_t task_idle_{nullptr};  // Given by the audio task each time it goes idle
+  // A pass is a few ms; the task missing this is wedged, not slow
+  static const uint32_t STOP_ACK_TIMEOUT_MS = 200;
 
   // Sockets
   int rx_socket_{-1};
   int tx_socket_{-1};
+  int wake_fd_{-1};  // eventfd signalled by mic frames and start/stop
+  TransportType transport_{TransportType::SOCKET};
+  NetconnTransport netconn_;
   struct sockaddr_in remote_addr_{};
+  uint8_t ip_tos_{0};
+  WifiCallProfile wifi_profile_;
+  IdlePowerMode idle_power_;
+
+  // Recording (written by the mic callback between calls, the audio task during them)
+  AudioRecorder recorder_;
+  bool record_calls_{false};
+#ifdef USE_INTERCOM_WEB_EXPORT
+  RecordingExport *recording_export_{nullptr};
+#endif
+
+  // Trace (written by the audio task only)
+  AudioTrace trace_;
+  uint32_t trace_duration_ms_{0};
+  uint32_t trace_seq_{0};  // TX frames this session
+  uint32_t play_seq_{0};   // play_() calls this session
+  uint32_t rx_seq_{0};     // Frames received this session
+#ifdef USE_INTERCOM_WEB_EXPORT
+  TraceExport *trace_export_{nullptr};
+  MetricsExport *metrics_export_{nullptr};
+#endif
 
   // Ring buffers
   std::unique_ptr<RingBuffer> rx_buffer_;        // UDP RX -> speaker
@@ -229,11 +664,25 @@ class IntercomAudio : public Component {
   bool aec_enabled_{false};
 
   // Mic data conversion buffer (pre-allocated in setup)
-  std::vector<int16_t> mic_convert_buf_;
+  // Mic callbacks -> exact frames (producer side, mic task only)
+  MicIngest mic_ingest_;
+  uint32_t ingest_session_{0};
+  int16_t *mic_frame_{nullptr};  // Converted frame (non-16-bit mics)
+  int32_t *mic_wide_{nullptr};   // 24-bit samples widened for the converter
+  // Capture time (esp_timer, low 32 bits) of each frame in mic_input_buffer_,
+  // under mic_mutex_ like the buffer itself
+  uint32_t *capture_times_{nullptr};
+  uint32_t capture_times_mask_{0};
+  uint32_t capture_times_head_{0};
+  uint32_t capture_times_tail_{0};
 
   // Frame buffers (allocated once in setup)
   int16_t *rx_frame_{nullptr};
   int16_t *tx_frame_{nullptr};
+  // Socket transport: tail of rx_frame_ the speaker has not taken yet (audio task only)
+  size_t rx_held_bytes_{0};
+  // Time this audio task pass spent waiting on the speaker and buffer locks
+  uint32_t blocked_us_{0};
 
   // AEC frame buffers
 #ifdef USE_ESP_AEC
@@ -248,10 +697,68 @@ class IntercomAudio : public Component {
   std::atomic<uint32_t> tx_drops_{0};
   std::atomic<uint32_t> rx_drops_{0};
   std::atomic<size_t> rx_fill_{0};
+  std::atomic<uint32_t> copies_{0};
+  std::atomic<uint32_t> bytes_moved_{0};
+  std::atomic<uint32_t> fec_overhead_bytes_{0};  // Headers, redundant copies and parity sent
+  std::atomic<uint32_t> fec_cpu_us_{0};          // Encode, reorder and recovery time
+  std::atomic<uint32_t> send_cpu_us_{0};
+  std::atomic<uint32_t> send_latency_q4_us_{0};  // Audio task writes, sensors read
+  std::atomic<uint32_t> seal_cycles_q4_{0};
+  std::atomic<uint32_t> open_cycles_q4_{0};
+  std::atomic<uint32_t> crypto_rejected_{0};
+  std::atomic<uint32_t> task_wakeups_{0};
+  std::atomic<uint32_t> guard_wakeups_{0};
+  std::atomic<uint32_t> socket_wakeups_{0};
+  std::atomic<uint32_t> tap_cycles_q4_{0};
+  std::atomic<uint32_t> trace_cycles_q4_{0};
+  std::atomic<uint32_t> convert_cycles_q4_{0};
+  std::atomic<uint32_t> mic_misaligned_{0};
+  std::atomic<uint32_t> capture_latency_q4_us_{0};
+  std::atomic<uint32_t> loop_blocked_q4_us_{0};
+  std::atomic<uint32_t> loop_blocked_max_us_{0};
+  std::atomic<uint32_t> playout_deferred_{0};
+  std::atomic<uint16_t> loss_permille_{0};
+  static const uint32_t RTT_UNKNOWN = UINT32_MAX;
+  std::atomic<uint32_t> rtt_ms_{RTT_UNKNOWN};
+  std::atomic<uint16_t> jitter_100us_{0};
+  std::atomic<uint16_t> peer_loss_permille_{0};
+  std::atomic<uint16_t> peer_jitter_100us_{0};
+  std::atomic<uint16_t> peer_depth_ms_{0};
+  static const int16_t QUALITY_UNKNOWN = INT16_MIN;
+  std::atomic<uint16_t> call_mos_x100_{0};
+  std::atomic<int16_t> call_r_x10_{QUALITY_UNKNOWN};
+  std::atomic<uint16_t> last_call_mos_avg_x100_{0};
+  std::atomic<uint16_t> last_call_mos_worst_x100_{0};
+  std::atomic<uint32_t> calls_rated_{0};
+  // Latency histograms for the metrics export (since boot, not reset per call)
+  LatencyHistogram send_histogram_;
+  LatencyHistogram capture_histogram_;
+  LatencyHistogram blocked_histogram_;
+  LatencyHistogram transit_histogram_;
+  LatencyHistogram rtt_histogram_;
+  // Odd while the audio task is in a pass; a scrape retries its copy until
+  // it falls between two passes (mic callback and stop() values excepted)
+  PassSequence pass_seq_;
+  static const int METRICS_COPY_TRIES = 8;
+  // Start/stop health for soak runs (since boot)
+  LatencyHistogram stop_histogram_;
+  std::atomic<uint32_t> starts_{0};
+  std::atomic<uint32_t> stale_mic_frames_{0};   // Captured for a session that had already ended
+  std::atomic<uint32_t> heap_after_stop_{0};    // Internal heap free once stop() finished
+  std::atomic<uint32_t> stop_ack_timeouts_{0};  // stop() went on without the audio task's answer
+#ifdef USE_INTERCOM_FAULT_INJECTION
+  FaultInjector faults_;
+#endif
+  // Link state for get_link_state()
+  std::atomic<bool> link_framed_{false};
+  std::atomic<uint8_t> link_codec_{0};
+  std::atomic<uint8_t> link_frames_{1};
+  std::atomic<bool> link_fec_{false};
 
   // Automations
   Trigger<> start_trigger_;
   Trigger<> stop_trigger_;
+  Trigger<> peer_lost_trigger_;
 };
 
 // Actions
@@ -282,6 +789,18 @@ class StopAction : public Action<Ts...>, public Parented<IntercomAudio> {
   void play(Ts... x) override { this->parent_->stop(); }
 };
 
+template<typename... Ts>
+class RecordingStartAction : public Action<Ts...>, public Parented<IntercomAudio> {
+ public:
+  void play(Ts... x) override { this->parent_->start_recording(); }
+};
+
+template<typename... Ts>
+class RecordingStopAction : public Action<Ts...>, public Parented<IntercomAudio> {
+ public:
+  void play(Ts... x) override { this->parent_->stop_recording(); }
+};
+
 template<typename... Ts>
 class ResetCountersAction : public Action<Ts...>, public Parented<IntercomAudio> {
  public:
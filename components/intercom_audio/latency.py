@@ -0,0 +1,183 @@
+"""Mouth-to-ear latency budget of an intercom_audio configuration.
+
+Covers one direction of a call: the far end captures and sends, this device
+plays. Both ends are assumed to run the same configuration. Each stage has an
+expected value (steady state) and a worst case (every queue on the way full).
+
+No ESPHome imports, so the numbers can be checked from a plain Python shell.
+"""
+
+from dataclasses import dataclass, field
+
+# One-way Wi-Fi LAN delay. Jitter beyond it is what the jitter buffer absorbs,
+# so the network stage itself is the same in both columns.
+NETWORK_MS = 5.0
+
+# Share of the target the playback DMA ring may take when latency_target sizes it
+PLAYBACK_DMA_SHARE = 0.25
+MIN_DMA_BUFFERS = 2
+MAX_DMA_BUFFERS = 8
+# Shortest DMA descriptor latency_target picks (samples), and the descriptor size limit
+MIN_DMA_BUFFER_SIZE = 32
+DMA_BUFFER_MAX_BYTES = 4092
+# Speaker buffer picked by latency_target, in frames. Playout never waits on it,
+# so it only needs to cover the gap between two audio task passes.
+SPEAKER_BUFFER_FRAMES = 2
+MIN_SPEAKER_BUFFER_BYTES = 512
+# buffer_size floor (see validate_audio_config)
+MIN_BUFFER_SIZE = 2048
+
+
+@dataclass
+class Stage:
+    name: str
+    expected_ms: float
+    worst_ms: float
+    note: str = ""
+
+
+@dataclass
+class LatencyPlan:
+    stages: list = field(default_factory=list)
+    # Sizes picked by latency_target (None: set in the configuration)
+    prebuffer_size: int = None
+    buffer_size: int = None
+    dma_buffer_count: int = None
+    dma_buffer_size: int = None
+    speaker_buffer_size: int = None
+
+    @property
+    def expected_ms(self):
+        return sum(s.expected_ms for s in self.stages)
+
+    @property
+    def worst_ms(self):
+        return sum(s.worst_ms for s in self.stages)
+
+    def format(self):
+        width = max(len(s.name) for s in self.stages)
+        lines = [f"  {'stage':<{width}}  expected     worst"]
+        for s in self.stages:
+            note = f"  ({s.note})" if s.note else ""
+            lines.append(f"  {s.name:<{width}}  {s.expected_ms:6.1f} ms {s.worst_ms:6.1f} ms{note}")
+        lines.append(f"  {'total':<{width}}  {self.expected_ms:6.1f} ms {self.worst_ms:6.1f} ms")
+        return "\n".join(lines)
+
+
+@dataclass
+class Geometry:
+    """What the planner works from. None on a size means latency_target picks it."""
+
+    sample_rate: int
+    frame_ms: int
+    packet_frames: int = 1
+    fec_hold_packets: int = 0  # Packets a gap may be held for repair; 0: no FEC
+    prebuffer_size: int = None
+    buffer_size: int = None
+    duplex: bool = False
+    dma_buffer_count: int = None
+    dma_buffer_size: int = None
+    dma_frame_bytes: int = 2  # One I2S frame: every captured slot at the capture width
+    speaker_buffer_size: int = None
+    # Separate speaker component: its own buffer (buffer_duration), if known
+    speaker_buffer_ms: float = None
+
+
+def _bytes_to_ms(sample_rate, size):
+    return size * 1000.0 / (sample_rate * 2)
+
+
+def _stages(g, prebuffer, buffer, dma_count, dma_size, speaker_buffer):
+    frame_ms = float(g.frame_ms)
+    stages = [Stage("capture frame", frame_ms, frame_ms, "first sample waits for the frame")]
+    if g.duplex:
+        dma_ms = dma_size * 1000.0 / g.sample_rate
+        stages.append(Stage("capture DMA", dma_ms / 2, dma_count * dma_ms, f"{dma_count} x {dma_size} samples"))
+    else:
+        stages.append(Stage("capture DMA", 0.0, 0.0, "microphone component, not counted"))
+    packet_ms = (g.packet_frames - 1) * frame_ms
+    stages.append(Stage("packetization", packet_ms, packet_ms))
+    stages.append(Stage("network", NETWORK_MS, NETWORK_MS, "LAN allowance"))
+    if g.fec_hold_packets:
+        stages.append(Stage("FEC reorder", 0.0, g.fec_hold_packets * g.packet_frames * frame_ms,
+                            "gap held while its repair can arrive"))
+    # Playout never waits, so the prebuffer ends up split between the jitter
+    # buffer and the speaker buffer; both fill only if the sender runs ahead
+    speaker_ms = _bytes_to_ms(g.sample_rate, speaker_buffer) if g.duplex else (g.speaker_buffer_ms or 0.0)
+    note = "prebuffer" if g.duplex or g.speaker_buffer_ms is not None else "prebuffer; speaker buffer not counted"
+    stages.append(Stage("jitter + speaker buffer", _bytes_to_ms(g.sample_rate, prebuffer),
+                        _bytes_to_ms(g.sample_rate, buffer) + speaker_ms, note))
+    if g.duplex:
+        dma_ms = dma_count * dma_size * 1000.0 / g.sample_rate
+        stages.append(Stage("playback DMA", dma_ms, dma_ms, "kept full"))
+    else:
+        stages.append(Stage("playback DMA", 0.0, 0.0, "speaker component, not counted"))
+    return stages
+
+
+def plan_latency(g, target_ms=None):
+    """Budget for g. With target_ms, sizes left as None are derived to meet it.
+
+    Raises ValueError when the target cannot be met; the message carries the
+    breakdown with the smallest buffering possible.
+    """
+    frame_samples = g.sample_rate * g.frame_ms // 1000
+    frame_bytes = frame_samples * 2
+    plan = LatencyPlan()
+
+    dma_size = g.dma_buffer_size
+    dma_count = g.dma_buffer_count
+    speaker_buffer = g.speaker_buffer_size
+    prebuffer = g.prebuffer_size
+    buffer = g.buffer_size
+
+    if target_ms is None:
+        dma_size = min(512 if dma_size is None else dma_size, DMA_BUFFER_MAX_BYTES // g.dma_frame_bytes)
+        dma_count = 8 if dma_count is None else dma_count
+        speaker_buffer = 8192 if speaker_buffer is None else speaker_buffer
+        prebuffer = 2048 if prebuffer is None else prebuffer
+        buffer = 8192 if buffer is None else buffer
+        plan.stages = _stages(g, prebuffer, buffer, dma_count, dma_size, speaker_buffer)
+        return plan
+
+    if g.duplex:
+        if dma_size is not None:
+            dma_size = min(dma_size, DMA_BUFFER_MAX_BYTES // g.dma_frame_bytes)
+        if dma_size is None:
+            # Half a frame: the capture read returns soon after a frame completes
+            dma_size = plan.dma_buffer_size = min(max(MIN_DMA_BUFFER_SIZE, frame_samples // 2),
+                                                  DMA_BUFFER_MAX_BYTES // g.dma_frame_bytes)
+        if dma_count is None:
+            dma_ms = dma_size * 1000.0 / g.sample_rate
+            count = int(target_ms * PLAYBACK_DMA_SHARE // dma_ms)
+            dma_count = plan.dma_buffer_count = min(MAX_DMA_BUFFERS, max(MIN_DMA_BUFFERS, count))
+        if speaker_buffer is None:
+            speaker_buffer = plan.speaker_buffer_size = max(MIN_SPEAKER_BUFFER_BYTES,
+                                                            SPEAKER_BUFFER_FRAMES * frame_bytes)
+
+    if prebuffer is None:
+        # Whatever the fixed stages leave, in whole frames, at least one
+        fixed = _stages(g, 0, 0, dma_count or 0, dma_size or 0, speaker_buffer or 0)
+        spare_ms = target_ms - sum(s.expected_ms for s in fixed)
+        frames = int(spare_ms // g.frame_ms)
+        if frames < 1:
+            plan.stages = _stages(g, frame_bytes, max(MIN_BUFFER_SIZE, 2 * frame_bytes), dma_count or 0,
+                                  dma_size or 0, speaker_buffer or 0)
+            raise ValueError(_unreachable(plan, target_ms))
+        prebuffer = plan.prebuffer_size = frames * frame_bytes
+    if buffer is None:
+        # Room for as much again as the prebuffer before datagrams are dropped
+        buffer = plan.buffer_size = max(MIN_BUFFER_SIZE, 2 * prebuffer, prebuffer + 2 * g.packet_frames * frame_bytes)
+
+    plan.stages = _stages(g, prebuffer, buffer, dma_count or 0, dma_size or 0, speaker_buffer or 0)
+    if plan.expected_ms > target_ms:
+        raise ValueError(_unreachable(plan, target_ms))
+    return plan
+
+
+def _unreachable(plan, target_ms):
+    return (
+        f"latency_target {target_ms}ms cannot be met, expected latency is {plan.expected_ms:.1f}ms:\n"
+        f"{plan.format()}\n"
+        "Use a shorter frame_duration / packet_duration, or leave the buffer sizes to latency_target"
+    )
@@ -0,0 +1,156 @@
+#include "metrics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdarg>
+#include <cstdio>
+
+namespace esphome {
+namespace intercom_audio {
+
+const uint32_t LatencyHistogram::BOUNDS_US[LatencyHistogram::BOUNDS] = {
+    100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000,
+};
+
+void LatencyHistogram::record(uint32_t us) {
+  size_t i = 0;
+  while (i < BOUNDS && us > BOUNDS_US[i]) {
+    i++;
+  }
+  this->buckets_[i].fetch_add(1, std::memory_order_relaxed);
+  this->sum_us_.fetch_add(us, std::memory_order_relaxed);
+}
+
+void LatencyHistogram::read(Counts *out) const {
+  for (size_t i = 0; i < BUCKETS; i++) {
+    out->buckets[i] = this->buckets_[i].load(std::memory_order_relaxed);
+  }
+  out->sum_us = this->sum_us_.load(std::memory_order_relaxed);
+}
+
+void MetricsSnapshot::clear() {
+  this->value_count_ = 0;
+  this->histogram_count_ = 0;
+  this->dropped_ = 0;
+}
+
+void MetricsSnapshot::rewind(const Mark &mark) {
+  this->value_count_ = std::min(this->value_count_, mark.values);
+  this->histogram_count_ = std::min(this->histogram_count_, mark.histograms);
+  this->dropped_ = std::min(this->dropped_, mark.dropped);
+}
+
+void MetricsSnapshot::counter(const char *name, const char *help, double value) {
+  if (this->value_count_ >= MAX_VALUES) {
+    this->dropped_++;
+    return;
+  }
+  this->values_[this->value_count_++] = {name, help, Type::COUNTER, value};
+}
+
+void MetricsSnapshot::gauge(const char *name, const char *help, double value) {
+  if (this->value_count_ >= MAX_VALUES) {
+    this->dropped_++;
+    return;
+  }
+  this->values_[this->value_count_++] = {name, help, Type::GAUGE, value};
+}
+
+void MetricsSnapshot::histogram(const char *name, const char *help, const LatencyHistogram &histogram) {
+  if (this->histogram_count_ >= MAX_HISTOGRAMS) {
+    this->dropped_++;
+    return;
+  }
+  Histogram &h = this->histograms_[this->histogram_count_++];
+  h.name = name;
+  h.help = help;
+  histogram.read(&h.counts);
+}
+
+namespace {
+
+// Lines go into the buffer until the next one might not fit, then out to the sink
+class LineWriter {
+ public:
+  LineWriter(char *buf, size_t size, const MetricsSnapshot::Sink &sink) : buf_(buf), size_(size), sink_(sink) {}
+
+  void line(const char *fmt, ...) __attribute__((format(printf, 2, 3))) {
+    if (!this->ok_) {
+      return;
+    }
+    if (this->size_ - this->used_ < MetricsSnapshot::LINE_BYTES && !this->flush()) {
+      return;
+    }
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(this->buf_ + this->used_, MetricsSnapshot::LINE_BYTES, fmt, args);
+    va_end(args);
+    if (n > 0) {
+      this->used_ += std::min<size_t>(n, MetricsSnapshot::LINE_BYTES - 1);
+    }
+  }
+
+  bool flush() {
+    if (this->ok_ && this->used_ > 0) {
+      this->ok_ = this->sink_(this->buf_, this->used_);
+    }
+    this->used_ = 0;
+    return this->ok_;
+  }
+
+ protected:
+  char *buf_;
+  size_t size_;
+  size_t used_{0};
+  const MetricsSnapshot::Sink &sink_;
+  bool ok_{true};
+};
+
+// Prometheus spells the special values its own way
+void format_value(double value, char *out, size_t size) {
+  if (std::isnan(value)) {
+    snprintf(out, size, "NaN");
+  } else if (std::isinf(value)) {
+    snprintf(out, size, value > 0 ? "+Inf" : "-Inf");
+  } else {
+    snprintf(out, size, "%.15g", value);
+  }
+}
+
+}  // namespace
+
+bool MetricsSnapshot::write(char *buf, size_t size, const Sink &sink) const {
+  if (size <= LINE_BYTES) {
+    return false;
+  }
+  LineWriter out(buf, size, sink);
+  char value[32];
+  for (size_t i = 0; i < this->value_count_; i++) {
+    const Value &v = this->values_[i];
+    format_value(v.value, value, sizeof(value));
+    out.line("# HELP %s %s\n", v.name, v.help);
+    out.line("# TYPE %s %s\n", v.name, v.type == Type::COUNTER ? "counter" : "gauge");
+    out.line("%s %s\n", v.name, value);
+  }
+  for (size_t i = 0; i < this->histogram_count_; i++) {
+    const Histogram &h = this->histograms_[i];
+    out.line("# HELP %s %s\n", h.name, h.help);
+    out.line("# TYPE %s histogram\n", h.name);
+    uint64_t cumulative = 0;
+    for (size_t b = 0; b < LatencyHistogram::BUCKETS; b++) {
+      cumulative += h.counts.buckets[b];
+      if (b < LatencyHistogram::BOUNDS) {
+        out.line("%s_bucket{le=\"%g\"} %llu\n", h.name, LatencyHistogram::BOUNDS_US[b] / 1e6,
+                 (unsigned long long) cumulative);
+      } else {
+        out.line("%s_bucket{le=\"+Inf\"} %llu\n", h.name, (unsigned long long) cumulative);
+      }
+    }
+    out.line("%s_sum %.6f\n", h.name, h.counts.sum_us / 1e6);
+    out.line("%s_count %llu\n", h.name, (unsigned long long) cumulative);
+  }
+  return out.flush();
+}
+
+}  // namespace intercom_audio
+}  // namespace esphome
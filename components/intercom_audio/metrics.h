@@ -0,0 +1,140 @@
+#pragma once
+
+// Counters and latency histograms in the Prometheus text exposition format
+// (version 0.0.4). Histograms have fixed buckets the audio tasks fill with
+// relaxed atomics. A scrape first copies every value into a snapshot and only
+// formats afterwards, so a slow client cannot skew the output. The copy itself
+// is one instant only per PassSequence group; values other tasks write are read
+// one by one. No ESPHome dependencies so it can be built and checked on the host.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace esphome {
+namespace intercom_audio {
+
+class LatencyHistogram {
+ public:
+  // Upper bounds of every bucket but the last (+Inf), 100 µs to 250 ms
+  static const size_t BOUNDS = 11;
+  static const uint32_t BOUNDS_US[BOUNDS];
+  static const size_t BUCKETS = BOUNDS + 1;
+
+  struct Counts {
+    uint32_t buckets[BUCKETS];  // Per bucket, not cumulative
+    uint64_t sum_us;
+  };
+
+  // Any task; never reset, so a scraper sees counters that only grow
+  void record(uint32_t us);
+  void read(Counts *out) const;
+
+ protected:
+  std::atomic<uint32_t> buckets_[BUCKETS]{};
+  std::atomic<uint64_t> sum_us_{0};
+};
+
+// Sequence lock over the values one task updates in a pass. The task never
+// waits for a reader; a reader that overlapped a pass discards its copy and
+// takes it again. Only the owning task may begin passes.
+class PassSequence {
+ public:
+  // Owning task: a pass in scope, paused around calls that block
+  class Pass {
+   public:
+    explicit Pass(PassSequence &seq) : seq_(seq) { this->resume(); }
+    ~Pass() { this->pause(); }
+    Pass(const Pass &) = delete;
+    Pass &operator=(const Pass &) = delete;
+    void pause() {
+      if (this->running_) {
+        this->seq_.end();
+        this->running_ = false;
+      }
+    }
+    void resume() {
+      if (!this->running_) {
+        this->seq_.begin();
+        this->running_ = true;
+      }
+    }
+
+   protected:
+    PassSequence &seq_;
+    bool running_{false};
+  };
+
+  // Any task: copy the group between read_begin() and read_end(); the copy
+  // is from between two passes only if read_end() returns true
+  uint32_t read_begin() const { return this->seq_.load(std::memory_order_acquire); }
+  bool read_end(uint32_t seq) const {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return (seq & 1) == 0 && this->seq_.load(std::memory_order_relaxed) == seq;
+  }
+
+ protected:
+  // Odd while a pass runs
+  void begin() {
+    this->seq_.store(this->seq_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+  }
+  void end() { this->seq_.store(this->seq_.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+  std::atomic<uint32_t> seq_{0};
+};
+
+class MetricsSnapshot {
+ public:
+  static const size_t MAX_VALUES = 80;
+  static const size_t MAX_HISTOGRAMS = 8;
+  // Longest line written; write() needs a buffer larger than this
+  static const size_t LINE_BYTES = 160;
+
+  // Takes one piece of the output; false once the client is gone
+  using Sink = std::function<bool(const char *data, size_t len)>;
+
+  void clear();
+  // Names and help texts must outlive the snapshot (string literals). Values
+  // past the capacity are left out and counted in get_dropped().
+  void counter(const char *name, const char *help, double value);
+  void gauge(const char *name, const char *help, double value);
+  void histogram(const char *name, const char *help, const LatencyHistogram &histogram);
+  size_t get_dropped() const { return this->dropped_; }
+
+  // Where the snapshot stands, to take back a group whose copy has to be retried
+  struct Mark {
+    size_t values;
+    size_t histograms;
+    size_t dropped;
+  };
+  Mark mark() const { return {this->value_count_, this->histogram_count_, this->dropped_}; }
+  void rewind(const Mark &mark);
+
+  // Formats into buf and hands it to sink each time it fills; false if the sink failed
+  bool write(char *buf, size_t size, const Sink &sink) const;
+
+ protected:
+  enum class Type : uint8_t { COUNTER, GAUGE };
+  struct Value {
+    const char *name;
+    const char *help;
+    Type type;
+    double value;
+  };
+  struct Histogram {
+    const char *name;
+    const char *help;
+    LatencyHistogram::Counts counts;
+  };
+
+  Value values_[MAX_VALUES];
+  size_t value_count_{0};
+  Histogram histograms_[MAX_HISTOGRAMS];
+  size_t histogram_count_{0};
+  size_t dropped_{0};
+};
+
+}  // namespace intercom_audio
+}  // namespace esphome
@@ -0,0 +1,36 @@
+#include "mic_convert.h"
+
+namespace esphome {
+namespace intercom_audio {
+
+static const int DC_SHIFT = 13;
+
+void MicConverter::process(const int32_t *in, int16_t *out, size_t samples) {
+  int64_t dc_acc = this->dc_acc_;
+  uint32_t state = this->dither_state_;
+  const int64_t gain = this->gain_;
+  for (size_t i = 0; i < samples; i++) {
+    int64_t sample = in[i];
+    if (this->dc_removal_) {
+      dc_acc += sample - (dc_acc >> DC_SHIFT);
+      sample -= dc_acc >> DC_SHIFT;
+    }
+    sample *= gain;
+
+    // TPDF dither of +-1 output LSB (two uniform 16-bit values), then round
+    // to the top 16 bits. xorshift32 is plenty for dither.
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    int64_t dither = (int64_t) (state & 0xFFFF) + (int64_t) (state >> 16) - 0xFFFF;
+    int64_t rounded = (sample + dither + 0x8000) >> 16;
+    if (rounded > 32767) rounded = 32767;
+    if (rounded < -32768) rounded = -32768;
+    out[i] = (int16_t) rounded;
+  }
+  this->dc_acc_ = dc_acc;
+  this->dither_state_ = state;
+}
+
+}  // namespace intercom_audio
+}  // namespace esphome
@@ -0,0 +1,34 @@
+#pragma once
+
+// 32-bit microphone samples (24-bit I2S mics left-justified in 32-bit slots)
+// to the int16 wire format in one step: DC removal and gain run on the full
+// width sample and the only loss of precision is a single TPDF-dithered
+// rounding at the end, so quiet talkers keep their low bits.
+// No ESPHome dependencies so it can be built and checked on the host.
+
+#include <cstddef>
+#include <cstdint>
+
+namespace esphome {
+namespace intercom_audio {
+
+class MicConverter {
+ public:
+  void set_dc_removal(bool enabled) { this->dc_removal_ = enabled; }
+  // Linear gain applied before rounding (the intercom mic_gain multiplier)
+  void set_gain(int32_t gain) { this->gain_ = gain; }
+  // Forget the DC estimate (new session)
+  void reset() { this->dc_acc_ = 0; }
+
+  void process(const int32_t *in, int16_t *out, size_t samples);
+
+ protected:
+  bool dc_removal_{false};
+  int32_t gain_{1};
+  // DC estimate scaled by 2^DC_SHIFT (one-pole, ~0.3 s at 16 kHz)
+  int64_t dc_acc_{0};
+  uint32_t dither_state_{0x12345678};
+};
+
+}  // namespace intercom_audio
+}  // namespace esphome
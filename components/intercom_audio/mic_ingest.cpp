@@ -0,0 +1,98 @@
+#include "mic_ingest.h"
+
+#ifdef USE_ESP32
+#include <esp_heap_caps.h>
+#else
+#include <cstdlib>
+#endif
+
+#include <cstring>
+
+namespace esphome {
+namespace intercom_audio {
+
+bool MicIngest::allocate(size_t frame_samples, uint32_t sample_rate) {
+  if (this->partial_ != nullptr) {
+    return true;
+  }
+  this->frame_samples_ = frame_samples;
+  this->sample_rate_ = sample_rate;
+  size_t bytes = frame_samples * MAX_SAMPLE_BYTES;
+#ifdef USE_ESP32
+  this->partial_ = (uint8_t *) heap_caps_malloc(bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+#else
+  this->partial_ = (uint8_t *) malloc(bytes);
+#endif
+  return this->partial_ != nullptr;
+}
+
+void MicIngest::set_sample_bytes(uint8_t bytes) {
+  if (bytes == this->sample_bytes_ || bytes < 2 || bytes > MAX_SAMPLE_BYTES) {
+    return;
+  }
+  this->misaligned_bytes_ += this->partial_fill_;
+  this->partial_fill_ = 0;
+  this->sample_bytes_ = bytes;
+}
+
+void MicIngest::reset() {
+  this->partial_fill_ = 0;
+  this->chunk_left_ = 0;
+}
+
+void MicIngest::push(const uint8_t *data, size_t len, int64_t now_us) {
+  // Drivers deliver whole samples; a chunk that ends mid-sample is cut back to
+  // the last whole one so the next chunk starts aligned again
+  size_t tail = len % this->sample_bytes_;
+  this->misaligned_bytes_ += tail;
+  len -= tail;
+
+  size_t samples = len / this->sample_bytes_;
+  this->chunk_ = data;
+  this->chunk_left_ = len;
+  this->chunk_pos_ = 0;
+  this->chunk_start_us_ = now_us - (int64_t) samples * 1000000 / this->sample_rate_;
+}
+
+bool MicIngest::pop(Frame *frame) {
+  if (this->partial_ == nullptr || this->chunk_left_ == 0) {
+    return false;
+  }
+  const size_t frame_bytes = this->frame_bytes_();
+  int64_t capture_us = this->chunk_start_us_ + (int64_t) this->chunk_pos_ * 1000000 / this->sample_rate_;
+
+  // Whole frame inside the chunk: hand it out in place
+  if (this->partial_fill_ == 0 && this->chunk_left_ >= frame_bytes) {
+    frame->data = this->chunk_;
+    frame->capture_us = capture_us;
+    this->chunk_ += frame_bytes;
+    this->chunk_left_ -= frame_bytes;
+    this->chunk_pos_ += this->frame_samples_;
+    return true;
+  }
+
+  // Otherwise assemble it across chunks
+  if (this->partial_fill_ == 0) {
+    this->partial_capture_us_ = capture_us;
+  }
+  size_t take = frame_bytes - this->partial_fill_;
+  if (take > this->chunk_left_) {
+    take = this->chunk_left_;
+  }
+  memcpy(this->partial_ + this->partial_fill_, this->chunk_, take);
+  this->partial_fill_ += take;
+  this->chunk_ += take;
+  this->chunk_left_ -= take;
+  this->chunk_pos_ += take / this->sample_bytes_;
+  if (this->partial_fill_ < frame_bytes) {
+    return false;
+  }
+  frame->data = this->partial_;
+  frame->capture_us = this->partial_capture_us_;
+  this->partial_fill_ = 0;
+  this->assembled_frames_++;
+  return true;
+}
+
+}  // namespace intercom_audio
+}  // namespace esphome
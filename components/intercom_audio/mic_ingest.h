@@ -0,0 +1,67 @@
+#pragma once
+
+// Turns microphone callbacks of any size into exact frames. Chunks are
+// consumed in place when they hold whole frames; only a frame split across
+// callbacks is assembled in a preallocated buffer. Each frame is tagged with
+// the capture time of its first sample, estimated from the callback time and
+// the audio still ahead of it in the chunk.
+// No ESPHome dependencies so it can be built and checked on the host.
+
+#include <cstddef>
+#include <cstdint>
+
+namespace esphome {
+namespace intercom_audio {
+
+class MicIngest {
+ public:
+  static const uint8_t MAX_SAMPLE_BYTES = 4;
+
+  struct Frame {
+    const uint8_t *data;  // frame_samples * sample_bytes, valid until the next pop()/push()
+    int64_t capture_us;
+  };
+
+  // Accumulator for one frame of the widest samples
+  bool allocate(size_t frame_samples, uint32_t sample_rate);
+  bool is_allocated() const { return this->partial_ != nullptr; }
+
+  // 2, 3 or 4 bytes per sample; a change drops the partial frame (counted as misaligned)
+  void set_sample_bytes(uint8_t bytes);
+  uint8_t get_sample_bytes() const { return this->sample_bytes_; }
+  // New session: forget the partial frame
+  void reset();
+
+  // Hand over a callback chunk received at now_us, then pop() until it returns false
+  void push(const uint8_t *data, size_t len, int64_t now_us);
+  bool pop(Frame *frame);
+
+  // Bytes dropped to stay on sample boundaries: the tail of a chunk that ends
+  // mid-sample, and partial frames lost to a width change
+  uint32_t get_misaligned_bytes() const { return this->misaligned_bytes_; }
+  // Frames that were assembled from more than one chunk (had to be copied)
+  uint32_t get_assembled_frames() const { return this->assembled_frames_; }
+
+ protected:
+  size_t frame_bytes_() const { return this->frame_samples_ * this->sample_bytes_; }
+
+  size_t frame_samples_{0};
+  uint32_t sample_rate_{16000};
+  uint8_t sample_bytes_{2};
+
+  uint8_t *partial_{nullptr};
+  size_t partial_fill_{0};
+  int64_t partial_capture_us_{0};
+
+  // Current chunk
+  const uint8_t *chunk_{nullptr};
+  size_t chunk_left_{0};
+  int64_t chunk_start_us_{0};  // Capture time of the chunk's first sample
+  size_t chunk_pos_{0};        // Samples already consumed from it
+
+  uint32_t misaligned_bytes_{0};
+  uint32_t assembled_frames_{0};
+};
+
+}  // namespace intercom_audio
+}  // namespace esphome
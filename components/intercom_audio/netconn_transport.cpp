@@ -0,0 +1,141 @@
+#include "netconn_transport.h"
+
+#ifdef USE_ESP32
+
+#include "esphome/core/log.h"
+
+#include <lwip/udp.h>
+
+namespace esphome {
+namespace intercom_audio {
+
+static const char *const TAG = "intercom_audio.netconn";
+
+NetconnTransport *NetconnTransport::active_ = nullptr;
+
+bool NetconnTransport::open(uint16_t listen_port, const char *remote_ip, uint16_t remote_port,
+                            size_t max_queued_bytes, WakeCallback wake, void *wake_arg, uint8_t tos) {
+  this->close();
+
+  if (!ipaddr_aton(remote_ip, &this->remote_addr_)) {
+    ESP_LOGE(TAG, "Invalid remote IP: %s", remote_ip);
+    return false;
+  }
+  this->remote_port_ = remote_port;
+  this->max_queued_bytes_ = max_queued_bytes;
+  this->wake_ = wake;
+  this->wake_arg_ = wake_arg;
+
+  active_ = this;
+  this->conn_ = netconn_new_with_callback(NETCONN_UDP, netconn_event);
+  if (this->conn_ == nullptr) {
+    ESP_LOGE(TAG, "Failed to create netconn");
+    active_ = nullptr;
+    return false;
+  }
+  err_t err = netconn_bind(this->conn_, IP_ADDR_ANY, listen_port);
+  if (err != ERR_OK) {
+    ESP_LOGE(TAG, "Failed to bind: %d", err);
+    this->close();
+    return false;
+  }
+  netconn_set_nonblocking(this->conn_, 1);
+  // No netconn call for this; the pcb is not in use by the tcpip thread yet
+  this->conn_->pcb.udp->tos = tos;
+
+  ESP_LOGD(TAG, "Netconn ready: RX :%d, TX %s:%d", listen_port, remote_ip, remote_port);
+  return true;
+}
+
+void NetconnTransport::close() {
+  this->abort_tx();
+  while (this->count_ > 0) {
+    this->pop_();
+  }
+  this->queued_bytes_ = 0;
+  if (this->conn_ != nullptr) {
+    active_ = nullptr;
+    netconn_delete(this->conn_);
+    this->conn_ = nullptr;
+  }
+}
+
+void NetconnTransport::netconn_event(struct netconn *conn, enum netconn_evt evt, u16_t len) {
+  // Runs in the tcpip thread: just wake the audio task
+  NetconnTransport *self = active_;
+  if (evt == NETCONN_EVT_RCVPLUS && self != nullptr && self->conn_ == conn && self->wake_ != nullptr) {
+    self->wake_(self->wake_arg_);
+  }
+}
+
+size_t NetconnTransport::receive(uint32_t *dropped) {
+  if (this->conn_ == nullptr) {
+    return 0;
+  }
+
+  size_t received = 0;
+  struct netbuf *buf = nullptr;
+  while (netconn_recv(this->conn_, &buf) == ERR_OK) {
+    received++;
+    size_t len = netbuf_len(buf);
+    if (this->count_ == MAX_PACKETS || this->queued_bytes_ + len > this->max_queued_bytes_) {
+      netbuf_delete(buf);
+      (*dropped)++;
+      continue;
+    }
+    this->queue_[(this->head_ + this->count_) % MAX_PACKETS] = buf;
+    this->count_++;
+    this->queued_bytes_ += len;
+  }
+  return received;
+}
+
+void NetconnTransport::pop_() {
+  netbuf_delete(this->queue_[this->head_]);
+  this->queue_[this->head_] = nullptr;
+  this->head_ = (this->head_ + 1) % MAX_PACKETS;
+  this->count_--;
+  this->head_started_ = false;
+}
+
+uint8_t *NetconnTransport::begin_tx(size_t bytes) {
+  this->abort_tx();
+  if (this->conn_ == nullptr) {
+    return nullptr;
+  }
+  this->tx_buf_ = netbuf_new();
+  if (this->tx_buf_ == nullptr) {
+    return nullptr;
+  }
+  void *payload = netbuf_alloc(this->tx_buf_, bytes);
+  if (payload == nullptr) {
+    this->abort_tx();
+    return nullptr;
+  }
+  this->tx_payload_ = static_cast<uint8_t *>(payload);
+  return this->tx_payload_;
+}
+
+bool NetconnTransport::send_tx() {
+  if (this->tx_buf_ == nullptr) {
+    return false;
+  }
+  err_t err = netconn_sendto(this->conn_, this->tx_buf_, &this->remote_addr_, this->remote_port_);
+  netbuf_delete(this->tx_buf_);
+  this->tx_buf_ = nullptr;
+  this->tx_payload_ = nullptr;
+  return err == ERR_OK;
+}
+
+void NetconnTransport::abort_tx() {
+  if (this->tx_buf_ != nullptr) {
+    netbuf_delete(this->tx_buf_);
+    this->tx_buf_ = nullptr;
+    this->tx_payload_ = nullptr;
+  }
+}
+
+}  // namespace intercom_audio
+}  // namespace esphome
+
+#endif  // USE_ESP32
@@ -0,0 +1,107 @@
+#pragma once
+
+#ifdef USE_ESP32
+
+#include <lwip/api.h>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace esphome {
+namespace intercom_audio {
+
+// UDP on the lwIP netconn API instead of BSD sockets. Received netbufs stay
+// referenced in a packet queue (the jitter buffer) until playout hands their
+// payload straight to the speaker, and TX packets are built in place in a
+// netbuf payload. Only open()/close() run outside the audio task.
+class NetconnTransport {
+ public:
+  using WakeCallback = void (*)(void *arg);
+
+  // tos: IP TOS byte for everything sent (DSCP << 2), 0 for best effort
+  bool open(uint16_t listen_port, const char *remote_ip, uint16_t remote_port, size_t max_queued_bytes,
+            WakeCallback wake, void *wake_arg, uint8_t tos);
+  void close();
+  bool is_open() const { return this->conn_ != nullptr; }
+
+  // RX: queue every pending datagram. Returns datagrams received; *dropped counts queue overflows.
+  size_t receive(uint32_t *dropped);
+  size_t queued_bytes() const { return this->queued_bytes_; }
+
+  // Offer up to `bytes` queued bytes to sink(const uint8_t *data, size_t len) -> accepted.
+  // Stops early if the sink accepts less than offered; the rest stays queued.
+  template<typename Sink> size_t consume(size_t bytes, Sink &&sink);
+
+  // TX: payload of a fresh netbuf, then send_tx() or abort_tx()
+  uint8_t *begin_tx(size_t bytes);
+  bool has_tx() const { return this->tx_buf_ != nullptr; }
+  // Payload of the pending netbuf (nullptr if none), for packets filled frame by frame
+  uint8_t *tx_payload() const { return this->tx_payload_; }
+  bool send_tx();
+  void abort_tx();
+
+ protected:
+  static void netconn_event(struct netconn *conn, enum netconn_evt evt, u16_t len);
+  void pop_();
+
+  static const size_t MAX_PACKETS = 64;
+  static NetconnTransport *active_;  // netconn callbacks carry no user argument
+
+  struct netconn *conn_{nullptr};
+  ip_addr_t remote_addr_{};
+  uint16_t remote_port_{0};
+  WakeCallback wake_{nullptr};
+  void *wake_arg_{nullptr};
+
+  // Jitter buffer: ring of received netbufs
+  std::array<struct netbuf *, MAX_PACKETS> queue_{};
+  size_t head_{0};
+  size_t count_{0};
+  size_t queued_bytes_{0};
+  size_t max_queued_bytes_{0};
+  bool head_started_{false};  // netbuf_first() done on the head netbuf
+  size_t frag_offset_{0};     // Read position in the head's current fragment
+
+  struct netbuf *tx_buf_{nullptr};
+  uint8_t *tx_payload_{nullptr};
+};
+
+template<typename Sink> size_t NetconnTransport::consume(size_t bytes, Sink &&sink) {
+  size_t done = 0;
+  while (done < bytes && this->count_ > 0) {
+    struct netbuf *buf = this->queue_[this->head_];
+    if (!this->head_started_) {
+      netbuf_first(buf);
+      this->frag_offset_ = 0;
+      this->head_started_ = true;
+    }
+
+    void *data;
+    u16_t len;
+    netbuf_data(buf, &data, &len);
+    size_t want = std::min<size_t>(len - this->frag_offset_, bytes - done);
+    size_t taken = want > 0 ? sink(static_cast<const uint8_t *>(data) + this->frag_offset_, want) : 0;
+    done += taken;
+    this->frag_offset_ += taken;
+    this->queued_bytes_ -= taken;
+    if (taken < want) {
+      break;
+    }
+
+    if (this->frag_offset_ >= len) {
+      if (netbuf_next(buf) < 0) {
+        this->pop_();
+      } else {
+        this->frag_offset_ = 0;
+      }
+    }
+  }
+  return done;
+}
+
+}  // namespace intercom_audio
+}  // namespace esphome
+
+#endif  // USE_ESP32
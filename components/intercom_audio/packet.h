@@ -0,0 +1,143 @@
+#pragma once
+
+// Framed packet header used once both peers have negotiated it (see HELLO).
+// Without negotiation the stream stays raw payload, so go2rtc and older
+// firmware keep working. No ESPHome/ESP-IDF dependencies so it can be built
+// and checked on the host.
+//
+//   0      1      2      3      4      5      6      7      8      9
+//   +------+------+------+------+------+------+------+------+------+------+
+//   | 'I'  | 'C'  | type | flags|    seq      |   length    |  aux | rsvd |
+//   +------+------+------+------+------+------+------+------+------+------+
+//
+// Multi-byte fields are big endian. The body follows the header.
+
+#include <cstddef>
+#include <cstdint>
+
+namespace esphome {
+namespace intercom_audio {
+namespace wire {
+
+static const size_t HEADER_SIZE = 10;
+static const uint8_t MAGIC_0 = 'I';
+static const uint8_t MAGIC_1 = 'C';
+
+enum class PacketType : uint8_t {
+  AUDIO = 1,   // length = primary payload bytes, aux = XOR group (size << 4 | index)
+  PARITY = 2,  // seq = first frame of the group, length = XOR payload bytes, aux = size << 4
+  HELLO = 3,   // aux = capability bits
+  REPORT = 4,  // Receiver statistics, see report fields below
+  KEEPALIVE = 5,  // No body; sent while nothing else has gone out for KEEPALIVE_INTERVAL_MS
+};
+
+// AUDIO: a redundant copy of packet seq - 1 follows the primary payload
+static const uint8_t FLAG_RED = 0x01;
+// HELLO: the sender has already received our HELLO
+static const uint8_t FLAG_ACK = 0x02;
+// AUDIO/PARITY: payload codec (PayloadCodec value) in bits 2-3
+static const uint8_t FLAG_CODEC_SHIFT = 2;
+static const uint8_t FLAG_CODEC_MASK = 0x0C;
+
+inline uint8_t codec_flags(uint8_t codec) { return (uint8_t) ((codec << FLAG_CODEC_SHIFT) & FLAG_CODEC_MASK); }
+inline uint8_t flags_codec(uint8_t flags) { return (flags & FLAG_CODEC_MASK) >> FLAG_CODEC_SHIFT; }
+
+// HELLO capability bits
+static const uint8_t CAP_XOR = 0x01;
+static const uint8_t CAP_RED = 0x02;
+static const uint8_t CAP_G711 = 0x04;  // Can decode G.711 payloads (16 kHz devices)
+static const uint8_t CAP_AEAD = 0x08;  // Encrypted session: HELLO carries nonces, other packets a tag
+static const uint8_t CAP_KEEPALIVE = 0x10;  // Parses KEEPALIVE and sends it whenever it goes quiet
+
+// Longest a KEEPALIVE-capable sender stays silent in a framed session. Audio,
+// reports and HELLOs all count, so keepalives only fill gaps (DTX, a mic that
+// is muted or not running) and a silent peer can be told from a dead one.
+static const uint32_t KEEPALIVE_INTERVAL_MS = 200;
+
+// REPORT body, sent by both ends once per interval. RTT is measured like RTCP:
+// the peer echoes our last timestamp with the time it held it.
+//   0 timestamp (u32 ms)   4 echo timestamp (u32 ms, 0 = none)   8 echo delay (u16 ms)
+//  10 loss before FEC (u16 per mille)   12 jitter (u16 0.1 ms)   14 jitter buffer depth (u16 ms)
+static const size_t REPORT_BODY_SIZE = 16;
+
+struct Report {
+  uint32_t timestamp{0};
+  uint32_t echo_timestamp{0};
+  uint16_t echo_delay_ms{0};
+  uint16_t loss_permille{0};
+  uint16_t jitter_100us{0};
+  uint16_t depth_ms{0};
+};
+
+struct PacketHeader {
+  PacketType type{PacketType::AUDIO};
+  uint8_t flags{0};
+  uint16_t seq{0};
+  uint16_t length{0};
+  uint8_t aux{0};
+};
+
+inline void put_be16(uint8_t *p, uint16_t v) {
+  p[0] = (uint8_t) (v >> 8);
+  p[1] = (uint8_t) v;
+}
+inline uint16_t get_be16(const uint8_t *p) { return (uint16_t) ((p[0] << 8) | p[1]); }
+inline void put_be32(uint8_t *p, uint32_t v) {
+  put_be16(p, (uint16_t) (v >> 16));
+  put_be16(p + 2, (uint16_t) v);
+}
+inline uint32_t get_be32(const uint8_t *p) { return ((uint32_t) get_be16(p) << 16) | get_be16(p + 2); }
+
+inline void write_header(const PacketHeader &header, uint8_t *out) {
+  out[0] = MAGIC_0;
+  out[1] = MAGIC_1;
+  out[2] = (uint8_t) header.type;
+  out[3] = header.flags;
+  put_be16(out + 4, header.seq);
+  put_be16(out + 6, header.length);
+  out[8] = header.aux;
+  out[9] = 0;
+}
+
+// False for raw payloads and anything that doesn't parse as a known packet
+inline bool parse_header(const uint8_t *data, size_t len, PacketHeader *header) {
+  if (len < HEADER_SIZE || data[0] != MAGIC_0 || data[1] != MAGIC_1 || data[9] != 0) {
+    return false;
+  }
+  uint8_t type = data[2];
+  if (type < (uint8_t) PacketType::AUDIO || type > (uint8_t) PacketType::KEEPALIVE) {
+    return false;
+  }
+  header->type = (PacketType) type;
+  header->flags = data[3];
+  header->seq = get_be16(data + 4);
+  header->length = get_be16(data + 6);
+  header->aux = data[8];
+  return header->length <= len - HEADER_SIZE;
+}
+
+inline void write_report(const Report &report, uint8_t *out) {
+  put_be32(out, report.timestamp);
+  put_be32(out + 4, report.echo_timestamp);
+  put_be16(out + 8, report.echo_delay_ms);
+  put_be16(out + 10, report.loss_permille);
+  put_be16(out + 12, report.jitter_100us);
+  put_be16(out + 14, report.depth_ms);
+}
+
+inline bool parse_report(const uint8_t *body, size_t len, Report *report) {
+  if (len < REPORT_BODY_SIZE) {
+    return false;
+  }
+  report->timestamp = get_be32(body);
+  report->echo_timestamp = get_be32(body + 4);
+  report->echo_delay_ms = get_be16(body + 8);
+  report->loss_permille = get_be16(body + 10);
+  report->jitter_100us = get_be16(body + 12);
+  report->depth_ms = get_be16(body + 14);
+  return true;
+}
+
+}  // namespace wire
+}  // namespace intercom_audio
+}  // namespace esphome
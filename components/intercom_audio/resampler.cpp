@@ -0,0 +1,77 @@
+#include "resampler.h"
+
+#include <cstring>
+
+namespace esphome {
+namespace intercom_audio {
+
+// Half-band taps at offsets +/-1, +/-3 ... +/-15 from the centre, scaled so each
+// polyphase branch has unity DC gain (sum = 0.5 in Q15, centre tap = 0.5)
+static const int32_t HALFBAND_Q15[HALFBAND_PAIRS] = {20606, -6226, 3053, -1589, 786, -341, 116, -21};
+
+static inline int16_t clamp16(int32_t v) {
+  if (v > 32767)
+    return 32767;
+  if (v < -32768)
+    return -32768;
+  return (int16_t) v;
+}
+
+// ════════════════════════════════════════════════════════════════════
+// Downsampler2x
+// ════════════════════════════════════════════════════════════════════
+
+void Downsampler2x::reset() { memset(this->history_, 0, sizeof(this->history_)); }
+
+void Downsampler2x::process(const int16_t *in, size_t in_samples, int16_t *out) {
+  // Window of the last 2*HALFBAND_PAIRS*2 input samples, newest last. The
+  // output for each input pair is centred 2*HALFBAND_PAIRS - 1 samples back.
+  static const size_t CENTRE = 2 * HALFBAND_PAIRS - 1;
+  int16_t window[HISTORY];
+  memcpy(window, this->history_, sizeof(this->history_));
+
+  for (size_t n = 0; n + 1 < in_samples; n += 2) {
+    memmove(window, window + 2, (HISTORY - 2) * sizeof(int16_t));
+    window[HISTORY - 2] = in[n];
+    window[HISTORY - 1] = in[n + 1];
+
+    const int16_t *c = window + (HISTORY - 1 - CENTRE);
+    int32_t acc = (int32_t) c[0] << 15;
+    for (size_t m = 0; m < HALFBAND_PAIRS; m++) {
+      size_t k = 2 * m + 1;
+      acc += HALFBAND_Q15[m] * ((int32_t) c[-(int) k] + c[k]);
+    }
+    out[n / 2] = clamp16((acc + (1 << 15)) >> 16);
+  }
+  memcpy(this->history_, window, sizeof(this->history_));
+}
+
+// ════════════════════════════════════════════════════════════════════
+// Upsampler2x
+// ════════════════════════════════════════════════════════════════════
+
+void Upsampler2x::reset() { memset(this->history_, 0, sizeof(this->history_)); }
+
+void Upsampler2x::process(const int16_t *in, size_t in_samples, int16_t *out) {
+  // Even outputs are delayed input samples (centre tap), odd outputs are
+  // interpolated half-way between them by the symmetric pair taps
+  int16_t window[HISTORY];
+  memcpy(window, this->history_, sizeof(this->history_));
+
+  for (size_t n = 0; n < in_samples; n++) {
+    memmove(window, window + 1, (HISTORY - 1) * sizeof(int16_t));
+    window[HISTORY - 1] = in[n];
+
+    // Interpolation point sits between window[HALFBAND_PAIRS - 1] and window[HALFBAND_PAIRS]
+    int32_t acc = 0;
+    for (size_t m = 0; m < HALFBAND_PAIRS; m++) {
+      acc += HALFBAND_Q15[m] * ((int32_t) window[HALFBAND_PAIRS - 1 - m] + window[HALFBAND_PAIRS + m]);
+    }
+    out[2 * n] = window[HALFBAND_PAIRS - 1];
+    out[2 * n + 1] = clamp16((acc + (1 << 14)) >> 15);
+  }
+  memcpy(this->history_, window, sizeof(this->history_));
+}
+
+}  // namespace intercom_audio
+}  // namespace esphome
@@ -0,0 +1,42 @@
+#pragma once
+
+// 2:1 half-band polyphase resamplers (Q15) for 8 kHz narrowband payloads.
+// No ESPHome/ESP-IDF dependencies so it can be built and checked on the host.
+
+#include <cstddef>
+#include <cstdint>
+
+namespace esphome {
+namespace intercom_audio {
+
+// 31-tap half-band low-pass (Kaiser, beta 6): -0.6 dB at 3.4 kHz, -56 dB at 5 kHz
+// for 16 kHz. Only the odd taps around the centre are non-zero and symmetric.
+static const size_t HALFBAND_PAIRS = 8;
+
+// Decimate by 2 (16 kHz -> 8 kHz). Keeps history across calls, so frames
+// can be processed one at a time without edge artefacts.
+class Downsampler2x {
+ public:
+  void reset();
+  // in_samples must be even; writes in_samples / 2 samples to out
+  void process(const int16_t *in, size_t in_samples, int16_t *out);
+
+ protected:
+  static const size_t HISTORY = 4 * HALFBAND_PAIRS;  // Even number >= 31 taps
+  int16_t history_[HISTORY]{};
+};
+
+// Interpolate by 2 (8 kHz -> 16 kHz)
+class Upsampler2x {
+ public:
+  void reset();
+  // Writes 2 * in_samples samples to out
+  void process(const int16_t *in, size_t in_samples, int16_t *out);
+
+ protected:
+  static const size_t HISTORY = 2 * HALFBAND_PAIRS;
+  int16_t history_[HISTORY]{};
+};
+
+}  // namespace intercom_audio
+}  // namespace esphome
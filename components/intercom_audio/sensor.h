@@ -2,6 +2,7 @@
 
 #include "esphome/components/sensor/sensor.h"
 #include "esphome/core/component.h"
+#include "esphome/core/hal.h"
 #include "intercom_audio.h"
 
 namespace esphome {
@@ -22,6 +23,108 @@ class IntercomAudioSensor : public sensor::Sensor, public PollingComponent {
       case 2:  // Buffer fill
         this->publish_state(this->parent_->get_buffer_fill());
         break;
+      case 3:  // Payload copies
+        this->publish_state(this->parent_->get_copies());
+        break;
+      case 4:  // Bytes moved by those copies
+        this->publish_state(this->parent_->get_bytes_moved());
+        break;
+      case 5:  // Frames recovered by FEC
+        this->publish_state(this->parent_->get_fec_recovered());
+        break;
+      case 6:  // Frames lost after FEC
+        this->publish_state(this->parent_->get_fec_lost());
+        break;
+      case 7:  // FEC bytes sent
+        this->publish_state(this->parent_->get_fec_overhead_bytes());
+        break;
+      case 8:  // FEC CPU time
+        this->publish_state(this->parent_->get_fec_cpu_us());
+        break;
+      case 9:  // Packet loss before FEC
+        this->publish_state(this->parent_->get_packet_loss());
+        break;
+      case 10:  // Round-trip time from receiver reports
+        this->publish_state(this->parent_->get_rtt_ms());
+        break;
+      case 11:  // Interarrival jitter of received audio
+        this->publish_state(this->parent_->get_jitter_ms());
+        break;
+      case 12:  // Loss the peer reports for our stream
+        this->publish_state(this->parent_->get_peer_loss());
+        break;
+      case 13:  // Jitter the peer reports for our stream
+        this->publish_state(this->parent_->get_peer_jitter_ms());
+        break;
+      case 14:  // Peer jitter buffer depth
+        this->publish_state(this->parent_->get_peer_buffer_ms());
+        break;
+      case 15:  // TX packet rate since the last update
+        this->publish_rate_(this->parent_->get_tx_packets());
+        break;
+      case 16:  // Time spent in UDP send calls
+        this->publish_state(this->parent_->get_send_cpu_us());
+        break;
+      case 17:  // Smoothed time per send call
+        this->publish_state(this->parent_->get_send_latency_us());
+        break;
+      case 18:  // Smoothed CPU cycles per packet sealed
+        this->publish_state(this->parent_->get_encrypt_cycles());
+        break;
+      case 19:  // Smoothed CPU cycles per packet opened
+        this->publish_state(this->parent_->get_decrypt_cycles());
+        break;
+      case 20:  // Packets dropped by authentication / replay checks
+        this->publish_state(this->parent_->get_crypto_rejected());
+        break;
+      case 21:  // Audio task wakeups per second since the last update
+        this->publish_rate_(this->parent_->get_task_wakeups());
+        break;
+      case 22:  // Smoothed CPU cycles per frame written to the recording ring
+        this->publish_state(this->parent_->get_recording_tap_cycles());
+        break;
+      case 23:  // Seconds of audio in the recording ring
+        this->publish_state(this->parent_->get_recording_buffered());
+        break;
+      case 24:  // Smoothed CPU cycles per trace record
+        this->publish_state(this->parent_->get_trace_cycles());
+        break;
+      case 25:  // Smoothed CPU cycles per 32-bit mic frame converted
+        this->publish_state(this->parent_->get_mic_convert_cycles());
+        break;
+      case 26:  // Mic bytes dropped to stay on sample boundaries
+        this->publish_state(this->parent_->get_mic_misaligned_bytes());
+        break;
+      case 27:  // Smoothed capture (first sample) -> send time
+        this->publish_state(this->parent_->get_capture_latency_us() / 1000.0f);
+        break;
+      case 28:  // Smoothed time per audio task pass blocked on the speaker / locks
+        this->publish_state(this->parent_->get_loop_blocked_us());
+        break;
+      case 29:  // Worst pass since the last update
+        this->publish_state(this->parent_->take_loop_blocked_max_us());
+        break;
+      case 30:  // Passes that left frames queued for a full speaker
+        this->publish_state(this->parent_->get_playout_deferred());
+        break;
+      case 31:  // Jitter buffer + speaker buffer + playback DMA
+        this->publish_state(this->parent_->get_latency_breakdown().playout_ms());
+        break;
+      case 32:  // Estimated mouth-to-ear latency of what we play
+        this->publish_state(this->parent_->get_latency_breakdown().total_ms());
+        break;
+      case 33:  // E-model MOS of the latest window of the call
+        this->publish_state(this->parent_->get_call_mos());
+        break;
+      case 34:  // E-model R of the latest window of the call
+        this->publish_state(this->parent_->get_call_r_factor());
+        break;
+      case 35:  // Average window MOS, once per finished call
+        this->publish_per_call_(this->parent_->get_last_call_mos_average());
+        break;
+      case 36:  // Worst window MOS, once per finished call
+        this->publish_per_call_(this->parent_->get_last_call_mos_worst());
+        break;
     }
   }
 
@@ -29,8 +132,28 @@ class IntercomAudioSensor : public sensor::Sensor, public PollingComponent {
   void set_sensor_type(uint8_t type) { this->sensor_type_ = type; }
 
  protected:
+  void publish_rate_(uint32_t count) {
+    uint32_t now = millis();
+    // Skip the first sample and counter resets
+    if (this->last_ms_ != 0 && now > this->last_ms_ && count >= this->last_count_) {
+      this->publish_state((count - this->last_count_) * 1000.0f / (now - this->last_ms_));
+    }
+    this->last_count_ = count;
+    this->last_ms_ = now;
+  }
+
+  void publish_per_call_(float value) {
+    uint32_t calls = this->parent_->get_calls_rated();
+    if (calls != this->last_count_) {
+      this->last_count_ = calls;
+      this->publish_state(value);
+    }
+  }
+
   IntercomAudio *parent_{nullptr};
   uint8_t sensor_type_{0};
+  uint32_t last_count_{0};
+  uint32_t last_ms_{0};
 };
 
 }  // namespace intercom_audio
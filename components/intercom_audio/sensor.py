@@ -9,6 +9,9 @@ from esphome.const import (
     STATE_CLASS_TOTAL_INCREASING,
     STATE_CLASS_MEASUREMENT,
     UNIT_EMPTY,
+    UNIT_MILLISECOND,
+    UNIT_PERCENT,
+    UNIT_SECOND,
 )
 
 from . import IntercomAudio, intercom_audio_ns
@@ -17,6 +20,81 @@ CONF_INTERCOM_AUDIO_ID = "intercom_audio_id"
 CONF_TX_PACKETS = "tx_packets"
 CONF_RX_PACKETS = "rx_packets"
 CONF_BUFFER_FILL = "buffer_fill"
+CONF_COPIES = "copies"
+CONF_BYTES_MOVED = "bytes_moved"
+CONF_FEC_RECOVERED = "fec_recovered"
+CONF_FEC_LOST = "fec_lost"
+CONF_FEC_OVERHEAD = "fec_overhead"
+CONF_FEC_CPU = "fec_cpu"
+CONF_PACKET_LOSS = "packet_loss"
+CONF_RTT = "rtt"
+CONF_JITTER = "jitter"
+CONF_PEER_PACKET_LOSS = "peer_packet_loss"
+CONF_PEER_JITTER = "peer_jitter"
+CONF_PEER_BUFFER = "peer_buffer"
+CONF_TX_PACKET_RATE = "tx_packet_rate"
+CONF_SEND_CPU = "send_cpu"
+CONF_SEND_LATENCY = "send_latency"
+CONF_ENCRYPT_CYCLES = "encrypt_cycles"
+CONF_DECRYPT_CYCLES = "decrypt_cycles"
+CONF_CRYPTO_REJECTED = "crypto_rejected"
+CONF_TASK_WAKEUPS = "task_wakeups"
+CONF_RECORDING_TAP_CYCLES = "recording_tap_cycles"
+CONF_RECORDING_BUFFERED = "recording_buffered"
+CONF_TRACE_CYCLES = "trace_cycles"
+CONF_MIC_CONVERT_CYCLES = "mic_convert_cycles"
+CONF_MIC_MISALIGNED = "mic_misaligned"
+CONF_CAPTURE_LATENCY = "capture_latency"
+CONF_LOOP_BLOCKED = "loop_blocked"
+CONF_LOOP_BLOCKED_MAX = "loop_blocked_max"
+CONF_PLAYOUT_DEFERRED = "playout_deferred"
+CONF_PLAYOUT_LATENCY = "playout_latency"
+CONF_MOUTH_TO_EAR_LATENCY = "mouth_to_ear_latency"
+CONF_CALL_MOS = "call_mos"
+CONF_CALL_R_FACTOR = "call_r_factor"
+CONF_CALL_MOS_AVERAGE = "call_mos_average"
+CONF_CALL_MOS_WORST = "call_mos_worst"
+
+# Value passed to IntercomAudioSensor::set_sensor_type()
+SENSOR_TYPES = {
+    CONF_TX_PACKETS: 0,
+    CONF_RX_PACKETS: 1,
+    CONF_BUFFER_FILL: 2,
+    CONF_COPIES: 3,
+    CONF_BYTES_MOVED: 4,
+    CONF_FEC_RECOVERED: 5,
+    CONF_FEC_LOST: 6,
+    CONF_FEC_OVERHEAD: 7,
+    CONF_FEC_CPU: 8,
+    CONF_PACKET_LOSS: 9,
+    CONF_RTT: 10,
+    CONF_JITTER: 11,
+    CONF_PEER_PACKET_LOSS: 12,
+    CONF_PEER_JITTER: 13,
+    CONF_PEER_BUFFER: 14,
+    CONF_TX_PACKET_RATE: 15,
+    CONF_SEND_CPU: 16,
+    CONF_SEND_LATENCY: 17,
+    CONF_ENCRYPT_CYCLES: 18,
+    CONF_DECRYPT_CYCLES: 19,
+    CONF_CRYPTO_REJECTED: 20,
+    CONF_TASK_WAKEUPS: 21,
+    CONF_RECORDING_TAP_CYCLES: 22,
+    CONF_RECORDING_BUFFERED: 23,
+    CONF_TRACE_CYCLES: 24,
+    CONF_MIC_CONVERT_CYCLES: 25,
+    CONF_MIC_MISALIGNED: 26,
+    CONF_CAPTURE_LATENCY: 27,
+    CONF_LOOP_BLOCKED: 28,
+    CONF_LOOP_BLOCKED_MAX: 29,
+    CONF_PLAYOUT_DEFERRED: 30,
+    CONF_PLAYOUT_LATENCY: 31,
+    CONF_MOUTH_TO_EAR_LATENCY: 32,
+    CONF_CALL_MOS: 33,
+    CONF_CALL_R_FACTOR: 34,
+    CONF_CALL_MOS_AVERAGE: 35,
+    CONF_CALL_MOS_WORST: 36,
+}
 
 IntercomAudioSensor = intercom_audio_ns.class_(
     "IntercomAudioSensor", sensor.Sensor, cg.PollingComponent
@@ -42,29 +120,217 @@ CONFIG_SCHEMA = cv.Schema({
         entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
         state_class=STATE_CLASS_MEASUREMENT,
     ).extend({cv.GenerateID(): cv.declare_id(IntercomAudioSensor)}).extend(cv.polling_component_schema("1s")),
+    cv.Optional(CONF_COPIES): sensor.sensor_schema(
+        unit_of_measurement=UNIT_EMPTY,
+        accuracy_decimals=0,
+        entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        state_class=STATE_CLASS_TOTAL_INCREASING,
+    ).extend({cv.GenerateID(): cv.declare_id(IntercomAudioSensor)}).extend(cv.polling_component_schema("1s")),
+    cv.Optional(CONF_BYTES_MOVED): sensor.sensor_schema(
+        unit_of_measurement="B",
+        accuracy_decimals=0,
+        entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        state_class=STATE_CLASS_TOTAL_INCREASING,
+    ).extend({cv.GenerateID(): cv.declare_id(IntercomAudioSensor)}).extend(cv.polling_component_schema("1s")),
+    cv.Optional(CONF_FEC_RECOVERED): sensor.sensor_schema(
+        unit_of_measurement=UNIT_EMPTY,
+        accuracy_decimals=0,
+        entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        state_class=STATE_CLASS_TOTAL_INCREASING,
+    ).extend({cv.GenerateID(): cv.declare_id(IntercomAudioSensor)}).extend(cv.polling_component_schema("1s")),
+    cv.Optional(CONF_FEC_LOST): sensor.sensor_schema(
+        unit_of_measurement=UNIT_EMPTY,
+        accuracy_decimals=0,
+        entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        state_class=STATE_CLASS_TOTAL_INCREASING,
+    ).extend({cv.GenerateID(): cv.declare_id(IntercomAudioSensor)}).extend(cv.polling_component_schema("1s")),
+    cv.Optional(CONF_FEC_OVERHEAD): sensor.sensor_schema(
+        unit_of_measurement="B",
+        accuracy_decimals=0,
+        entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        state_class=STATE_CLASS_TOTAL_INCREASING,
+    ).extend({cv.GenerateID(): cv.declare_id(IntercomAudioSensor)}).extend(cv.polling_component_schema("1s")),
+    cv.Optional(CONF_FEC_CPU): sensor.sensor_schema(
+        unit_of_measurement="µs",
+        accuracy_decimals=0,
+        entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        state_class=STATE_CLASS_TOTAL_INCREASING,
+    ).extend({cv.GenerateID(): cv.declare_id(IntercomAudioSensor)}).extend(cv.polling_component_schema("1s")),
+    cv.Optional(CONF_PACKET_LOSS): sensor.sensor_schema(
+        unit_of_measurement=UNIT_PERCENT,
+        accuracy_decimals=1,
+        entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        state_class=STATE_CLASS_MEASUREMENT,
+    ).extend({cv.GenerateID(): cv.declare_id(IntercomAudioSensor)}).extend(cv.polling_component_schema("1s")),
+    cv.Optional(CONF_RTT): sensor.sensor_schema(
+        unit_of_measurement=UNIT_MILLISECOND,
+        accuracy_decimals=0,
+        entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        state_class=STATE_CLASS_MEASUREMENT,
+    ).extend({cv.GenerateID(): cv.declare_id(IntercomAudioSensor)}).extend(cv.polling_component_schema("1s")),
+    cv.Optional(CONF_JITTER): sensor.sensor_schema(
+        unit_of_measurement=UNIT_MILLISECOND,
+        accuracy_decimals=1,
+        entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        state_class=STATE_CLASS_MEASUREMENT,
+    ).extend({cv.GenerateID(): cv.declare_id(IntercomAudioSensor)}).extend(cv.polling_component_schema("1s")),
+    cv.Optional(CONF_PEER_PACKET_LOSS): sensor.sensor_schema(
+        unit_of_measurement=UNIT_PERCENT,
+        accuracy_decimals=1,
+        entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        state_class=STATE_CLASS_MEASUREMENT,
+    ).extend({cv.GenerateID(): cv.declare_id(IntercomAudioSensor)}).extend(cv.polling_component_schema("1s")),
+    cv.Optional(CONF_PEER_JITTER): sensor.sensor_schema(
+        unit_of_measurement=UNIT_MILLISECOND,
+        accuracy_decimals=1,
+        entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        state_class=STATE_CLASS_MEASUREMENT,
+    ).extend({cv.GenerateID(): cv.declare_id(IntercomAudioSensor)}).extend(cv.polling_component_schema("1s")),
+    cv.Optional(CONF_PEER_BUFFER): sensor.sensor_schema(
+        unit_of_measurement=UNIT_MILLISECOND,
+        accuracy_decimals=0,
+        entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        state_class=STATE_CLASS_MEASUREMENT,
+    ).extend({cv.GenerateID(): cv.declare_id(IntercomAudioSensor)}).extend(cv.polling_component_schema("1s")),
+    cv.Optional(CONF_TX_PACKET_RATE): sensor.sensor_schema(
+        unit_of_measurement="packets/s",
+        accuracy_decimals=1,
+        entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        state_class=STATE_CLASS_MEASUREMENT,
+    ).extend({cv.GenerateID(): cv.declare_id(IntercomAudioSensor)}).extend(cv.polling_component_schema("5s")),
+    cv.Optional(CONF_SEND_CPU): sensor.sensor_schema(
+        unit_of_measurement="µs",
+        accuracy_decimals=0,
+        entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        state_class=STATE_CLASS_TOTAL_INCREASING,
+    ).extend({cv.GenerateID(): cv.declare_id(IntercomAudioSensor)}).extend(cv.polling_component_schema("1s")),
+    cv.Optional(CONF_SEND_LATENCY): sensor.sensor_schema(
+        unit_of_measurement="µs",
+        accuracy_decimals=0,
+        entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        state_class=STATE_CLASS_MEASUREMENT,
+    ).extend({cv.GenerateID(): cv.declare_id(IntercomAudioSensor)}).extend(cv.polling_component_schema("1s")),
+    cv.Optional(CONF_ENCRYPT_CYCLES): sensor.sensor_schema(
+        unit_of_measurement="cycles",
+        accuracy_decimals=0,
+        entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        state_class=STATE_CLASS_MEASUREMENT,
+    ).extend({cv.GenerateID(): cv.declare_id(IntercomAudioSensor)}).extend(cv.polling_component_schema("1s")),
+    cv.Optional(CONF_DECRYPT_CYCLES): sensor.sensor_schema(
+        unit_of_measurement="cycles",
+        accuracy_decimals=0,
+        entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        state_class=STATE_CLASS_MEASUREMENT,
+    ).extend({cv.GenerateID(): cv.declare_id(IntercomAudioSensor)}).extend(cv.polling_component_schema("1s")),
+    cv.Optional(CONF_CRYPTO_REJECTED): sensor.sensor_schema(
+        unit_of_measurement=UNIT_EMPTY,
+        accuracy_decimals=0,
+        entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        state_class=STATE_CLASS_TOTAL_INCREASING,
+    ).extend({cv.GenerateID(): cv.declare_id(IntercomAudioSensor)}).extend(cv.polling_component_schema("1s")),
+    cv.Optional(CONF_TASK_WAKEUPS): sensor.sensor_schema(
+        unit_of_measurement="wakeups/s",
+        accuracy_decimals=1,
+        entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        state_class=STATE_CLASS_MEASUREMENT,
+    ).extend({cv.GenerateID(): cv.declare_id(IntercomAudioSensor)}).extend(cv.polling_component_schema("60s")),
+    cv.Optional(CONF_RECORDING_TAP_CYCLES): sensor.sensor_schema(
+        unit_of_measurement="cycles",
+        accuracy_decimals=0,
+        entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        state_class=STATE_CLASS_MEASUREMENT,
+    ).extend({cv.GenerateID(): cv.declare_id(IntercomAudioSensor)}).extend(cv.polling_component_schema("10s")),
+    cv.Optional(CONF_RECORDING_BUFFERED): sensor.sensor_schema(
+        unit_of_measurement=UNIT_SECOND,
+        accuracy_decimals=1,
+        entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        state_class=STATE_CLASS_MEASUREMENT,
+    ).extend({cv.GenerateID(): cv.declare_id(IntercomAudioSensor)}).extend(cv.polling_component_schema("10s")),
+    cv.Optional(CONF_TRACE_CYCLES): sensor.sensor_schema(
+        unit_of_measurement="cycles",
+        accuracy_decimals=0,
+        entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        state_class=STATE_CLASS_MEASUREMENT,
+    ).extend({cv.GenerateID(): cv.declare_id(IntercomAudioSensor)}).extend(cv.polling_component_schema("10s")),
+    cv.Optional(CONF_MIC_CONVERT_CYCLES): sensor.sensor_schema(
+        unit_of_measurement="cycles",
+        accuracy_decimals=0,
+        entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        state_class=STATE_CLASS_MEASUREMENT,
+    ).extend({cv.GenerateID(): cv.declare_id(IntercomAudioSensor)}).extend(cv.polling_component_schema("10s")),
+    cv.Optional(CONF_MIC_MISALIGNED): sensor.sensor_schema(
+        unit_of_measurement="B",
+        accuracy_decimals=0,
+        entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        state_class=STATE_CLASS_TOTAL_INCREASING,
+    ).extend({cv.GenerateID(): cv.declare_id(IntercomAudioSensor)}).extend(cv.polling_component_schema("10s")),
+    cv.Optional(CONF_CAPTURE_LATENCY): sensor.sensor_schema(
+        unit_of_measurement=UNIT_MILLISECOND,
+        accuracy_decimals=1,
+        entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        state_class=STATE_CLASS_MEASUREMENT,
+    ).extend({cv.GenerateID(): cv.declare_id(IntercomAudioSensor)}).extend(cv.polling_component_schema("1s")),
+    cv.Optional(CONF_LOOP_BLOCKED): sensor.sensor_schema(
+        unit_of_measurement="µs",
+        accuracy_decimals=0,
+        entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        state_class=STATE_CLASS_MEASUREMENT,
+    ).extend({cv.GenerateID(): cv.declare_id(IntercomAudioSensor)}).extend(cv.polling_component_schema("1s")),
+    cv.Optional(CONF_LOOP_BLOCKED_MAX): sensor.sensor_schema(
+        unit_of_measurement="µs",
+        accuracy_decimals=0,
+        entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        state_class=STATE_CLASS_MEASUREMENT,
+    ).extend({cv.GenerateID(): cv.declare_id(IntercomAudioSensor)}).extend(cv.polling_component_schema("10s")),
+    cv.Optional(CONF_PLAYOUT_DEFERRED): sensor.sensor_schema(
+        unit_of_measurement=UNIT_EMPTY,
+        accuracy_decimals=0,
+        entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        state_class=STATE_CLASS_TOTAL_INCREASING,
+    ).extend({cv.GenerateID(): cv.declare_id(IntercomAudioSensor)}).extend(cv.polling_component_schema("10s")),
+    cv.Optional(CONF_PLAYOUT_LATENCY): sensor.sensor_schema(
+        unit_of_measurement=UNIT_MILLISECOND,
+        accuracy_decimals=0,
+        entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        state_class=STATE_CLASS_MEASUREMENT,
+    ).extend({cv.GenerateID(): cv.declare_id(IntercomAudioSensor)}).extend(cv.polling_component_schema("1s")),
+    cv.Optional(CONF_MOUTH_TO_EAR_LATENCY): sensor.sensor_schema(
+        unit_of_measurement=UNIT_MILLISECOND,
+        accuracy_decimals=0,
+        entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        state_class=STATE_CLASS_MEASUREMENT,
+    ).extend({cv.GenerateID(): cv.declare_id(IntercomAudioSensor)}).extend(cv.polling_component_schema("1s")),
+    cv.Optional(CONF_CALL_MOS): sensor.sensor_schema(
+        unit_of_measurement=UNIT_EMPTY,
+        accuracy_decimals=2,
+        state_class=STATE_CLASS_MEASUREMENT,
+    ).extend({cv.GenerateID(): cv.declare_id(IntercomAudioSensor)}).extend(cv.polling_component_schema("5s")),
+    cv.Optional(CONF_CALL_R_FACTOR): sensor.sensor_schema(
+        unit_of_measurement=UNIT_EMPTY,
+        accuracy_decimals=1,
+        state_class=STATE_CLASS_MEASUREMENT,
+    ).extend({cv.GenerateID(): cv.declare_id(IntercomAudioSensor)}).extend(cv.polling_component_schema("5s")),
+    cv.Optional(CONF_CALL_MOS_AVERAGE): sensor.sensor_schema(
+        unit_of_measurement=UNIT_EMPTY,
+        accuracy_decimals=2,
+        state_class=STATE_CLASS_MEASUREMENT,
+    ).extend({cv.GenerateID(): cv.declare_id(IntercomAudioSensor)}).extend(cv.polling_component_schema("10s")),
+    cv.Optional(CONF_CALL_MOS_WORST): sensor.sensor_schema(
+        unit_of_measurement=UNIT_EMPTY,
+        accuracy_decimals=2,
+        state_class=STATE_CLASS_MEASUREMENT,
+    ).extend({cv.GenerateID(): cv.declare_id(IntercomAudioSensor)}).extend(cv.polling_component_schema("10s")),
 })
 
 
 async def to_code(config):
     parent = await cg.get_variable(config[CONF_INTERCOM_AUDIO_ID])
 
-    if CONF_TX_PACKETS in config:
-        conf = config[CONF_TX_PACKETS]
-        sens = await sensor.new_sensor(conf)
-        await cg.register_component(sens, conf)
-        cg.add(sens.set_parent(parent))
-        cg.add(sens.set_sensor_type(0))  # TX
-
-    if CONF_RX_PACKETS in config:
-        conf = config[CONF_RX_PACKETS]
-        sens = await sensor.new_sensor(conf)
-        await cg.register_component(sens, conf)
-        cg.add(sens.set_parent(parent))
-        cg.add(sens.set_sensor_type(1))  # RX
-
-    if CONF_BUFFER_FILL in config:
-        conf = config[CONF_BUFFER_FILL]
+    for key, sensor_type in SENSOR_TYPES.items():
+        if key not in config:
+            continue
+        conf = config[key]
         sens = await sensor.new_sensor(conf)
         await cg.register_component(sens, conf)
         cg.add(sens.set_parent(parent))
-        cg.add(sens.set_sensor_type(2))  # Buffer
+        cg.add(sens.set_sensor_type(sensor_type))
@@ -0,0 +1,251 @@
+#include "stream_crypto.h"
+
+#include <mbedtls/md.h>
+
+#include <cstring>
+#include <initializer_list>
+
+namespace esphome {
+namespace intercom_audio {
+
+// Domain separation between the HMAC uses of the pre-shared key
+static const char *const LABEL_HELLO = "intercom hello";
+static const char *const LABEL_KEY = "intercom key";
+static const char *const LABEL_SALT = "intercom salt";
+
+// === Replay window ===
+
+bool ReplayWindow::check(uint16_t seq, uint32_t *index) const {
+  if (!this->started_) {
+    *index = seq + 0x10000u;  // Offset keeps early reordering above zero
+    return true;
+  }
+  uint32_t ext = this->highest_ + (int16_t) (seq - (uint16_t) this->highest_);
+  *index = ext;
+  if (ext > this->highest_) {
+    return true;
+  }
+  uint32_t age = this->highest_ - ext;
+  return age < SIZE && !(this->bitmap_ & ((uint64_t) 1 << age));
+}
+
+void ReplayWindow::accept(uint32_t index) {
+  if (!this->started_) {
+    this->started_ = true;
+    this->highest_ = index;
+    this->bitmap_ = 1;
+    return;
+  }
+  if (index > this->highest_) {
+    uint32_t shift = index - this->highest_;
+    this->bitmap_ = shift < SIZE ? (this->bitmap_ << shift) | 1 : 1;
+    this->highest_ = index;
+  } else {
+    this->bitmap_ |= (uint64_t) 1 << (this->highest_ - index);
+  }
+}
+
+// === Stream crypto ===
+
+StreamCrypto::StreamCrypto() {
+  for (Direction *dir : {&this->tx_, &this->rx_}) {
+    mbedtls_gcm_init(&dir->gcm);
+#ifdef MBEDTLS_CHACHAPOLY_C
+    mbedtls_chachapoly_init(&dir->chachapoly);
+#endif
+  }
+}
+
+StreamCrypto::~StreamCrypto() {
+  for (Direction *dir : {&this->tx_, &this->rx_}) {
+    mbedtls_gcm_free(&dir->gcm);
+#ifdef MBEDTLS_CHACHAPOLY_C
+    mbedtls_chachapoly_free(&dir->chachapoly);
+#endif
+  }
+  memset(this->psk_, 0, sizeof(this->psk_));
+}
+
+bool StreamCrypto::is_supported(CipherSuite suite) {
+  if (suite == CipherSuite::CHACHA20_POLY1305) {
+#ifdef MBEDTLS_CHACHAPOLY_C
+    return true;
+#else
+    return false;
+#endif
+  }
+  return true;
+}
+
+void StreamCrypto::set_psk(const uint8_t *key) {
+  memcpy(this->psk_, key, KEY_SIZE);
+  this->enabled_ = true;
+}
+
+void StreamCrypto::begin_session(const uint8_t *local_nonce) {
+  memcpy(this->local_nonce_, local_nonce, NONCE_SIZE);
+  memset(this->peer_nonce_, 0, NONCE_SIZE);
+  this->keyed_ = false;
+}
+
+bool StreamCrypto::is_peer_nonce(const uint8_t *nonce) const {
+  return this->keyed_ && memcmp(nonce, this->peer_nonce_, NONCE_SIZE) == 0;
+}
+
+void StreamCrypto::hmac_(const char *label, const uint8_t *a, size_t a_len, const uint8_t *b, size_t b_len,
+                         uint8_t *out) const {
+  // HMAC-SHA256(psk, label || suite || a || b)
+  mbedtls_md_context_t ctx;
+  mbedtls_md_init(&ctx);
+  mbedtls_md_setup(&ctx, mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), 1);
+  mbedtls_md_hmac_starts(&ctx, this->psk_, KEY_SIZE);
+  mbedtls_md_hmac_update(&ctx, (const uint8_t *) label, strlen(label));
+  uint8_t suite = (uint8_t) this->suite_;
+  mbedtls_md_hmac_update(&ctx, &suite, 1);
+  mbedtls_md_hmac_update(&ctx, a, a_len);
+  mbedtls_md_hmac_update(&ctx, b, b_len);
+  mbedtls_md_hmac_finish(&ctx, out);
+  mbedtls_md_free(&ctx);
+}
+
+void StreamCrypto::write_hello(const uint8_t *header, uint8_t *body) const {
+  memcpy(body, this->local_nonce_, NONCE_SIZE);
+  if (this->keyed_) {
+    memcpy(body + NONCE_SIZE, this->peer_nonce_, NONCE_SIZE);
+  } else {
+    memset(body + NONCE_SIZE, 0, NONCE_SIZE);
+  }
+  uint8_t mac[32];
+  this->hmac_(LABEL_HELLO, header, wire::HEADER_SIZE, body, 2 * NONCE_SIZE, mac);
+  memcpy(body + 2 * NONCE_SIZE, mac, TAG_SIZE);
+}
+
+bool StreamCrypto::verify_hello(const uint8_t *header, const uint8_t *body, size_t len, const uint8_t **peer_nonce,
+                                bool *echo_ok) const {
+  if (len < HELLO_BODY_SIZE) {
+    return false;
+  }
+  uint8_t mac[32];
+  this->hmac_(LABEL_HELLO, header, wire::HEADER_SIZE, body, 2 * NONCE_SIZE, mac);
+  // Constant time compare
+  uint8_t diff = 0;
+  for (size_t i = 0; i < TAG_SIZE; i++) {
+    diff |= mac[i] ^ body[2 * NONCE_SIZE + i];
+  }
+  if (diff != 0) {
+    return false;
+  }
+  *peer_nonce = body;
+  *echo_ok = memcmp(body + NONCE_SIZE, this->local_nonce_, NONCE_SIZE) == 0;
+  return true;
+}
+
+bool StreamCrypto::set_key_(Direction &dir, const uint8_t *sender_nonce, const uint8_t *receiver_nonce) {
+  uint8_t key[32];
+  uint8_t salt[32];
+  this->hmac_(LABEL_KEY, sender_nonce, NONCE_SIZE, receiver_nonce, NONCE_SIZE, key);
+  this->hmac_(LABEL_SALT, sender_nonce, NONCE_SIZE, receiver_nonce, NONCE_SIZE, salt);
+  memcpy(dir.salt, salt, SALT_SIZE);
+  int ret = -1;
+  if (this->suite_ == CipherSuite::CHACHA20_POLY1305) {
+#ifdef MBEDTLS_CHACHAPOLY_C
+    ret = mbedtls_chachapoly_setkey(&dir.chachapoly, key);
+#endif
+  } else {
+    ret = mbedtls_gcm_setkey(&dir.gcm, MBEDTLS_CIPHER_ID_AES, key, 256);
+  }
+  memset(key, 0, sizeof(key));
+  return ret == 0;
+}
+
+bool StreamCrypto::key_session(const uint8_t *peer_nonce) {
+  if (this->is_peer_nonce(peer_nonce)) {
+    return true;  // Same session; resetting the sender's indices here would reuse IVs
+  }
+  memcpy(this->peer_nonce_, peer_nonce, NONCE_SIZE);
+  this->keyed_ = this->set_key_(this->tx_, this->local_nonce_, this->peer_nonce_) &&
+                 this->set_key_(this->rx_, this->peer_nonce_, this->local_nonce_);
+  // Fresh keys: sequence numbers may restart without reusing an IV
+  for (size_t i = 0; i < TYPES; i++) {
+    this->tx_started_[i] = false;
+    this->rx_window_[i].reset();
+  }
+  return this->keyed_;
+}
+
+void StreamCrypto::make_iv_(const Direction &dir, uint8_t type, uint32_t index, uint8_t *iv) const {
+  memcpy(iv, dir.salt, SALT_SIZE);
+  iv[4] = type;
+  iv[5] = 0;
+  iv[6] = 0;
+  iv[7] = 0;
+  wire::put_be32(iv + 8, index);
+}
+
+bool StreamCrypto::seal(const uint8_t *header, const wire::PacketHeader &info, uint8_t *body, size_t len) {
+  uint8_t type = (uint8_t) info.type;
+  if (!this->keyed_ || type >= TYPES) {
+    return false;
+  }
+  // Extend the 16-bit sequence number; the sender's own numbers only move forward
+  uint32_t index;
+  if (!this->tx_started_[type]) {
+    this->tx_started_[type] = true;
+    index = info.seq + 0x10000u;
+  } else {
+    index = this->tx_index_[type] + (int16_t) (info.seq - (uint16_t) this->tx_index_[type]);
+    if (index <= this->tx_index_[type]) {
+      return false;  // Would reuse an IV
+    }
+  }
+  this->tx_index_[type] = index;
+
+  uint8_t iv[IV_SIZE];
+  this->make_iv_(this->tx_, type, index, iv);
+  uint8_t *tag = body + len;
+  if (this->suite_ == CipherSuite::CHACHA20_POLY1305) {
+#ifdef MBEDTLS_CHACHAPOLY_C
+    return mbedtls_chachapoly_encrypt_and_tag(&this->tx_.chachapoly, len, iv, header, wire::HEADER_SIZE, body,
+                                              body, tag) == 0;
+#else
+    return false;
+#endif
+  }
+  return mbedtls_gcm_crypt_and_tag(&this->tx_.gcm, MBEDTLS_GCM_ENCRYPT, len, iv, IV_SIZE, header,
+                                   wire::HEADER_SIZE, body, body, TAG_SIZE, tag) == 0;
+}
+
+bool StreamCrypto::open(const uint8_t *header, const wire::PacketHeader &info, uint8_t *body, size_t len) {
+  uint8_t type = (uint8_t) info.type;
+  if (!this->keyed_ || type >= TYPES || len < TAG_SIZE) {
+    return false;
+  }
+  ReplayWindow &window = this->rx_window_[type];
+  uint32_t index;
+  if (!window.check(info.seq, &index)) {
+    return false;
+  }
+
+  uint8_t iv[IV_SIZE];
+  this->make_iv_(this->rx_, type, index, iv);
+  size_t data_len = len - TAG_SIZE;
+  const uint8_t *tag = body + data_len;
+  int ret = -1;
+  if (this->suite_ == CipherSuite::CHACHA20_POLY1305) {
+#ifdef MBEDTLS_CHACHAPOLY_C
+    ret = mbedtls_chachapoly_auth_decrypt(&this->rx_.chachapoly, data_len, iv, header, wire::HEADER_SIZE, tag, body,
+                                          body);
+#endif
+  } else {
+    ret = mbedtls_gcm_auth_decrypt(&this->rx_.gcm, data_len, iv, IV_SIZE, header, wire::HEADER_SIZE, tag, TAG_SIZE,
+                                   body, body);
+  }
+  if (ret != 0) {
+    return false;
+  }
+  window.accept(index);
+  return true;
+}
+
+}  // namespace intercom_audio
+}  // namespace esphome
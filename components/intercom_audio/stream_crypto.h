@@ -0,0 +1,123 @@
+#pragma once
+
+// Authenticated encryption of framed packets, SRTP style:
+//   - per-session keys, one per direction, derived from a pre-shared key and
+//     both peers' random HELLO nonces (HMAC-SHA256)
+//   - AES-256-GCM (ESP32 AES hardware through mbedTLS) or ChaCha20-Poly1305
+//   - the 10-byte packet header is associated data, a 16-byte tag follows the body
+//   - 96-bit IV: 4-byte session salt, packet type, 32-bit extended sequence number
+//   - a 64-packet replay window per packet type
+// HELLO stays readable (it carries the nonces) but is authenticated with the
+// pre-shared key. Only mbedTLS is used, so it can be built and checked on the host.
+
+#include "packet.h"
+
+#include <mbedtls/gcm.h>
+// ChaCha20-Poly1305 is optional in mbedTLS (off in the ESP-IDF default
+// sdkconfig); gcm.h has pulled in the config that says whether it is built
+#ifdef MBEDTLS_CHACHAPOLY_C
+#include <mbedtls/chachapoly.h>
+#endif
+
+#include <cstddef>
+#include <cstdint>
+
+namespace esphome {
+namespace intercom_audio {
+
+enum class CipherSuite : uint8_t {
+  AES_256_GCM,
+  CHACHA20_POLY1305,
+};
+
+// Sliding replay window over 16-bit wire sequence numbers, extended to 32 bits
+class ReplayWindow {
+ public:
+  void reset() { this->started_ = false; }
+  // Extended index of seq; false if it was already received or is too old
+  bool check(uint16_t seq, uint32_t *index) const;
+  // Record index; only call once the packet authenticated
+  void accept(uint32_t index);
+
+ protected:
+  static const uint32_t SIZE = 64;
+  bool started_{false};
+  uint32_t highest_{0};
+  uint64_t bitmap_{0};  // Bit i: highest_ - i received
+};
+
+class StreamCrypto {
+ public:
+  static const size_t KEY_SIZE = 32;
+  static const size_t NONCE_SIZE = 16;  // Session nonce, sent in HELLO
+  static const size_t TAG_SIZE = 16;
+  // HELLO body: our nonce, the peer's nonce as we know it (zeros if not yet), tag
+  static const size_t HELLO_BODY_SIZE = 2 * NONCE_SIZE + TAG_SIZE;
+
+  StreamCrypto();
+  ~StreamCrypto();
+  StreamCrypto(const StreamCrypto &) = delete;
+  StreamCrypto &operator=(const StreamCrypto &) = delete;
+
+  void set_suite(CipherSuite suite) { this->suite_ = suite; }
+  CipherSuite get_suite() const { return this->suite_; }
+  // KEY_SIZE bytes; enables protection
+  void set_psk(const uint8_t *key);
+  bool is_enabled() const { return this->enabled_; }
+  // False if the suite is not compiled into this mbedTLS; keying an
+  // unsupported suite fails, so nothing is ever sent in the clear
+  static bool is_supported(CipherSuite suite);
+
+  // Start a session with a fresh random nonce; forgets the peer
+  void begin_session(const uint8_t *local_nonce);
+  bool is_keyed() const { return this->keyed_; }
+  bool is_peer_nonce(const uint8_t *nonce) const;
+
+  void write_hello(const uint8_t *header, uint8_t *body) const;
+  // Checks the tag. *peer_nonce points into body; *echo_ok is set when the
+  // peer echoed our current nonce (so the HELLO is not a replay)
+  bool verify_hello(const uint8_t *header, const uint8_t *body, size_t len, const uint8_t **peer_nonce,
+                    bool *echo_ok) const;
+  // Derive both directions' keys for this peer nonce and reset the replay windows
+  bool key_session(const uint8_t *peer_nonce);
+
+  // Encrypt len body bytes in place and append the tag (body needs len + TAG_SIZE)
+  bool seal(const uint8_t *header, const wire::PacketHeader &info, uint8_t *body, size_t len);
+  // Authenticate and decrypt in place; len includes the tag. False for forgeries and replays.
+  bool open(const uint8_t *header, const wire::PacketHeader &info, uint8_t *body, size_t len);
+
+ protected:
+  static const size_t IV_SIZE = 12;
+  static const size_t SALT_SIZE = 4;
+  static const size_t TYPES = 6;  // Indexed by PacketType value
+
+  struct Direction {
+    mbedtls_gcm_context gcm;
+#ifdef MBEDTLS_CHACHAPOLY_C
+    mbedtls_chachapoly_context chachapoly;
+#endif
+    uint8_t salt[SALT_SIZE]{};
+  };
+
+  void hmac_(const char *label, const uint8_t *a, size_t a_len, const uint8_t *b, size_t b_len,
+             uint8_t *out) const;
+  bool set_key_(Direction &dir, const uint8_t *sender_nonce, const uint8_t *receiver_nonce);
+  void make_iv_(const Direction &dir, uint8_t type, uint32_t index, uint8_t *iv) const;
+
+  CipherSuite suite_{CipherSuite::AES_256_GCM};
+  bool enabled_{false};
+  bool keyed_{false};
+  uint8_t psk_[KEY_SIZE]{};
+  uint8_t local_nonce_[NONCE_SIZE]{};
+  uint8_t peer_nonce_[NONCE_SIZE]{};
+
+  Direction tx_;
+  Direction rx_;
+  // Sender side extended sequence numbers, per packet type
+  bool tx_started_[TYPES]{};
+  uint32_t tx_index_[TYPES]{};
+  ReplayWindow rx_window_[TYPES];
+};
+
+}  // namespace intercom_audio
+}  // namespace esphome
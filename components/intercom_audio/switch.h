@@ -49,5 +49,26 @@ class IntercomAudioAecSwitch : public switch_::Switch, public Component {
   IntercomAudio *parent_{nullptr};
 };
 
+class IntercomAudioTraceSwitch : public switch_::Switch, public Component {
+ public:
+  void setup() override {
+    if (this->parent_ != nullptr) {
+      this->publish_state(this->parent_->is_trace_enabled());
+    }
+  }
+
+  void write_state(bool state) override {
+    if (this->parent_ == nullptr) return;
+    // Stays off without a trace ring (no trace: config, or PSRAM allocation failed)
+    this->parent_->set_trace_enabled(state);
+    this->publish_state(this->parent_->is_trace_enabled());
+  }
+
+  void set_parent(IntercomAudio *parent) { this->parent_ = parent; }
+
+ protected:
+  IntercomAudio *parent_{nullptr};
+};
+
 }  // namespace intercom_audio
 }  // namespace esphome
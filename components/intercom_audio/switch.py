@@ -3,13 +3,14 @@
 import esphome.codegen as cg
 import esphome.config_validation as cv
 from esphome.components import switch
-from esphome.const import CONF_ID
+from esphome.const import CONF_ID, ENTITY_CATEGORY_CONFIG
 
 from . import IntercomAudio, intercom_audio_ns
 
 CONF_INTERCOM_AUDIO_ID = "intercom_audio_id"
 CONF_STREAMING = "streaming"
 CONF_AEC = "aec"
+CONF_TRACE = "trace"
 
 IntercomAudioSwitch = intercom_audio_ns.class_(
     "IntercomAudioSwitch", switch.Switch, cg.Component
@@ -19,6 +20,10 @@ IntercomAudioAecSwitch = intercom_audio_ns.class_(
     "IntercomAudioAecSwitch", switch.Switch, cg.Component
 )
 
+IntercomAudioTraceSwitch = intercom_audio_ns.class_(
+    "IntercomAudioTraceSwitch", switch.Switch, cg.Component
+)
+
 CONFIG_SCHEMA = cv.Schema({
     cv.GenerateID(CONF_INTERCOM_AUDIO_ID): cv.use_id(IntercomAudio),
     cv.Optional(CONF_STREAMING): switch.switch_schema(
@@ -29,6 +34,11 @@ CONFIG_SCHEMA = cv.Schema({
         IntercomAudioAecSwitch,
         icon="mdi:echo-off",
     ),
+    cv.Optional(CONF_TRACE): switch.switch_schema(
+        IntercomAudioTraceSwitch,
+        icon="mdi:record-rec",
+        entity_category=ENTITY_CATEGORY_CONFIG,
+    ),
 })
 
 
@@ -46,3 +56,9 @@ async def to_code(config):
         sw = await switch.new_switch(conf)
         await cg.register_component(sw, conf)
         cg.add(sw.set_parent(parent))
+
+    if CONF_TRACE in config:
+        conf = config[CONF_TRACE]
+        sw = await switch.new_switch(conf)
+        await cg.register_component(sw, conf)
+        cg.add(sw.set_parent(parent))
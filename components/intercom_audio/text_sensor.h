@@ -37,5 +37,41 @@ class IntercomAudioModeTextSensor : public text_sensor::TextSensor, public Compo
   IntercomAudio *parent_{nullptr};
 };
 
+// Link text sensor - what we currently send, e.g. "raw", "pcm x1", "ulaw x2 +red"
+class IntercomAudioLinkTextSensor : public text_sensor::TextSensor, public PollingComponent {
+ public:
+  void update() override {
+    if (this->parent_ == nullptr) return;
+
+    std::string link = this->parent_->get_link_state();
+    if (link != this->state) {
+      this->publish_state(link);
+    }
+  }
+
+  void set_parent(IntercomAudio *parent) { this->parent_ = parent; }
+
+ protected:
+  IntercomAudio *parent_{nullptr};
+};
+
+// Latency text sensor - per-stage breakdown of what we play, "idle" between calls
+class IntercomAudioLatencyTextSensor : public text_sensor::TextSensor, public PollingComponent {
+ public:
+  void update() override {
+    if (this->parent_ == nullptr) return;
+
+    std::string latency = this->parent_->is_streaming() ? this->parent_->get_latency_summary() : "idle";
+    if (latency != this->state) {
+      this->publish_state(latency);
+    }
+  }
+
+  void set_parent(IntercomAudio *parent) { this->parent_ = parent; }
+
+ protected:
+  IntercomAudio *parent_{nullptr};
+};
+
 }  // namespace intercom_audio
 }  // namespace esphome
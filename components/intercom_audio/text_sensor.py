@@ -10,6 +10,8 @@ from . import IntercomAudio, intercom_audio_ns
 CONF_INTERCOM_AUDIO_ID = "intercom_audio_id"
 CONF_STATE = "state"
 CONF_MODE = "mode"
+CONF_LINK = "link"
+CONF_LATENCY = "latency"
 
 IntercomAudioTextSensor = intercom_audio_ns.class_(
     "IntercomAudioTextSensor", text_sensor.TextSensor, cg.PollingComponent
@@ -19,6 +21,14 @@ IntercomAudioModeTextSensor = intercom_audio_ns.class_(
     "IntercomAudioModeTextSensor", text_sensor.TextSensor, cg.Component
 )
 
+IntercomAudioLinkTextSensor = intercom_audio_ns.class_(
+    "IntercomAudioLinkTextSensor", text_sensor.TextSensor, cg.PollingComponent
+)
+
+IntercomAudioLatencyTextSensor = intercom_audio_ns.class_(
+    "IntercomAudioLatencyTextSensor", text_sensor.TextSensor, cg.PollingComponent
+)
+
 CONFIG_SCHEMA = cv.Schema({
     cv.GenerateID(CONF_INTERCOM_AUDIO_ID): cv.use_id(IntercomAudio),
     cv.Optional(CONF_STATE): text_sensor.text_sensor_schema(
@@ -27,6 +37,14 @@ CONFIG_SCHEMA = cv.Schema({
     cv.Optional(CONF_MODE): text_sensor.text_sensor_schema(
         entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
     ).extend({cv.GenerateID(): cv.declare_id(IntercomAudioModeTextSensor)}),
+    cv.Optional(CONF_LINK): text_sensor.text_sensor_schema(
+        entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+    ).extend({cv.GenerateID(): cv.declare_id(IntercomAudioLinkTextSensor)}).extend(cv.polling_component_schema("1s")),
+    cv.Optional(CONF_LATENCY): text_sensor.text_sensor_schema(
+        entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+    ).extend({cv.GenerateID(): cv.declare_id(IntercomAudioLatencyTextSensor)}).extend(
+        cv.polling_component_schema("5s")
+    ),
 })
 
 
@@ -43,3 +61,15 @@ async def to_code(config):
         sens = await text_sensor.new_text_sensor(conf)
         await cg.register_component(sens, conf)
         cg.add(sens.set_parent(parent))
+
+    if CONF_LINK in config:
+        conf = config[CONF_LINK]
+        sens = await text_sensor.new_text_sensor(conf)
+        await cg.register_component(sens, conf)
+        cg.add(sens.set_parent(parent))
+
+    if CONF_LATENCY in config:
+        conf = config[CONF_LATENCY]
+        sens = await text_sensor.new_text_sensor(conf)
+        await cg.register_component(sens, conf)
+        cg.add(sens.set_parent(parent))
@@ -0,0 +1,131 @@
+#include "web_export.h"
+
+#ifdef USE_ESP32
+#ifdef USE_INTERCOM_WEB_EXPORT
+
+#include "esphome/core/log.h"
+
+#include <esp_heap_caps.h>
+#include <esp_http_server.h>
+
+#include <string>
+
+namespace esphome {
+namespace intercom_audio {
+
+static const char *const TAG = "intercom_audio.export";
+
+void ChunkedExport::setup() {
+  this->base_->init();
+  this->base_->add_handler(this);
+}
+
+uint8_t *ChunkedExport::begin_(AsyncWebServerRequest *request, size_t chunk_bytes, const char *type,
+                               const char *filename) {
+  uint8_t *chunk = (uint8_t *) heap_caps_malloc(chunk_bytes, MALLOC_CAP_INTERNAL);
+  if (chunk == nullptr) {
+    request->send(503, "text/plain", "Out of memory");
+    return nullptr;
+  }
+  httpd_req_t *req = *request;
+  httpd_resp_set_type(req, type);
+  std::string disposition;
+  if (filename != nullptr) {
+    disposition = std::string("attachment; filename=\"") + filename + "\"";
+    httpd_resp_set_hdr(req, "Content-Disposition", disposition.c_str());
+  }
+  httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+  return chunk;
+}
+
+bool ChunkedExport::send_(AsyncWebServerRequest *request, const uint8_t *data, size_t len) {
+  return httpd_resp_send_chunk(*request, (const char *) data, len) == ESP_OK;
+}
+
+void ChunkedExport::end_(AsyncWebServerRequest *request, uint8_t *chunk, bool complete) {
+  if (complete) {
+    httpd_resp_send_chunk(*request, nullptr, 0);
+  }
+  heap_caps_free(chunk);
+}
+
+void RecordingExport::handleRequest(AsyncWebServerRequest *request) {
+  AudioRecorder::Reader reader;
+  if (!this->recorder_->open(&reader)) {
+    request->send(404, "text/plain", "No recording");
+    return;
+  }
+  uint8_t *chunk = this->begin_(request, CHUNK_BYTES, "audio/wav", "recording.wav");
+  if (chunk == nullptr) {
+    return;
+  }
+
+  size_t total = 0;
+  size_t len = this->recorder_->write_wav_header(reader, chunk);
+  bool ok = this->send_(request, chunk, len);
+  while (ok && (len = this->recorder_->read(&reader, chunk, CHUNK_BYTES)) > 0) {
+    ok = this->send_(request, chunk, len);
+    total += len;
+  }
+  this->end_(request, chunk, ok);
+  if (ok) {
+    ESP_LOGD(TAG, "Sent %zu bytes of audio", total);
+  } else {
+    ESP_LOGW(TAG, "Recording export aborted after %zu bytes", total);
+  }
+  if (reader.gaps > 0) {
+    // The client read slower than the writer wrapped the ring
+    ESP_LOGW(TAG, "%u chunk(s) overwritten during the export, sent as silence", (unsigned) reader.gaps);
+  }
+}
+
+void TraceExport::handleRequest(AsyncWebServerRequest *request) {
+  AudioTrace::Reader reader;
+  this->trace_->open(&reader);
+  size_t chunk_bytes = CHUNK_RECORDS * this->trace_->get_record_size();
+  uint8_t *chunk = this->begin_(request, chunk_bytes, "application/octet-stream", "intercom-trace.bin");
+  if (chunk == nullptr) {
+    return;
+  }
+
+  size_t records = 0;
+  size_t len = this->trace_->write_file_header(chunk);
+  bool ok = this->send_(request, chunk, len);
+  while (ok && (len = this->trace_->read(&reader, chunk, chunk_bytes)) > 0) {
+    ok = this->send_(request, chunk, len);
+    records += len / this->trace_->get_record_size();
+  }
+  this->end_(request, chunk, ok);
+  if (ok) {
+    ESP_LOGD(TAG, "Sent %zu trace records (%u overwritten while sending)", records, (unsigned) reader.lost);
+  } else {
+    ESP_LOGW(TAG, "Trace export aborted after %zu records", records);
+  }
+}
+
+void MetricsExport::handleRequest(AsyncWebServerRequest *request) {
+  // Everything is read before the first byte goes out, so a slow client
+  // cannot skew one value against another
+  this->snapshot_.clear();
+  this->collect_(this->snapshot_);
+  if (this->snapshot_.get_dropped() > 0) {
+    ESP_LOGW(TAG, "%zu metrics did not fit the snapshot", this->snapshot_.get_dropped());
+  }
+  uint8_t *chunk = this->begin_(request, CHUNK_BYTES, "text/plain; version=0.0.4; charset=utf-8", nullptr);
+  if (chunk == nullptr) {
+    return;
+  }
+  bool ok = this->snapshot_.write((char *) chunk, CHUNK_BYTES, [this, request](const char *data, size_t len) {
+    return this->send_(request, (const uint8_t *) data, len);
+  });
+  this->end_(request, chunk, ok);
+  if (!ok) {
+    ESP_LOGW(TAG, "Metrics export aborted");
+  }
+}
+
+}  // namespace intercom_audio
+}  // namespace esphome
+
+#endif  // USE_INTERCOM_WEB_EXPORT
+#endif  // USE_ESP32
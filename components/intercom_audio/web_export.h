@@ -0,0 +1,93 @@
+#pragma once
+
+#ifdef USE_ESP32
+#ifdef USE_INTERCOM_WEB_EXPORT
+
+#include "esphome/components/web_server_base/web_server_base.h"
+
+#include "audio_recorder.h"
+#include "audio_trace.h"
+#include "metrics.h"
+
+#include <functional>
+#include <string>
+
+namespace esphome {
+namespace intercom_audio {
+
+// One GET path on the local web server, answered with chunked transfer
+// encoding straight out of a PSRAM ring in small pieces. Runs in the HTTP
+// server task and takes no lock the audio tasks use.
+class ChunkedExport : public AsyncWebHandler {
+ public:
+  ChunkedExport(web_server_base::WebServerBase *base, const std::string &path) : base_(base), path_(path) {}
+
+  void setup();
+  const std::string &get_path() const { return this->path_; }
+
+  bool canHandle(AsyncWebServerRequest *request) const override {
+    return request->method() == HTTP_GET && request->url() == this->path_;
+  }
+
+ protected:
+  // Set the response headers and allocate a chunk buffer (a 503 is sent if that fails).
+  // Without a filename the response is shown inline rather than downloaded.
+  uint8_t *begin_(AsyncWebServerRequest *request, size_t chunk_bytes, const char *type, const char *filename);
+  // Send one chunk; false once the client is gone
+  bool send_(AsyncWebServerRequest *request, const uint8_t *data, size_t len);
+  void end_(AsyncWebServerRequest *request, uint8_t *chunk, bool complete);
+
+  web_server_base::WebServerBase *base_;
+  std::string path_;
+};
+
+// GET <path>: the current (or last) recording as a WAV file
+class RecordingExport : public ChunkedExport {
+ public:
+  RecordingExport(web_server_base::WebServerBase *base, AudioRecorder *recorder, const std::string &path)
+      : ChunkedExport(base, path), recorder_(recorder) {}
+
+  void handleRequest(AsyncWebServerRequest *request) override;
+
+ protected:
+  static const size_t CHUNK_BYTES = 2048;
+
+  AudioRecorder *recorder_;
+};
+
+// GET <path>: the trace ring, oldest record first (tools/trace_report.py reads it)
+class TraceExport : public ChunkedExport {
+ public:
+  TraceExport(web_server_base::WebServerBase *base, AudioTrace *trace, const std::string &path)
+      : ChunkedExport(base, path), trace_(trace) {}
+
+  void handleRequest(AsyncWebServerRequest *request) override;
+
+ protected:
+  static const size_t CHUNK_RECORDS = 4;
+
+  AudioTrace *trace_;
+};
+
+// GET <path>: counters and latency histograms in the Prometheus text format,
+// collected into one snapshot before any of it is sent
+class MetricsExport : public ChunkedExport {
+ public:
+  MetricsExport(web_server_base::WebServerBase *base, std::function<void(MetricsSnapshot &)> collect,
+                const std::string &path)
+      : ChunkedExport(base, path), collect_(std::move(collect)) {}
+
+  void handleRequest(AsyncWebServerRequest *request) override;
+
+ protected:
+  static const size_t CHUNK_BYTES = 1024;
+
+  std::function<void(MetricsSnapshot &)> collect_;
+  MetricsSnapshot snapshot_;  // The HTTP server handles one request at a time
+};
+
+}  // namespace intercom_audio
+}  // namespace esphome
+
+#endif  // USE_INTERCOM_WEB_EXPORT
+#endif  // USE_ESP32
@@ -39,7 +39,10 @@ CONFIG_SCHEMA = cv.Schema(
     {
         cv.GenerateID(): cv.declare_id(MdnsDiscovery),
         cv.Required(CONF_SERVICE_TYPE): cv.string,
-        cv.Optional(CONF_SCAN_INTERVAL, default="10s"): cv.positive_time_period_milliseconds,
+        # "never": scan only on mdns_discovery.scan (e.g. when a call is placed)
+        cv.Optional(CONF_SCAN_INTERVAL, default="10s"): cv.Any(
+            cv.one_of("never", lower=True), cv.positive_time_period_milliseconds
+        ),
         cv.Optional(CONF_PEER_TIMEOUT, default="60s"): cv.positive_time_period_milliseconds,
         cv.Optional(CONF_ON_PEER_FOUND): automation.validate_automation(
             {
@@ -63,9 +66,12 @@ CONFIG_SCHEMA = cv.Schema(
 async def to_code(config):
     var = cg.new_Pvariable(config[CONF_ID])
     await cg.register_component(var, config)
+    # Lets other components (intercom_audio metrics) reference it
+    cg.add_define("USE_MDNS_DISCOVERY")
 
     cg.add(var.set_service_type(config[CONF_SERVICE_TYPE]))
-    cg.add(var.set_scan_interval(config[CONF_SCAN_INTERVAL]))
+    scan_interval = config[CONF_SCAN_INTERVAL]
+    cg.add(var.set_scan_interval(0 if isinstance(scan_interval, str) else scan_interval))
     cg.add(var.set_peer_timeout(config[CONF_PEER_TIMEOUT]))
 
     # Triggers
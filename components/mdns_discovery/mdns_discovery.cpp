@@ -13,31 +13,53 @@ namespace mdns_discovery {
 static const char *TAG = "mdns_discovery";
 
 void MdnsDiscovery::setup() {
-  // Config logged via dump_config()
-}
-
-void MdnsDiscovery::loop() {
-  uint32_t now = millis();
-
-  // Periodic scan
-  if (now - this->last_scan_ > this->scan_interval_) {
-    this->query_peers_();
-    this->cleanup_stale_peers_();
-    this->last_scan_ = now;
+  // Scans run from the scheduler (or on demand), so there is no per-loop
+  // polling; between scans only the expiry timeout of a known peer can run
+  if (this->scan_interval_ > 0) {
+    this->set_interval("scan", this->scan_interval_, [this]() { this->scan_now(); });
   }
 }
 
 void MdnsDiscovery::dump_config() {
   ESP_LOGCONFIG(TAG, "mDNS Discovery:");
   ESP_LOGCONFIG(TAG, "  Service Type: %s", this->service_type_.c_str());
-  ESP_LOGCONFIG(TAG, "  Scan Interval: %d ms", this->scan_interval_);
+  if (this->scan_interval_ > 0) {
+    ESP_LOGCONFIG(TAG, "  Scan Interval: %d ms", this->scan_interval_);
+  } else {
+    ESP_LOGCONFIG(TAG, "  Scan Interval: on demand");
+  }
   ESP_LOGCONFIG(TAG, "  Peer Timeout: %d ms", this->peer_timeout_);
 }
 
 void MdnsDiscovery::scan_now() {
+  uint32_t start = millis();
   this->query_peers_();
   this->cleanup_stale_peers_();
-  this->last_scan_ = millis();
+  this->last_scan_ms_.store(millis() - start, std::memory_order_relaxed);
+  this->scans_.fetch_add(1, std::memory_order_relaxed);
+  this->known_peers_.store(this->peers_.size(), std::memory_order_relaxed);
+  this->schedule_expiry_();
+}
+
+void MdnsDiscovery::schedule_expiry_() {
+  // One timeout for the peer that goes stale first: without periodic scans
+  // (scan_interval: never) nothing else would ever report it lost. No query
+  // is sent, and with no peers known nothing is scheduled at all.
+  if (this->peers_.empty()) {
+    this->cancel_timeout("expire");
+    return;
+  }
+  uint32_t now = millis();
+  uint32_t next = this->peer_timeout_;
+  for (const auto &peer : this->peers_) {
+    uint32_t age = now - peer.last_seen;
+    next = std::min(next, age >= this->peer_timeout_ ? 0 : this->peer_timeout_ - age);
+  }
+  this->set_timeout("expire", next + 1, [this]() {
+    this->cleanup_stale_peers_();
+    this->known_peers_.store(this->peers_.size(), std::memory_order_relaxed);
+    this->schedule_expiry_();
+  });
 }
 
 void MdnsDiscovery::query_peers_() {
@@ -67,6 +89,7 @@ void MdnsDiscovery::query_peers_() {
   esp_err_t err = mdns_query_ptr(service.c_str(), protocol.c_str(), 1000, 10, &results);
   if (err != ESP_OK) {
     ESP_LOGW(TAG, "mDNS query failed: %s", esp_err_to_name(err));
+    this->scan_failures_.fetch_add(1, std::memory_order_relaxed);
     this->scan_complete_callbacks_.call(this->peers_.size());
     return;
   }
@@ -110,6 +133,7 @@ void MdnsDiscovery::query_peers_() {
           new_peer.last_seen = millis();
           new_peer.active = true;
           this->peers_.push_back(new_peer);
+          this->peers_found_.fetch_add(1, std::memory_order_relaxed);
 
           ESP_LOGI(TAG, "Peer found: %s (%s:%d)", peer_name.c_str(), ip_str, r->port);
           this->peer_found_callbacks_.call(peer_name, std::string(ip_str), r->port);
@@ -131,6 +155,7 @@ void MdnsDiscovery::cleanup_stale_peers_() {
       ESP_LOGI(TAG, "Peer lost: %s", it->name.c_str());
       this->peer_lost_callbacks_.call(it->name);
       it = this->peers_.erase(it);
+      this->peers_lost_.fetch_add(1, std::memory_order_relaxed);
     } else {
       ++it;
     }
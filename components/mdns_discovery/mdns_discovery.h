@@ -6,6 +6,7 @@
 #include "esphome/components/sensor/sensor.h"
 #include "esphome/components/text_sensor/text_sensor.h"
 
+#include <atomic>
 #include <string>
 #include <vector>
 
@@ -23,12 +24,12 @@ struct PeerInfo {
 class MdnsDiscovery : public Component {
  public:
   void setup() override;
-  void loop() override;
   void dump_config() override;
   float get_setup_priority() const override { return setup_priority::AFTER_WIFI; }
 
   // Configuration
   void set_service_type(const std::string &type) { this->service_type_ = type; }
+  // 0: no periodic scans, only mdns_discovery.scan (nothing runs between scans)
   void set_scan_interval(uint32_t interval) { this->scan_interval_ = interval; }
   void set_peer_timeout(uint32_t timeout) { this->peer_timeout_ = timeout; }
 
@@ -42,6 +43,14 @@ class MdnsDiscovery : public Component {
   std::string get_peers_list() const;
   const std::vector<PeerInfo>& get_peers() const { return this->peers_; }
 
+  // Scan statistics, safe to read from any task (the peer list itself is main loop only)
+  uint32_t get_known_peers() const { return this->known_peers_.load(std::memory_order_relaxed); }
+  uint32_t get_scans() const { return this->scans_.load(std::memory_order_relaxed); }
+  uint32_t get_scan_failures() const { return this->scan_failures_.load(std::memory_order_relaxed); }
+  uint32_t get_peers_found() const { return this->peers_found_.load(std::memory_order_relaxed); }
+  uint32_t get_peers_lost() const { return this->peers_lost_.load(std::memory_order_relaxed); }
+  uint32_t get_last_scan_ms() const { return this->last_scan_ms_.load(std::memory_order_relaxed); }
+
   // Callbacks
   void add_on_peer_found_callback(std::function<void(std::string, std::string, uint16_t)> callback) {
     this->peer_found_callbacks_.add(std::move(callback));
@@ -56,14 +65,21 @@ class MdnsDiscovery : public Component {
  protected:
   void query_peers_();
   void cleanup_stale_peers_();
+  void schedule_expiry_();
 
   std::string service_type_;
   uint32_t scan_interval_{10000};
   uint32_t peer_timeout_{60000};
-  uint32_t last_scan_{0};
 
   std::vector<PeerInfo> peers_;
 
+  std::atomic<uint32_t> known_peers_{0};
+  std::atomic<uint32_t> scans_{0};
+  std::atomic<uint32_t> scan_failures_{0};
+  std::atomic<uint32_t> peers_found_{0};
+  std::atomic<uint32_t> peers_lost_{0};
+  std::atomic<uint32_t> last_scan_ms_{0};  // The query blocks the main loop for up to 1 s
+
   CallbackManager<void(std::string, std::string, uint16_t)> peer_found_callbacks_;
   CallbackManager<void(std::string)> peer_lost_callbacks_;
   CallbackManager<void(int)> scan_complete_callbacks_;
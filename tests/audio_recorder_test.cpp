@@ -0,0 +1,225 @@
+// Recording ring: pre-roll and stop boundaries, readers lapped by the writer,
+// and the WAV headers of both formats
+
+#include "intercom_audio/audio_recorder.h"
+#include "intercom_audio/g711.h"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <vector>
+
+namespace esphome {
+namespace intercom_audio {
+namespace {
+
+// 1 kHz keeps sample positions and milliseconds the same; 1 s of history is
+// rounded up to 1024 samples
+static const uint32_t SAMPLE_RATE = 1000;
+static const uint32_t CAPACITY = 1024;
+
+uint16_t le16(const uint8_t *p) { return (uint16_t) (p[0] | p[1] << 8); }
+uint32_t le32(const uint8_t *p) { return le16(p) | (uint32_t) le16(p + 2) << 16; }
+
+class AudioRecorderTest : public ::testing::Test {
+ protected:
+  void SetUp() override { this->configure(RecordFormat::PCM16, 0); }
+
+  void configure(RecordFormat format, uint32_t pre_roll_ms) {
+    this->recorder.set_sample_rate(SAMPLE_RATE);
+    this->recorder.set_format(format);
+    this->recorder.set_history_ms(1000);
+    this->recorder.set_pre_roll_ms(pre_roll_ms);
+  }
+
+  // Sample n of the stream is n
+  void write(size_t samples) {
+    std::vector<int16_t> pcm(samples);
+    for (auto &s : pcm) {
+      s = (int16_t) this->next++;
+    }
+    ASSERT_TRUE(this->recorder.write(pcm.data(), pcm.size()));
+  }
+
+  std::vector<int16_t> read(AudioRecorder::Reader *reader, size_t max_samples) {
+    std::vector<int16_t> out(max_samples);
+    size_t bytes = this->recorder.read(reader, reinterpret_cast<uint8_t *>(out.data()), max_samples * 2);
+    out.resize(bytes / 2);
+    return out;
+  }
+
+  static std::vector<int16_t> ramp(int16_t first, size_t count) {
+    std::vector<int16_t> out(count);
+    for (size_t i = 0; i < count; i++) {
+      out[i] = (int16_t) (first + i);
+    }
+    return out;
+  }
+
+  AudioRecorder recorder;
+  uint32_t next{0};
+};
+
+TEST_F(AudioRecorderTest, HistoryIsRoundedToAPowerOfTwo) {
+  ASSERT_TRUE(this->recorder.allocate());
+  EXPECT_EQ(this->recorder.get_memory_bytes(), CAPACITY * 2);
+  EXPECT_EQ(this->recorder.get_capacity_ms(), CAPACITY);
+  this->write(300);
+  EXPECT_FLOAT_EQ(this->recorder.get_buffered_seconds(), 0.3f);
+  this->write(2000);
+  EXPECT_FLOAT_EQ(this->recorder.get_buffered_seconds(), CAPACITY / 1000.0f);
+}
+
+TEST_F(AudioRecorderTest, RecordingStartsAPreRollBeforeAndEndsAtStop) {
+  this->configure(RecordFormat::PCM16, 100);
+  ASSERT_TRUE(this->recorder.allocate());
+  this->write(500);
+  this->recorder.start_recording();
+  this->write(200);
+  this->recorder.stop_recording();
+  this->write(100);
+
+  AudioRecorder::Reader reader;
+  ASSERT_TRUE(this->recorder.open(&reader));
+  EXPECT_EQ(reader.end - reader.pos, 300u);
+  EXPECT_EQ(this->read(&reader, 1000), ramp(400, 300));
+  EXPECT_TRUE(this->read(&reader, 1000).empty());
+  EXPECT_EQ(reader.gaps, 0u);
+}
+
+TEST_F(AudioRecorderTest, PreRollIsLimitedToWhatIsHeld) {
+  this->configure(RecordFormat::PCM16, 100);
+  ASSERT_TRUE(this->recorder.allocate());
+  this->write(30);
+  this->recorder.start_recording();
+  this->write(10);
+
+  // Still recording: exported up to now
+  AudioRecorder::Reader reader;
+  ASSERT_TRUE(this->recorder.open(&reader));
+  EXPECT_EQ(this->read(&reader, 1000), ramp(0, 40));
+}
+
+TEST_F(AudioRecorderTest, ReadAfterTheWriterLapsTheReaderIsSilenceAndAGap) {
+  ASSERT_TRUE(this->recorder.allocate());
+  this->write(100);
+  this->recorder.start_recording();
+  this->write(400);
+  this->recorder.stop_recording();
+
+  AudioRecorder::Reader reader;
+  ASSERT_TRUE(this->recorder.open(&reader));
+  EXPECT_EQ(this->read(&reader, 100), ramp(100, 100));
+
+  // A full ring later everything the reader has left is overwritten
+  this->write(CAPACITY);
+  for (int chunk = 0; chunk < 3; chunk++) {
+    EXPECT_EQ(this->read(&reader, 100), std::vector<int16_t>(100, 0)) << "chunk " << chunk;
+  }
+  EXPECT_EQ(reader.gaps, 3u);
+  EXPECT_TRUE(this->read(&reader, 100).empty());
+
+  // Opened now, the recording is gone altogether
+  ASSERT_TRUE(this->recorder.open(&reader));
+  EXPECT_EQ(reader.end, reader.pos);
+}
+
+TEST_F(AudioRecorderTest, OpenSkipsTheStartTheWriterOverwrote) {
+  ASSERT_TRUE(this->recorder.allocate());
+  this->recorder.start_recording();
+  this->write(CAPACITY);
+  this->write(200);
+  this->recorder.stop_recording();
+
+  AudioRecorder::Reader reader;
+  ASSERT_TRUE(this->recorder.open(&reader));
+  EXPECT_EQ(reader.end - reader.pos, CAPACITY);
+  EXPECT_EQ(this->read(&reader, CAPACITY), ramp(200, CAPACITY));
+  EXPECT_EQ(reader.gaps, 0u);
+}
+
+TEST_F(AudioRecorderTest, NothingToOpenWithoutARecording) {
+  AudioRecorder::Reader reader;
+  EXPECT_FALSE(this->recorder.open(&reader));  // Not allocated
+  ASSERT_TRUE(this->recorder.allocate());
+  this->write(100);
+  EXPECT_FALSE(this->recorder.open(&reader));
+}
+
+TEST_F(AudioRecorderTest, PcmWavHeader) {
+  ASSERT_TRUE(this->recorder.allocate());
+  this->recorder.start_recording();
+  this->write(250);
+  this->recorder.stop_recording();
+
+  AudioRecorder::Reader reader;
+  ASSERT_TRUE(this->recorder.open(&reader));
+  uint8_t header[AudioRecorder::WAV_HEADER_MAX];
+  ASSERT_EQ(this->recorder.write_wav_header(reader, header), 44u);
+  EXPECT_EQ(memcmp(header, "RIFF", 4), 0);
+  EXPECT_EQ(le32(header + 4), 36u + 500u);
+  EXPECT_EQ(memcmp(header + 8, "WAVEfmt ", 8), 0);
+  EXPECT_EQ(le32(header + 16), 16u);
+  EXPECT_EQ(le16(header + 20), 1);  // PCM
+  EXPECT_EQ(le32(header + 24), SAMPLE_RATE);
+  EXPECT_EQ(le32(header + 28), SAMPLE_RATE * 2);
+  EXPECT_EQ(le16(header + 34), 16);
+  EXPECT_EQ(memcmp(header + 36, "data", 4), 0);
+  EXPECT_EQ(le32(header + 40), 500u);
+}
+
+TEST_F(AudioRecorderTest, UlawWavHeaderAndData) {
+  this->configure(RecordFormat::ULAW, 0);
+  ASSERT_TRUE(this->recorder.allocate());
+  EXPECT_EQ(this->recorder.get_memory_bytes(), CAPACITY);
+  this->recorder.start_recording();
+  std::vector<int16_t> pcm = {0, 1000, -1000, 32767, -32768, 12345};
+  ASSERT_TRUE(this->recorder.write(pcm.data(), pcm.size()));
+  this->recorder.stop_recording();
+
+  AudioRecorder::Reader reader;
+  ASSERT_TRUE(this->recorder.open(&reader));
+  uint8_t header[AudioRecorder::WAV_HEADER_MAX];
+  static_assert(AudioRecorder::WAV_HEADER_MAX == 58, "the µ-law header is the largest");
+  ASSERT_EQ(this->recorder.write_wav_header(reader, header), 58u);
+  EXPECT_EQ(le32(header + 4), 50u + 6u);
+  EXPECT_EQ(le32(header + 16), 18u);  // fmt with cbSize
+  EXPECT_EQ(le16(header + 20), 7);    // WAVE_FORMAT_MULAW
+  EXPECT_EQ(le32(header + 28), SAMPLE_RATE);
+  EXPECT_EQ(le16(header + 32), 1);
+  EXPECT_EQ(le16(header + 34), 8);
+  EXPECT_EQ(le16(header + 36), 0);
+  EXPECT_EQ(memcmp(header + 38, "fact", 4), 0);
+  EXPECT_EQ(le32(header + 42), 4u);
+  EXPECT_EQ(le32(header + 46), 6u);  // Samples
+  EXPECT_EQ(memcmp(header + 50, "data", 4), 0);
+  EXPECT_EQ(le32(header + 54), 6u);
+
+  uint8_t data[16];
+  ASSERT_EQ(this->recorder.read(&reader, data, sizeof(data)), 6u);
+  for (size_t i = 0; i < pcm.size(); i++) {
+    EXPECT_EQ(data[i], g711::ulaw_encode(pcm[i])) << "sample " << i;
+  }
+}
+
+TEST_F(AudioRecorderTest, UlawGapIsUlawSilence) {
+  this->configure(RecordFormat::ULAW, 0);
+  ASSERT_TRUE(this->recorder.allocate());
+  this->recorder.start_recording();
+  this->write(100);
+  this->recorder.stop_recording();
+
+  AudioRecorder::Reader reader;
+  ASSERT_TRUE(this->recorder.open(&reader));
+  this->write(CAPACITY);
+  uint8_t data[100];
+  ASSERT_EQ(this->recorder.read(&reader, data, sizeof(data)), 100u);
+  EXPECT_EQ(reader.gaps, 1u);
+  for (uint8_t code : data) {
+    ASSERT_EQ(code, 0xFF);
+  }
+}
+
+}  // namespace
+}  // namespace intercom_audio
+}  // namespace esphome
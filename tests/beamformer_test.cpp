@@ -0,0 +1,196 @@
+// Beamformer geometry (steering delay per mic), slot routing and the gain of
+// the delay-and-sum for a wave from the steered direction and from elsewhere
+
+#include "i2s_audio_duplex/beamformer.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+namespace esphome {
+namespace i2s_audio_duplex {
+namespace {
+
+static const uint32_t SAMPLE_RATE = 48000;
+static const size_t FRAME_SAMPLES = 256;
+
+// Samples a wave from the steered side travels between neighbouring mics
+float delay_samples(float spacing_m, float angle_deg) {
+  return spacing_m * sinf(angle_deg * (float) M_PI / 180.0f) * SAMPLE_RATE / 343.0f;
+}
+
+// A 1 kHz plane wave on a line of mics: mic m hears it lead_per_mic * m
+// samples before mic 0, one frame per call, interleaved over the slots
+class PlaneWave {
+ public:
+  PlaneWave(uint8_t slots, float lead_per_mic) : slots_(slots), lead_(lead_per_mic) {}
+
+  std::vector<int16_t> next_frame() {
+    std::vector<int16_t> frame(FRAME_SAMPLES * this->slots_);
+    for (size_t t = 0; t < FRAME_SAMPLES; t++, this->t_++) {
+      for (uint8_t m = 0; m < this->slots_; m++) {
+        frame[t * this->slots_ + m] = sample(this->t_ + this->lead_ * m);
+      }
+    }
+    return frame;
+  }
+
+  static int16_t sample(double t) { return (int16_t) lround(16000.0 * sin(2.0 * M_PI * 1000.0 * t / SAMPLE_RATE)); }
+
+ protected:
+  uint8_t slots_;
+  float lead_;
+  size_t t_{0};
+};
+
+double rms(const std::vector<int16_t> &samples) {
+  double sum = 0;
+  for (int16_t s : samples) {
+    sum += (double) s * s;
+  }
+  return sqrt(sum / samples.size());
+}
+
+// RMS of the beamformed output over the last of a few frames (history filled)
+double steered_rms(Beamformer &beamformer, PlaneWave &wave) {
+  std::vector<int16_t> out(FRAME_SAMPLES);
+  for (int i = 0; i < 4; i++) {
+    std::vector<int16_t> in = wave.next_frame();
+    beamformer.process(in.data(), out.data(), nullptr);
+  }
+  return rms(out);
+}
+
+TEST(BeamformerTest, DelayPerMicFollowsSpacingAndAngle) {
+  Beamformer beamformer;
+  // 5 cm at 30 degrees: 0.05 * 0.5 * 48000 / 343 = 3.4985 samples per mic
+  ASSERT_TRUE(beamformer.configure(4, -1, SAMPLE_RATE, 0.05f, 30.0f));
+  EXPECT_EQ(beamformer.get_mic_channels(), 4);
+  for (uint8_t m = 0; m < 4; m++) {
+    EXPECT_NEAR(beamformer.get_delay(m), 3.4985f * m, 0.001f) << "mic " << (int) m;
+  }
+
+  // The other side: the same delays in reverse, the last mic undelayed
+  ASSERT_TRUE(beamformer.configure(4, -1, SAMPLE_RATE, 0.05f, -30.0f));
+  for (uint8_t m = 0; m < 4; m++) {
+    EXPECT_NEAR(beamformer.get_delay(m), 3.4985f * (3 - m), 0.001f) << "mic " << (int) m;
+  }
+
+  // Broadside: a wave reaches every mic at once
+  ASSERT_TRUE(beamformer.configure(2, -1, SAMPLE_RATE, 0.05f, 0.0f));
+  EXPECT_EQ(beamformer.get_delay(0), 0.0f);
+  EXPECT_EQ(beamformer.get_delay(1), 0.0f);
+}
+
+TEST(BeamformerTest, RejectsGeometryBeyondTheDelayLine) {
+  Beamformer beamformer;
+  // 50 cm endfire at 48 kHz is 70 samples between two mics
+  EXPECT_FALSE(beamformer.configure(2, -1, SAMPLE_RATE, 0.5f, 90.0f));
+  EXPECT_TRUE(beamformer.configure(2, -1, SAMPLE_RATE, 0.4f, 90.0f));
+  // Slots out of range, or no mic left beside the reference
+  EXPECT_FALSE(beamformer.configure(0, -1, SAMPLE_RATE, 0.05f, 0.0f));
+  EXPECT_FALSE(beamformer.configure(Beamformer::MAX_SLOTS + 1, -1, SAMPLE_RATE, 0.05f, 0.0f));
+  EXPECT_FALSE(beamformer.configure(2, 2, SAMPLE_RATE, 0.05f, 0.0f));
+  EXPECT_FALSE(beamformer.configure(1, 0, SAMPLE_RATE, 0.05f, 0.0f));
+}
+
+TEST(BeamformerTest, InPhaseMicsSumAtUnityGain) {
+  for (uint8_t mics : {2, 3, 4}) {
+    Beamformer beamformer;
+    ASSERT_TRUE(beamformer.configure(mics, -1, SAMPLE_RATE, 0.05f, 0.0f));
+    ASSERT_TRUE(beamformer.allocate(FRAME_SAMPLES));
+
+    PlaneWave wave(mics, 0.0f);
+    std::vector<int16_t> in = wave.next_frame();
+    std::vector<int16_t> out(FRAME_SAMPLES);
+    beamformer.process(in.data(), out.data(), nullptr);
+    for (size_t t = 0; t < FRAME_SAMPLES; t++) {
+      ASSERT_NEAR(out[t], in[t * mics], 1) << (int) mics << " mics, sample " << t;
+    }
+  }
+}
+
+TEST(BeamformerTest, SteeredWaveKeepsItsLevelAcrossFrames) {
+  // Whole-sample delays, so the taps line the mics up exactly: 2 samples per mic
+  const float spacing = 2.0f * 343.0f / (SAMPLE_RATE * sinf(30.0f * (float) M_PI / 180.0f));
+  ASSERT_NEAR(delay_samples(spacing, 30.0f), 2.0f, 1e-4f);
+
+  Beamformer beamformer;
+  ASSERT_TRUE(beamformer.configure(4, -1, SAMPLE_RATE, spacing, 30.0f));
+  ASSERT_TRUE(beamformer.allocate(FRAME_SAMPLES));
+  PlaneWave wave(4, 2.0f);
+  std::vector<int16_t> out(FRAME_SAMPLES);
+  for (int i = 0; i < 4; i++) {
+    std::vector<int16_t> in = wave.next_frame();
+    beamformer.process(in.data(), out.data(), nullptr);
+  }
+  // Mic m is delayed by 2 * m samples, the first ones read from the previous
+  // frame's history, so all four line up with mic 0 and sum to the wave itself
+  for (size_t t = 0; t < FRAME_SAMPLES; t++) {
+    ASSERT_NEAR(out[t], PlaneWave::sample(3 * FRAME_SAMPLES + t), 1) << "sample " << t;
+  }
+}
+
+TEST(BeamformerTest, WaveFromElsewhereIsAttenuated) {
+  // Steered at +30 degrees; the same 1 kHz tone from -30 degrees arrives with
+  // the opposite lead and does not add up in phase
+  const float spacing = 0.05f;
+  const float lead = delay_samples(spacing, 30.0f);
+  Beamformer steered;
+  ASSERT_TRUE(steered.configure(4, -1, SAMPLE_RATE, spacing, 30.0f));
+  ASSERT_TRUE(steered.allocate(FRAME_SAMPLES));
+  PlaneWave on_axis(4, lead);
+  const double on = steered_rms(steered, on_axis);
+
+  Beamformer other;
+  ASSERT_TRUE(other.configure(4, -1, SAMPLE_RATE, spacing, 30.0f));
+  ASSERT_TRUE(other.allocate(FRAME_SAMPLES));
+  PlaneWave off_axis(4, -lead);
+  const double off = steered_rms(other, off_axis);
+
+  const double input = 16000.0 / sqrt(2.0);
+  EXPECT_NEAR(on / input, 1.0, 0.02);  // Fractional delays: interpolation loses a little
+  EXPECT_LT(20.0 * log10(off / on), -3.0);
+}
+
+TEST(BeamformerTest, ReferenceSlotIsSplitOut) {
+  Beamformer beamformer;
+  ASSERT_TRUE(beamformer.configure(3, 1, SAMPLE_RATE, 0.05f, 0.0f));
+  ASSERT_EQ(beamformer.get_mic_channels(), 2);
+  ASSERT_TRUE(beamformer.allocate(FRAME_SAMPLES));
+
+  std::vector<int16_t> in(FRAME_SAMPLES * 3);
+  for (size_t t = 0; t < FRAME_SAMPLES; t++) {
+    in[t * 3 + 0] = 1000;
+    in[t * 3 + 1] = (int16_t) t;  // Loopback
+    in[t * 3 + 2] = 3000;
+  }
+  std::vector<int16_t> out(FRAME_SAMPLES), reference(FRAME_SAMPLES);
+  beamformer.process(in.data(), out.data(), reference.data());
+  for (size_t t = 0; t < FRAME_SAMPLES; t++) {
+    ASSERT_EQ(reference[t], (int16_t) t);
+    ASSERT_NEAR(out[t], 2000, 1);  // The mean of the two mics, without the reference
+  }
+}
+
+TEST(BeamformerTest, SingleMicPassesThrough) {
+  Beamformer beamformer;
+  ASSERT_TRUE(beamformer.configure(2, 0, SAMPLE_RATE, 0.05f, 45.0f));
+  ASSERT_TRUE(beamformer.allocate(FRAME_SAMPLES));
+
+  std::vector<int16_t> in(FRAME_SAMPLES * 2);
+  for (size_t t = 0; t < FRAME_SAMPLES; t++) {
+    in[t * 2] = -7;
+    in[t * 2 + 1] = (int16_t) (t * 3);
+  }
+  std::vector<int16_t> out(FRAME_SAMPLES);
+  beamformer.process(in.data(), out.data(), nullptr);
+  for (size_t t = 0; t < FRAME_SAMPLES; t++) {
+    ASSERT_EQ(out[t], (int16_t) (t * 3));
+  }
+}
+
+}  // namespace
+}  // namespace i2s_audio_duplex
+}  // namespace esphome
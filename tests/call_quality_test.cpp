@@ -0,0 +1,136 @@
+// E-model terms against G.107 reference points, and the call windows built
+// on them
+
+#include "intercom_audio/call_quality.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+
+namespace esphome {
+namespace intercom_audio {
+namespace {
+
+TEST(EmodelTest, PerfectConnectionRatesAtTheDefaultR) {
+  const float r = emodel_rating(0.0f, 0.0f, 1.0f);
+  EXPECT_NEAR(r, 93.2f, 0.01f);
+  EXPECT_NEAR(emodel_mos(r), 4.41f, 0.01f);
+}
+
+TEST(EmodelTest, DelayImpairmentStartsAboveOneHundredMs) {
+  EXPECT_EQ(emodel_delay_impairment(0.0f), 0.0f);
+  EXPECT_EQ(emodel_delay_impairment(100.0f), 0.0f);
+  EXPECT_NEAR(emodel_delay_impairment(101.0f), 0.0f, 0.01f);  // Continuous at the knee
+  EXPECT_NEAR(emodel_delay_impairment(200.0f), 3.04f, 0.01f);
+  EXPECT_NEAR(emodel_delay_impairment(400.0f), 24.07f, 0.01f);
+  EXPECT_NEAR(emodel_rating(200.0f, 0.0f, 1.0f), 90.16f, 0.01f);
+}
+
+TEST(EmodelTest, RandomLossHasABurstRatioOfOne) {
+  // Independent loss at rate p leaves lost * (1 - p) separate runs
+  EXPECT_FLOAT_EQ(emodel_burst_ratio(100, 10, 9), 1.0f);
+  EXPECT_FLOAT_EQ(emodel_burst_ratio(1000, 200, 160), 1.0f);
+
+  // And close to one for a drawn pattern
+  srand(1);
+  uint32_t lost = 0, runs = 0;
+  bool previous = false;
+  for (int i = 0; i < 100000; i++) {
+    const bool gap = rand() % 10 == 0;
+    lost += gap;
+    runs += gap && !previous;
+    previous = gap;
+  }
+  EXPECT_NEAR(emodel_burst_ratio(100000, lost, runs), 1.0f, 0.05f);
+}
+
+TEST(EmodelTest, BurstsRaiseTheRatioAndTheImpairment) {
+  // Ten losses in one run: p = 1/90, q = 1/10
+  EXPECT_FLOAT_EQ(emodel_burst_ratio(100, 10, 1), 9.0f);
+  EXPECT_LT(emodel_rating(0.0f, 10.0f, 9.0f), emodel_rating(0.0f, 10.0f, 1.0f));
+  // Nothing lost, or nothing received: no pattern to rate
+  EXPECT_EQ(emodel_burst_ratio(100, 0, 0), 1.0f);
+  EXPECT_EQ(emodel_burst_ratio(10, 10, 1), 1.0f);
+}
+
+TEST(EmodelTest, RandomLossAgainstG113Bpl) {
+  // G.711 without PLC, Bpl 4.3: Ie-eff = 95 * 10 / (10 + 4.3)
+  const float r = emodel_rating(0.0f, 10.0f, 1.0f);
+  EXPECT_NEAR(r, 26.77f, 0.01f);
+  EXPECT_NEAR(emodel_mos(r), 1.48f, 0.01f);
+}
+
+TEST(EmodelTest, MosIsClampedToItsScale) {
+  EXPECT_EQ(emodel_mos(-10.0f), 1.0f);
+  EXPECT_EQ(emodel_mos(0.0f), 1.0f);
+  EXPECT_EQ(emodel_mos(100.0f), 4.5f);
+  EXPECT_EQ(emodel_mos(120.0f), 4.5f);
+}
+
+TEST(CallQualityTest, NoValuesBeforeTheFirstWindow) {
+  CallQuality quality;
+  quality.reset();
+  for (int i = 0; i < CallQuality::WINDOW_INTERVALS - 1; i++) {
+    EXPECT_FALSE(quality.add(50, 0, 0, 0.0f));
+  }
+  EXPECT_EQ(quality.get_windows(), 0u);
+  EXPECT_TRUE(std::isnan(quality.get_window_mos()));
+  EXPECT_TRUE(std::isnan(quality.get_average_mos()));
+  EXPECT_TRUE(std::isnan(quality.get_worst_mos()));
+
+  EXPECT_TRUE(quality.add(50, 0, 0, 0.0f));
+  EXPECT_EQ(quality.get_windows(), 1u);
+  EXPECT_NEAR(quality.get_window_r(), 93.2f, 0.01f);
+  EXPECT_NEAR(quality.get_window_mos(), 4.41f, 0.01f);
+}
+
+TEST(CallQualityTest, SilentIntervalsDoNotCount) {
+  CallQuality quality;
+  quality.reset();
+  for (int i = 0; i < 10; i++) {
+    EXPECT_FALSE(quality.add(0, 0, 0, 500.0f));
+  }
+  quality.finish();
+  EXPECT_EQ(quality.get_windows(), 0u);
+}
+
+TEST(CallQualityTest, WindowAveragesTheDelayOfItsIntervals) {
+  CallQuality quality;
+  quality.reset();
+  // 100, 300, 100, 300 and 100 ms: rated at the mean of 180 ms, not the worst
+  for (int i = 0; i < CallQuality::WINDOW_INTERVALS; i++) {
+    quality.add(50, 0, 0, i % 2 == 0 ? 100.0f : 300.0f);
+  }
+  EXPECT_NEAR(quality.get_window_r(), 93.2f - emodel_delay_impairment(180.0f), 0.01f);
+}
+
+TEST(CallQualityTest, PartialFinalWindowCountsInAverageAndWorst) {
+  CallQuality quality;
+  quality.reset();
+  for (int i = 0; i < CallQuality::WINDOW_INTERVALS; i++) {
+    quality.add(50, 0, 0, 0.0f);
+  }
+  // Two intervals of 10 % random loss, then the call ends
+  quality.add(50, 5, 5, 0.0f);
+  quality.add(50, 5, 4, 0.0f);
+  EXPECT_EQ(quality.get_windows(), 1u);
+  quality.finish();
+
+  ASSERT_EQ(quality.get_windows(), 2u);
+  const float loss_mos = emodel_mos(emodel_rating(0.0f, 10.0f, emodel_burst_ratio(100, 10, 9)));
+  EXPECT_NEAR(quality.get_window_mos(), loss_mos, 0.001f);
+  EXPECT_NEAR(quality.get_worst_mos(), loss_mos, 0.001f);
+  EXPECT_NEAR(quality.get_average_mos(), (emodel_mos(93.2f) + loss_mos) / 2, 0.001f);
+
+  // Nothing left to close
+  quality.finish();
+  EXPECT_EQ(quality.get_windows(), 2u);
+
+  quality.reset();
+  EXPECT_EQ(quality.get_windows(), 0u);
+  EXPECT_TRUE(std::isnan(quality.get_worst_mos()));
+}
+
+}  // namespace
+}  // namespace intercom_audio
+}  // namespace esphome
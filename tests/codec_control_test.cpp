@@ -0,0 +1,161 @@
+// ES8311/ES8388 register writes against a fake I2C register bus
+
+#include "i2s_audio_duplex/codec_control.h"
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace esphome {
+namespace i2s_audio_duplex {
+namespace {
+
+class FakeRegisterBus : public CodecRegisterBus {
+ public:
+  bool write_register(uint8_t reg, uint8_t value) override {
+    if (this->fail_) {
+      return false;
+    }
+    this->regs[reg] = value;
+    this->writes.emplace_back(reg, value);
+    return true;
+  }
+  bool read_register(uint8_t reg, uint8_t *value) override {
+    if (this->fail_) {
+      return false;
+    }
+    *value = this->regs[reg];
+    return true;
+  }
+  void set_failing(bool fail) { this->fail_ = fail; }
+
+  std::map<uint8_t, uint8_t> regs;
+  std::vector<std::pair<uint8_t, uint8_t>> writes;
+
+ protected:
+  bool fail_{false};
+};
+
+TEST(ES8311, SpeakerVolumeIsHalfDecibelSteps) {
+  FakeRegisterBus bus;
+  ES8311Control codec(&bus);
+  ASSERT_TRUE(codec.set_speaker_volume(1.0f));
+  EXPECT_EQ(bus.regs[ES8311Control::REG_DAC_VOLUME], 0xBF);  // 0 dB
+  ASSERT_TRUE(codec.set_speaker_volume(0.5f));
+  EXPECT_EQ(bus.regs[ES8311Control::REG_DAC_VOLUME], 0xBF - 12);  // -6.02 dB
+  ASSERT_TRUE(codec.set_speaker_volume(0.0f));
+  EXPECT_EQ(bus.regs[ES8311Control::REG_DAC_VOLUME], 0x00);  // Mute
+  ASSERT_TRUE(codec.set_speaker_volume(1e-9f));
+  EXPECT_EQ(bus.regs[ES8311Control::REG_DAC_VOLUME], 0x01);  // Quietest step, not mute
+}
+
+TEST(ES8311, MicGainBoostsAboveUnity) {
+  FakeRegisterBus bus;
+  ES8311Control codec(&bus);
+  ASSERT_TRUE(codec.set_mic_gain(2.0f));
+  EXPECT_EQ(bus.regs[ES8311Control::REG_ADC_VOLUME], 0xBF + 12);  // +6.02 dB
+  ASSERT_TRUE(codec.set_mic_gain(1000.0f));
+  EXPECT_EQ(bus.regs[ES8311Control::REG_ADC_VOLUME], 0xFF);  // +32 dB ceiling
+  EXPECT_EQ(bus.writes.size(), 2u);
+}
+
+TEST(ES8311, BusErrorIsReported) {
+  FakeRegisterBus bus;
+  bus.set_failing(true);
+  ES8311Control codec(&bus);
+  EXPECT_FALSE(codec.set_speaker_volume(1.0f));
+  EXPECT_FALSE(codec.set_mic_gain(1.0f));
+}
+
+TEST(ES8388, SpeakerVolumeWritesBothChannels) {
+  FakeRegisterBus bus;
+  ES8388Control codec(&bus);
+  ASSERT_TRUE(codec.set_speaker_volume(0.5f));
+  EXPECT_EQ(bus.regs[ES8388Control::REG_DAC_VOLUME_L], 12);  // 6 dB of attenuation
+  EXPECT_EQ(bus.regs[ES8388Control::REG_DAC_VOLUME_R], 12);
+  ASSERT_TRUE(codec.set_speaker_volume(1.0f));
+  EXPECT_EQ(bus.regs[ES8388Control::REG_DAC_VOLUME_L], 0);
+  ASSERT_TRUE(codec.set_speaker_volume(0.0f));
+  EXPECT_EQ(bus.regs[ES8388Control::REG_DAC_VOLUME_R], 192);  // -96 dB
+}
+
+TEST(ES8388, InitFailsWithoutCodec) {
+  FakeRegisterBus bus;
+  bus.set_failing(true);
+  ES8388Control codec(&bus);
+  EXPECT_FALSE(codec.init());
+}
+
+TEST(ES8388, UnityGainKeepsTheBootPga) {
+  FakeRegisterBus bus;
+  bus.regs[ES8388Control::REG_ADC_PGA] = 0x44;  // +12 dB on both channels
+  ES8388Control codec(&bus);
+  ASSERT_TRUE(codec.init());
+  ASSERT_TRUE(codec.set_mic_gain(1.0f));
+  EXPECT_EQ(bus.regs[ES8388Control::REG_ADC_PGA], 0x44);
+  EXPECT_EQ(bus.regs[ES8388Control::REG_ADC_VOLUME_L], 0);
+  EXPECT_EQ(bus.regs[ES8388Control::REG_ADC_VOLUME_R], 0);
+}
+
+TEST(ES8388, BoostUsesPgaStepsAndTrimsTheExcess) {
+  FakeRegisterBus bus;
+  bus.regs[ES8388Control::REG_ADC_PGA] = 0x22;
+  ES8388Control codec(&bus);
+  ASSERT_TRUE(codec.init());
+  ASSERT_TRUE(codec.set_mic_gain(2.0f));  // +6.02 dB: three PGA steps (+9 dB), then ~3 dB back
+  EXPECT_EQ(bus.regs[ES8388Control::REG_ADC_PGA], 0x55);
+  EXPECT_EQ(bus.regs[ES8388Control::REG_ADC_VOLUME_L], 6);
+  EXPECT_EQ(bus.regs[ES8388Control::REG_ADC_VOLUME_R], 6);
+}
+
+TEST(ES8388, CutOnlyUsesTheAttenuator) {
+  FakeRegisterBus bus;
+  bus.regs[ES8388Control::REG_ADC_PGA] = 0x33;
+  ES8388Control codec(&bus);
+  ASSERT_TRUE(codec.init());
+  ASSERT_TRUE(codec.set_mic_gain(0.5f));
+  EXPECT_EQ(bus.regs[ES8388Control::REG_ADC_PGA], 0x33);
+  EXPECT_EQ(bus.regs[ES8388Control::REG_ADC_VOLUME_L], 12);
+  ASSERT_TRUE(codec.set_mic_gain(0.0f));
+  EXPECT_EQ(bus.regs[ES8388Control::REG_ADC_VOLUME_L], 192);
+  EXPECT_EQ(bus.regs[ES8388Control::REG_ADC_VOLUME_R], 192);
+}
+
+// The PGA register holds the left channel in the high nibble and the right in
+// the low one; a board that set them differently keeps both baselines
+TEST(ES8388, PgaBaselineIsPerChannel) {
+  FakeRegisterBus bus;
+  bus.regs[ES8388Control::REG_ADC_PGA] = 0x84;  // Left +24 dB (the maximum), right +12 dB
+  ES8388Control codec(&bus);
+  ASSERT_TRUE(codec.init());
+
+  ASSERT_TRUE(codec.set_mic_gain(1.0f));
+  EXPECT_EQ(bus.regs[ES8388Control::REG_ADC_PGA], 0x84);
+
+  ASSERT_TRUE(codec.set_mic_gain(2.0f));
+  // Left cannot boost further and stays at 0 dB attenuation; right gains three steps
+  EXPECT_EQ(bus.regs[ES8388Control::REG_ADC_PGA], 0x87);
+  EXPECT_EQ(bus.regs[ES8388Control::REG_ADC_VOLUME_L], 0);
+  EXPECT_EQ(bus.regs[ES8388Control::REG_ADC_VOLUME_R], 6);
+}
+
+TEST(ES8388, OutOfRangePgaIsClamped) {
+  FakeRegisterBus bus;
+  bus.regs[ES8388Control::REG_ADC_PGA] = 0xFF;  // Reserved values above +24 dB
+  ES8388Control codec(&bus);
+  ASSERT_TRUE(codec.init());
+  ASSERT_TRUE(codec.set_mic_gain(1.0f));
+  EXPECT_EQ(bus.regs[ES8388Control::REG_ADC_PGA], 0x88);
+}
+
+TEST(CodecControl, CreatesTheRequestedDriver) {
+  FakeRegisterBus bus;
+  EXPECT_STREQ(CodecControl::create(CodecType::ES8311, &bus)->get_name(), "ES8311");
+  EXPECT_STREQ(CodecControl::create(CodecType::ES8388, &bus)->get_name(), "ES8388");
+}
+
+}  // namespace
+}  // namespace i2s_audio_duplex
+}  // namespace esphome
@@ -0,0 +1,264 @@
+// XOR and RED recovery over a Gilbert-Elliott burst-loss channel
+
+#include "intercom_audio/fec.h"
+#include "intercom_audio/g711.h"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace esphome {
+namespace intercom_audio {
+namespace {
+
+static const size_t MAX_PAYLOAD = 1024;
+
+// Gilbert channel: everything sent in the bad state is lost, so loss runs
+// are geometric with the given mean
+class GilbertElliott {
+ public:
+  GilbertElliott(double loss, double mean_burst, uint32_t seed) : rng_(seed) {
+    this->leave_bad_ = 1.0 / mean_burst;
+    this->enter_bad_ = loss * this->leave_bad_ / (1.0 - loss);
+  }
+  bool lose() {
+    double u = std::uniform_real_distribution<double>(0.0, 1.0)(this->rng_);
+    this->bad_ = this->bad_ ? u >= this->leave_bad_ : u < this->enter_bad_;
+    return this->bad_;
+  }
+
+ protected:
+  std::mt19937 rng_;
+  double enter_bad_;
+  double leave_bad_;
+  bool bad_{false};
+};
+
+// Frame n: its index in the first 4 bytes, then bytes derived from it, and a
+// length that varies so XOR also has to rebuild the length
+std::vector<uint8_t> make_frame(uint32_t n) {
+  std::vector<uint8_t> frame(448 + (n % 33) * 2);
+  wire::put_be32(frame.data(), n);
+  uint32_t x = n * 2654435761u + 1;
+  for (size_t i = 4; i < frame.size(); i++) {
+    x = x * 1664525u + 1013904223u;
+    frame[i] = (uint8_t) (x >> 24);
+  }
+  return frame;
+}
+
+struct Delivery {
+  std::vector<uint8_t> data;
+  bool redundant;
+};
+
+struct SimResult {
+  uint32_t frames{0};
+  uint32_t audio_lost{0};      // Audio packets the channel dropped
+  uint32_t recoverable{0};     // Of those, how many the FEC data that arrived can rebuild
+  uint32_t recovered{0};       // Decoder's count
+  uint32_t decoder_lost{0};    // Released as gaps
+  std::vector<Delivery> delivered;
+};
+
+// Runs `frames` frames through encoder -> channel -> decoder. The trailing
+// frames (one group's worth) are sent clean so nothing is left held.
+SimResult simulate(FecMode mode, uint8_t group, uint32_t frames, double loss, uint32_t seed) {
+  FecEncoder tx;
+  FecDecoder rx;
+  tx.set_mode(mode);
+  tx.set_group_size(group);
+  tx.set_redundant_ulaw(false);
+  EXPECT_TRUE(tx.allocate(MAX_PAYLOAD));
+  EXPECT_TRUE(rx.allocate(MAX_PAYLOAD));
+  tx.reset();
+  rx.reset();
+  tx.set_active(true);
+
+  GilbertElliott channel(loss, 2.0, seed);
+  SimResult result;
+  result.frames = frames;
+  auto sink = [&](const uint8_t *data, size_t len, uint8_t flags, bool redundant) {
+    result.delivered.push_back({std::vector<uint8_t>(data, data + len), redundant});
+  };
+
+  const uint32_t tail = FEC_MAX_GROUP + 1;
+  std::vector<bool> audio_lost(frames + tail, false);
+  std::vector<bool> parity_lost(frames + tail, false);  // Indexed by the group's first frame
+  std::vector<uint8_t> packet;
+  for (uint32_t n = 0; n < frames + tail; n++) {
+    std::vector<uint8_t> frame = make_frame(n);
+    wire::PacketHeader header;
+    const uint8_t *red;
+    size_t red_len;
+    tx.prepare(frame.size(), &header, &red, &red_len);
+    packet.assign(frame.begin(), frame.end());
+    if (red_len > 0) {
+      packet.insert(packet.end(), red, red + red_len);
+    }
+    // The decoder starts at the first frame it sees, so frame 0 always arrives
+    audio_lost[n] = n > 0 && n < frames && channel.lose();
+    if (!audio_lost[n]) {
+      rx.on_audio(header, packet.data(), packet.size(), sink);
+    }
+
+    tx.commit(frame.data(), frame.size());
+    const uint8_t *parity;
+    size_t parity_len;
+    if (tx.take_parity(&header, &parity, &parity_len)) {
+      uint32_t base = n + 1 - group;
+      parity_lost[base] = n < frames && channel.lose();
+      if (!parity_lost[base]) {
+        rx.on_parity(header, parity, parity_len, sink);
+      }
+    }
+  }
+
+  // What the FEC data that got through can rebuild
+  for (uint32_t n = 0; n < frames; n++) {
+    if (!audio_lost[n]) {
+      continue;
+    }
+    result.audio_lost++;
+    if (mode == FecMode::RED) {
+      // The next packet carries this frame (the first packet has no copy to carry)
+      if (!audio_lost[n + 1]) {
+        result.recoverable++;
+      }
+    } else {
+      uint32_t base = n - n % group;
+      uint32_t missing = 0;
+      for (uint32_t i = base; i < base + group; i++) {
+        missing += audio_lost[i] ? 1 : 0;
+      }
+      if (missing == 1 && !parity_lost[base]) {
+        result.recoverable++;
+      }
+    }
+  }
+  result.recovered = rx.get_recovered();
+  result.decoder_lost = rx.get_lost();
+  return result;
+}
+
+// Every delivered frame is bit-exact and in order, and together with the gaps
+// the decoder reported they account for every frame sent
+void expect_exact_and_in_order(const SimResult &result, uint32_t total_frames) {
+  int64_t last = -1;
+  for (const Delivery &d : result.delivered) {
+    ASSERT_GE(d.data.size(), 4u);
+    uint32_t n = wire::get_be32(d.data.data());
+    ASSERT_GT((int64_t) n, last) << "frame " << n << " out of order";
+    ASSERT_EQ(d.data, make_frame(n)) << "frame " << n << " not bit-exact";
+    last = n;
+  }
+  EXPECT_EQ(result.delivered.size() + result.decoder_lost, total_frames);
+
+}
+
+static const uint32_t FRAMES = 100000;
+static const double LOSS = 0.015;
+
+TEST(FecSimulation, XorRecoversEveryRepairableFrameForEachGroupSize) {
+  for (uint8_t group = FEC_MIN_GROUP; group <= FEC_MAX_GROUP; group++) {
+    SCOPED_TRACE(testing::Message() << "group " << (int) group);
+    SimResult result = simulate(FecMode::XOR, group, FRAMES, LOSS, 1000 + group);
+    ASSERT_GT(result.audio_lost, 0u);
+    EXPECT_EQ(result.recovered, result.recoverable);
+    EXPECT_EQ(result.decoder_lost, result.audio_lost - result.recovered);
+    expect_exact_and_in_order(result, FRAMES + FEC_MAX_GROUP + 1);
+  }
+}
+
+TEST(FecSimulation, XorRepairRateFallsWithGroupSize) {
+  // Parity shares the channel, so a burst often takes it along with the
+  // frame; larger groups also see more groups with two losses. Measured:
+  // 36% of lost frames repaired at group 2, 32% at 4, 26% at 8.
+  double first = 0.0;
+  double previous = 1.0;
+  for (uint8_t group = FEC_MIN_GROUP; group <= FEC_MAX_GROUP; group++) {
+    SimResult result = simulate(FecMode::XOR, group, FRAMES, LOSS, 2000 + group);
+    double repaired = (double) result.recovered / result.audio_lost;
+    EXPECT_GT(repaired, 0.2) << "group " << (int) group;
+    EXPECT_LT(repaired, previous + 0.02) << "group " << (int) group;
+    if (group == FEC_MIN_GROUP) {
+      first = repaired;
+    }
+    previous = repaired;
+  }
+  EXPECT_GT(first - previous, 0.05);
+}
+
+TEST(FecSimulation, RedRecoversEveryRepairableFrame) {
+  SimResult result = simulate(FecMode::RED, 4, FRAMES, LOSS, 3000);
+  ASSERT_GT(result.audio_lost, 0u);
+  EXPECT_EQ(result.recovered, result.recoverable);
+  EXPECT_EQ(result.decoder_lost, result.audio_lost - result.recovered);
+  // Only the last frame of a burst has its copy arrive: 1 / mean burst
+  EXPECT_NEAR((double) result.recovered / result.audio_lost, 0.5, 0.03);
+  expect_exact_and_in_order(result, FRAMES + FEC_MAX_GROUP + 1);
+  for (const Delivery &d : result.delivered) {
+    if (d.redundant) {
+      return;
+    }
+  }
+  ADD_FAILURE() << "no frame was delivered from a redundant copy";
+}
+
+TEST(FecSimulation, CleanChannelAddsNothing) {
+  SimResult result = simulate(FecMode::XOR, 4, 1000, 0.0, 4000);
+  EXPECT_EQ(result.recovered, 0u);
+  EXPECT_EQ(result.decoder_lost, 0u);
+  expect_exact_and_in_order(result, 1000 + FEC_MAX_GROUP + 1);
+}
+
+// PCM streams carry their redundant copy as device-rate mu-law
+TEST(FecRed, UlawCopyStandsInForALostPcmFrame) {
+  FecEncoder tx;
+  FecDecoder rx;
+  tx.set_mode(FecMode::RED);
+  ASSERT_TRUE(tx.allocate(MAX_PAYLOAD));
+  ASSERT_TRUE(rx.allocate(MAX_PAYLOAD));
+  tx.reset();
+  rx.reset();
+  tx.set_active(true);
+
+  std::vector<Delivery> delivered;
+  auto sink = [&](const uint8_t *data, size_t len, uint8_t flags, bool redundant) {
+    delivered.push_back({std::vector<uint8_t>(data, data + len), redundant});
+  };
+  std::vector<std::vector<uint8_t>> sent;
+  for (uint32_t n = 0; n < 3; n++) {
+    std::vector<uint8_t> frame = make_frame(n);
+    frame.resize(512);
+    wire::PacketHeader header;
+    const uint8_t *red;
+    size_t red_len;
+    tx.prepare(frame.size(), &header, &red, &red_len);
+    std::vector<uint8_t> packet(frame);
+    packet.insert(packet.end(), red, red + red_len);
+    if (n != 1) {
+      rx.on_audio(header, packet.data(), packet.size(), sink);
+    }
+    tx.commit(frame.data(), frame.size());
+    sent.push_back(frame);
+  }
+
+  ASSERT_EQ(delivered.size(), 3u);
+  EXPECT_FALSE(delivered[0].redundant);
+  EXPECT_TRUE(delivered[1].redundant);
+  EXPECT_FALSE(delivered[2].redundant);
+  ASSERT_EQ(delivered[1].data.size(), 256u);
+  for (size_t i = 0; i < 256; i++) {
+    int16_t sample;
+    memcpy(&sample, sent[1].data() + 2 * i, sizeof(sample));
+    ASSERT_EQ(delivered[1].data[i], g711::ulaw_encode(sample)) << "sample " << i;
+  }
+  EXPECT_EQ(delivered[2].data, sent[2]);
+}
+
+}  // namespace
+}  // namespace intercom_audio
+}  // namespace esphome
@@ -0,0 +1,179 @@
+// Frame bus fan-out, drop policies and subscriber deactivation
+
+#include "i2s_audio_duplex/frame_bus.h"
+
+#include <gtest/gtest.h>
+
+namespace esphome {
+namespace i2s_audio_duplex {
+namespace {
+
+static const size_t FRAME_SAMPLES = 256;
+
+size_t referenced_slots(FrameBus &bus, FrameSlot *first) {
+  size_t count = 0;
+  for (size_t i = 0; i < bus.get_pool_size(); i++) {
+    if (first[i].refs.load() != 0) {
+      count++;
+    }
+  }
+  return count;
+}
+
+class FrameBusTest : public ::testing::Test {
+ protected:
+  void TearDown() override { host_shim::set_queue_send_hook(nullptr); }
+
+  FrameSlot *publish_one() {
+    FrameSlot *slot = this->bus.acquire();
+    if (slot != nullptr) {
+      this->bus.publish(slot);
+    }
+    return slot;
+  }
+
+  FrameBus bus;
+};
+
+TEST_F(FrameBusTest, FansOutOneSlotToEverySubscriber) {
+  FrameSubscription *a = this->bus.subscribe(4, DropPolicy::DROP_OLDEST);
+  FrameSubscription *b = this->bus.subscribe(4, DropPolicy::DROP_NEWEST);
+  ASSERT_TRUE(this->bus.allocate(FRAME_SAMPLES));
+  a->set_active(true);
+  b->set_active(true);
+
+  FrameSlot *published = this->publish_one();
+  ASSERT_NE(published, nullptr);
+  EXPECT_EQ(published->refs.load(), 2);
+
+  FrameSlot *got_a = a->receive(0);
+  FrameSlot *got_b = b->receive(0);
+  EXPECT_EQ(got_a, published);
+  EXPECT_EQ(got_b, published);
+  a->release(got_a);
+  b->release(got_b);
+  EXPECT_EQ(published->refs.load(), 0);
+}
+
+TEST_F(FrameBusTest, InactiveSubscribersAreSkipped) {
+  FrameSubscription *sub = this->bus.subscribe(4, DropPolicy::DROP_OLDEST);
+  ASSERT_TRUE(this->bus.allocate(FRAME_SAMPLES));
+
+  FrameSlot *published = this->publish_one();
+  EXPECT_EQ(published->refs.load(), 0);
+  EXPECT_EQ(sub->receive(0), nullptr);
+}
+
+TEST_F(FrameBusTest, DropOldestKeepsTheNewestFrames) {
+  FrameSubscription *sub = this->bus.subscribe(2, DropPolicy::DROP_OLDEST);
+  ASSERT_TRUE(this->bus.allocate(FRAME_SAMPLES));
+  sub->set_active(true);
+
+  for (int i = 0; i < 5; i++) {
+    this->publish_one();
+  }
+  EXPECT_EQ(sub->get_dropped(), 3u);
+  FrameSlot *first = sub->receive(0);
+  FrameSlot *second = sub->receive(0);
+  ASSERT_NE(first, nullptr);
+  ASSERT_NE(second, nullptr);
+  EXPECT_EQ(first->sequence, 3u);
+  EXPECT_EQ(second->sequence, 4u);
+  sub->release(first);
+  sub->release(second);
+}
+
+TEST_F(FrameBusTest, DropNewestKeepsWhatIsQueued) {
+  FrameSubscription *sub = this->bus.subscribe(2, DropPolicy::DROP_NEWEST);
+  ASSERT_TRUE(this->bus.allocate(FRAME_SAMPLES));
+  sub->set_active(true);
+
+  for (int i = 0; i < 5; i++) {
+    this->publish_one();
+  }
+  EXPECT_EQ(sub->get_dropped(), 3u);
+  FrameSlot *first = sub->receive(0);
+  EXPECT_EQ(first->sequence, 0u);
+  sub->release(first);
+  sub->release(sub->receive(0));
+}
+
+TEST_F(FrameBusTest, DeactivationReleasesQueuedFrames) {
+  FrameSubscription *sub = this->bus.subscribe(3, DropPolicy::DROP_NEWEST);
+  ASSERT_TRUE(this->bus.allocate(FRAME_SAMPLES));
+  FrameSlot *pool = this->bus.acquire();  // Slot 0, the start of the pool
+  this->bus.release(pool);
+  sub->set_active(true);
+
+  for (int i = 0; i < 3; i++) {
+    this->publish_one();
+  }
+  EXPECT_EQ(referenced_slots(this->bus, pool), 3u);
+  sub->set_active(false);
+  EXPECT_EQ(referenced_slots(this->bus, pool), 0u);
+}
+
+// The subscriber is deactivated after publish() saw it active but before the
+// frame reached its queue. The frame must not stay queued: it would pin a pool
+// slot while nobody reads, and surface as stale audio on reactivation.
+void deactivation_racing_publish(FrameBus &bus, DropPolicy policy, size_t queued_before) {
+  FrameSubscription *sub = bus.subscribe(2, policy);
+  ASSERT_TRUE(bus.allocate(FRAME_SAMPLES));
+  FrameSlot *pool = bus.acquire();
+  bus.release(pool);
+  sub->set_active(true);
+  for (size_t i = 0; i < queued_before; i++) {
+    FrameSlot *slot = bus.acquire();
+    bus.publish(slot);
+  }
+
+  bool fired = false;
+  host_shim::set_queue_send_hook([&](QueueHandle_t) {
+    if (!fired) {
+      fired = true;
+      sub->set_active(false);
+    }
+  });
+  FrameSlot *late = bus.acquire();
+  bus.publish(late);
+  host_shim::set_queue_send_hook(nullptr);
+  ASSERT_TRUE(fired);
+
+  EXPECT_EQ(referenced_slots(bus, pool), 0u);
+  sub->set_active(true);
+  EXPECT_EQ(sub->receive(0), nullptr);
+}
+
+TEST_F(FrameBusTest, DeactivationRacingPublishLeavesNothingQueued) {
+  deactivation_racing_publish(this->bus, DropPolicy::DROP_OLDEST, 0);
+}
+
+TEST_F(FrameBusTest, DeactivationRacingDropOldestRetryLeavesNothingQueued) {
+  // Queue already full, so the racing send is the retry after dropping the oldest
+  deactivation_racing_publish(this->bus, DropPolicy::DROP_OLDEST, 2);
+}
+
+TEST_F(FrameBusTest, DeactivationRacingDropNewestLeavesNothingQueued) {
+  deactivation_racing_publish(this->bus, DropPolicy::DROP_NEWEST, 0);
+}
+
+TEST_F(FrameBusTest, PoolExhaustionCountsOverruns) {
+  FrameSubscription *sub = this->bus.subscribe(1, DropPolicy::DROP_NEWEST);
+  ASSERT_TRUE(this->bus.allocate(FRAME_SAMPLES));
+  sub->set_active(true);
+
+  std::vector<FrameSlot *> held;
+  for (size_t i = 0; i < this->bus.get_pool_size(); i++) {
+    held.push_back(this->bus.acquire());
+  }
+  EXPECT_EQ(this->bus.acquire(), nullptr);
+  EXPECT_EQ(this->bus.get_overruns(), 1u);
+  for (FrameSlot *slot : held) {
+    this->bus.release(slot);
+  }
+  EXPECT_NE(this->bus.acquire(), nullptr);
+}
+
+}  // namespace
+}  // namespace i2s_audio_duplex
+}  // namespace esphome
@@ -0,0 +1,240 @@
+// G.711 against the Sun Microsystems reference g711.c, and the 2:1 resamplers'
+// frequency response
+
+#include "intercom_audio/g711.h"
+#include "intercom_audio/resampler.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+namespace esphome {
+namespace intercom_audio {
+namespace {
+
+// ─── Reference g711.c (Sun Microsystems, public domain), unchanged logic ───
+
+const int16_t SEG_AEND[8] = {0x1F, 0x3F, 0x7F, 0xFF, 0x1FF, 0x3FF, 0x7FF, 0xFFF};
+const int16_t SEG_UEND[8] = {0x3F, 0x7F, 0xFF, 0x1FF, 0x3FF, 0x7FF, 0xFFF, 0x1FFF};
+
+int16_t ref_search(int16_t val, const int16_t *table, int16_t size) {
+  for (int16_t i = 0; i < size; i++) {
+    if (val <= *table++)
+      return i;
+  }
+  return size;
+}
+
+uint8_t ref_linear2alaw(int16_t pcm_val) {
+  int16_t mask;
+  pcm_val = pcm_val >> 3;
+  if (pcm_val >= 0) {
+    mask = 0xD5;
+  } else {
+    mask = 0x55;
+    pcm_val = -pcm_val - 1;
+  }
+  int16_t seg = ref_search(pcm_val, SEG_AEND, 8);
+  if (seg >= 8)
+    return (uint8_t) (0x7F ^ mask);
+  uint8_t aval = (uint8_t) (seg << 4);
+  if (seg < 2)
+    aval |= (pcm_val >> 1) & 0x0F;
+  else
+    aval |= (pcm_val >> seg) & 0x0F;
+  return (uint8_t) (aval ^ mask);
+}
+
+int16_t ref_alaw2linear(uint8_t a_val) {
+  a_val ^= 0x55;
+  int16_t t = (int16_t) ((a_val & 0x0F) << 4);
+  int16_t seg = (int16_t) ((a_val & 0x70) >> 4);
+  switch (seg) {
+    case 0:
+      t += 8;
+      break;
+    case 1:
+      t += 0x108;
+      break;
+    default:
+      t += 0x108;
+      t = (int16_t) (t << (seg - 1));
+  }
+  return (a_val & 0x80) ? t : (int16_t) -t;
+}
+
+uint8_t ref_linear2ulaw(int16_t pcm_val) {
+  const int16_t bias = 0x84;
+  const int16_t clip = 8159;
+  int16_t mask;
+  pcm_val = pcm_val >> 2;
+  if (pcm_val < 0) {
+    pcm_val = -pcm_val;
+    mask = 0x7F;
+  } else {
+    mask = 0xFF;
+  }
+  if (pcm_val > clip)
+    pcm_val = clip;
+  pcm_val += (bias >> 2);
+  int16_t seg = ref_search(pcm_val, SEG_UEND, 8);
+  if (seg >= 8)
+    return (uint8_t) (0x7F ^ mask);
+  uint8_t uval = (uint8_t) ((seg << 4) | ((pcm_val >> (seg + 1)) & 0x0F));
+  return (uint8_t) (uval ^ mask);
+}
+
+int16_t ref_ulaw2linear(uint8_t u_val) {
+  const int16_t bias = 0x84;
+  u_val = ~u_val;
+  int16_t t = (int16_t) (((u_val & 0x0F) << 3) + bias);
+  t = (int16_t) (t << ((u_val & 0x70) >> 4));
+  return (u_val & 0x80) ? (int16_t) (bias - t) : (int16_t) (t - bias);
+}
+
+// ─── G.711 ───
+
+TEST(G711, AlawEncodeMatchesReferenceForEveryInput) {
+  for (int32_t pcm = -32768; pcm <= 32767; pcm++) {
+    ASSERT_EQ(g711::alaw_encode((int16_t) pcm), ref_linear2alaw((int16_t) pcm)) << "pcm " << pcm;
+  }
+}
+
+TEST(G711, UlawEncodeMatchesReferenceForEveryInput) {
+  for (int32_t pcm = -32768; pcm <= 32767; pcm++) {
+    ASSERT_EQ(g711::ulaw_encode((int16_t) pcm), ref_linear2ulaw((int16_t) pcm)) << "pcm " << pcm;
+  }
+}
+
+TEST(G711, DecodeMatchesReferenceForEveryCode) {
+  for (int code = 0; code < 256; code++) {
+    EXPECT_EQ(g711::alaw_decode((uint8_t) code), ref_alaw2linear((uint8_t) code)) << "A-law code " << code;
+    EXPECT_EQ(g711::ulaw_decode((uint8_t) code), ref_ulaw2linear((uint8_t) code)) << "mu-law code " << code;
+  }
+}
+
+TEST(G711, DecodedValuesReencodeToTheSameCode) {
+  for (int code = 0; code < 256; code++) {
+    EXPECT_EQ(g711::alaw_encode(g711::alaw_decode((uint8_t) code)), code);
+    // mu-law has two zero codes (0x7F and 0xFF); both decode to 0, which encodes as 0xFF
+    if (code != 0x7F) {
+      EXPECT_EQ(g711::ulaw_encode(g711::ulaw_decode((uint8_t) code)), code);
+    }
+  }
+}
+
+// ─── Resamplers ───
+
+static const double PI = 3.14159265358979323846;
+static const size_t FRAME = 256;  // One 16 ms frame at 16 kHz
+static const size_t FRAMES = 40;
+
+std::vector<int16_t> tone(double freq, double rate, size_t samples, double amplitude) {
+  std::vector<int16_t> out(samples);
+  for (size_t n = 0; n < samples; n++) {
+    out[n] = (int16_t) std::lround(amplitude * std::sin(2.0 * PI * freq * n / rate));
+  }
+  return out;
+}
+
+// Amplitude of the component at freq, by Goertzel over the last half second.
+// Every test frequency is a whole number of cycles in that span, so there is
+// no leakage from the other components.
+double amplitude_at(const std::vector<int16_t> &x, double freq, double rate) {
+  size_t skip = x.size() - (size_t) (rate / 2);
+  double w = 2.0 * PI * freq / rate;
+  double coeff = 2.0 * std::cos(w);
+  double s1 = 0.0, s2 = 0.0;
+  size_t n = x.size() - skip;
+  for (size_t i = skip; i < x.size(); i++) {
+    double s0 = x[i] + coeff * s1 - s2;
+    s2 = s1;
+    s1 = s0;
+  }
+  double power = s1 * s1 + s2 * s2 - coeff * s1 * s2;
+  return 2.0 * std::sqrt(std::max(power, 0.0)) / n;
+}
+
+double db(double ratio) { return 20.0 * std::log10(ratio); }
+
+// Decimate a 16 kHz tone frame by frame; returns the 8 kHz output
+std::vector<int16_t> decimate(double freq, double amplitude) {
+  std::vector<int16_t> in = tone(freq, 16000.0, FRAME * FRAMES, amplitude);
+  std::vector<int16_t> out(in.size() / 2);
+  Downsampler2x down;
+  down.reset();
+  for (size_t f = 0; f < FRAMES; f++) {
+    down.process(in.data() + f * FRAME, FRAME, out.data() + f * FRAME / 2);
+  }
+  return out;
+}
+
+std::vector<int16_t> interpolate(double freq, double amplitude) {
+  std::vector<int16_t> in = tone(freq, 8000.0, FRAME / 2 * FRAMES, amplitude);
+  std::vector<int16_t> out(in.size() * 2);
+  Upsampler2x up;
+  up.reset();
+  for (size_t f = 0; f < FRAMES; f++) {
+    up.process(in.data() + f * FRAME / 2, FRAME / 2, out.data() + f * FRAME);
+  }
+  return out;
+}
+
+TEST(Resampler, DownsamplerPassband) {
+  const double amplitude = 16000.0;
+  for (double freq : {250.0, 1000.0, 2000.0, 3000.0}) {
+    std::vector<int16_t> out = decimate(freq, amplitude);
+    EXPECT_NEAR(db(amplitude_at(out, freq, 8000.0) / amplitude), 0.0, 0.05) << freq << " Hz";
+  }
+  // Band edge of narrowband telephony: -0.6 dB
+  std::vector<int16_t> edge = decimate(3400.0, amplitude);
+  EXPECT_NEAR(db(amplitude_at(edge, 3400.0, 8000.0) / amplitude), -0.6, 0.1);
+}
+
+TEST(Resampler, DownsamplerRejectsAliases) {
+  const double amplitude = 16000.0;
+  // 5 kHz and up fold back to 3 kHz and below at 8 kHz; -56 dB at 5 kHz
+  for (double freq : {5000.0, 6000.0, 7000.0}) {
+    std::vector<int16_t> out = decimate(freq, amplitude);
+    double alias = 8000.0 - freq;
+    double gain = db(amplitude_at(out, alias, 8000.0) / amplitude);
+    EXPECT_LT(gain, -55.0) << freq << " Hz";
+  }
+}
+
+TEST(Resampler, UpsamplerPassbandAndImages) {
+  const double amplitude = 16000.0;
+  for (double freq : {250.0, 1000.0, 3000.0}) {
+    std::vector<int16_t> out = interpolate(freq, amplitude);
+    EXPECT_NEAR(db(amplitude_at(out, freq, 16000.0) / amplitude), 0.0, 0.05) << freq << " Hz";
+  }
+  std::vector<int16_t> edge = interpolate(3400.0, amplitude);
+  EXPECT_NEAR(db(amplitude_at(edge, 3400.0, 16000.0) / amplitude), -0.6, 0.1);
+  // The image of a tone at f lands at 8 kHz - f; only tones up to 3 kHz have
+  // their image in the stopband (>= 5 kHz)
+  for (double freq : {250.0, 1000.0, 3000.0}) {
+    std::vector<int16_t> out = interpolate(freq, amplitude);
+    double image = db(amplitude_at(out, 16000.0 / 2 - freq, 16000.0) / amplitude);
+    EXPECT_LT(image, -55.0) << freq << " Hz";
+  }
+}
+
+TEST(Resampler, DcPassesAtUnityGain) {
+  std::vector<int16_t> in(FRAME * 4, 10000);
+  std::vector<int16_t> half(in.size() / 2);
+  std::vector<int16_t> back(in.size());
+  Downsampler2x down;
+  Upsampler2x up;
+  down.reset();
+  up.reset();
+  down.process(in.data(), in.size(), half.data());
+  up.process(half.data(), half.size(), back.data());
+  EXPECT_NEAR(half.back(), 10000, 1);
+  EXPECT_NEAR(back.back(), 10000, 1);
+  EXPECT_NEAR(back[back.size() - 2], 10000, 1);
+}
+
+}  // namespace
+}  // namespace intercom_audio
+}  // namespace esphome
@@ -0,0 +1,368 @@
+// IntercomAudio start/stop cycles against shims: real UDP sockets on loopback,
+// a microphone fed from another thread and a speaker that takes everything.
+// Checks that the heap and the open descriptors come back to where they were,
+// that no mic frame of one call is sent in the next, and that stop() is quick.
+//
+// SOAK_CYCLES=<n> runs longer; --gtest_output=xml:<file> keeps the timing
+// properties (stop and start times) to compare between releases.
+
+#include "intercom_harness.h"
+
+#include <esp_heap_caps.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace esphome {
+namespace intercom_audio {
+namespace {
+
+class FakeMicrophone : public microphone::Microphone {
+ public:
+  void start() override { this->state_ = microphone::STATE_RUNNING; }
+  void stop() override { this->state_ = microphone::STATE_STOPPED; }
+  // On the calling thread, like the I2S reader task
+  void feed(const std::vector<uint8_t> &data) { this->data_callbacks_.call(data); }
+};
+
+class FakeSpeaker : public speaker::Speaker {
+ public:
+  size_t play(const uint8_t *data, size_t length) override {
+    this->played += length;
+    return length;
+  }
+  void start() override { this->state_ = speaker::STATE_RUNNING; }
+  void stop() override { this->state_ = speaker::STATE_STOPPED; }
+  bool has_buffered_data() const override { return false; }
+
+  std::atomic<size_t> played{0};
+};
+
+// One component per test process: its audio task runs until the process exits
+class IntercomAudioTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    this->listen_port = free_udp_port();
+    this->intercom.set_microphone(&this->mic);
+    this->intercom.set_speaker(&this->spk);
+    this->intercom.set_listen_port(this->listen_port);
+  }
+
+  void setup_intercom() {
+    this->intercom.setup();
+    ASSERT_FALSE(this->intercom.is_failed());
+  }
+
+  // Mic frames from another thread for as long as the test runs, each filled
+  // with the call it was captured for. The tag changes only under feed_lock,
+  // so a frame tagged for one call has been delivered before the next starts.
+  void start_feeding() {
+    this->feeder = std::thread([this] {
+      std::vector<uint8_t> frame(FRAME_BYTES);
+      while (!this->done.load()) {
+        {
+          std::lock_guard<std::mutex> lock(this->feed_lock);
+          this->feed_tagged(frame, this->call.load());
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(500));
+      }
+    });
+  }
+
+  void feed_tagged(std::vector<uint8_t> &frame, int16_t tag) {
+    for (size_t i = 0; i < FRAME_SAMPLES; i++) {
+      memcpy(&frame[i * 2], &tag, sizeof(tag));
+    }
+    this->mic.feed(frame);
+  }
+
+  void TearDown() override {
+    host_shim::set_semaphore_take_hook(nullptr);
+    this->done.store(true);
+    if (this->feeder.joinable()) {
+      this->feeder.join();
+    }
+    if (this->intercom.is_streaming()) {
+      this->intercom.stop();
+    }
+  }
+
+  // Start/stop cycles with traffic both ways; returns the timings
+  Timings run_cycles(int cycles) {
+    Timings timings;
+    for (int i = 1; i <= cycles; i++) {
+      {
+        std::lock_guard<std::mutex> lock(this->feed_lock);
+        this->call.store((int16_t) i);
+      }
+      auto t0 = std::chrono::steady_clock::now();
+      this->intercom.start("127.0.0.1", this->peer.port());
+      timings.start_ms.push_back(elapsed_ms(t0));
+      EXPECT_TRUE(this->intercom.is_streaming());
+
+      for (int f = 0; f < 4; f++) {
+        this->peer.send_frame(this->listen_port, (int16_t) i);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+      this->peer.drain([&](int16_t tag) { this->check_tag(tag, i); });
+
+      t0 = std::chrono::steady_clock::now();
+      this->intercom.stop();
+      timings.stop_ms.push_back(elapsed_ms(t0));
+      // Whatever the task sent before it went idle is here now; nothing after
+      this->peer.drain([&](int16_t tag) { this->check_tag(tag, i); });
+    }
+    return timings;
+  }
+
+  void check_tag(int16_t tag, int call) {
+    this->sent_to_peer++;
+    if (tag != (int16_t) call) {
+      this->foreign_frames++;
+    }
+  }
+
+  // Never freed: the audio task keeps using them until the process exits
+  FakeMicrophone &mic{*new FakeMicrophone()};
+  FakeSpeaker &spk{*new FakeSpeaker()};
+  IntercomAudio &intercom{*new IntercomAudio()};
+  Peer peer;
+  uint16_t listen_port{0};
+
+  std::thread feeder;
+  std::mutex feed_lock;
+  std::atomic<int16_t> call{0};
+  std::atomic<bool> done{false};
+  uint32_t sent_to_peer{0};
+  uint32_t foreign_frames{0};
+};
+
+int soak_cycles(int fallback) {
+  const char *env = getenv("SOAK_CYCLES");
+  return env != nullptr ? atoi(env) : fallback;
+}
+
+TEST_F(IntercomAudioTest, StartStopCyclesLeakNothing) {
+  this->setup_intercom();
+  this->start_feeding();
+
+  // Warm-up: the first calls may allocate once (lazy buffers, the stop semaphore's first answer)
+  this->run_cycles(5);
+  const size_t blocks = host_shim::heap_caps_live_blocks();
+  const double heap_free = metric(this->intercom, "intercom_heap_after_stop_bytes");
+  const int fds = open_descriptors();
+
+  const int cycles = soak_cycles(300);
+  Timings timings = this->run_cycles(cycles);
+  timings.report();
+
+  EXPECT_EQ(host_shim::heap_caps_live_blocks(), blocks);
+  EXPECT_EQ(metric(this->intercom, "intercom_heap_after_stop_bytes"), heap_free);
+  EXPECT_EQ(open_descriptors(), fds);
+  EXPECT_EQ(this->foreign_frames, 0u);
+  EXPECT_GT(this->sent_to_peer, 0u);
+  EXPECT_GT(this->spk.played.load(), 0u);
+  EXPECT_EQ(metric(this->intercom, "intercom_starts_total"), cycles + 5);
+  // Every stop() returned on the task's answer, not on the timeout
+  EXPECT_EQ(metric(this->intercom, "intercom_stop_ack_timeouts_total"), 0);
+}
+
+TEST_F(IntercomAudioTest, StopWithoutTrafficIsAcknowledged) {
+  this->setup_intercom();
+  Timings timings;
+  for (int i = 0; i < 20; i++) {
+    this->intercom.start("127.0.0.1", this->peer.port());
+    auto t0 = std::chrono::steady_clock::now();
+    this->intercom.stop();
+    timings.stop_ms.push_back(elapsed_ms(t0));
+  }
+  timings.report();
+  EXPECT_EQ(metric(this->intercom, "intercom_stop_ack_timeouts_total"), 0);
+  EXPECT_FALSE(this->intercom.is_streaming());
+}
+
+// The soak cannot hit this window (its tag changes under feed_lock), so force
+// it: stop() and the next start() land between the mic callback capturing its
+// session and taking the TX buffer lock. The frame must be dropped, not sent
+// in the next call.
+TEST_F(IntercomAudioTest, MicFrameSpanningStopAndStartIsDropped) {
+  this->setup_intercom();
+  this->intercom.start("127.0.0.1", this->peer.port());
+  const std::thread::id caller = std::this_thread::get_id();
+  bool armed = true;
+  host_shim::set_semaphore_take_hook([&](SemaphoreHandle_t) {
+    // The audio task takes locks too; only the callback on this thread may restart
+    if (std::this_thread::get_id() != caller || !armed) {
+      return;
+    }
+    armed = false;
+    this->intercom.stop();
+    this->intercom.start("127.0.0.1", this->peer.port());
+  });
+  std::vector<uint8_t> frame(FRAME_BYTES);
+  this->feed_tagged(frame, 1);
+  host_shim::set_semaphore_take_hook(nullptr);
+  ASSERT_FALSE(armed);
+  EXPECT_EQ(metric(this->intercom, "intercom_stale_mic_frames_total"), 1);
+
+  for (int f = 0; f < 4; f++) {
+    this->feed_tagged(frame, 2);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  this->intercom.stop();
+  this->peer.drain([&](int16_t tag) { this->check_tag(tag, 2); });
+  EXPECT_GT(this->sent_to_peer, 0u);
+  EXPECT_EQ(this->foreign_frames, 0u);
+}
+
+// Datagrams that queue up while the task is busy are read in the next pass,
+// not one per wakeup. The task is held inside a pass (at its mic lock) while
+// the burst arrives, so every datagram is waiting when it gets back.
+TEST_F(IntercomAudioTest, BurstIsDrainedInOnePass) {
+  const uint32_t burst = 16;
+  this->setup_intercom();
+  this->intercom.start("127.0.0.1", this->peer.port());
+  const std::thread::id caller = std::this_thread::get_id();
+  std::atomic<bool> armed{true};
+  std::atomic<bool> held{false};
+  std::atomic<bool> release{false};
+  host_shim::set_semaphore_take_hook([&](SemaphoreHandle_t) {
+    if (std::this_thread::get_id() == caller || !armed.exchange(false)) {
+      return;
+    }
+    held.store(true);
+    while (!release.load()) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  });
+  std::vector<uint8_t> frame(FRAME_BYTES);
+  this->feed_tagged(frame, 1);  // Wakes the task into its TX path
+  for (int i = 0; i < 1000 && !held.load(); i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  ASSERT_TRUE(held.load());
+
+  const uint32_t packets = this->intercom.get_rx_packets();
+  for (uint32_t i = 0; i < burst; i++) {
+    this->peer.send_frame(this->listen_port, (int16_t) i);
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  const uint32_t wakeups = this->intercom.get_task_wakeups();
+  release.store(true);
+  for (int i = 0; i < 1000 && this->intercom.get_rx_packets() - packets < burst; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  host_shim::set_semaphore_take_hook(nullptr);
+
+  EXPECT_EQ(this->intercom.get_rx_packets() - packets, burst);
+  // The rest of the held pass, then one wakeup with all of them ready
+  EXPECT_LE(this->intercom.get_task_wakeups() - wakeups, 2u);
+  this->intercom.stop();
+}
+
+// With a call up but nothing to send or play, every wakeup is the 100 ms
+// guard running out (a 5 ms tick would be ~100 here). A slow runner only
+// makes the elapsed time, and so the bound, larger.
+TEST_F(IntercomAudioTest, IdleCallWakesOnlyForTheGuard) {
+  this->setup_intercom();
+  this->intercom.start("127.0.0.1", this->peer.port());
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  const uint32_t wakeups = this->intercom.get_task_wakeups();
+  const uint32_t guard = this->intercom.get_guard_wakeups();
+  auto t0 = std::chrono::steady_clock::now();
+  std::this_thread::sleep_for(std::chrono::milliseconds(500));
+  const uint32_t idle_wakeups = this->intercom.get_task_wakeups() - wakeups;
+  const uint32_t guard_wakeups = this->intercom.get_guard_wakeups() - guard;
+  const double elapsed = elapsed_ms(t0);
+  RecordProperty("idle_wakeups", (int) idle_wakeups);
+
+  // The wait still pending at the end was counted when it began
+  EXPECT_LE(idle_wakeups, guard_wakeups + 1);
+  EXPECT_LE(guard_wakeups, (uint32_t) (elapsed / 100.0) + 1);
+  EXPECT_EQ(this->intercom.get_socket_wakeups(), 0u);
+  this->intercom.stop();
+}
+
+// A datagram ends the task's wait when it arrives. One that lands while the
+// task happens to be awake for the guard is read in that pass instead.
+TEST_F(IntercomAudioTest, DatagramWakesTheTask) {
+  const int datagrams = 10;
+  this->setup_intercom();
+  this->intercom.start("127.0.0.1", this->peer.port());
+  const uint32_t packets = this->intercom.get_rx_packets();
+  const uint32_t socket = this->intercom.get_socket_wakeups();
+  std::vector<double> latency_ms;
+  for (int i = 0; i < datagrams; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));  // Let the task block again
+    const uint32_t before = this->intercom.get_rx_packets();
+    const uint32_t socket_before = this->intercom.get_socket_wakeups();
+    const uint32_t guard_before = this->intercom.get_guard_wakeups();
+    auto t0 = std::chrono::steady_clock::now();
+    this->peer.send_frame(this->listen_port, (int16_t) i);
+    while (this->intercom.get_rx_packets() == before && elapsed_ms(t0) < 1000.0) {
+      std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+    latency_ms.push_back(elapsed_ms(t0));
+    EXPECT_TRUE(this->intercom.get_socket_wakeups() != socket_before ||
+                this->intercom.get_guard_wakeups() != guard_before);
+  }
+  RecordProperty("rx_latency_ms_median", std::to_string(Timings::percentile(latency_ms, 0.5)));
+
+  EXPECT_EQ(this->intercom.get_rx_packets() - packets, (uint32_t) datagrams);
+  EXPECT_GT(this->intercom.get_socket_wakeups() - socket, 0u);
+  this->intercom.stop();
+}
+
+// Mic frames wake the streaming task through the eventfd only: a task
+// notification per frame would pile up and end the idle wait right after stop
+TEST_F(IntercomAudioTest, StoppedTaskStaysAsleep) {
+  this->setup_intercom();
+  // After one call the task is known to be in its idle wait
+  this->intercom.start("127.0.0.1", this->peer.port());
+  this->intercom.stop();
+  this->intercom.start("127.0.0.1", this->peer.port());
+  std::vector<uint8_t> frame(FRAME_BYTES);
+  for (int f = 0; f < 8; f++) {
+    this->feed_tagged(frame, 1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  // Blocked in select() again, well inside the guard timeout
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  const uint32_t wakeups = this->intercom.get_task_wakeups();
+  this->intercom.stop();
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  // The wait stop() ended was counted when it began; going idle adds none
+  EXPECT_EQ(this->intercom.get_task_wakeups(), wakeups);
+  EXPECT_EQ(metric(this->intercom, "intercom_stop_ack_timeouts_total"), 0);
+}
+
+TEST_F(IntercomAudioTest, FaultsDoNotLeakOrCrossCalls) {
+  this->intercom.set_fault_rate(Fault::SEND_ERROR, 0.2f);
+  this->intercom.set_fault_rate(Fault::RECEIVE_LOSS, 0.2f);
+  this->intercom.set_fault_rate(Fault::SPEAKER_STALL, 0.2f);
+  this->intercom.set_fault_rate(Fault::MIC_OVERFLOW, 0.2f);
+  this->setup_intercom();
+  this->start_feeding();
+
+  this->run_cycles(5);
+  const size_t blocks = host_shim::heap_caps_live_blocks();
+  const int fds = open_descriptors();
+
+  Timings timings = this->run_cycles(soak_cycles(300));
+  timings.report();
+
+  EXPECT_EQ(host_shim::heap_caps_live_blocks(), blocks);
+  EXPECT_EQ(open_descriptors(), fds);
+  EXPECT_EQ(this->foreign_frames, 0u);
+  EXPECT_GT(metric(this->intercom, "intercom_injected_send_errors_total"), 0);
+  EXPECT_GT(metric(this->intercom, "intercom_injected_mic_overflows_total"), 0);
+  EXPECT_EQ(metric(this->intercom, "intercom_stop_ack_timeouts_total"), 0);
+}
+
+}  // namespace
+}  // namespace intercom_audio
+}  // namespace esphome
@@ -0,0 +1,255 @@
+// IntercomAudio on an I2SAudioDuplex, both against shims: the duplex audio
+// task reads a fake I2S controller paced at the sample rate and writes every
+// frame it plays back to the test. Each call starts and stops the duplex, so
+// the cycles also check that no I2S channel, task buffer or frame bus slot is
+// left behind, including when I2S reads and writes time out.
+//
+// SOAK_CYCLES=<n> runs longer, as in intercom_audio_test.
+
+#include "intercom_harness.h"
+
+#include "i2s_audio_duplex/i2s_audio_duplex.h"
+
+#include <driver/i2s_std.h>
+#include <esp_heap_caps.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace esphome {
+namespace intercom_audio {
+namespace {
+
+// Odd calls are positive, even ones negative: a played sample of the other sign
+// came from the previous call, whatever concealment did to its level
+int16_t call_tag(int call) { return (int16_t) (call % 2 != 0 ? call : -call); }
+
+// One component and one duplex per test process: their tasks outlive the test
+class IntercomDuplexTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    this->listen_port = free_udp_port();
+    this->duplex.set_bclk_pin(1);
+    this->duplex.set_lrclk_pin(2);
+    this->duplex.set_din_pin(3);
+    this->duplex.set_dout_pin(4);
+    // Subscribed but never active: every captured frame takes a bus slot and
+    // hands it back, and intercom stop() still stops the duplex
+    this->duplex.subscribe_frames(4, i2s_audio_duplex::DropPolicy::DROP_OLDEST);
+    this->intercom.set_duplex(&this->duplex);
+    this->intercom.set_listen_port(this->listen_port);
+
+    host_shim::set_i2s_capture([this](uint8_t *data, size_t len) {
+      const int16_t tag = call_tag(this->call.load());
+      for (size_t i = 0; i + 1 < len; i += 2) {
+        memcpy(&data[i], &tag, sizeof(tag));
+      }
+    });
+    host_shim::set_i2s_playback([this](const uint8_t *data, size_t len) {
+      const bool positive = this->call.load() % 2 != 0;
+      for (size_t i = 0; i + 1 < len; i += 2) {
+        int16_t sample;
+        memcpy(&sample, &data[i], sizeof(sample));
+        if (sample != 0) {
+          this->played_samples++;
+          if ((sample > 0) != positive) {
+            this->foreign_samples++;
+          }
+        }
+      }
+    });
+  }
+
+  void setup_components() {
+    this->duplex.setup();
+    ASSERT_FALSE(this->duplex.is_failed());
+    this->intercom.setup();
+    ASSERT_FALSE(this->intercom.is_failed());
+  }
+
+  void TearDown() override {
+    if (this->intercom.is_streaming()) {
+      this->intercom.stop();
+    }
+    host_shim::set_i2s_capture(nullptr);
+    host_shim::set_i2s_playback(nullptr);
+  }
+
+  // Start/stop cycles with traffic both ways; the duplex captures between
+  // start() and stop() only, so the tag needs no lock
+  Timings run_cycles(int cycles) {
+    Timings timings;
+    for (int i = 1; i <= cycles; i++) {
+      this->call.store(++this->calls);
+      auto t0 = std::chrono::steady_clock::now();
+      this->intercom.start("127.0.0.1", this->peer.port());
+      timings.start_ms.push_back(elapsed_ms(t0));
+      EXPECT_TRUE(this->intercom.is_streaming());
+
+      // The audio task starts the duplex; then a few frames of traffic at the
+      // frame rate, enough to get past the prebuffer and into the speaker
+      for (int ms = 0; ms < 1000 && !this->duplex.is_running(); ms++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+      EXPECT_TRUE(this->duplex.is_running());
+      for (int f = 0; f < 8; f++) {
+        this->peer.send_frame(this->listen_port, call_tag(this->calls));
+        std::this_thread::sleep_for(std::chrono::milliseconds(16));
+      }
+      this->peer.drain([&](int16_t tag) { this->check_tag(tag); });
+
+      t0 = std::chrono::steady_clock::now();
+      this->intercom.stop();
+      timings.stop_ms.push_back(elapsed_ms(t0));
+      EXPECT_FALSE(this->duplex.is_running());
+      EXPECT_EQ(host_shim::i2s_live_channels(), 0u);
+      this->peer.drain([&](int16_t tag) { this->check_tag(tag); });
+    }
+    return timings;
+  }
+
+  void check_tag(int16_t tag) {
+    this->sent_to_peer++;
+    if (tag != call_tag(this->calls)) {
+      this->foreign_frames++;
+    }
+  }
+
+  // Leak checks against the state after a few warm-up calls (the frame bus
+  // pool is allocated on the first start)
+  void expect_cycles_leak_nothing(int cycles) {
+    this->run_cycles(3);
+    const size_t blocks = host_shim::heap_caps_live_blocks();
+    const int fds = open_descriptors();
+
+    Timings timings = this->run_cycles(cycles);
+    timings.report();
+
+    EXPECT_EQ(host_shim::heap_caps_live_blocks(), blocks);
+    EXPECT_EQ(open_descriptors(), fds);
+    EXPECT_EQ(this->foreign_frames, 0u);
+    EXPECT_EQ(this->foreign_samples.load(), 0u);
+    EXPECT_GT(this->sent_to_peer, 0u);
+    EXPECT_GT(metric(this->intercom, "i2s_audio_duplex_frames_published_total"), 0);
+    EXPECT_EQ(metric(this->intercom, "i2s_audio_duplex_frame_overruns_total"), 0);
+    EXPECT_EQ(metric(this->intercom, "intercom_stop_ack_timeouts_total"), 0);
+  }
+
+  // Never freed: the audio tasks keep using them until the process exits
+  i2s_audio_duplex::I2SAudioDuplex &duplex{*new i2s_audio_duplex::I2SAudioDuplex()};
+  IntercomAudio &intercom{*new IntercomAudio()};
+  Peer peer;
+  uint16_t listen_port{0};
+
+  std::atomic<int> call{0};
+  int calls{0};
+  uint32_t sent_to_peer{0};
+  uint32_t foreign_frames{0};
+  std::atomic<uint32_t> played_samples{0};
+  std::atomic<uint32_t> foreign_samples{0};
+};
+
+TEST_F(IntercomDuplexTest, StartStopCyclesLeakNothing) {
+  this->setup_components();
+  this->expect_cycles_leak_nothing(soak_cycles(50));
+  EXPECT_GT(this->played_samples.load(), 0u);
+  EXPECT_EQ(metric(this->intercom, "i2s_audio_duplex_read_timeouts_total"), 0);
+  EXPECT_EQ(metric(this->intercom, "i2s_audio_duplex_write_timeouts_total"), 0);
+}
+
+// A timed-out read hands its bus slot back and delivers nothing; a timed-out
+// write drops that frame. Neither may leak or carry audio into the next call.
+TEST_F(IntercomDuplexTest, I2STimeoutsDoNotLeakOrCrossCalls) {
+  this->intercom.set_fault_rate(Fault::I2S_READ_TIMEOUT, 0.2f);
+  this->intercom.set_fault_rate(Fault::I2S_WRITE_TIMEOUT, 0.2f);
+  this->setup_components();
+  this->expect_cycles_leak_nothing(soak_cycles(50));
+
+  const double read_timeouts = metric(this->intercom, "intercom_injected_i2s_read_timeouts_total");
+  const double write_timeouts = metric(this->intercom, "intercom_injected_i2s_write_timeouts_total");
+  EXPECT_GT(read_timeouts, 0);
+  EXPECT_GT(write_timeouts, 0);
+  // The fake controller never times out by itself
+  EXPECT_EQ(metric(this->intercom, "i2s_audio_duplex_read_timeouts_total"), read_timeouts);
+  EXPECT_EQ(metric(this->intercom, "i2s_audio_duplex_write_timeouts_total"), write_timeouts);
+}
+
+// Every read and write fails: the task still ends on stop() and frees all of it
+TEST_F(IntercomDuplexTest, StopWhileEveryI2SCallTimesOut) {
+  this->intercom.set_fault_rate(Fault::I2S_READ_TIMEOUT, 1.0f);
+  this->intercom.set_fault_rate(Fault::I2S_WRITE_TIMEOUT, 1.0f);
+  this->setup_components();
+  this->run_cycles(3);
+  const size_t blocks = host_shim::heap_caps_live_blocks();
+  this->run_cycles(10);
+
+  EXPECT_EQ(host_shim::heap_caps_live_blocks(), blocks);
+  EXPECT_EQ(this->sent_to_peer, 0u);
+  EXPECT_EQ(this->played_samples.load(), 0u);
+  EXPECT_EQ(metric(this->intercom, "i2s_audio_duplex_frames_published_total"), 0);
+  EXPECT_EQ(metric(this->intercom, "intercom_stop_ack_timeouts_total"), 0);
+}
+
+// Each datagram goes into the trace as an RX record, in order and as received:
+// what tools/trace_report.py --replay sends again. TRACE_DUMP=<file> keeps the
+// dump for the trace_replay_report test.
+TEST_F(IntercomDuplexTest, TraceRecordsEveryReceivedFrame) {
+  this->intercom.set_trace_duration(2000);
+  this->setup_components();
+  ASSERT_TRUE(this->intercom.has_trace());
+  // Untraced first call: a start() right after setup() can run before the new
+  // audio task has taken its first look at the session counter
+  this->run_cycles(1);
+  this->intercom.set_trace_enabled(true);
+  this->run_cycles(1);
+  this->intercom.set_trace_enabled(false);
+
+  const std::vector<uint8_t> dump = dump_trace(this->intercom.get_trace());
+  const size_t record_size = this->intercom.get_trace().get_record_size();
+  std::vector<TraceRecordHeader> rx;
+  uint32_t plays = 0, starts = 0, stops = 0;
+  for (size_t at = AudioTrace::FILE_HEADER_SIZE; at + record_size <= dump.size(); at += record_size) {
+    TraceRecordHeader header;
+    memcpy(&header, &dump[at], sizeof(header));
+    if (header.kind == (uint8_t) TraceKind::PLAY) {
+      plays++;
+    } else if (header.kind == (uint8_t) TraceKind::EVENT) {
+      starts += header.event == (uint16_t) TraceEvent::SESSION_START;
+      stops += header.event == (uint16_t) TraceEvent::SESSION_STOP;
+    } else if (header.kind == (uint8_t) TraceKind::RX) {
+      rx.push_back(header);
+      for (size_t i = 0; i < header.samples; i++) {
+        int16_t sample;
+        memcpy(&sample, &dump[at + sizeof(header) + i * sizeof(sample)], sizeof(sample));
+        ASSERT_EQ(sample, call_tag(2));
+      }
+    }
+  }
+  ASSERT_EQ(rx.size(), 8u);
+  for (size_t i = 0; i < rx.size(); i++) {
+    EXPECT_EQ(rx[i].seq, i);
+    EXPECT_EQ(rx[i].samples, FRAME_SAMPLES);
+    EXPECT_EQ(rx[i].flags, 0);
+    if (i > 0) {
+      EXPECT_GE(rx[i].time_us - rx[i - 1].time_us, 10000u);  // Sent 16 ms apart
+    }
+  }
+  EXPECT_GT(plays, 0u);
+  EXPECT_EQ(starts, 1u);
+  EXPECT_EQ(stops, 1u);
+
+  const char *path = getenv("TRACE_DUMP");
+  if (path != nullptr) {
+    FILE *file = fopen(path, "wb");
+    ASSERT_NE(file, nullptr);
+    EXPECT_EQ(fwrite(dump.data(), 1, dump.size(), file), dump.size());
+    fclose(file);
+  }
+}
+
+}  // namespace
+}  // namespace intercom_audio
+}  // namespace esphome
@@ -0,0 +1,164 @@
+#pragma once
+
+// What the IntercomAudio host tests (and trace_replay) share: the far end of
+// the call, metric scrapes, descriptor counts and stop() timings. SOAK_CYCLES=<n> sets how many
+// start/stop cycles the soak tests run.
+
+#include "intercom_audio/intercom_audio.h"
+
+#include <gtest/gtest.h>
+
+#include <arpa/inet.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace esphome {
+namespace intercom_audio {
+
+static const size_t FRAME_SAMPLES = IntercomAudio::get_frame_samples();
+static const size_t FRAME_BYTES = FRAME_SAMPLES * sizeof(int16_t);
+
+inline int open_descriptors() {
+  int count = 0;
+  DIR *dir = opendir("/proc/self/fd");
+  if (dir == nullptr) {
+    return -1;
+  }
+  while (readdir(dir) != nullptr) {
+    count++;
+  }
+  closedir(dir);
+  return count;
+}
+
+// The far end: a loopback UDP socket on a port of its own
+class Peer {
+ public:
+  Peer() {
+    this->fd_ = socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(this->fd_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr));
+    socklen_t len = sizeof(addr);
+    getsockname(this->fd_, reinterpret_cast<sockaddr *>(&addr), &len);
+    this->port_ = ntohs(addr.sin_port);
+    fcntl(this->fd_, F_SETFL, O_NONBLOCK);
+  }
+  ~Peer() { close(this->fd_); }
+
+  uint16_t port() const { return this->port_; }
+
+  void send_frame(uint16_t to_port, int16_t value) {
+    std::vector<int16_t> frame(FRAME_SAMPLES, value);
+    this->send_samples(to_port, frame.data(), frame.size());
+  }
+
+  // A raw PCM datagram
+  void send_samples(uint16_t to_port, const int16_t *samples, size_t count) {
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(to_port);
+    sendto(this->fd_, samples, count * sizeof(int16_t), 0, reinterpret_cast<sockaddr *>(&addr), sizeof(addr));
+  }
+
+  // Every datagram waiting; calls check(first sample) for each
+  template<typename F> size_t drain(F &&check) {
+    uint8_t buf[2048];
+    size_t count = 0;
+    while (true) {
+      ssize_t n = recv(this->fd_, buf, sizeof(buf), 0);
+      if (n < 0) {
+        return count;
+      }
+      if (n >= 2) {
+        int16_t first;
+        memcpy(&first, buf, sizeof(first));
+        check(first);
+      }
+      count++;
+    }
+  }
+
+ protected:
+  int fd_;
+  uint16_t port_;
+};
+
+inline uint16_t free_udp_port() {
+  Peer probe;
+  return probe.port();
+}
+
+inline double metric(const IntercomAudio &intercom, const std::string &name) {
+  static MetricsSnapshot snapshot;  // Too large for the stack of a test
+  snapshot.clear();
+  intercom.collect_metrics(snapshot);
+  EXPECT_EQ(snapshot.get_dropped(), 0u);
+  std::string text;
+  char buf[1024];
+  snapshot.write(buf, sizeof(buf), [&text](const char *data, size_t len) {
+    text.append(data, len);
+    return true;
+  });
+  size_t at = text.find("\n" + name + " ");
+  return at == std::string::npos ? -1.0 : std::stod(text.substr(at + name.size() + 2));
+}
+
+// The whole trace as the web export serves it
+inline std::vector<uint8_t> dump_trace(const AudioTrace &trace) {
+  AudioTrace::Reader reader;
+  trace.open(&reader);
+  std::vector<uint8_t> dump(trace.get_dump_size(reader));
+  size_t at = trace.write_file_header(dump.data());
+  size_t n;
+  while ((n = trace.read(&reader, &dump[at], dump.size() - at)) > 0) {
+    at += n;
+  }
+  dump.resize(at);
+  return dump;
+}
+
+struct Timings {
+  std::vector<double> start_ms;
+  std::vector<double> stop_ms;
+
+  static double percentile(std::vector<double> values, double p) {
+    std::sort(values.begin(), values.end());
+    return values[std::min(values.size() - 1, (size_t) (values.size() * p))];
+  }
+  void report() const {
+    double sum = 0;
+    for (double ms : this->stop_ms) {
+      sum += ms;
+    }
+    ::testing::Test::RecordProperty("cycles", std::to_string(this->stop_ms.size()));
+    ::testing::Test::RecordProperty("stop_ms_mean", std::to_string(sum / this->stop_ms.size()));
+    ::testing::Test::RecordProperty("stop_ms_p95", std::to_string(percentile(this->stop_ms, 0.95)));
+    ::testing::Test::RecordProperty("stop_ms_max", std::to_string(percentile(this->stop_ms, 1.0)));
+    if (!this->start_ms.empty()) {
+      ::testing::Test::RecordProperty("start_ms_p95", std::to_string(percentile(this->start_ms, 0.95)));
+    }
+  }
+};
+
+inline double elapsed_ms(std::chrono::steady_clock::time_point since) {
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+}
+
+inline int soak_cycles(int fallback) {
+  const char *env = getenv("SOAK_CYCLES");
+  return env != nullptr ? atoi(env) : fallback;
+}
+
+}  // namespace intercom_audio
+}  // namespace esphome
@@ -0,0 +1,152 @@
+// Loopback delay, polarity and gain from a simulated speaker-to-mic path
+
+#include "i2s_audio_duplex/loopback_calibrator.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace esphome {
+namespace i2s_audio_duplex {
+namespace {
+
+static const double PI = 3.14159265358979323846;
+static const size_t FRAME = 256;
+static const size_t MAX_LAG = 1600;  // 100 ms at 16 kHz
+static const int16_t AMPLITUDE = 8000;
+
+// Echo path: gain and a (possibly fractional) delay, by a Hann-windowed sinc
+std::vector<double> echo_path(double delay, double gain) {
+  const int half = 32;
+  std::vector<double> taps(MAX_LAG + half + 1, 0.0);
+  int centre = (int) std::floor(delay);
+  double frac = delay - centre;
+  for (int k = -half; k <= half; k++) {
+    int n = centre + k;
+    if (n < 0 || n >= (int) taps.size()) {
+      continue;
+    }
+    double t = k - frac;
+    double sinc = std::fabs(t) < 1e-9 ? 1.0 : std::sin(PI * t) / (PI * t);
+    double window = 0.5 + 0.5 * std::cos(PI * t / (half + 1));
+    taps[n] = gain * sinc * window;
+  }
+  return taps;
+}
+
+// Plays the stimulus frame by frame, feeds the mic what the path makes of it
+// (plus noise) and runs the analysis in slices like the main loop does
+LoopbackResult measure(const std::vector<double> &path, double noise_rms, uint32_t seed = 1) {
+  LoopbackCalibrator cal;
+  EXPECT_TRUE(cal.begin(MAX_LAG, AMPLITUDE));
+  std::mt19937 rng(seed);
+  std::normal_distribution<double> noise(0.0, noise_rms > 0.0 ? noise_rms : 1.0);
+
+  std::vector<int16_t> played;
+  std::vector<int16_t> frame(FRAME);
+  std::vector<int16_t> mic(FRAME);
+  bool captured = false;
+  while (!captured) {
+    cal.fill_stimulus(frame.data(), FRAME);
+    played.insert(played.end(), frame.begin(), frame.end());
+    size_t base = played.size() - FRAME;
+    for (size_t i = 0; i < FRAME; i++) {
+      double acc = noise_rms > 0.0 ? noise(rng) : 0.0;
+      size_t n = base + i;
+      for (size_t k = 0; k < path.size() && k <= n; k++) {
+        if (path[k] != 0.0) {
+          acc += path[k] * played[n - k];
+        }
+      }
+      mic[i] = (int16_t) std::lround(std::max(-32768.0, std::min(32767.0, acc)));
+    }
+    captured = cal.capture(mic.data(), FRAME);
+  }
+  while (!cal.analyze(256)) {
+  }
+  return cal.get_result();
+}
+
+std::vector<double> direct(size_t delay, double gain) {
+  std::vector<double> path(delay + 1, 0.0);
+  path[delay] = gain;
+  return path;
+}
+
+TEST(LoopbackCalibrator, IntegerDelaysAreExact) {
+  for (size_t delay : {0u, 1u, 37u, 250u, 777u, 1599u}) {
+    LoopbackResult r = measure(direct(delay, 0.25), 0.0);
+    EXPECT_TRUE(r.valid) << delay;
+    EXPECT_FLOAT_EQ(r.delay_samples, (float) delay);
+    EXPECT_FALSE(r.inverted);
+    EXPECT_NEAR(r.gain_db, 20.0 * std::log10(0.25), 0.1) << delay;
+  }
+}
+
+TEST(LoopbackCalibrator, FractionalDelaysWithinPointOneFiveSamples) {
+  for (double delay : {100.25, 100.5, 100.75, 333.1, 512.9}) {
+    LoopbackResult r = measure(echo_path(delay, 0.3), 0.0);
+    EXPECT_TRUE(r.valid) << delay;
+    EXPECT_NEAR(r.delay_samples, delay, 0.15) << delay;
+    // The three taps around the peak hold most, not all, of a fractional path
+    EXPECT_NEAR(r.gain_db, 20.0 * std::log10(0.3), 1.0) << delay;
+  }
+}
+
+TEST(LoopbackCalibrator, InvertedPolarityIsReported) {
+  LoopbackResult r = measure(direct(300, -0.2), 0.0);
+  EXPECT_TRUE(r.valid);
+  EXPECT_TRUE(r.inverted);
+  EXPECT_FLOAT_EQ(r.delay_samples, 300.0f);
+
+  LoopbackResult frac = measure(echo_path(300.4, -0.2), 0.0);
+  EXPECT_TRUE(frac.inverted);
+  EXPECT_NEAR(frac.delay_samples, 300.4, 0.15);
+}
+
+TEST(LoopbackCalibrator, FindsTheDelayUnderNoiseAndAQuieterReflection) {
+  // Direct path 30 dB down with noise as loud as the echo, plus a later reflection
+  std::vector<double> path = echo_path(420.6, 0.03);
+  std::vector<double> reflection = echo_path(700.0, 0.01);
+  for (size_t i = 0; i < path.size(); i++) {
+    path[i] += reflection[i];
+  }
+  LoopbackResult r = measure(path, 0.03 * AMPLITUDE, 7);
+  EXPECT_TRUE(r.valid);
+  EXPECT_NEAR(r.delay_samples, 420.6, 0.2);
+  EXPECT_GT(r.peak_to_noise_db, LoopbackCalibrator::MIN_PEAK_TO_NOISE_DB);
+}
+
+TEST(LoopbackCalibrator, NoiseAloneIsRejected) {
+  for (uint32_t seed = 1; seed <= 5; seed++) {
+    LoopbackResult r = measure({}, 2000.0, seed);
+    EXPECT_FALSE(r.valid) << "seed " << seed << ": peak " << r.peak_to_noise_db << " dB";
+  }
+}
+
+TEST(LoopbackCalibrator, SilenceIsRejected) {
+  LoopbackResult r = measure({}, 0.0);
+  EXPECT_FALSE(r.valid);
+}
+
+TEST(LoopbackCalibrator, StimulusIsOneFullSequenceThenSilence) {
+  LoopbackCalibrator cal;
+  ASSERT_TRUE(cal.begin(10, 1000));
+  std::vector<int16_t> out(LoopbackCalibrator::MLS_LENGTH + 100);
+  cal.fill_stimulus(out.data(), out.size());
+  int ones = 0;
+  for (size_t i = 0; i < LoopbackCalibrator::MLS_LENGTH; i++) {
+    ASSERT_TRUE(out[i] == 1000 || out[i] == -1000);
+    ones += out[i] > 0 ? 1 : 0;
+  }
+  EXPECT_EQ(ones, 2048);  // A maximum length sequence has one more 1 than 0
+  for (size_t i = LoopbackCalibrator::MLS_LENGTH; i < out.size(); i++) {
+    EXPECT_EQ(out[i], 0);
+  }
+}
+
+}  // namespace
+}  // namespace i2s_audio_duplex
+}  // namespace esphome
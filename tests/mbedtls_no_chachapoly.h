@@ -0,0 +1,11 @@
+// Host mbedTLS config without ChaCha20-Poly1305, as in the ESP-IDF default
+// sdkconfig. Used as MBEDTLS_CONFIG_FILE, so it pulls in the stock config first.
+#if __has_include(<mbedtls/mbedtls_config.h>)
+#include <mbedtls/mbedtls_config.h>
+#else
+#include <mbedtls/config.h>
+#endif
+
+#undef MBEDTLS_CHACHAPOLY_C
+#undef MBEDTLS_CHACHA20_C
+#undef MBEDTLS_POLY1305_C
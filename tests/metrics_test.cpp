@@ -0,0 +1,133 @@
+// Metrics snapshot, its exposition format and the pass sequence a scrape copies under
+
+#include "intercom_audio/metrics.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+
+namespace esphome {
+namespace intercom_audio {
+namespace {
+
+std::string render(const MetricsSnapshot &m) {
+  std::string out;
+  char buf[512];
+  EXPECT_TRUE(m.write(buf, sizeof(buf), [&out](const char *data, size_t len) {
+    out.append(data, len);
+    return true;
+  }));
+  return out;
+}
+
+TEST(MetricsSnapshot, WritesCountersGaugesAndCumulativeBuckets) {
+  LatencyHistogram h;
+  h.record(50);      // First bucket
+  h.record(300);     // le 0.0005
+  h.record(900000);  // +Inf only
+  MetricsSnapshot m;
+  m.counter("a_total", "A", 3);
+  m.gauge("b", "B", 0.5);
+  m.histogram("h_seconds", "H", h);
+  std::string out = render(m);
+  EXPECT_NE(out.find("# TYPE a_total counter\na_total 3\n"), std::string::npos);
+  EXPECT_NE(out.find("# TYPE b gauge\nb 0.5\n"), std::string::npos);
+  EXPECT_NE(out.find("h_seconds_bucket{le=\"0.0001\"} 1\n"), std::string::npos);
+  EXPECT_NE(out.find("h_seconds_bucket{le=\"0.0005\"} 2\n"), std::string::npos);
+  EXPECT_NE(out.find("h_seconds_bucket{le=\"0.25\"} 2\n"), std::string::npos);
+  EXPECT_NE(out.find("h_seconds_bucket{le=\"+Inf\"} 3\n"), std::string::npos);
+  EXPECT_NE(out.find("h_seconds_count 3\n"), std::string::npos);
+  EXPECT_NE(out.find("h_seconds_sum 0.900350\n"), std::string::npos);
+}
+
+TEST(MetricsSnapshot, RewindTakesBackAGroup) {
+  LatencyHistogram h;
+  MetricsSnapshot m;
+  m.counter("kept_total", "Kept", 1);
+  MetricsSnapshot::Mark mark = m.mark();
+  m.counter("retried_total", "Retried", 1);
+  m.histogram("retried_seconds", "Retried", h);
+  m.rewind(mark);
+  m.counter("retried_total", "Retried", 2);
+  std::string out = render(m);
+  EXPECT_NE(out.find("kept_total 1\n"), std::string::npos);
+  EXPECT_NE(out.find("retried_total 2\n"), std::string::npos);
+  EXPECT_EQ(out.find("retried_total 1\n"), std::string::npos);
+  EXPECT_EQ(out.find("retried_seconds"), std::string::npos);
+}
+
+TEST(MetricsSnapshot, ValuesPastTheCapacityAreCounted) {
+  MetricsSnapshot m;
+  for (size_t i = 0; i < MetricsSnapshot::MAX_VALUES + 3; i++) {
+    m.counter("c_total", "C", i);
+  }
+  EXPECT_EQ(m.get_dropped(), 3u);
+  MetricsSnapshot::Mark mark = m.mark();
+  m.gauge("g", "G", 1);
+  m.rewind(mark);
+  EXPECT_EQ(m.get_dropped(), 3u);
+}
+
+TEST(PassSequence, PauseAndScopeEndOnce) {
+  PassSequence seq;
+  uint32_t idle = seq.read_begin();
+  {
+    PassSequence::Pass pass(seq);
+    EXPECT_FALSE(seq.read_end(seq.read_begin()));  // Odd while the pass runs
+    pass.pause();
+    uint32_t paused = seq.read_begin();
+    EXPECT_TRUE(seq.read_end(paused));
+    pass.resume();
+    pass.pause();
+    // Leaving the scope after a pause must not start another pass
+  }
+  uint32_t after = seq.read_begin();
+  EXPECT_TRUE(seq.read_end(after));
+  EXPECT_NE(after, idle);
+}
+
+// A writer keeps two counters equal at the end of every pass; every copy a
+// reader accepts must see them equal, and it must get some copies
+TEST(PassSequence, AcceptedCopiesAreFromBetweenPasses) {
+  PassSequence seq;
+  std::atomic<uint32_t> packets{0};
+  std::atomic<uint32_t> bytes{0};
+  std::atomic<bool> done{false};
+
+  std::thread writer([&] {
+    for (uint32_t i = 0; i < 20000; i++) {
+      PassSequence::Pass pass(seq);
+      packets.fetch_add(1, std::memory_order_relaxed);
+      std::this_thread::yield();
+      bytes.fetch_add(1, std::memory_order_relaxed);
+      if ((i & 63) == 0) {
+        pass.pause();
+        std::this_thread::yield();
+      }
+    }
+    done.store(true);
+  });
+
+  uint32_t accepted = 0;
+  uint32_t torn = 0;
+  while (!done.load()) {
+    uint32_t s = seq.read_begin();
+    uint32_t p = packets.load(std::memory_order_relaxed);
+    uint32_t b = bytes.load(std::memory_order_relaxed);
+    if (seq.read_end(s)) {
+      accepted++;
+      if (p != b) {
+        torn++;
+      }
+    }
+    std::this_thread::yield();
+  }
+  writer.join();
+  EXPECT_EQ(torn, 0u);
+  EXPECT_GT(accepted, 0u);
+}
+
+}  // namespace
+}  // namespace intercom_audio
+}  // namespace esphome
@@ -0,0 +1,90 @@
+// 32-bit mic samples to int16: scaling, dither that keeps sub-LSB level,
+// gain with clamping and DC removal
+
+#include "intercom_audio/mic_convert.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace esphome {
+namespace intercom_audio {
+namespace {
+
+static const size_t SAMPLES = 100000;
+
+std::vector<int16_t> convert(MicConverter &converter, int32_t value, size_t samples = SAMPLES) {
+  std::vector<int32_t> in(samples, value);
+  std::vector<int16_t> out(samples);
+  converter.process(in.data(), out.data(), samples);
+  return out;
+}
+
+double mean(const std::vector<int16_t> &samples, size_t from = 0) {
+  double sum = 0;
+  for (size_t i = from; i < samples.size(); i++) {
+    sum += samples[i];
+  }
+  return sum / (samples.size() - from);
+}
+
+TEST(MicConverterTest, TopSixteenBitsWithinOneLsbOfDither) {
+  MicConverter converter;
+  for (int16_t value : {0, 1, -1, 1234, -1234, 32000, -32000}) {
+    std::vector<int16_t> out = convert(converter, (int32_t) value * 65536, 1000);
+    for (int16_t sample : out) {
+      ASSERT_LE(std::abs(sample - value), 1) << "input " << value;
+    }
+    EXPECT_NEAR(mean(out), value, 0.1) << "input " << value;
+  }
+}
+
+TEST(MicConverterTest, DitherKeepsLevelsBelowOneLsb) {
+  // A quarter of an output LSB: plain rounding would give 0 every time
+  MicConverter converter;
+  EXPECT_NEAR(mean(convert(converter, 0x4000)), 0.25, 0.02);
+  EXPECT_NEAR(mean(convert(converter, -0x4000)), -0.25, 0.02);
+}
+
+TEST(MicConverterTest, GainRunsBeforeRoundingAndClamps) {
+  MicConverter converter;
+  converter.set_gain(4);
+  // 0.25 LSB times four is a whole LSB, not four times a rounded zero
+  EXPECT_NEAR(mean(convert(converter, 0x4000)), 1.0, 0.02);
+  EXPECT_NEAR(mean(convert(converter, 1000 * 65536)), 4000.0, 0.1);
+
+  std::vector<int16_t> high = convert(converter, 10000 * 65536, 100);
+  std::vector<int16_t> low = convert(converter, -10000 * 65536, 100);
+  EXPECT_EQ(high, std::vector<int16_t>(100, 32767));
+  EXPECT_EQ(low, std::vector<int16_t>(100, -32768));
+}
+
+TEST(MicConverterTest, DcRemovalSettlesToZeroAndReset) {
+  MicConverter converter;
+  converter.set_dc_removal(true);
+  std::vector<int16_t> out = convert(converter, 5000 * 65536);
+  EXPECT_NEAR(out[0], 5000, 2);  // The estimate starts at zero
+  EXPECT_NEAR(mean(out, SAMPLES - 1000), 0.0, 0.1);
+
+  // A 1 kHz tone at 16 kHz rides on the offset untouched
+  std::vector<int32_t> tone(16000);
+  for (size_t i = 0; i < tone.size(); i++) {
+    tone[i] = (int32_t) lround((5000.0 + 8000.0 * sin(2.0 * M_PI * 1000.0 * i / 16000.0)) * 65536.0);
+  }
+  std::vector<int16_t> tone_out(tone.size());
+  converter.process(tone.data(), tone_out.data(), tone.size());
+  int16_t peak = 0;
+  for (size_t i = tone.size() - 16; i < tone.size(); i++) {
+    peak = std::max<int16_t>(peak, tone_out[i]);
+  }
+  EXPECT_NEAR(peak, 8000, 50);
+
+  converter.reset();
+  EXPECT_NEAR(convert(converter, 5000 * 65536, 1)[0], 5000, 2);
+}
+
+}  // namespace
+}  // namespace intercom_audio
+}  // namespace esphome
@@ -0,0 +1,163 @@
+// Mic callbacks cut into frames: in place, assembled across chunks, 24-bit
+// samples, misaligned tails and the capture time of each frame
+
+#include "intercom_audio/mic_ingest.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+namespace esphome {
+namespace intercom_audio {
+namespace {
+
+static const size_t FRAME_SAMPLES = 16;  // 1 ms at 16 kHz
+static const uint32_t SAMPLE_RATE = 16000;
+
+// Sample i of the stream is i, in sample_bytes little-endian bytes
+std::vector<uint8_t> samples(size_t first, size_t count, uint8_t sample_bytes) {
+  std::vector<uint8_t> out;
+  for (size_t i = first; i < first + count; i++) {
+    for (uint8_t b = 0; b < sample_bytes; b++) {
+      out.push_back(b == 0 ? (uint8_t) i : 0);
+    }
+  }
+  return out;
+}
+
+class MicIngestTest : public ::testing::Test {
+ protected:
+  void SetUp() override { ASSERT_TRUE(this->ingest.allocate(FRAME_SAMPLES, SAMPLE_RATE)); }
+
+  // Pushes a chunk and keeps every frame it completes
+  void push(const std::vector<uint8_t> &chunk, int64_t now_us) {
+    this->ingest.push(chunk.data(), chunk.size(), now_us);
+    MicIngest::Frame frame;
+    while (this->ingest.pop(&frame)) {
+      const size_t bytes = FRAME_SAMPLES * this->ingest.get_sample_bytes();
+      this->frames.emplace_back(frame.data, frame.data + bytes);
+      this->captures.push_back(frame.capture_us);
+      this->in_place.push_back(frame.data >= chunk.data() && frame.data < chunk.data() + chunk.size());
+    }
+  }
+
+  // Frames so far are the stream from sample 0 on, without a gap
+  void expect_contiguous() {
+    const uint8_t width = this->ingest.get_sample_bytes();
+    for (size_t f = 0; f < this->frames.size(); f++) {
+      EXPECT_EQ(this->frames[f], samples(f * FRAME_SAMPLES, FRAME_SAMPLES, width)) << "frame " << f;
+    }
+  }
+
+  MicIngest ingest;
+  std::vector<std::vector<uint8_t>> frames;
+  std::vector<int64_t> captures;
+  std::vector<bool> in_place;
+};
+
+TEST_F(MicIngestTest, WholeFramesAreHandedOutInPlace) {
+  this->push(samples(0, 3 * FRAME_SAMPLES, 2), 3000);
+
+  ASSERT_EQ(this->frames.size(), 3u);
+  this->expect_contiguous();
+  EXPECT_EQ(this->in_place, std::vector<bool>(3, true));
+  EXPECT_EQ(this->ingest.get_assembled_frames(), 0u);
+  EXPECT_EQ(this->ingest.get_misaligned_bytes(), 0u);
+}
+
+TEST_F(MicIngestTest, ChunksSmallerThanAFrameAreAssembled) {
+  // 5 samples at a time: a frame needs three or four chunks
+  for (size_t first = 0; first < 60; first += 5) {
+    this->push(samples(first, 5, 2), 0);
+  }
+
+  ASSERT_EQ(this->frames.size(), 3u);  // 60 samples: 12 of the fourth are held
+  this->expect_contiguous();
+  EXPECT_EQ(this->ingest.get_assembled_frames(), 3u);
+  EXPECT_EQ(this->in_place, std::vector<bool>(3, false));
+}
+
+TEST_F(MicIngestTest, ChunksLargerThanAFrameCarryTheirRemainder) {
+  // 1.5 frames, then 1.5 frames: in place, assembled from both, in place
+  this->push(samples(0, FRAME_SAMPLES * 3 / 2, 2), 0);
+  this->push(samples(FRAME_SAMPLES * 3 / 2, FRAME_SAMPLES * 3 / 2, 2), 0);
+
+  ASSERT_EQ(this->frames.size(), 3u);
+  this->expect_contiguous();
+  EXPECT_EQ(this->in_place, (std::vector<bool>{true, false, true}));
+  EXPECT_EQ(this->ingest.get_assembled_frames(), 1u);
+}
+
+TEST_F(MicIngestTest, PackedTwentyFourBitSamples) {
+  this->ingest.set_sample_bytes(3);
+  // 7 samples (21 bytes) per chunk: frames of 48 bytes straddle chunks
+  for (size_t first = 0; first < 2 * FRAME_SAMPLES + 4; first += 7) {
+    this->push(samples(first, 7, 3), 0);
+  }
+
+  ASSERT_EQ(this->frames.size(), 2u);
+  this->expect_contiguous();
+  EXPECT_EQ(this->frames[0].size(), FRAME_SAMPLES * 3);
+  EXPECT_EQ(this->ingest.get_misaligned_bytes(), 0u);
+}
+
+TEST_F(MicIngestTest, OddTailsAreCountedAndDropped) {
+  // A 16-bit chunk one byte past its last whole sample
+  std::vector<uint8_t> chunk = samples(0, 10, 2);
+  chunk.push_back(0xEE);
+  this->push(chunk, 0);
+  this->push(samples(10, 6, 2), 0);
+  ASSERT_EQ(this->frames.size(), 1u);
+  this->expect_contiguous();  // The stray byte never reached a frame
+  EXPECT_EQ(this->ingest.get_misaligned_bytes(), 1u);
+
+  // 24-bit: 3 * 5 + 2 bytes leaves a two-byte tail
+  this->ingest.set_sample_bytes(3);
+  chunk = samples(0, 5, 3);
+  chunk.push_back(0xEE);
+  chunk.push_back(0xEE);
+  this->push(chunk, 0);
+  EXPECT_EQ(this->ingest.get_misaligned_bytes(), 3u);
+
+  // A width change drops the 5 samples already held for the next frame
+  this->ingest.set_sample_bytes(2);
+  EXPECT_EQ(this->ingest.get_misaligned_bytes(), 3u + 5 * 3);
+}
+
+TEST_F(MicIngestTest, AssembledFrameCarriesTheCaptureTimeOfItsFirstSample) {
+  // 16 kHz: 62.5 us per sample. Each chunk arrives when its last sample is in.
+  this->push(samples(0, 10, 2), 10000);  // Samples 0-9 from 9375 us
+  EXPECT_TRUE(this->frames.empty());
+  this->push(samples(10, 10, 2), 10625);  // 10-19 from 10000 us: frame 0 done
+  ASSERT_EQ(this->frames.size(), 1u);
+  EXPECT_EQ(this->captures[0], 9375);
+
+  // Frame 1 starts at sample 16, six samples into the second chunk
+  this->push(samples(20, 12, 2), 11375);
+  ASSERT_EQ(this->frames.size(), 2u);
+  this->expect_contiguous();
+  EXPECT_EQ(this->captures[1], 10000 + 6 * 1000000 / SAMPLE_RATE);
+  EXPECT_EQ(this->ingest.get_assembled_frames(), 2u);
+}
+
+TEST_F(MicIngestTest, InPlaceFramesAreTimedFromTheChunkEnd) {
+  this->push(samples(0, 2 * FRAME_SAMPLES, 2), 5000);
+
+  ASSERT_EQ(this->captures.size(), 2u);
+  EXPECT_EQ(this->captures[0], 3000);
+  EXPECT_EQ(this->captures[1], 4000);
+}
+
+TEST_F(MicIngestTest, ResetForgetsThePartialFrame) {
+  this->push(samples(0, 10, 2), 0);
+  this->ingest.reset();
+  this->push(samples(0, FRAME_SAMPLES, 2), 0);
+
+  ASSERT_EQ(this->frames.size(), 1u);
+  this->expect_contiguous();
+  EXPECT_TRUE(this->in_place[0]);
+}
+
+}  // namespace
+}  // namespace intercom_audio
+}  // namespace esphome
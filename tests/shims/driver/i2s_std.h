@@ -0,0 +1,91 @@
+#pragma once
+
+// One fake I2S controller. Enabled RX channels hand out audio at the sample
+// rate (a read waits until the DMA would have filled), TX channels take every
+// write at once. Disabled channels fail like the real driver does.
+#include "esp_err.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+typedef struct HostI2SChannel *i2s_chan_handle_t;
+
+typedef enum { GPIO_NUM_NC = -1 } gpio_num_t;
+typedef enum { I2S_NUM_0 = 0 } i2s_port_t;
+typedef enum { I2S_ROLE_MASTER, I2S_ROLE_SLAVE } i2s_role_t;
+typedef enum { I2S_CLK_SRC_DEFAULT } i2s_clock_src_t;
+typedef enum { I2S_MCLK_MULTIPLE_256 = 256 } i2s_mclk_multiple_t;
+typedef enum { I2S_DATA_BIT_WIDTH_16BIT = 16, I2S_DATA_BIT_WIDTH_32BIT = 32 } i2s_data_bit_width_t;
+typedef enum { I2S_SLOT_BIT_WIDTH_AUTO = 0, I2S_SLOT_BIT_WIDTH_32BIT = 32 } i2s_slot_bit_width_t;
+typedef enum { I2S_SLOT_MODE_MONO = 1, I2S_SLOT_MODE_STEREO = 2 } i2s_slot_mode_t;
+typedef enum { I2S_STD_SLOT_LEFT = 1, I2S_STD_SLOT_RIGHT = 2, I2S_STD_SLOT_BOTH = 3 } i2s_std_slot_mask_t;
+
+typedef struct {
+  i2s_port_t id;
+  i2s_role_t role;
+  uint32_t dma_desc_num;
+  uint32_t dma_frame_num;
+  bool auto_clear_after_cb;
+  bool auto_clear_before_cb;
+  int intr_priority;
+} i2s_chan_config_t;
+
+typedef struct {
+  uint32_t sample_rate_hz;
+  i2s_clock_src_t clk_src;
+  i2s_mclk_multiple_t mclk_multiple;
+} i2s_std_clk_config_t;
+
+typedef struct {
+  i2s_data_bit_width_t data_bit_width;
+  i2s_slot_bit_width_t slot_bit_width;
+  i2s_slot_mode_t slot_mode;
+  i2s_std_slot_mask_t slot_mask;
+  uint32_t ws_width;
+} i2s_std_slot_config_t;
+
+#define I2S_STD_PHILIPS_SLOT_DEFAULT_CONFIG(bits, mode) \
+  { \
+    .data_bit_width = (bits), .slot_bit_width = I2S_SLOT_BIT_WIDTH_AUTO, .slot_mode = (mode), \
+    .slot_mask = I2S_STD_SLOT_BOTH, .ws_width = (uint32_t) (bits), \
+  }
+
+typedef struct {
+  gpio_num_t mclk;
+  gpio_num_t bclk;
+  gpio_num_t ws;
+  gpio_num_t dout;
+  gpio_num_t din;
+  struct {
+    bool mclk_inv;
+    bool bclk_inv;
+    bool ws_inv;
+  } invert_flags;
+} i2s_std_gpio_config_t;
+
+typedef struct {
+  i2s_std_clk_config_t clk_cfg;
+  i2s_std_slot_config_t slot_cfg;
+  i2s_std_gpio_config_t gpio_cfg;
+} i2s_std_config_t;
+
+esp_err_t i2s_new_channel(const i2s_chan_config_t *chan_cfg, i2s_chan_handle_t *tx_handle,
+                          i2s_chan_handle_t *rx_handle);
+esp_err_t i2s_del_channel(i2s_chan_handle_t handle);
+esp_err_t i2s_channel_init_std_mode(i2s_chan_handle_t handle, const i2s_std_config_t *std_cfg);
+esp_err_t i2s_channel_enable(i2s_chan_handle_t handle);
+esp_err_t i2s_channel_disable(i2s_chan_handle_t handle);
+esp_err_t i2s_channel_read(i2s_chan_handle_t handle, void *dest, size_t size, size_t *bytes_read,
+                           uint32_t timeout_ms);
+esp_err_t i2s_channel_write(i2s_chan_handle_t handle, const void *src, size_t size, size_t *bytes_written,
+                            uint32_t timeout_ms);
+
+namespace host_shim {
+// Fills what an RX channel captures (silence without one), and sees what a TX
+// channel plays; both run on the reading or writing task
+void set_i2s_capture(std::function<void(uint8_t *data, size_t len)> capture);
+void set_i2s_playback(std::function<void(const uint8_t *data, size_t len)> playback);
+// Channels made by i2s_new_channel and not deleted yet
+size_t i2s_live_channels();
+}  // namespace host_shim
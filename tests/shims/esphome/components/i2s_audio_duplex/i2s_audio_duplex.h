@@ -0,0 +1,4 @@
+#pragma once
+
+// The real component, under the path ESPHome gives it
+#include "i2s_audio_duplex/i2s_audio_duplex.h"
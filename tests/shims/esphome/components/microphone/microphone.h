@@ -0,0 +1,38 @@
+#pragma once
+
+#include "esphome/components/audio/audio.h"
+#include "esphome/core/helpers.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace esphome {
+namespace microphone {
+
+enum State : uint8_t {
+  STATE_STOPPED = 0,
+  STATE_STARTING,
+  STATE_RUNNING,
+  STATE_STOPPING,
+};
+
+class Microphone {
+ public:
+  virtual ~Microphone() = default;
+  virtual void start() = 0;
+  virtual void stop() = 0;
+  void add_data_callback(std::function<void(const std::vector<uint8_t> &)> &&data_callback) {
+    this->data_callbacks_.add(std::move(data_callback));
+  }
+  bool is_running() const { return this->state_ == STATE_RUNNING; }
+  bool is_stopped() const { return this->state_ == STATE_STOPPED; }
+  audio::AudioStreamInfo get_audio_stream_info() { return this->audio_stream_info_; }
+
+ protected:
+  State state_{STATE_STOPPED};
+  audio::AudioStreamInfo audio_stream_info_;
+  CallbackManager<void(const std::vector<uint8_t> &)> data_callbacks_{};
+};
+
+}  // namespace microphone
+}  // namespace esphome
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "esphome/components/audio/audio.h"
+#include "freertos/FreeRTOS.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace esphome {
+namespace speaker {
+
+enum State : uint8_t {
+  STATE_STOPPED = 0,
+  STATE_STARTING,
+  STATE_RUNNING,
+  STATE_STOPPING,
+};
+
+class Speaker {
+ public:
+  virtual ~Speaker() = default;
+  virtual size_t play(const uint8_t *data, size_t length, TickType_t ticks_to_wait) {
+    return this->play(data, length);
+  }
+  virtual size_t play(const uint8_t *data, size_t length) = 0;
+  virtual void start() = 0;
+  virtual void stop() = 0;
+  virtual bool has_buffered_data() const = 0;
+  bool is_running() const { return this->state_ == STATE_RUNNING; }
+  virtual void set_volume(float volume) { this->volume_ = volume; }
+  float get_volume() { return this->volume_; }
+  virtual void set_mute_state(bool mute_state) { this->mute_state_ = mute_state; }
+  void set_audio_stream_info(const audio::AudioStreamInfo &info) { this->audio_stream_info_ = info; }
+
+ protected:
+  State state_{STATE_STOPPED};
+  audio::AudioStreamInfo audio_stream_info_;
+  float volume_{1.0f};
+  bool mute_state_{false};
+};
+
+}  // namespace speaker
+}  // namespace esphome
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "esphome/core/component.h"
+
+namespace esphome {
+
+class Application {
+ public:
+  void set_loop_interval(uint32_t ms) { this->loop_interval_ = ms; }
+  uint32_t get_loop_interval() const { return this->loop_interval_; }
+
+ protected:
+  uint32_t loop_interval_{16};
+};
+
+extern Application App;  // NOLINT
+
+}  // namespace esphome
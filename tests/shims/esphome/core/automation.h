@@ -0,0 +1,50 @@
+#pragma once
+
+// Triggers count how often they fired, so a test can check a start or stop ran.
+// Templatable values are plain values (no lambdas).
+#include "esphome/core/component.h"
+#include "esphome/core/optional.h"
+
+#include <cstdint>
+
+namespace esphome {
+
+template<typename... Ts> class Trigger {
+ public:
+  void trigger(Ts... x) { this->fired_++; }
+  uint32_t get_fired() const { return this->fired_; }
+
+ protected:
+  uint32_t fired_{0};
+};
+
+template<typename... Ts> class Action {
+ public:
+  virtual ~Action() = default;
+  virtual void play(Ts... x) = 0;
+};
+
+template<typename... Ts> class Condition {
+ public:
+  virtual ~Condition() = default;
+  virtual bool check(Ts... x) = 0;
+};
+
+template<typename T, typename... X> class TemplatableValue {
+ public:
+  TemplatableValue() = default;
+  TemplatableValue(T value) : value_(value) {}
+  T value(X... x) { return this->value_; }
+
+ protected:
+  T value_{};
+};
+
+#define TEMPLATABLE_VALUE(type, name) \
+ protected: \
+  TemplatableValue<type, Ts...> name##_{}; \
+\
+ public: \
+  template<typename V> void set_##name(V name) { this->name##_ = name; }
+
+}  // namespace esphome
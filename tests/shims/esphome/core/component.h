@@ -0,0 +1,38 @@
+#pragma once
+
+// The slice of Component the components under test use; mark_failed() sticks
+#include "esphome/core/helpers.h"
+#include "esphome/core/log.h"
+
+#include <cstdint>
+
+namespace esphome {
+
+namespace setup_priority {
+static const float HARDWARE = 800.0f;
+static const float DATA = 600.0f;
+static const float PROCESSOR = 400.0f;
+static const float AFTER_WIFI = 200.0f;
+static const float LATE = -100.0f;
+}  // namespace setup_priority
+
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+
+class Component {
+ public:
+  virtual ~Component() = default;
+  virtual void setup() {}
+  virtual void loop() {}
+  virtual void dump_config() {}
+  virtual float get_setup_priority() const { return setup_priority::DATA; }
+
+  void mark_failed() { this->failed_ = true; }
+  bool is_failed() const { return this->failed_; }
+
+ protected:
+  bool failed_{false};
+};
+
+}  // namespace esphome
@@ -0,0 +1,8 @@
+#pragma once
+
+#include "esphome/core/component.h"
+
+namespace esphome {
+// Nanoseconds here, for cycle counts that only get compared
+uint32_t arch_get_cpu_cycle_count();
+}  // namespace esphome
@@ -0,0 +1,14 @@
+#pragma once
+
+// Log calls compile (and keep their arguments used) but print nothing
+namespace esphome {
+inline void host_log_discard(const char *tag, const char *format, ...) {}
+}  // namespace esphome
+
+#define ESP_LOGE(tag, ...) ::esphome::host_log_discard(tag, __VA_ARGS__)
+#define ESP_LOGW(tag, ...) ::esphome::host_log_discard(tag, __VA_ARGS__)
+#define ESP_LOGI(tag, ...) ::esphome::host_log_discard(tag, __VA_ARGS__)
+#define ESP_LOGD(tag, ...) ::esphome::host_log_discard(tag, __VA_ARGS__)
+#define ESP_LOGV(tag, ...) ::esphome::host_log_discard(tag, __VA_ARGS__)
+#define ESP_LOGVV(tag, ...) ::esphome::host_log_discard(tag, __VA_ARGS__)
+#define ESP_LOGCONFIG(tag, ...) ::esphome::host_log_discard(tag, __VA_ARGS__)
@@ -0,0 +1,7 @@
+#pragma once
+
+#include <optional>
+
+namespace esphome {
+template<typename T> using optional = std::optional<T>;
+}  // namespace esphome
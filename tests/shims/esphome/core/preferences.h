@@ -0,0 +1,22 @@
+#pragma once
+
+// Nothing is kept across runs: every load finds no record, every save succeeds
+#include <cstdint>
+
+namespace esphome {
+
+class ESPPreferenceObject {
+ public:
+  template<typename T> bool save(const T *src) { return true; }
+  template<typename T> bool load(T *dest) { return false; }
+};
+
+class ESPPreferences {
+ public:
+  template<typename T> ESPPreferenceObject make_preference(uint32_t type, bool in_flash) { return {}; }
+  bool sync() { return true; }
+};
+
+extern ESPPreferences *global_preferences;  // NOLINT
+
+}  // namespace esphome
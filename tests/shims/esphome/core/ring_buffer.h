@@ -0,0 +1,38 @@
+#pragma once
+
+// Byte ring like ESPHome's, with storage from heap_caps_malloc so the heap
+// accounting sees it. Reads and writes never wait.
+#include "freertos/FreeRTOS.h"
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+
+namespace esphome {
+
+class RingBuffer {
+ public:
+  ~RingBuffer();
+
+  size_t read(void *data, size_t len, TickType_t ticks_to_wait = 0);
+  // Makes room by dropping the oldest bytes
+  size_t write(const void *data, size_t len);
+  size_t write_without_replacement(const void *data, size_t len, TickType_t ticks_to_wait = 0,
+                                   bool write_partial = true);
+  size_t available() const;
+  size_t free() const;
+  BaseType_t reset();
+
+  static std::unique_ptr<RingBuffer> create(size_t len);
+
+ protected:
+  size_t put_(const void *data, size_t len);
+
+  mutable std::mutex mutex_;
+  uint8_t *storage_{nullptr};
+  size_t size_{0};
+  size_t head_{0};
+  size_t used_{0};
+};
+
+}  // namespace esphome
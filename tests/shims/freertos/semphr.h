@@ -0,0 +1,20 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+#include <functional>
+
+// Mutexes and binary semaphores are both a count of at most one
+typedef struct HostSemaphore *SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateMutex();
+SemaphoreHandle_t xSemaphoreCreateBinary();
+void vSemaphoreDelete(SemaphoreHandle_t semaphore);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks_to_wait);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore);
+
+namespace host_shim {
+// Runs on the taking thread at the start of xSemaphoreTake, before it waits:
+// lets a test land a stop() and start() inside another task's critical path
+void set_semaphore_take_hook(std::function<void(SemaphoreHandle_t)> hook);
+}  // namespace host_shim
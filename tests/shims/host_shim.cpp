@@ -0,0 +1,511 @@
+// Host implementations behind the shim headers
+
+#include "driver/i2s_std.h"
+#include "esp_heap_caps.h"
+#include "esp_partition.h"
+#include "esp_timer.h"
+#include "esphome/core/application.h"
+#include "esphome/core/hal.h"
+#include "esphome/core/helpers.h"
+#include "esphome/core/preferences.h"
+#include "esphome/core/ring_buffer.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "lwip/api.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+struct HostQueue {
+  std::mutex mutex;
+  std::condition_variable changed;
+  std::deque<std::vector<uint8_t>> items;
+  size_t length;
+  size_t item_size;
+};
+
+struct HostTask {
+  std::mutex mutex;
+  std::condition_variable notified;
+  uint32_t notifications{0};
+  std::atomic<bool> deleted{false};
+};
+
+struct HostI2SChannel {
+  std::atomic<bool> enabled{false};
+  uint32_t sample_rate{16000};
+  size_t frame_bytes{2};  // One sample of every slot
+  int64_t filled_us{0};   // RX: capture time up to which reads have been served
+};
+
+struct HostSemaphore {
+  std::mutex mutex;
+  std::condition_variable given;
+  uint32_t count;
+};
+
+namespace host_shim {
+
+static std::function<void(QueueHandle_t)> queue_send_hook;
+static std::function<void(SemaphoreHandle_t)> semaphore_take_hook;
+static std::function<void(uint8_t *, size_t)> i2s_capture;
+static std::function<void(const uint8_t *, size_t)> i2s_playback;
+static std::atomic<size_t> i2s_channels{0};
+static std::mutex heap_mutex;
+static size_t heap_blocks = 0;
+static size_t heap_bytes = 0;
+// Internal heap of a plain ESP32 with Wi-Fi up, before anything here allocates
+static const size_t HEAP_TOTAL = 320 * 1024;
+
+static const auto boot = std::chrono::steady_clock::now();
+// Tasks made by xTaskCreatePinnedToCore, or made on first use for other threads
+static thread_local HostTask *current_task = nullptr;
+
+void set_queue_send_hook(std::function<void(QueueHandle_t)> hook) { queue_send_hook = std::move(hook); }
+
+void set_semaphore_take_hook(std::function<void(SemaphoreHandle_t)> hook) { semaphore_take_hook = std::move(hook); }
+
+void set_i2s_capture(std::function<void(uint8_t *, size_t)> capture) { i2s_capture = std::move(capture); }
+
+void set_i2s_playback(std::function<void(const uint8_t *, size_t)> playback) { i2s_playback = std::move(playback); }
+
+size_t i2s_live_channels() { return i2s_channels.load(); }
+
+size_t heap_caps_live_blocks() {
+  std::lock_guard<std::mutex> lock(heap_mutex);
+  return heap_blocks;
+}
+
+// condition_variable::wait() would need a newer libstdc++ than some GTest
+// builds carry; a bounded wait_for in a loop does the same
+template<typename Pred> static bool wait_for(std::condition_variable &cv, std::unique_lock<std::mutex> &lock,
+                                             TickType_t ticks, Pred pred) {
+  if (ticks == portMAX_DELAY) {
+    while (!cv.wait_for(lock, std::chrono::seconds(1), pred)) {
+    }
+    return true;
+  }
+  return cv.wait_for(lock, std::chrono::milliseconds(ticks * portTICK_PERIOD_MS), pred);
+}
+
+static HostTask *this_task() {
+  if (current_task == nullptr) {
+    current_task = new HostTask();  // Lives as long as the thread may be notified
+  }
+  return current_task;
+}
+
+// Allocations carry their size in front, for the free heap figure
+static const size_t HEADER = alignof(std::max_align_t);
+
+static void *track(void *block, size_t size) {
+  if (block == nullptr) {
+    return nullptr;
+  }
+  *static_cast<size_t *>(block) = size;
+  std::lock_guard<std::mutex> lock(heap_mutex);
+  heap_blocks++;
+  heap_bytes += size;
+  return static_cast<uint8_t *>(block) + HEADER;
+}
+
+}  // namespace host_shim
+
+// Queues
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size) {
+  auto *queue = new HostQueue();
+  queue->length = length;
+  queue->item_size = item_size;
+  return queue;
+}
+
+void vQueueDelete(QueueHandle_t queue) { delete queue; }
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks_to_wait) {
+  if (host_shim::queue_send_hook) {
+    host_shim::queue_send_hook(queue);
+  }
+  {
+    std::unique_lock<std::mutex> lock(queue->mutex);
+    if (!host_shim::wait_for(queue->changed, lock, ticks_to_wait,
+                             [queue] { return queue->items.size() < queue->length; })) {
+      return pdFALSE;
+    }
+    const auto *bytes = static_cast<const uint8_t *>(item);
+    queue->items.emplace_back(bytes, bytes + queue->item_size);
+  }
+  queue->changed.notify_all();
+  return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks_to_wait) {
+  {
+    std::unique_lock<std::mutex> lock(queue->mutex);
+    if (!host_shim::wait_for(queue->changed, lock, ticks_to_wait, [queue] { return !queue->items.empty(); })) {
+      return pdFALSE;
+    }
+    std::memcpy(item, queue->items.front().data(), queue->item_size);
+    queue->items.pop_front();
+  }
+  queue->changed.notify_all();
+  return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+  std::lock_guard<std::mutex> lock(queue->mutex);
+  return queue->items.size();
+}
+
+// Tasks and notifications
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t code, const char *name, uint32_t stack_depth, void *param,
+                                   UBaseType_t priority, TaskHandle_t *created, BaseType_t core) {
+  auto *task = new HostTask();
+  if (created != nullptr) {
+    *created = task;
+  }
+  std::thread([task, code, param] {
+    host_shim::current_task = task;
+    code(param);
+  }).detach();
+  return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task) {
+  if (task == nullptr) {
+    host_shim::this_task()->deleted.store(true);
+  }
+}
+
+eTaskState eTaskGetState(TaskHandle_t task) { return task->deleted.load() ? eDeleted : eRunning; }
+
+void vTaskYield() { std::this_thread::yield(); }
+
+void vTaskDelay(TickType_t ticks) { std::this_thread::sleep_for(std::chrono::milliseconds(ticks * portTICK_PERIOD_MS)); }
+
+TickType_t xTaskGetTickCount() { return esphome::millis() / portTICK_PERIOD_MS; }
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+  {
+    std::lock_guard<std::mutex> lock(task->mutex);
+    task->notifications++;
+  }
+  task->notified.notify_all();
+  return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks_to_wait) {
+  HostTask *task = host_shim::this_task();
+  std::unique_lock<std::mutex> lock(task->mutex);
+  host_shim::wait_for(task->notified, lock, ticks_to_wait, [task] { return task->notifications > 0; });
+  uint32_t count = task->notifications;
+  if (count > 0) {
+    task->notifications = clear_on_exit ? 0 : count - 1;
+  }
+  return count;
+}
+
+// Semaphores
+
+static SemaphoreHandle_t create_semaphore(uint32_t count) {
+  auto *semaphore = new HostSemaphore();
+  semaphore->count = count;
+  return semaphore;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex() { return create_semaphore(1); }
+
+SemaphoreHandle_t xSemaphoreCreateBinary() { return create_semaphore(0); }
+
+void vSemaphoreDelete(SemaphoreHandle_t semaphore) { delete semaphore; }
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks_to_wait) {
+  if (host_shim::semaphore_take_hook) {
+    host_shim::semaphore_take_hook(semaphore);
+  }
+  std::unique_lock<std::mutex> lock(semaphore->mutex);
+  if (!host_shim::wait_for(semaphore->given, lock, ticks_to_wait, [semaphore] { return semaphore->count > 0; })) {
+    return pdFALSE;
+  }
+  semaphore->count--;
+  return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+  {
+    std::lock_guard<std::mutex> lock(semaphore->mutex);
+    if (semaphore->count > 0) {
+      return pdFALSE;
+    }
+    semaphore->count = 1;
+  }
+  semaphore->given.notify_all();
+  return pdTRUE;
+}
+
+// Heap
+
+void *heap_caps_malloc(size_t size, uint32_t caps) {
+  return host_shim::track(std::malloc(host_shim::HEADER + size), size);
+}
+
+void *heap_caps_calloc(size_t n, size_t size, uint32_t caps) {
+  return host_shim::track(std::calloc(1, host_shim::HEADER + n * size), n * size);
+}
+
+void heap_caps_free(void *ptr) {
+  if (ptr == nullptr) {
+    return;
+  }
+  void *block = static_cast<uint8_t *>(ptr) - host_shim::HEADER;
+  size_t size = *static_cast<size_t *>(block);
+  std::free(block);
+  std::lock_guard<std::mutex> lock(host_shim::heap_mutex);
+  host_shim::heap_blocks--;
+  host_shim::heap_bytes -= size;
+}
+
+size_t heap_caps_get_free_size(uint32_t caps) {
+  std::lock_guard<std::mutex> lock(host_shim::heap_mutex);
+  return host_shim::HEAP_TOTAL - std::min(host_shim::heap_bytes, host_shim::HEAP_TOTAL);
+}
+
+// I2S
+
+esp_err_t i2s_new_channel(const i2s_chan_config_t *chan_cfg, i2s_chan_handle_t *tx_handle,
+                          i2s_chan_handle_t *rx_handle) {
+  for (i2s_chan_handle_t *handle : {tx_handle, rx_handle}) {
+    if (handle != nullptr) {
+      *handle = new HostI2SChannel();
+      host_shim::i2s_channels++;
+    }
+  }
+  return ESP_OK;
+}
+
+esp_err_t i2s_del_channel(i2s_chan_handle_t handle) {
+  if (handle->enabled.load()) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  delete handle;
+  host_shim::i2s_channels--;
+  return ESP_OK;
+}
+
+esp_err_t i2s_channel_init_std_mode(i2s_chan_handle_t handle, const i2s_std_config_t *std_cfg) {
+  const i2s_std_slot_config_t &slot = std_cfg->slot_cfg;
+  handle->sample_rate = std_cfg->clk_cfg.sample_rate_hz;
+  handle->frame_bytes = (size_t) slot.slot_mode * slot.data_bit_width / 8;
+  return ESP_OK;
+}
+
+esp_err_t i2s_channel_enable(i2s_chan_handle_t handle) {
+  if (handle->enabled.exchange(true)) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  handle->filled_us = esp_timer_get_time();
+  return ESP_OK;
+}
+
+esp_err_t i2s_channel_disable(i2s_chan_handle_t handle) {
+  return handle->enabled.exchange(false) ? ESP_OK : ESP_ERR_INVALID_STATE;
+}
+
+esp_err_t i2s_channel_read(i2s_chan_handle_t handle, void *dest, size_t size, size_t *bytes_read,
+                           uint32_t timeout_ms) {
+  *bytes_read = 0;
+  if (!handle->enabled.load()) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  // Returns once the DMA would have captured this much; a reader that fell
+  // far behind finds the ring overwritten and starts again from now
+  const int64_t now = esp_timer_get_time();
+  const int64_t duration = (int64_t) (size / handle->frame_bytes) * 1000000 / handle->sample_rate;
+  handle->filled_us = std::max(handle->filled_us, now - 4 * duration) + duration;
+  if (handle->filled_us > now) {
+    std::this_thread::sleep_for(std::chrono::microseconds(handle->filled_us - now));
+  }
+  if (host_shim::i2s_capture) {
+    host_shim::i2s_capture(static_cast<uint8_t *>(dest), size);
+  } else {
+    std::memset(dest, 0, size);
+  }
+  *bytes_read = size;
+  return ESP_OK;
+}
+
+esp_err_t i2s_channel_write(i2s_chan_handle_t handle, const void *src, size_t size, size_t *bytes_written,
+                            uint32_t timeout_ms) {
+  *bytes_written = 0;
+  if (!handle->enabled.load()) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  if (host_shim::i2s_playback) {
+    host_shim::i2s_playback(static_cast<const uint8_t *>(src), size);
+  }
+  *bytes_written = size;
+  return ESP_OK;
+}
+
+// No flash partitions on the host
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                                const char *label) {
+  return nullptr;
+}
+
+esp_err_t esp_partition_mmap(const esp_partition_t *partition, size_t offset, size_t size,
+                             esp_partition_mmap_memory_t memory, const void **out_ptr,
+                             esp_partition_mmap_handle_t *out_handle) {
+  return ESP_FAIL;
+}
+
+// Time
+
+int64_t esp_timer_get_time() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - host_shim::boot)
+      .count();
+}
+
+// No netconn on the host
+
+const ip_addr_t ip_addr_any = {0};
+
+struct netconn *netconn_new_with_callback(enum netconn_type type, netconn_callback callback) { return nullptr; }
+err_t netconn_bind(struct netconn *conn, const ip_addr_t *addr, u16_t port) { return ERR_MEM; }
+err_t netconn_recv(struct netconn *conn, struct netbuf **new_buf) { return ERR_WOULDBLOCK; }
+err_t netconn_sendto(struct netconn *conn, struct netbuf *buf, const ip_addr_t *addr, u16_t port) { return ERR_MEM; }
+err_t netconn_delete(struct netconn *conn) { return ERR_OK; }
+void netconn_set_nonblocking(struct netconn *conn, int val) {}
+struct netbuf *netbuf_new() { return nullptr; }
+void netbuf_delete(struct netbuf *buf) {}
+void *netbuf_alloc(struct netbuf *buf, u16_t size) { return nullptr; }
+err_t netbuf_data(struct netbuf *buf, void **dataptr, u16_t *len) { return ERR_MEM; }
+s8_t netbuf_next(struct netbuf *buf) { return -1; }
+void netbuf_first(struct netbuf *buf) {}
+u16_t netbuf_len(struct netbuf *buf) { return 0; }
+int ipaddr_aton(const char *cp, ip_addr_t *addr) { return 0; }
+
+namespace esphome {
+
+Application App;  // NOLINT
+
+static ESPPreferences host_preferences;
+ESPPreferences *global_preferences = &host_preferences;  // NOLINT
+
+uint32_t millis() { return (uint32_t) (esp_timer_get_time() / 1000); }
+
+uint32_t micros() { return (uint32_t) esp_timer_get_time(); }
+
+void delay(uint32_t ms) { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+
+uint32_t arch_get_cpu_cycle_count() {
+  return (uint32_t) std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() -
+                                                                         host_shim::boot)
+      .count();
+}
+
+bool random_bytes(uint8_t *data, size_t len) {
+  static std::mutex mutex;
+  static std::random_device source;
+  std::lock_guard<std::mutex> lock(mutex);
+  for (size_t i = 0; i < len; i++) {
+    data[i] = (uint8_t) source();
+  }
+  return true;
+}
+
+uint32_t fnv1_hash(const std::string &str) {
+  uint32_t hash = 2166136261UL;
+  for (char c : str) {
+    hash *= 16777619UL;
+    hash ^= (uint8_t) c;
+  }
+  return hash;
+}
+
+// Ring buffer
+
+RingBuffer::~RingBuffer() { heap_caps_free(this->storage_); }
+
+std::unique_ptr<RingBuffer> RingBuffer::create(size_t len) {
+  std::unique_ptr<RingBuffer> rb(new RingBuffer());
+  rb->storage_ = static_cast<uint8_t *>(heap_caps_malloc(len, MALLOC_CAP_8BIT));
+  if (rb->storage_ == nullptr) {
+    return nullptr;
+  }
+  rb->size_ = len;
+  return rb;
+}
+
+size_t RingBuffer::read(void *data, size_t len, TickType_t ticks_to_wait) {
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  size_t n = std::min(len, this->used_);
+  auto *out = static_cast<uint8_t *>(data);
+  size_t tail = (this->head_ + this->size_ - this->used_) % this->size_;
+  for (size_t i = 0; i < n; i++) {
+    out[i] = this->storage_[(tail + i) % this->size_];
+  }
+  this->used_ -= n;
+  return n;
+}
+
+size_t RingBuffer::put_(const void *data, size_t len) {
+  const auto *in = static_cast<const uint8_t *>(data);
+  for (size_t i = 0; i < len; i++) {
+    this->storage_[this->head_] = in[i];
+    this->head_ = (this->head_ + 1) % this->size_;
+  }
+  this->used_ += len;
+  return len;
+}
+
+size_t RingBuffer::write(const void *data, size_t len) {
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  len = std::min(len, this->size_);
+  size_t room = this->size_ - this->used_;
+  if (len > room) {
+    this->used_ -= len - room;  // Oldest bytes go
+  }
+  return this->put_(data, len);
+}
+
+size_t RingBuffer::write_without_replacement(const void *data, size_t len, TickType_t ticks_to_wait,
+                                             bool write_partial) {
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  size_t room = this->size_ - this->used_;
+  if (len > room && !write_partial) {
+    return 0;
+  }
+  return this->put_(data, std::min(len, room));
+}
+
+size_t RingBuffer::available() const {
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  return this->used_;
+}
+
+size_t RingBuffer::free() const {
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  return this->size_ - this->used_;
+}
+
+BaseType_t RingBuffer::reset() {
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  this->used_ = 0;
+  this->head_ = 0;
+  return pdPASS;
+}
+
+}  // namespace esphome
@@ -0,0 +1,52 @@
+#pragma once
+
+// Enough of the netconn API to build NetconnTransport. There is no netconn on
+// the host: netconn_new_with_callback() fails, so only the socket transport runs.
+#include <cstdint>
+
+typedef int8_t err_t;
+typedef uint16_t u16_t;
+typedef int8_t s8_t;
+
+#define ERR_OK 0
+#define ERR_MEM -1
+#define ERR_WOULDBLOCK -7
+
+struct ip_addr_t {
+  uint32_t addr;
+};
+extern const ip_addr_t ip_addr_any;
+#define IP_ADDR_ANY (&ip_addr_any)
+
+enum netconn_type { NETCONN_UDP = 0x20 };
+enum netconn_evt {
+  NETCONN_EVT_RCVPLUS,
+  NETCONN_EVT_RCVMINUS,
+  NETCONN_EVT_SENDPLUS,
+  NETCONN_EVT_SENDMINUS,
+  NETCONN_EVT_ERROR,
+};
+
+struct udp_pcb;
+struct netconn {
+  union {
+    struct udp_pcb *udp;
+  } pcb;
+};
+struct netbuf;
+typedef void (*netconn_callback)(struct netconn *conn, enum netconn_evt evt, u16_t len);
+
+struct netconn *netconn_new_with_callback(enum netconn_type type, netconn_callback callback);
+err_t netconn_bind(struct netconn *conn, const ip_addr_t *addr, u16_t port);
+err_t netconn_recv(struct netconn *conn, struct netbuf **new_buf);
+err_t netconn_sendto(struct netconn *conn, struct netbuf *buf, const ip_addr_t *addr, u16_t port);
+err_t netconn_delete(struct netconn *conn);
+void netconn_set_nonblocking(struct netconn *conn, int val);
+struct netbuf *netbuf_new();
+void netbuf_delete(struct netbuf *buf);
+void *netbuf_alloc(struct netbuf *buf, u16_t size);
+err_t netbuf_data(struct netbuf *buf, void **dataptr, u16_t *len);
+s8_t netbuf_next(struct netbuf *buf);
+void netbuf_first(struct netbuf *buf);
+u16_t netbuf_len(struct netbuf *buf);
+int ipaddr_aton(const char *cp, ip_addr_t *addr);
@@ -0,0 +1,10 @@
+#pragma once
+
+// The host's BSD sockets stand in for lwIP's
+#include <netinet/in.h>
+#include <netinet/ip.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
@@ -0,0 +1,7 @@
+#pragma once
+
+#include <cstdint>
+
+struct udp_pcb {
+  uint8_t tos;
+};
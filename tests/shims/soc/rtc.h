@@ -0,0 +1,7 @@
+#pragma once
+
+typedef enum {
+  SOC_XTAL_FREQ_40M = 40,
+} soc_xtal_freq_t;
+
+inline soc_xtal_freq_t rtc_clk_xtal_freq_get() { return SOC_XTAL_FREQ_40M; }
@@ -0,0 +1,4 @@
+#pragma once
+
+// A plain ESP32: standard I2S slots only
+#define SOC_I2S_SUPPORTS_TDM 0
@@ -0,0 +1,210 @@
+// Stream encryption round trips, forgery and replay rejection, and the cost
+// of sealing and opening one frame
+
+#include "intercom_audio/stream_crypto.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstring>
+#include <vector>
+
+namespace esphome {
+namespace intercom_audio {
+namespace {
+
+// Seal + open of one frame may take at most this share of the 16 ms frame
+// period on the host; see the README for the device figures
+static const double FRAME_PERIOD_US = 16000.0;
+static const double MAX_FRAME_SHARE = 0.01;
+
+struct Peers {
+  StreamCrypto a;
+  StreamCrypto b;
+};
+
+void key_peers(Peers &peers, CipherSuite suite, uint8_t psk_byte = 0x42, uint8_t psk_byte_b = 0x42) {
+  uint8_t psk[StreamCrypto::KEY_SIZE];
+  uint8_t nonce_a[StreamCrypto::NONCE_SIZE];
+  uint8_t nonce_b[StreamCrypto::NONCE_SIZE];
+  memset(nonce_a, 0xA0, sizeof(nonce_a));
+  memset(nonce_b, 0xB0, sizeof(nonce_b));
+  peers.a.set_suite(suite);
+  peers.b.set_suite(suite);
+  memset(psk, psk_byte, sizeof(psk));
+  peers.a.set_psk(psk);
+  memset(psk, psk_byte_b, sizeof(psk));
+  peers.b.set_psk(psk);
+  peers.a.begin_session(nonce_a);
+  peers.b.begin_session(nonce_b);
+  peers.a.key_session(nonce_b);
+  peers.b.key_session(nonce_a);
+}
+
+struct Packet {
+  wire::PacketHeader info;
+  uint8_t header[wire::HEADER_SIZE];
+  std::vector<uint8_t> body;
+};
+
+Packet make_packet(uint16_t seq, size_t len, wire::PacketType type = wire::PacketType::AUDIO) {
+  Packet p;
+  p.info.type = type;
+  p.info.seq = seq;
+  p.info.length = (uint16_t) len;
+  wire::write_header(p.info, p.header);
+  p.body.resize(len + StreamCrypto::TAG_SIZE);
+  for (size_t i = 0; i < len; i++) {
+    p.body[i] = (uint8_t) (i * 7 + seq);
+  }
+  return p;
+}
+
+class StreamCryptoTest : public ::testing::TestWithParam<CipherSuite> {
+ protected:
+  void SetUp() override {
+    if (!StreamCrypto::is_supported(GetParam())) {
+      GTEST_SKIP() << "cipher suite not in this mbedTLS build";
+    }
+  }
+};
+
+TEST_P(StreamCryptoTest, RoundTripBothDirections) {
+  Peers peers;
+  key_peers(peers, GetParam());
+  ASSERT_TRUE(peers.a.is_keyed());
+  ASSERT_TRUE(peers.b.is_keyed());
+
+  for (uint16_t seq = 0; seq < 4; seq++) {
+    Packet p = make_packet(seq, 512);
+    std::vector<uint8_t> plain(p.body.begin(), p.body.begin() + 512);
+    ASSERT_TRUE(peers.a.seal(p.header, p.info, p.body.data(), 512));
+    EXPECT_NE(memcmp(p.body.data(), plain.data(), 512), 0);
+    ASSERT_TRUE(peers.b.open(p.header, p.info, p.body.data(), p.body.size()));
+    EXPECT_EQ(memcmp(p.body.data(), plain.data(), 512), 0);
+
+    // And back: each direction has its own key
+    Packet q = make_packet(seq, 64);
+    ASSERT_TRUE(peers.b.seal(q.header, q.info, q.body.data(), 64));
+    ASSERT_TRUE(peers.a.open(q.header, q.info, q.body.data(), q.body.size()));
+  }
+}
+
+TEST_P(StreamCryptoTest, RejectsTamperedHeaderBodyAndTag) {
+  Peers peers;
+  key_peers(peers, GetParam());
+  uint16_t seq = 1;
+  for (size_t where : {(size_t) 0, (size_t) 100, (size_t) 512 + 3}) {
+    Packet p = make_packet(seq++, 512);
+    ASSERT_TRUE(peers.a.seal(p.header, p.info, p.body.data(), 512));
+    p.body[where] ^= 0x01;
+    EXPECT_FALSE(peers.b.open(p.header, p.info, p.body.data(), p.body.size())) << "byte " << where;
+  }
+  Packet p = make_packet(seq, 512);
+  ASSERT_TRUE(peers.a.seal(p.header, p.info, p.body.data(), 512));
+  p.header[3] ^= 0x01;  // Flags are associated data
+  EXPECT_FALSE(peers.b.open(p.header, p.info, p.body.data(), p.body.size()));
+}
+
+TEST_P(StreamCryptoTest, RejectsReplayButAcceptsReorder) {
+  Peers peers;
+  key_peers(peers, GetParam());
+  std::vector<Packet> sent;
+  for (uint16_t seq = 10; seq < 14; seq++) {
+    sent.push_back(make_packet(seq, 32));
+    ASSERT_TRUE(peers.a.seal(sent.back().header, sent.back().info, sent.back().body.data(), 32));
+  }
+  std::vector<Packet> copies = sent;
+  ASSERT_TRUE(peers.b.open(sent[0].header, sent[0].info, sent[0].body.data(), sent[0].body.size()));
+  ASSERT_TRUE(peers.b.open(sent[2].header, sent[2].info, sent[2].body.data(), sent[2].body.size()));
+  ASSERT_TRUE(peers.b.open(sent[1].header, sent[1].info, sent[1].body.data(), sent[1].body.size()));
+  EXPECT_FALSE(peers.b.open(copies[2].header, copies[2].info, copies[2].body.data(), copies[2].body.size()));
+  EXPECT_FALSE(peers.b.open(copies[0].header, copies[0].info, copies[0].body.data(), copies[0].body.size()));
+}
+
+TEST_P(StreamCryptoTest, SequenceNumbersWrap) {
+  Peers peers;
+  key_peers(peers, GetParam());
+  uint16_t seq = 0xFFF0;
+  for (int i = 0; i < 40; i++, seq++) {
+    Packet p = make_packet(seq, 16);
+    ASSERT_TRUE(peers.a.seal(p.header, p.info, p.body.data(), 16)) << "seq " << seq;
+    ASSERT_TRUE(peers.b.open(p.header, p.info, p.body.data(), p.body.size())) << "seq " << seq;
+  }
+  // The sender never seals a sequence number it has already used
+  Packet old = make_packet(0xFFF0, 16);
+  EXPECT_FALSE(peers.a.seal(old.header, old.info, old.body.data(), 16));
+}
+
+TEST_P(StreamCryptoTest, WrongKeyDoesNotOpen) {
+  Peers peers;
+  key_peers(peers, GetParam(), 0x42, 0x43);
+  Packet p = make_packet(1, 128);
+  ASSERT_TRUE(peers.a.seal(p.header, p.info, p.body.data(), 128));
+  EXPECT_FALSE(peers.b.open(p.header, p.info, p.body.data(), p.body.size()));
+}
+
+TEST_P(StreamCryptoTest, SealPlusOpenFitsTheFrameBudget) {
+  Peers peers;
+  key_peers(peers, GetParam());
+  const int iterations = 5000;
+  std::vector<Packet> packets;
+  for (int i = 0; i < iterations; i++) {
+    packets.push_back(make_packet((uint16_t) i, 512));
+  }
+  auto start = std::chrono::steady_clock::now();
+  for (Packet &p : packets) {
+    ASSERT_TRUE(peers.a.seal(p.header, p.info, p.body.data(), 512));
+    ASSERT_TRUE(peers.b.open(p.header, p.info, p.body.data(), p.body.size()));
+  }
+  double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() /
+              iterations;
+  RecordProperty("seal_open_us", std::to_string(us));
+  printf("seal + open of a 512-byte frame: %.2f us (%.3f%% of the frame period)\n", us,
+         100.0 * us / FRAME_PERIOD_US);
+  EXPECT_LT(us, MAX_FRAME_SHARE * FRAME_PERIOD_US);
+}
+
+INSTANTIATE_TEST_SUITE_P(Suites, StreamCryptoTest,
+                         ::testing::Values(CipherSuite::AES_256_GCM, CipherSuite::CHACHA20_POLY1305),
+                         [](const ::testing::TestParamInfo<CipherSuite> &info) {
+                           return info.param == CipherSuite::AES_256_GCM ? "AesGcm" : "ChaChaPoly";
+                         });
+
+TEST(StreamCrypto, HelloAuthenticatesAndEchoesTheNonce) {
+  Peers peers;
+  key_peers(peers, CipherSuite::AES_256_GCM);
+  wire::PacketHeader info;
+  info.type = wire::PacketType::HELLO;
+  info.length = StreamCrypto::HELLO_BODY_SIZE;
+  uint8_t header[wire::HEADER_SIZE];
+  wire::write_header(info, header);
+  uint8_t body[StreamCrypto::HELLO_BODY_SIZE];
+  peers.a.write_hello(header, body);
+
+  const uint8_t *nonce;
+  bool echo_ok = false;
+  ASSERT_TRUE(peers.b.verify_hello(header, body, sizeof(body), &nonce, &echo_ok));
+  EXPECT_TRUE(echo_ok);  // a already knows b's nonce
+  EXPECT_TRUE(peers.b.is_peer_nonce(nonce));
+
+  body[0] ^= 0x01;
+  EXPECT_FALSE(peers.b.verify_hello(header, body, sizeof(body), &nonce, &echo_ok));
+}
+
+// Without ChaCha20-Poly1305 in mbedTLS the suite must fail closed
+TEST(StreamCrypto, UnsupportedSuiteNeverKeys) {
+  if (StreamCrypto::is_supported(CipherSuite::CHACHA20_POLY1305)) {
+    GTEST_SKIP() << "ChaCha20-Poly1305 is built in";
+  }
+  Peers peers;
+  key_peers(peers, CipherSuite::CHACHA20_POLY1305);
+  EXPECT_FALSE(peers.a.is_keyed());
+  Packet p = make_packet(1, 32);
+  EXPECT_FALSE(peers.a.seal(p.header, p.info, p.body.data(), 32));
+  EXPECT_FALSE(peers.b.open(p.header, p.info, p.body.data(), p.body.size()));
+}
+
+}  // namespace
+}  // namespace intercom_audio
+}  // namespace esphome
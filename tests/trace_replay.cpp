@@ -0,0 +1,224 @@
+// Replays the received audio of an intercom_audio trace through the host build
+// of the receive path: every RX record is sent to an IntercomAudio on loopback
+// at the time it arrived on the device, into the real jitter buffer and
+// playout, and a duplex whose fake I2S controller drains the speaker buffer at
+// the sample rate (the playback backpressure). Calls start and stop where the
+// trace has SESSION_START / SESSION_STOP. The replay's own trace is written
+// out for tools/trace_report.py --replay to set against the recorded one.
+//
+//   trace_replay <trace.bin> <replay.bin> [--buffer-size N] [--prebuffer-size N] [--speaker-buffer-size N]
+//
+// The sizes are the device's buffer_size, prebuffer_size and the duplex
+// speaker_buffer_size (component defaults when left out). The frame format is
+// fixed at build time, so a trace of another sample rate or frame size is
+// refused. Only the receive side is replayed: mic frames are silence, and the
+// AEC (ESP32 only) does not run.
+
+#include "intercom_harness.h"
+
+#include "i2s_audio_duplex/i2s_audio_duplex.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace esphome {
+namespace intercom_audio {
+namespace {
+
+// Header of a dump as AudioTrace::write_file_header() lays it out
+struct FileHeader {
+  char magic[4];
+  uint16_t version;
+  uint16_t record_header_size;
+  uint32_t sample_rate;
+  uint16_t frame_samples;
+  uint16_t record_size;
+};
+static_assert(sizeof(FileHeader) == AudioTrace::FILE_HEADER_SIZE, "dump header layout");
+
+// What the replay acts on, with the time since the first record
+struct Step {
+  int64_t at_us;
+  TraceKind kind;
+  TraceEvent event;
+  std::vector<int16_t> samples;
+};
+
+bool read_steps(const char *path, std::vector<Step> *steps) {
+  FILE *file = fopen(path, "rb");
+  if (file == nullptr) {
+    fprintf(stderr, "%s: cannot open\n", path);
+    return false;
+  }
+  std::vector<uint8_t> data;
+  uint8_t chunk[4096];
+  size_t n;
+  while ((n = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+    data.insert(data.end(), chunk, chunk + n);
+  }
+  fclose(file);
+
+  FileHeader header;
+  if (data.size() < sizeof(header)) {
+    fprintf(stderr, "%s: file too short\n", path);
+    return false;
+  }
+  memcpy(&header, data.data(), sizeof(header));
+  if (memcmp(header.magic, "IATR", 4) != 0 || header.version != AudioTrace::VERSION ||
+      header.record_header_size != sizeof(TraceRecordHeader)) {
+    fprintf(stderr, "%s: not an intercom_audio trace of version %u\n", path, AudioTrace::VERSION);
+    return false;
+  }
+  if (header.sample_rate != IntercomAudio::get_sample_rate() ||
+      header.frame_samples != IntercomAudio::get_frame_samples()) {
+    fprintf(stderr, "%s: %u Hz / %u-sample frames, this build replays %u Hz / %zu\n", path,
+            (unsigned) header.sample_rate, header.frame_samples, (unsigned) IntercomAudio::get_sample_rate(),
+            IntercomAudio::get_frame_samples());
+    return false;
+  }
+
+  int64_t first = -1;
+  int64_t epoch = 0;
+  uint32_t last = 0;
+  for (size_t at = sizeof(header); at + header.record_size <= data.size(); at += header.record_size) {
+    TraceRecordHeader record;
+    memcpy(&record, &data[at], sizeof(record));
+    if (record.kind == (uint8_t) TraceKind::LOST) {
+      continue;
+    }
+    // esp_timer low 32 bits wrap every ~71 minutes
+    if (first >= 0 && record.time_us < last && last - record.time_us > (1u << 31)) {
+      epoch += (int64_t) 1 << 32;
+    }
+    last = record.time_us;
+    const int64_t time_us = epoch + record.time_us;
+    if (first < 0) {
+      first = time_us;
+    }
+    const bool session = record.kind == (uint8_t) TraceKind::EVENT &&
+                         (record.event == (uint16_t) TraceEvent::SESSION_START ||
+                          record.event == (uint16_t) TraceEvent::SESSION_STOP);
+    if (record.kind != (uint8_t) TraceKind::RX && !session) {
+      continue;
+    }
+    Step step{time_us - first, (TraceKind) record.kind, (TraceEvent) record.event, {}};
+    step.samples.resize(std::min<size_t>(record.samples, header.frame_samples));
+    memcpy(step.samples.data(), &data[at + sizeof(record)], step.samples.size() * sizeof(int16_t));
+    steps->push_back(std::move(step));
+  }
+  return true;
+}
+
+bool write_dump(const AudioTrace &trace, const char *path) {
+  FILE *file = fopen(path, "wb");
+  if (file == nullptr) {
+    fprintf(stderr, "%s: cannot create\n", path);
+    return false;
+  }
+  const std::vector<uint8_t> dump = dump_trace(trace);
+  const bool ok = fwrite(dump.data(), 1, dump.size(), file) == dump.size();
+  return fclose(file) == 0 && ok;
+}
+
+int replay(int argc, char **argv) {
+  if (argc < 3) {
+    fprintf(stderr,
+            "usage: %s <trace.bin> <replay.bin> [--buffer-size N] [--prebuffer-size N] "
+            "[--speaker-buffer-size N]\n",
+            argv[0]);
+    return 2;
+  }
+  size_t buffer_size = 8192;
+  size_t prebuffer_size = 2048;
+  size_t speaker_buffer_size = 8192;
+  for (int i = 3; i + 1 < argc; i += 2) {
+    size_t value = strtoul(argv[i + 1], nullptr, 10);
+    if (strcmp(argv[i], "--buffer-size") == 0) {
+      buffer_size = value;
+    } else if (strcmp(argv[i], "--prebuffer-size") == 0) {
+      prebuffer_size = value;
+    } else if (strcmp(argv[i], "--speaker-buffer-size") == 0) {
+      speaker_buffer_size = value;
+    } else {
+      fprintf(stderr, "unknown option %s\n", argv[i]);
+      return 2;
+    }
+  }
+
+  std::vector<Step> steps;
+  if (!read_steps(argv[1], &steps)) {
+    return 1;
+  }
+  if (steps.empty()) {
+    fprintf(stderr, "%s: no received audio to replay\n", argv[1]);
+    return 1;
+  }
+
+  // Never freed: their tasks run until the process exits
+  auto &duplex = *new i2s_audio_duplex::I2SAudioDuplex();
+  auto &intercom = *new IntercomAudio();
+  duplex.set_bclk_pin(1);
+  duplex.set_lrclk_pin(2);
+  duplex.set_din_pin(3);
+  duplex.set_dout_pin(4);
+  duplex.set_speaker_buffer_size(speaker_buffer_size);
+  const uint16_t listen_port = free_udp_port();
+  intercom.set_duplex(&duplex);
+  intercom.set_listen_port(listen_port);
+  intercom.set_buffer_size(buffer_size);
+  intercom.set_prebuffer_size(prebuffer_size);
+  // Room for the whole replay, plus the calls' own start and stop
+  intercom.set_trace_duration((uint32_t) (steps.back().at_us / 1000) + 2000);
+  duplex.setup();
+  intercom.setup();
+  if (duplex.is_failed() || intercom.is_failed() || !intercom.has_trace()) {
+    fprintf(stderr, "replay setup failed\n");
+    return 1;
+  }
+  intercom.set_trace_enabled(true);
+
+  Peer sender;
+  // A trace that begins inside a call replays from its first record
+  if (steps.front().kind == TraceKind::RX) {
+    intercom.start("127.0.0.1", sender.port());
+  }
+  const auto begin = std::chrono::steady_clock::now();
+  size_t sent = 0;
+  for (const Step &step : steps) {
+    std::this_thread::sleep_until(begin + std::chrono::microseconds(step.at_us));
+    if (step.kind == TraceKind::RX) {
+      if (intercom.is_streaming()) {
+        sender.send_samples(listen_port, step.samples.data(), step.samples.size());
+        sent++;
+      }
+    } else if (step.event == TraceEvent::SESSION_START) {
+      intercom.start("127.0.0.1", sender.port());
+    } else if (intercom.is_streaming()) {
+      intercom.stop();
+    }
+    sender.drain([](int16_t) {});  // The intercom's mic frames
+  }
+  // Let playout finish what is still buffered
+  std::this_thread::sleep_for(std::chrono::milliseconds(
+      (buffer_size + speaker_buffer_size) * 1000 / (IntercomAudio::get_sample_rate() * sizeof(int16_t)) + 100));
+  if (intercom.is_streaming()) {
+    intercom.stop();
+  }
+  intercom.set_trace_enabled(false);
+
+  if (!write_dump(intercom.get_trace(), argv[2])) {
+    return 1;
+  }
+  fprintf(stderr, "replayed %zu received frames\n", sent);
+  return 0;
+}
+
+}  // namespace
+}  // namespace intercom_audio
+}  // namespace esphome
+
+int main(int argc, char **argv) { return esphome::intercom_audio::replay(argc, argv); }
@@ -0,0 +1,272 @@
+#!/usr/bin/env python3
+"""Start/stop soak run against an intercom_audio device.
+
+Needs the device's web_server, the intercom `metrics:` scrape target and a
+`streaming` switch. For the error paths, build it with `fault_injection:` too.
+Then run:
+
+    python3 tools/soak.py http://<device> --cycles 2000 [--json soak.json]
+    python3 tools/soak.py http://<device> --compare baseline.json
+
+Each cycle turns the streaming switch on, waits, turns it off and waits again,
+so the device goes through start() and stop() back to back. The metrics are
+scraped as it goes. The run fails when:
+
+  - the internal heap left after stop() keeps shrinking past the warm-up
+  - a stop() takes longer than the bound
+  - the device restarts, or a turn-on does not start a call
+
+The report gives request round trips, stop() times, the heap trend, mic frames
+rejected for an ended session and the faults injected. --json writes it for
+--compare against a later release. Standard library only.
+"""
+
+import argparse
+import base64
+import json
+import math
+import statistics
+import sys
+import time
+import urllib.error
+import urllib.request
+
+STOP_HISTOGRAM = "intercom_stop_seconds"
+INJECTED = {
+    "send_error": "intercom_injected_send_errors_total",
+    "receive_loss": "intercom_injected_receive_losses_total",
+    "speaker_stall": "intercom_injected_speaker_stalls_total",
+    "mic_overflow": "intercom_injected_mic_overflows_total",
+    "i2s_read_timeout": "intercom_injected_i2s_read_timeouts_total",
+    "i2s_write_timeout": "intercom_injected_i2s_write_timeouts_total",
+}
+# Heap samples compared at each end of the run (median of each)
+HEAP_WINDOW = 5
+
+
+class Device:
+    def __init__(self, url, switch, metrics_path, auth, timeout):
+        self.url = url.rstrip("/")
+        self.switch = switch
+        self.metrics_path = metrics_path
+        self.timeout = timeout
+        self.headers = {}
+        if auth:
+            self.headers["Authorization"] = "Basic " + base64.b64encode(auth.encode()).decode()
+
+    def request(self, method, path):
+        req = urllib.request.Request(self.url + path, method=method, headers=self.headers)
+        start = time.monotonic()
+        with urllib.request.urlopen(req, timeout=self.timeout) as resp:
+            body = resp.read()
+        return body, (time.monotonic() - start) * 1000.0
+
+    def set_streaming(self, on):
+        _, ms = self.request("POST", f"/switch/{self.switch}/{'turn_on' if on else 'turn_off'}")
+        return ms
+
+    def scrape(self):
+        body, _ = self.request("GET", self.metrics_path)
+        return parse_metrics(body.decode())
+
+
+def parse_metrics(text):
+    """Prometheus text format to {name or name{labels}: value}."""
+    values = {}
+    for line in text.splitlines():
+        if not line or line.startswith("#"):
+            continue
+        name, _, value = line.rpartition(" ")
+        try:
+            values[name] = float(value)
+        except ValueError:
+            continue
+    return values
+
+
+def stop_buckets(metrics):
+    """Cumulative stop() histogram as [(upper bound in s, count)], +Inf last."""
+    buckets = []
+    prefix = STOP_HISTOGRAM + '_bucket{le="'
+    for name, count in metrics.items():
+        if name.startswith(prefix):
+            le = name[len(prefix):-2]
+            buckets.append((math.inf if le == "+Inf" else float(le), count))
+    return sorted(buckets)
+
+
+def summarize(values):
+    if not values:
+        return None
+    ordered = sorted(values)
+    return {
+        "mean": round(statistics.fmean(ordered), 1),
+        "p50": round(ordered[len(ordered) // 2], 1),
+        "p95": round(ordered[min(len(ordered) - 1, int(len(ordered) * 0.95))], 1),
+        "max": round(ordered[-1], 1),
+    }
+
+
+def run(device, args):
+    before = device.scrape()
+    if STOP_HISTOGRAM + "_count" not in before:
+        raise ValueError(f"{device.metrics_path} has no {STOP_HISTOGRAM}; is this an intercom_audio metrics path?")
+
+    on_ms, off_ms, heap = [], [], []
+    restarted = False
+    last = before
+    start = time.monotonic()
+    for cycle in range(1, args.cycles + 1):
+        on_ms.append(device.set_streaming(True))
+        time.sleep(args.on)
+        off_ms.append(device.set_streaming(False))
+        time.sleep(args.off)
+        if cycle % args.sample_every == 0 or cycle == args.cycles:
+            now = device.scrape()
+            if now.get("intercom_starts_total", 0) < last.get("intercom_starts_total", 0):
+                restarted = True
+                print(f"cycle {cycle}: device restarted", file=sys.stderr)
+                break
+            if cycle > args.warmup:
+                heap.append(now["intercom_heap_after_stop_bytes"])
+            last = now
+            if not args.quiet:
+                print(f"cycle {cycle}/{args.cycles}: heap after stop {now['intercom_heap_after_stop_bytes']:.0f}, "
+                      f"stale mic frames {now.get('intercom_stale_mic_frames_total', 0):.0f}", file=sys.stderr)
+    after = last
+    return report(args, before, after, on_ms, off_ms, heap, restarted, time.monotonic() - start)
+
+
+def report(args, before, after, on_ms, off_ms, heap, restarted, duration):
+    def delta(name):
+        return after.get(name, 0) - before.get(name, 0)
+
+    cycles = len(off_ms)
+    stops = delta(STOP_HISTOGRAM + "_count")
+    # Stops in the run past the bound, at the histogram's resolution
+    first = dict(stop_buckets(before))
+    within = 0
+    for le, count in stop_buckets(after):
+        if le <= args.max_stop:
+            within = count - first.get(le, 0)
+    over = stops - within if not restarted else 0
+
+    growth = None
+    if len(heap) >= 2 * HEAP_WINDOW:
+        growth = statistics.median(heap[:HEAP_WINDOW]) - statistics.median(heap[-HEAP_WINDOW:])
+    starts = delta("intercom_starts_total")
+
+    checks = {
+        "no_restart": not restarted,
+        "every_cycle_started": restarted or starts >= cycles,
+        "stop_within_bound": over == 0,
+        "no_heap_growth": growth is None or growth <= args.heap_tolerance,
+    }
+    return {
+        "device": args.device,
+        "cycles": cycles,
+        "duration_s": round(duration, 1),
+        "on_s": args.on,
+        "off_s": args.off,
+        "turn_on_request_ms": summarize(on_ms),
+        "turn_off_request_ms": summarize(off_ms),
+        "stops": int(stops),
+        "stop_mean_ms": round(delta(STOP_HISTOGRAM + "_sum") / stops * 1000.0, 1) if stops > 0 else None,
+        "stop_bound_ms": round(args.max_stop * 1000.0, 1),
+        "stops_over_bound": int(over),
+        "starts": int(starts),
+        "heap_after_stop_first": statistics.median(heap[:HEAP_WINDOW]) if heap else None,
+        "heap_after_stop_last": statistics.median(heap[-HEAP_WINDOW:]) if heap else None,
+        "heap_growth_bytes": growth,
+        "heap_samples": len(heap),
+        "stale_mic_frames_rejected": int(delta("intercom_stale_mic_frames_total")),
+        "injected": {key: int(delta(name)) for key, name in INJECTED.items() if name in after},
+        "checks": checks,
+        "passed": all(checks.values()),
+    }
+
+
+def print_report(result):
+    def fmt(stats):
+        if stats is None:
+            return "-"
+        return f"mean {stats['mean']} ms, p95 {stats['p95']} ms, max {stats['max']} ms"
+
+    print(f"Soak: {result['cycles']} cycles in {result['duration_s']} s against {result['device']}")
+    print(f"  turn_on requests {fmt(result['turn_on_request_ms'])}")
+    print(f"  turn_off requests {fmt(result['turn_off_request_ms'])}")
+    print(f"  stop(): {result['stops']} stops, mean {result['stop_mean_ms']} ms, "
+          f"{result['stops_over_bound']} over {result['stop_bound_ms']} ms")
+    if result["heap_growth_bytes"] is None:
+        print(f"  heap after stop: too few samples past the warm-up ({result['heap_samples']})")
+    else:
+        print(f"  heap after stop: {result['heap_after_stop_first']:.0f} -> {result['heap_after_stop_last']:.0f} "
+              f"bytes ({result['heap_growth_bytes']:+.0f} used)")
+    print(f"  mic frames rejected for an ended session: {result['stale_mic_frames_rejected']}")
+    if result["injected"]:
+        print("  faults injected: " + ", ".join(f"{k} {v}" for k, v in result["injected"].items()))
+    for name, ok in result["checks"].items():
+        print(f"  {'ok  ' if ok else 'FAIL'} {name}")
+
+
+def print_comparison(baseline, result):
+    rows = [
+        ("stop() mean ms", baseline.get("stop_mean_ms"), result.get("stop_mean_ms")),
+        ("stops over bound", baseline.get("stops_over_bound"), result.get("stops_over_bound")),
+        ("turn_on p95 ms", (baseline.get("turn_on_request_ms") or {}).get("p95"),
+         (result.get("turn_on_request_ms") or {}).get("p95")),
+        ("turn_off p95 ms", (baseline.get("turn_off_request_ms") or {}).get("p95"),
+         (result.get("turn_off_request_ms") or {}).get("p95")),
+        ("heap growth bytes", baseline.get("heap_growth_bytes"), result.get("heap_growth_bytes")),
+        ("heap after stop", baseline.get("heap_after_stop_last"), result.get("heap_after_stop_last")),
+    ]
+    print(f"Against {baseline.get('device')} ({baseline.get('cycles')} cycles):")
+    for name, old, new in rows:
+        change = ""
+        if isinstance(old, (int, float)) and isinstance(new, (int, float)):
+            change = f"  ({new - old:+.1f})"
+        print(f"  {name:<20} {old!s:>10} -> {new!s:>10}{change}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("device", help="device URL, e.g. http://intercom.local")
+    parser.add_argument("--switch", default="streaming", help="object id of the streaming switch")
+    parser.add_argument("--metrics-path", default="/metrics", help="path of the metrics scrape target")
+    parser.add_argument("--auth", metavar="USER:PASSWORD", help="web_server basic auth")
+    parser.add_argument("--cycles", type=int, default=1000, help="start/stop cycles")
+    parser.add_argument("--on", type=float, default=1.0, help="seconds streaming per cycle")
+    parser.add_argument("--off", type=float, default=0.3, help="seconds stopped per cycle")
+    parser.add_argument("--sample-every", type=int, default=10, help="scrape the metrics every N cycles")
+    parser.add_argument("--warmup", type=int, default=20, help="cycles before heap samples count")
+    parser.add_argument("--heap-tolerance", type=int, default=2048, help="bytes the heap may shrink over the run")
+    parser.add_argument("--max-stop", type=float, default=0.25, help="stop() bound in seconds (a histogram bucket)")
+    parser.add_argument("--timeout", type=float, default=5.0, help="HTTP timeout in seconds")
+    parser.add_argument("--json", metavar="FILE", help="also write the report as JSON")
+    parser.add_argument("--compare", metavar="FILE", help="compare with a JSON report from an earlier run")
+    parser.add_argument("--quiet", action="store_true", help="no progress lines")
+    args = parser.parse_args()
+    if args.cycles < 1 or args.sample_every < 1:
+        parser.error("--cycles and --sample-every must be at least 1")
+
+    device = Device(args.device, args.switch, args.metrics_path, args.auth, args.timeout)
+    try:
+        result = run(device, args)
+    except (OSError, ValueError, KeyError, urllib.error.URLError) as err:
+        print(f"{args.device}: {err}", file=sys.stderr)
+        return 2
+    print_report(result)
+    if args.compare:
+        try:
+            with open(args.compare) as f:
+                print_comparison(json.load(f), result)
+        except (OSError, ValueError) as err:
+            print(f"{args.compare}: {err}", file=sys.stderr)
+    if args.json:
+        with open(args.json, "w") as f:
+            json.dump(result, f, indent=2)
+    return 0 if result["passed"] else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,357 @@
+#!/usr/bin/env python3
+"""Report on an intercom_audio trace dump.
+
+Fetch a dump from a device with `trace: web_export:` configured and the trace
+switch on, then run this on it:
+
+    curl -o trace.bin http://<device>/intercom/trace.bin
+    python3 tools/trace_report.py trace.bin [--wav out/] [--json]
+
+The report covers capture and playout timing, jitter buffer depth, drops and
+underruns, the AEC reference and its ERLE, and the echo path delay between the
+reference and the microphone. --wav writes the mic, reference, AEC output,
+received and played audio as WAV stems for listening or for a desktop AEC.
+
+--replay runs the trace_replay program of the host tests (tests/trace_replay.cpp)
+on the dump: the received frames go back through the host build of the jitter
+buffer, playout and duplex speaker path at the times they arrived, and the
+replayed playout is reported next to the recorded one. Buffer sizes other than
+the defaults are passed on, to try a configuration against a real arrival
+pattern:
+
+    cmake -S tests -B build/tests && cmake --build build/tests --target trace_replay
+    python3 tools/trace_report.py trace.bin --replay build/tests/trace_replay --buffer-size 12288
+
+Only the receive side is replayed. The ESP-SR AEC itself only exists as a
+binary for the ESP32 targets, so the AEC output is taken from the trace as
+recorded rather than recomputed, and the host speaker drains at exactly the
+sample rate where a real I2S clock drifts a little. Standard library only.
+"""
+
+import argparse
+import json
+import math
+import os
+import statistics
+import struct
+import subprocess
+import sys
+import tempfile
+import wave
+
+FILE_HEADER = struct.Struct("<4sHHIHH")
+RECORD_HEADER = struct.Struct("<BBHIIHHHHI")
+
+KIND_MIC, KIND_REF, KIND_AEC_OUT, KIND_PLAY, KIND_EVENT, KIND_RX, KIND_LOST = 0, 1, 2, 3, 4, 5, 0xFF
+KIND_NAMES = {KIND_MIC: "mic", KIND_REF: "ref", KIND_AEC_OUT: "aec_out", KIND_RX: "rx", KIND_PLAY: "play"}
+
+EVENT_SESSION_START, EVENT_SESSION_STOP = 1, 2
+EVENT_TX_DROP, EVENT_RX_DROP, EVENT_RX_EMPTY = 3, 4, 5
+
+REF_FRESH, REF_HELD = 0x01, 0x02
+RX_DROPPED = 0x01
+
+# Playout figures set side by side by --replay
+REPLAY_COMPARED = ("calls", "partial", "underruns", "jitter_buffer_empty", "rx_drops")
+
+# Frames quieter than this (dBFS) carry no far-end speech for ERLE
+ACTIVE_DBFS = -45.0
+# Echo path delays searched, and envelope resolution for the search
+MAX_ECHO_DELAY_MS = 250
+ENVELOPE_MS = 1
+
+
+class Record:
+    __slots__ = ("kind", "flags", "seq", "time_us", "mic_fill", "rx_fill", "ref_fill", "event", "value", "samples")
+
+
+def read_trace(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    if len(data) < FILE_HEADER.size:
+        raise ValueError("file too short")
+    magic, version, header_size, rate, frame_samples, record_size = FILE_HEADER.unpack_from(data, 0)
+    if magic != b"IATR":
+        raise ValueError("not an intercom_audio trace")
+    if version != 1 or header_size != RECORD_HEADER.size:
+        raise ValueError(f"unsupported trace version {version}")
+
+    records = []
+    lost = 0
+    last_time = None
+    epoch = 0
+    for offset in range(FILE_HEADER.size, len(data) - record_size + 1, record_size):
+        fields = RECORD_HEADER.unpack_from(data, offset)
+        if fields[0] == KIND_LOST:
+            lost += 1
+            continue
+        rec = Record()
+        (rec.kind, rec.flags, count, rec.seq, time_us, rec.mic_fill, rec.rx_fill, rec.ref_fill, rec.event,
+         rec.value) = fields
+        # esp_timer low 32 bits wrap every ~71 minutes
+        if last_time is not None and time_us < last_time and last_time - time_us > 1 << 31:
+            epoch += 1 << 32
+        last_time = time_us
+        rec.time_us = epoch + time_us
+        start = offset + RECORD_HEADER.size
+        rec.samples = struct.unpack_from(f"<{count}h", data, start) if count else ()
+        records.append(rec)
+    return rate, frame_samples, records, lost
+
+
+def rms_dbfs(samples):
+    if not samples:
+        return -120.0
+    energy = sum(s * s for s in samples) / len(samples)
+    return 10.0 * math.log10(energy / (32768.0 * 32768.0)) if energy > 0 else -120.0
+
+
+def energy(samples):
+    return sum(s * s for s in samples)
+
+
+def percentile(values, pct):
+    if not values:
+        return None
+    ordered = sorted(values)
+    return ordered[min(len(ordered) - 1, int(round(pct / 100.0 * (len(ordered) - 1))))]
+
+
+def summarize(values, unit_scale=1.0):
+    if not values:
+        return None
+    scaled = [v * unit_scale for v in values]
+    return {
+        "mean": round(statistics.fmean(scaled), 2),
+        "p95": round(percentile(scaled, 95), 2),
+        "max": round(max(scaled), 2),
+    }
+
+
+def envelope(frames, rate):
+    step = max(1, rate * ENVELOPE_MS // 1000)
+    out = []
+    for frame in frames:
+        for i in range(0, len(frame) - step + 1, step):
+            out.append(sum(abs(s) for s in frame[i:i + step]) / step)
+    return out
+
+
+def echo_delay_ms(ref_frames, mic_frames, rate):
+    """Lag of the mic envelope behind the reference envelope with the best correlation."""
+    ref = envelope(ref_frames, rate)
+    mic = envelope(mic_frames, rate)
+    n = min(len(ref), len(mic))
+    max_lag = MAX_ECHO_DELAY_MS // ENVELOPE_MS
+    if n <= max_lag * 2:
+        return None, 0.0
+    ref_mean = statistics.fmean(ref[:n])
+    mic_mean = statistics.fmean(mic[:n])
+    ref_c = [v - ref_mean for v in ref[:n]]
+    mic_c = [v - mic_mean for v in mic[:n]]
+    best_lag, best = None, 0.0
+    for lag in range(max_lag + 1):
+        a = ref_c[:n - lag]
+        b = mic_c[lag:n]
+        num = sum(x * y for x, y in zip(a, b))
+        den = math.sqrt(sum(x * x for x in a) * sum(y * y for y in b))
+        corr = num / den if den > 0 else 0.0
+        if corr > best:
+            best_lag, best = lag, corr
+    return (None if best_lag is None else best_lag * ENVELOPE_MS), best
+
+
+def report(rate, frame_samples, records, lost):
+    frame_ms = frame_samples * 1000.0 / rate
+    bytes_to_ms = 1000.0 / (rate * 2)
+    by_kind = {kind: [r for r in records if r.kind == kind] for kind in KIND_NAMES}
+    events = [r for r in records if r.kind == KIND_EVENT]
+    result = {
+        "sample_rate": rate,
+        "frame_ms": round(frame_ms, 2),
+        "records": len(records),
+        "records_lost": lost,
+    }
+    if records:
+        result["duration_s"] = round((records[-1].time_us - records[0].time_us) / 1e6, 2)
+    result["sessions"] = sum(1 for e in events if e.event == EVENT_SESSION_START)
+
+    # Capture: one MIC record per frame sent
+    mic = by_kind[KIND_MIC]
+    mic_gaps = [(b.time_us - a.time_us) / 1000.0 for a, b in zip(mic, mic[1:]) if b.seq == a.seq + 1]
+    result["capture"] = {
+        "frames": len(mic),
+        "interval_ms": summarize(mic_gaps),
+        "mic_buffer_ms": summarize([r.mic_fill for r in mic], bytes_to_ms),
+        "tx_drops": sum(e.value for e in events if e.event == EVENT_TX_DROP),
+    }
+
+    # Receive: one RX record per frame that reached the jitter buffer
+    rx = by_kind[KIND_RX]
+    rx_gaps = [(b.time_us - a.time_us) / 1000.0 for a, b in zip(rx, rx[1:]) if b.seq == a.seq + 1]
+    result["receive"] = {
+        "frames": len(rx),
+        "interval_ms": summarize(rx_gaps),
+        "dropped": sum(1 for r in rx if r.flags & RX_DROPPED),
+    }
+
+    # Playout: a gap of more than 1.5 frames between play calls means the
+    # speaker ran out (underrun) unless the jitter buffer was simply empty
+    play = by_kind[KIND_PLAY]
+    play_gaps = [(b.time_us - a.time_us) / 1000.0 for a, b in zip(play, play[1:]) if b.seq == a.seq + 1]
+    result["playout"] = {
+        "calls": len(play),
+        "partial": sum(1 for r in play if r.flags & 1),
+        "interval_ms": summarize(play_gaps),
+        "underruns": sum(1 for g in play_gaps if g > 1.5 * frame_ms),
+        "jitter_buffer_ms": summarize([r.rx_fill for r in play], bytes_to_ms),
+        "jitter_buffer_empty": sum(1 for e in events if e.event == EVENT_RX_EMPTY),
+        "rx_drops": sum(e.value for e in events if e.event == EVENT_RX_DROP),
+    }
+
+    # AEC: reference availability, ERLE on frames with far-end activity, echo path delay
+    ref = {r.seq: r for r in by_kind[KIND_REF]}
+    out = {r.seq: r for r in by_kind[KIND_AEC_OUT]}
+    if ref:
+        erle = []
+        for m in mic:
+            r = ref.get(m.seq)
+            o = out.get(m.seq)
+            if r is None or o is None or rms_dbfs(r.samples) < ACTIVE_DBFS:
+                continue
+            e_mic, e_out = energy(m.samples), energy(o.samples)
+            if e_mic > 0 and e_out > 0:
+                erle.append(10.0 * math.log10(e_mic / e_out))
+        paired = [(ref[m.seq].samples, m.samples) for m in mic if m.seq in ref]
+        delay, corr = echo_delay_ms([p[0] for p in paired], [p[1] for p in paired], rate)
+        refs = list(ref.values())
+        result["aec"] = {
+            "frames": len(refs),
+            "ref_fresh": sum(1 for r in refs if r.flags & REF_FRESH),
+            "ref_held": sum(1 for r in refs if r.flags & REF_HELD),
+            "ref_silent": sum(1 for r in refs if not r.flags & (REF_FRESH | REF_HELD)),
+            "ref_buffer_ms": summarize([r.ref_fill for r in refs], bytes_to_ms),
+            "erle_db": summarize(erle),
+            "erle_frames": len(erle),
+            "echo_delay_ms": delay,
+            "echo_delay_correlation": round(corr, 2),
+        }
+    return result
+
+
+def write_wavs(directory, rate, records):
+    os.makedirs(directory, exist_ok=True)
+    for kind, name in KIND_NAMES.items():
+        frames = [r.samples for r in records if r.kind == kind]
+        if not frames:
+            continue
+        with wave.open(os.path.join(directory, f"{name}.wav"), "wb") as w:
+            w.setnchannels(1)
+            w.setsampwidth(2)
+            w.setframerate(rate)
+            for samples in frames:
+                w.writeframes(struct.pack(f"<{len(samples)}h", *samples))
+
+
+def run_replay(binary, trace, options):
+    """Replay the trace with the host build; returns the report of the replay's own trace."""
+    with tempfile.TemporaryDirectory() as tmp:
+        out = os.path.join(tmp, "replay.bin")
+        subprocess.run([binary, trace, out] + options, check=True)
+        return report(*read_trace(out))
+
+
+def compare_playout(recorded, replayed):
+    rec, rep = recorded["playout"], replayed["playout"]
+    result = {key: {"recorded": rec[key], "replayed": rep[key]} for key in REPLAY_COMPARED}
+    for key in ("interval_ms", "jitter_buffer_ms"):
+        result[key] = {"recorded": rec[key], "replayed": rep[key]}
+    result["frames_replayed"] = replayed["receive"]["frames"]
+    return result
+
+
+def fmt(stats, unit):
+    if stats is None:
+        return "-"
+    return f"mean {stats['mean']} {unit}, p95 {stats['p95']} {unit}, max {stats['max']} {unit}"
+
+
+def print_comparison(comparison):
+    print(f"Replay: {comparison['frames_replayed']} received frames through the host receive path")
+    print(f"  {'':22} {'recorded':>10} {'replayed':>10}")
+    for key in REPLAY_COMPARED:
+        print(f"  {key:22} {comparison[key]['recorded']:>10} {comparison[key]['replayed']:>10}")
+    for key, unit in (("interval_ms", "ms"), ("jitter_buffer_ms", "ms")):
+        print(f"  {key}: recorded {fmt(comparison[key]['recorded'], unit)}")
+        print(f"  {'':{len(key)}}  replayed {fmt(comparison[key]['replayed'], unit)}")
+
+
+def print_report(result):
+    print(f"Trace: {result['records']} records ({result['records_lost']} lost), "
+          f"{result.get('duration_s', 0)} s, {result['sessions']} session start(s), "
+          f"{result['sample_rate']} Hz / {result['frame_ms']} ms frames")
+    cap = result["capture"]
+    print(f"Capture: {cap['frames']} frames, interval {fmt(cap['interval_ms'], 'ms')}")
+    print(f"  mic buffer {fmt(cap['mic_buffer_ms'], 'ms')}, {cap['tx_drops']} dropped")
+    rx = result["receive"]
+    print(f"Receive: {rx['frames']} frames, interval {fmt(rx['interval_ms'], 'ms')}, {rx['dropped']} not buffered")
+    play = result["playout"]
+    print(f"Playout: {play['calls']} writes ({play['partial']} partial), interval {fmt(play['interval_ms'], 'ms')}")
+    print(f"  underruns {play['underruns']}, jitter buffer empty {play['jitter_buffer_empty']} time(s), "
+          f"{play['rx_drops']} datagrams dropped")
+    print(f"  jitter buffer {fmt(play['jitter_buffer_ms'], 'ms')}")
+    aec = result.get("aec")
+    if aec is None:
+        print("AEC: no reference frames (AEC off or not configured)")
+        return
+    print(f"AEC: {aec['frames']} frames, reference fresh {aec['ref_fresh']} / held {aec['ref_held']} / "
+          f"silent {aec['ref_silent']}, reference buffer {fmt(aec['ref_buffer_ms'], 'ms')}")
+    print(f"  ERLE {fmt(aec['erle_db'], 'dB')} over {aec['erle_frames']} far-end frames")
+    if aec["echo_delay_ms"] is None:
+        print("  echo path delay: not found (no far-end audio or no echo)")
+    else:
+        print(f"  echo path delay {aec['echo_delay_ms']} ms (correlation {aec['echo_delay_correlation']})")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("trace", help="dump from the trace web_export path")
+    parser.add_argument("--wav", metavar="DIR", help="write mic/ref/aec_out/rx/play WAV stems to DIR")
+    parser.add_argument("--json", action="store_true", help="print the report as JSON")
+    parser.add_argument("--replay", metavar="BIN", help="replay the received frames with the host trace_replay BIN")
+    for option in ("--buffer-size", "--prebuffer-size", "--speaker-buffer-size"):
+        parser.add_argument(option, type=int, metavar="BYTES", help="for --replay (component default if left out)")
+    args = parser.parse_args()
+
+    try:
+        rate, frame_samples, records, lost = read_trace(args.trace)
+    except (OSError, ValueError) as err:
+        print(f"{args.trace}: {err}", file=sys.stderr)
+        return 1
+    result = report(rate, frame_samples, records, lost)
+    if args.wav:
+        write_wavs(args.wav, rate, records)
+    comparison = None
+    if args.replay:
+        options = []
+        for name in ("buffer_size", "prebuffer_size", "speaker_buffer_size"):
+            if getattr(args, name) is not None:
+                options += ["--" + name.replace("_", "-"), str(getattr(args, name))]
+        try:
+            comparison = compare_playout(result, run_replay(args.replay, args.trace, options))
+        except (OSError, ValueError, subprocess.CalledProcessError) as err:
+            print(f"replay: {err}", file=sys.stderr)
+            return 1
+    if args.json:
+        if comparison is not None:
+            result["replay"] = comparison
+        print(json.dumps(result, indent=2))
+    else:
+        print_report(result)
+        if comparison is not None:
+            print_comparison(comparison)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())